@@ -66,6 +66,19 @@ typedef struct {
 
 	/* D-Bus path of the connection, if any */
 	char *path;
+
+	/* the version-id of the last time that settings were added or removed,
+	 * or secrets changed. Modifications of the settings themselves are tracked
+	 * by the settings, see _nm_connection_get_version_id(). */
+	guint64 version_id;
+
+	/* the result of the last _nm_connection_verify(). It is valid
+	 * as long as _nm_connection_get_version_id() is unchanged. */
+	struct {
+		guint64 version_id;
+		GError *error;
+		NMSettingVerifyResult result;
+	} verify_cache;
 } NMConnectionPrivate;
 
 G_DEFINE_INTERFACE (NMConnection, nm_connection, G_TYPE_OBJECT)
@@ -91,6 +104,53 @@ _gtype_to_hash_key (GType gtype)
 
 /*****************************************************************************/
 
+static void
+_version_bump (NMConnection *self)
+{
+	NM_CONNECTION_GET_PRIVATE (self)->version_id = _nm_setting_version_id_new ();
+}
+
+static void
+_signal_emit_changed (NMConnection *self)
+{
+	_version_bump (self);
+	g_signal_emit (self, signals[CHANGED], 0);
+}
+
+/**
+ * _nm_connection_get_version_id:
+ * @connection: the #NMConnection
+ *
+ * Returns: a version-id that changes whenever a setting of the connection
+ *   gets added, removed or modified. As long as the id is unchanged, so
+ *   is the connection.
+ *
+ *   The settings track their modifications when the property is set,
+ *   so this also holds while their "notify" signal is frozen.
+ */
+guint64
+_nm_connection_get_version_id (NMConnection *connection)
+{
+	NMConnectionPrivate *priv;
+	GHashTableIter iter;
+	NMSetting *setting;
+	guint64 version_id;
+
+	g_return_val_if_fail (NM_IS_CONNECTION (connection), 0);
+
+	priv = NM_CONNECTION_GET_PRIVATE (connection);
+
+	/* version-ids come from a global counter. The latest change of the
+	 * connection or any of its settings has the largest id. */
+	version_id = priv->version_id;
+	g_hash_table_iter_init (&iter, priv->settings);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &setting))
+		version_id = NM_MAX (version_id, _nm_setting_get_version_id (setting));
+	return version_id;
+}
+
+/*****************************************************************************/
+
 static void
 setting_changed_cb (NMSetting *setting,
                     GParamSpec *pspec,
@@ -129,6 +189,7 @@ _nm_connection_add_setting (NMConnection *connection, NMSetting *setting)
 		_setting_release (connection, s_old);
 
 	g_hash_table_insert (priv->settings, _gtype_to_hash_key (setting_type), setting);
+	_version_bump (connection);
 
 	g_signal_connect (setting, "notify", (GCallback) setting_changed_cb, connection);
 }
@@ -150,7 +211,7 @@ nm_connection_add_setting (NMConnection *connection, NMSetting *setting)
 	g_return_if_fail (NM_IS_SETTING (setting));
 
 	_nm_connection_add_setting (connection, setting);
-	g_signal_emit (connection, signals[CHANGED], 0);
+	_signal_emit_changed (connection);
 }
 
 gboolean
@@ -167,7 +228,7 @@ _nm_connection_remove_setting (NMConnection *connection, GType setting_type)
 	if (setting) {
 		g_signal_handlers_disconnect_by_func (setting, setting_changed_cb, connection);
 		g_hash_table_remove (priv->settings, _gtype_to_hash_key (setting_type));
-		g_signal_emit (connection, signals[CHANGED], 0);
+		_signal_emit_changed (connection);
 		return TRUE;
 	}
 	return FALSE;
@@ -426,6 +487,7 @@ _nm_connection_replace_settings (NMConnection *connection,
 
 	if (g_hash_table_size (priv->settings) > 0) {
 		g_hash_table_foreach_remove (priv->settings, _setting_release_hfr, connection);
+		_version_bump (connection);
 		changed = TRUE;
 	} else
 		changed = (settings != NULL);
@@ -451,7 +513,7 @@ _nm_connection_replace_settings (NMConnection *connection,
 		success = TRUE;
 
 	if (changed)
-		g_signal_emit (connection, signals[CHANGED], 0);
+		_signal_emit_changed (connection);
 	return success;
 }
 
@@ -509,8 +571,10 @@ nm_connection_replace_settings_from_connection (NMConnection *connection,
 	priv = NM_CONNECTION_GET_PRIVATE (connection);
 	new_priv = NM_CONNECTION_GET_PRIVATE (new_connection);
 
-	if ((changed = g_hash_table_size (priv->settings) > 0))
+	if ((changed = g_hash_table_size (priv->settings) > 0)) {
 		g_hash_table_foreach_remove (priv->settings, _setting_release_hfr, connection);
+		_version_bump (connection);
+	}
 
 	if (g_hash_table_size (new_priv->settings)) {
 		g_hash_table_iter_init (&iter, new_priv->settings);
@@ -520,7 +584,7 @@ nm_connection_replace_settings_from_connection (NMConnection *connection,
 	}
 
 	if (changed)
-		g_signal_emit (connection, signals[CHANGED], 0);
+		_signal_emit_changed (connection);
 }
 
 /**
@@ -540,7 +604,7 @@ nm_connection_clear_settings (NMConnection *connection)
 
 	if (g_hash_table_size (priv->settings) > 0) {
 		g_hash_table_foreach_remove (priv->settings, _setting_release_hfr, connection);
-		g_signal_emit (connection, signals[CHANGED], 0);
+		_signal_emit_changed (connection);
 	}
 }
 
@@ -1387,8 +1451,8 @@ nm_connection_verify (NMConnection *connection, GError **error)
 	return result == NM_SETTING_VERIFY_SUCCESS || result == NM_SETTING_VERIFY_NORMALIZABLE;
 }
 
-NMSettingVerifyResult
-_nm_connection_verify (NMConnection *connection, GError **error)
+static NMSettingVerifyResult
+_connection_verify (NMConnection *connection, GError **error)
 {
 	NMConnectionPrivate *priv;
 	NMSettingConnection *s_con;
@@ -1400,9 +1464,6 @@ _nm_connection_verify (NMConnection *connection, GError **error)
 	gs_free_error GError *normalizable_error = NULL;
 	NMSettingVerifyResult normalizable_error_type = NM_SETTING_VERIFY_SUCCESS;
 
-	g_return_val_if_fail (NM_IS_CONNECTION (connection), NM_SETTING_VERIFY_ERROR);
-	g_return_val_if_fail (!error || !*error, NM_SETTING_VERIFY_ERROR);
-
 	priv = NM_CONNECTION_GET_PRIVATE (connection);
 
 	/* First, make sure there's at least 'connection' setting */
@@ -1557,6 +1618,54 @@ _nm_connection_verify (NMConnection *connection, GError **error)
 	return NM_SETTING_VERIFY_SUCCESS;
 }
 
+NMSettingVerifyResult
+_nm_connection_verify (NMConnection *connection, GError **error)
+{
+	NMConnectionPrivate *priv;
+	NMSettingVerifyResult result;
+	GError *local = NULL;
+	guint64 version_id;
+
+	g_return_val_if_fail (NM_IS_CONNECTION (connection), NM_SETTING_VERIFY_ERROR);
+	g_return_val_if_fail (!error || !*error, NM_SETTING_VERIFY_ERROR);
+
+	priv = NM_CONNECTION_GET_PRIVATE (connection);
+
+	/* Verifying the same, unmodified connection over and over is common.
+	 * Reuse the previous result as long as the connection did not change. */
+	version_id = _nm_connection_get_version_id (connection);
+	if (priv->verify_cache.version_id == version_id) {
+#if NM_MORE_ASSERTS > 5
+		{
+			gs_free_error GError *error2 = NULL;
+
+			/* the cache is only correct, if all modifications of the connection
+			 * bump the version. Check that. */
+			result = _connection_verify (connection, &error2);
+			nm_assert (result == priv->verify_cache.result);
+			nm_assert ((!error2) == (!priv->verify_cache.error));
+			nm_assert (   !error2
+			           || nm_streq (error2->message, priv->verify_cache.error->message));
+		}
+#endif
+		if (   error
+		    && priv->verify_cache.error)
+			*error = g_error_copy (priv->verify_cache.error);
+		return priv->verify_cache.result;
+	}
+
+	result = _connection_verify (connection, &local);
+
+	g_clear_error (&priv->verify_cache.error);
+	priv->verify_cache.version_id = version_id;
+	priv->verify_cache.result = result;
+	if (local) {
+		priv->verify_cache.error = g_error_copy (local);
+		g_propagate_error (error, local);
+	}
+	return result;
+}
+
 /**
  * nm_connection_verify_secrets:
  * @connection: the #NMConnection to verify in
@@ -1941,8 +2050,10 @@ nm_connection_update_secrets (NMConnection *connection,
 		}
 	}
 
-	if (updated)
+	if (updated) {
+		_version_bump (connection);
 		g_signal_emit (connection, signals[SECRETS_UPDATED], 0, setting_name);
+	}
 
 	return success;
 }
@@ -2047,6 +2158,7 @@ nm_connection_clear_secrets_with_flags (NMConnection *connection,
 		g_signal_handlers_unblock_by_func (setting, (GCallback) setting_changed_cb, connection);
 	}
 
+	_version_bump (connection);
 	g_signal_emit (connection, signals[SECRETS_CLEARED], 0);
 }
 
@@ -3299,6 +3411,7 @@ nm_connection_private_free (NMConnectionPrivate *priv)
 	g_hash_table_foreach_remove (priv->settings, _setting_release_hfr, self);
 	g_hash_table_destroy (priv->settings);
 	g_free (priv->path);
+	g_clear_error (&priv->verify_cache.error);
 
 	g_slice_free (NMConnectionPrivate, priv);
 }
@@ -3320,6 +3433,7 @@ nm_connection_get_private (NMConnection *connection)
 		                         priv, (GDestroyNotify) nm_connection_private_free);
 
 		priv->self = connection;
+		priv->version_id = _nm_setting_version_id_new ();
 		priv->settings = g_hash_table_new_full (nm_direct_hash,
 		                                        NULL,
 		                                        NULL,
@@ -202,6 +202,8 @@ typedef enum {
 
 NMSettingVerifyResult _nm_connection_verify (NMConnection *connection, GError **error);
 
+guint64 _nm_connection_get_version_id (NMConnection *connection);
+
 gboolean _nm_connection_ensure_normalized (NMConnection *connection,
                                            gboolean allow_modify,
                                            const char *expected_uuid,
@@ -696,6 +698,16 @@ typedef GVariant *(*NMSettInfoPropGPropToDBusFcn)       (const GValue *from);
 typedef void      (*NMSettInfoPropGPropFromDBusFcn)     (GVariant *from,
                                                          GValue *to);
 
+typedef enum {
+	NM_SETT_INFO_PROPERTY_DIRECT_TYPE_NONE = 0,
+	NM_SETT_INFO_PROPERTY_DIRECT_TYPE_BOOLEAN,   /* gboolean, G_TYPE_BOOLEAN */
+	NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT32,     /* int, G_TYPE_INT */
+	NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32,    /* guint32, G_TYPE_UINT */
+	NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT64,     /* gint64, G_TYPE_INT64 */
+	NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT64,    /* guint64, G_TYPE_UINT64 */
+	NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,    /* char *, G_TYPE_STRING */
+} NMSettInfoPropertyDirectType;
+
 struct _NMSettInfoProperty {
 	const char *name;
 	GParamSpec *param_spec;
@@ -710,6 +722,13 @@ struct _NMSettInfoProperty {
 	 * on the GValue value of the GObject property. */
 	NMSettInfoPropGPropToDBusFcn       gprop_to_dbus_fcn;
 	NMSettInfoPropGPropFromDBusFcn     gprop_from_dbus_fcn;
+
+	/* If set, the value of the GObject property is stored as a plain field
+	 * at @direct_offset bytes from the instance pointer. Serialization, compare
+	 * and duplicate then access the field directly, instead of going through
+	 * g_object_get_property() and GValue. */
+	NMSettInfoPropertyDirectType       direct_type;
+	int                                direct_offset;
 };
 
 typedef struct {
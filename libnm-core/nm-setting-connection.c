@@ -1548,6 +1548,7 @@ nm_setting_connection_class_init (NMSettingConnectionClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	NMSettingClass *setting_class = NM_SETTING_CLASS (klass);
 	GArray *properties_override = _nm_sett_info_property_override_create_array ();
+	int private_offset;
 
 	g_type_class_add_private (klass, sizeof (NMSettingConnectionPrivate));
 
@@ -2179,6 +2180,62 @@ nm_setting_connection_class_init (NMSettingConnectionClass *klass)
 	                      G_PARAM_READWRITE |
 	                      G_PARAM_STATIC_STRINGS);
 
+	private_offset = g_type_class_get_instance_private_offset (klass);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_ID],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,
+	                                 private_offset, NMSettingConnectionPrivate, id);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_UUID],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,
+	                                 private_offset, NMSettingConnectionPrivate, uuid);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_STABLE_ID],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,
+	                                 private_offset, NMSettingConnectionPrivate, stable_id);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_TYPE],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,
+	                                 private_offset, NMSettingConnectionPrivate, type);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_AUTOCONNECT],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_BOOLEAN,
+	                                 private_offset, NMSettingConnectionPrivate, autoconnect);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_AUTOCONNECT_PRIORITY],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT32,
+	                                 private_offset, NMSettingConnectionPrivate, autoconnect_priority);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_AUTOCONNECT_RETRIES],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT32,
+	                                 private_offset, NMSettingConnectionPrivate, autoconnect_retries);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_MULTI_CONNECT],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT32,
+	                                 private_offset, NMSettingConnectionPrivate, multi_connect);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_TIMESTAMP],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT64,
+	                                 private_offset, NMSettingConnectionPrivate, timestamp);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_READ_ONLY],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_BOOLEAN,
+	                                 private_offset, NMSettingConnectionPrivate, read_only);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_ZONE],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,
+	                                 private_offset, NMSettingConnectionPrivate, zone);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_MASTER],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,
+	                                 private_offset, NMSettingConnectionPrivate, master);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_SLAVE_TYPE],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,
+	                                 private_offset, NMSettingConnectionPrivate, slave_type);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_GATEWAY_PING_TIMEOUT],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32,
+	                                 private_offset, NMSettingConnectionPrivate, gateway_ping_timeout);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_LLDP],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT32,
+	                                 private_offset, NMSettingConnectionPrivate, lldp);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_AUTH_RETRIES],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT32,
+	                                 private_offset, NMSettingConnectionPrivate, auth_retries);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_MDNS],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT32,
+	                                 private_offset, NMSettingConnectionPrivate, mdns);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_LLMNR],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT32,
+	                                 private_offset, NMSettingConnectionPrivate, llmnr);
+
 	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
 
 	_nm_setting_class_commit_full (setting_class, NM_META_SETTING_TYPE_CONNECTION,
@@ -41,6 +41,9 @@ int _nm_setting_compare_priority (gconstpointer a, gconstpointer b);
 
 void _nm_setting_emit_property_changed (NMSetting *setting);
 
+guint64 _nm_setting_version_id_new (void);
+guint64 _nm_setting_get_version_id (NMSetting *setting);
+
 typedef enum NMSettingUpdateSecretResult {
 	NM_SETTING_UPDATE_SECRET_ERROR              = FALSE,
 	NM_SETTING_UPDATE_SECRET_SUCCESS_MODIFIED   = TRUE,
@@ -171,6 +174,32 @@ void _properties_override_add__helper (GArray *properties_override,
 	(_properties_override_add_struct (properties_override, \
 	                                  NM_SETT_INFO_PROPERTY (__VA_ARGS__)))
 
+/**
+ * _properties_override_add_direct:
+ * @properties_override: an array collecting the overrides
+ * @prop_param_spec: the param spec of the property.
+ * @prop_direct_type: a #NMSettInfoPropertyDirectType matching the field and the
+ *   value type of @prop_param_spec.
+ * @private_offset: the offset of the private data from the instance pointer,
+ *   as returned by g_type_class_get_instance_private_offset().
+ * @PrivateType: the type of the private data.
+ * @field: the name of the field in @PrivateType.
+ *
+ * Registers a property whose value is stored as is in @field, and whose
+ * D-Bus representation is the default one. Such properties are read directly
+ * from the private data of the setting, without GValue.
+ */
+#define _properties_override_add_direct(properties_override, \
+                                        prop_param_spec, \
+                                        prop_direct_type, \
+                                        private_offset, \
+                                        PrivateType, \
+                                        field) \
+	_properties_override_add ((properties_override), \
+	                          .param_spec    = (prop_param_spec), \
+	                          .direct_type   = (prop_direct_type), \
+	                          .direct_offset = (private_offset) + ((int) G_STRUCT_OFFSET (PrivateType, field)))
+
 void _properties_override_add_dbus_only (GArray *properties_override,
                                          const char *property_name,
                                          const GVariantType *dbus_type,
@@ -1200,6 +1200,7 @@ nm_setting_wired_class_init (NMSettingWiredClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	NMSettingClass *setting_class = NM_SETTING_CLASS (klass);
 	GArray *properties_override = _nm_sett_info_property_override_create_array ();
+	int private_offset;
 
 	g_type_class_add_private (klass, sizeof (NMSettingWiredPrivate));
 
@@ -1641,6 +1642,26 @@ nm_setting_wired_class_init (NMSettingWiredClass *klass)
 	                         G_PARAM_READWRITE |
 	                         G_PARAM_STATIC_STRINGS);
 
+	private_offset = g_type_class_get_instance_private_offset (klass);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_PORT],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,
+	                                 private_offset, NMSettingWiredPrivate, port);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_SPEED],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32,
+	                                 private_offset, NMSettingWiredPrivate, speed);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_DUPLEX],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,
+	                                 private_offset, NMSettingWiredPrivate, duplex);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_GENERATE_MAC_ADDRESS_MASK],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,
+	                                 private_offset, NMSettingWiredPrivate, generate_mac_address_mask);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_MTU],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32,
+	                                 private_offset, NMSettingWiredPrivate, mtu);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_S390_NETTYPE],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,
+	                                 private_offset, NMSettingWiredPrivate, s390_nettype);
+
 	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
 
 	_nm_setting_class_commit_full (setting_class, NM_META_SETTING_TYPE_WIRED,
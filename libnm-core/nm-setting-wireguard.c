@@ -2370,6 +2370,7 @@ nm_setting_wireguard_class_init (NMSettingWireGuardClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	NMSettingClass *setting_class = NM_SETTING_CLASS (klass);
 	GArray *properties_override = _nm_sett_info_property_override_create_array ();
+	int private_offset;
 
 	object_class->get_property = get_property;
 	object_class->set_property = set_property;
@@ -2498,6 +2499,14 @@ nm_setting_wireguard_class_init (NMSettingWireGuardClass *klass)
 	                                    _peers_dbus_only_synth,
 	                                    _peers_dbus_only_set);
 
+	private_offset = G_STRUCT_OFFSET (NMSettingWireGuard, _priv);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_FWMARK],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32,
+	                                 private_offset, NMSettingWireGuardPrivate, fwmark);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_MTU],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32,
+	                                 private_offset, NMSettingWireGuardPrivate, mtu);
+
 	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
 
 	_nm_setting_class_commit_full (setting_class, NM_META_SETTING_TYPE_WIREGUARD, NULL, properties_override);
@@ -1196,6 +1196,7 @@ nm_setting_wireless_class_init (NMSettingWirelessClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	NMSettingClass *setting_class = NM_SETTING_CLASS (klass);
 	GArray *properties_override = _nm_sett_info_property_override_create_array ();
+	int private_offset;
 
 	g_type_class_add_private (klass, sizeof (NMSettingWirelessPrivate));
 
@@ -1721,6 +1722,38 @@ nm_setting_wireless_class_init (NMSettingWirelessClass *klass)
 	                       G_PARAM_READWRITE |
 	                       G_PARAM_STATIC_STRINGS);
 
+	private_offset = g_type_class_get_instance_private_offset (klass);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_MODE],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,
+	                                 private_offset, NMSettingWirelessPrivate, mode);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_BAND],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,
+	                                 private_offset, NMSettingWirelessPrivate, band);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_CHANNEL],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32,
+	                                 private_offset, NMSettingWirelessPrivate, channel);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_RATE],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32,
+	                                 private_offset, NMSettingWirelessPrivate, rate);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_TX_POWER],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32,
+	                                 private_offset, NMSettingWirelessPrivate, tx_power);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_GENERATE_MAC_ADDRESS_MASK],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING,
+	                                 private_offset, NMSettingWirelessPrivate, generate_mac_address_mask);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_MTU],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32,
+	                                 private_offset, NMSettingWirelessPrivate, mtu);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_HIDDEN],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_BOOLEAN,
+	                                 private_offset, NMSettingWirelessPrivate, hidden);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_POWERSAVE],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32,
+	                                 private_offset, NMSettingWirelessPrivate, powersave);
+	_properties_override_add_direct (properties_override, obj_properties[PROP_WAKE_ON_WLAN],
+	                                 NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32,
+	                                 private_offset, NMSettingWirelessPrivate, wowl);
+
 	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
 
 	_nm_setting_class_commit_full (setting_class, NM_META_SETTING_TYPE_WIRELESS,
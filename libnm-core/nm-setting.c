@@ -60,6 +60,14 @@ NM_GOBJECT_PROPERTIES_DEFINE (NMSetting,
 
 typedef struct {
 	GenData *gendata;
+
+	/* identifies the content of the setting. Two settings with the same, non-zero
+	 * content-id are known to be identical. It gets reset whenever the setting
+	 * changes, and is only assigned lazily when duplicating the setting. */
+	guint64 content_id;
+
+	/* the version-id of the last modification, see _nm_setting_version_id_new(). */
+	guint64 version_id;
 } NMSettingPrivate;
 
 G_DEFINE_ABSTRACT_TYPE (NMSetting, nm_setting, G_TYPE_OBJECT)
@@ -216,6 +224,22 @@ _gprop_to_dbus_fcn_flags (const GValue *val)
 	return g_variant_new_uint32 (g_value_get_flags (val));
 }
 
+static GType
+_property_direct_type_to_gtype (NMSettInfoPropertyDirectType direct_type)
+{
+	switch (direct_type) {
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_BOOLEAN: return G_TYPE_BOOLEAN;
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT32:   return G_TYPE_INT;
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32:  return G_TYPE_UINT;
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT64:   return G_TYPE_INT64;
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT64:  return G_TYPE_UINT64;
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING:  return G_TYPE_STRING;
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_NONE:
+		break;
+	}
+	return G_TYPE_INVALID;
+}
+
 void
 _properties_override_add_struct (GArray *properties_override,
                                  const NMSettInfoProperty *prop_info)
@@ -240,6 +264,13 @@ _properties_override_add_struct (GArray *properties_override,
 	nm_assert (!prop_info->gprop_to_dbus_fcn   || prop_info->param_spec);
 	nm_assert (!prop_info->gprop_from_dbus_fcn || prop_info->param_spec);
 
+	nm_assert (   prop_info->direct_type == NM_SETT_INFO_PROPERTY_DIRECT_TYPE_NONE
+	           || (   prop_info->param_spec
+	               && !prop_info->to_dbus_fcn
+	               && !prop_info->gprop_to_dbus_fcn
+	               && prop_info->direct_offset != 0
+	               && prop_info->param_spec->value_type == _property_direct_type_to_gtype (prop_info->direct_type)));
+
 	g_array_append_vals (properties_override, prop_info, 1);
 
 	if (!prop_info->name) {
@@ -439,6 +470,102 @@ _property_infos_sort (const NMSettInfoProperty *property_infos,
 	return arr;
 }
 
+/*****************************************************************************/
+
+/**
+ * _nm_setting_version_id_new:
+ *
+ * Returns: a new, non-zero version-id. Version-ids are handed out from
+ *   a global counter, so a later modification always has a larger id
+ *   than any earlier one, regardless of the setting.
+ */
+guint64
+_nm_setting_version_id_new (void)
+{
+	G_LOCK_DEFINE_STATIC (lock);
+	static guint64 id_counter;
+	guint64 id;
+
+	G_LOCK (lock);
+	id = ++id_counter;
+	G_UNLOCK (lock);
+	return id;
+}
+
+/**
+ * _nm_setting_get_version_id:
+ * @setting: the #NMSetting
+ *
+ * Returns: the version-id of the last modification of @setting, or
+ *   zero if it was never modified.
+ */
+guint64
+_nm_setting_get_version_id (NMSetting *setting)
+{
+	return NM_SETTING_GET_PRIVATE (setting)->version_id;
+}
+
+static void
+_setting_changed (NMSetting *setting)
+{
+	NMSettingPrivate *priv = NM_SETTING_GET_PRIVATE (setting);
+
+	priv->version_id = _nm_setting_version_id_new ();
+
+	/* any change invalidates the content-id. */
+	priv->content_id = 0;
+}
+
+NM_CACHED_QUARK_FCN ("nm-setting-set-property", _set_property_quark)
+
+static void
+_set_property_hooked (GObject *object,
+                      guint prop_id,
+                      const GValue *value,
+                      GParamSpec *pspec)
+{
+	GObjectSetPropertyFunc set_property;
+
+	set_property = g_type_get_qdata (pspec->owner_type, _set_property_quark ());
+	nm_assert (set_property);
+
+	/* the "notify" signal might be frozen and emitted much later. Track the
+	 * modification already now. */
+	_setting_changed (NM_SETTING (object));
+
+	set_property (object, prop_id, value, pspec);
+}
+
+static void
+_set_property_hook (GParamSpec *const*property_specs,
+                    guint n_property_specs)
+{
+	guint i;
+
+	/* GObject invokes the set_property() of the class that installed the
+	 * property. That is not necessarily the committed class itself, for
+	 * example with NMSettingIPConfig. Hook all of them, once. */
+	for (i = 0; i < n_property_specs; i++) {
+		GParamSpec *pspec = property_specs[i];
+		GObjectClass *owner_class;
+
+		if (!NM_FLAGS_HAS (pspec->flags, G_PARAM_WRITABLE))
+			continue;
+		if (g_type_get_qdata (pspec->owner_type, _set_property_quark ()))
+			continue;
+
+		owner_class = g_type_class_peek (pspec->owner_type);
+		nm_assert (owner_class);
+		nm_assert (owner_class->set_property);
+		nm_assert (owner_class->set_property != _set_property_hooked);
+
+		g_type_set_qdata (pspec->owner_type, _set_property_quark (), owner_class->set_property);
+		owner_class->set_property = _set_property_hooked;
+	}
+}
+
+/*****************************************************************************/
+
 void
 _nm_setting_class_commit_full (NMSettingClass *setting_class,
                                NMMetaSettingType meta_type,
@@ -469,6 +596,8 @@ _nm_setting_class_commit_full (NMSettingClass *setting_class,
 	property_specs = g_object_class_list_properties (G_OBJECT_CLASS (setting_class),
 	                                                 &n_property_specs);
 
+	_set_property_hook (property_specs, n_property_specs);
+
 #if NM_MORE_ASSERTS > 10
 	/* assert that properties_override is constructed consistently. */
 	for (i = 0; i < override_len; i++) {
@@ -616,6 +745,8 @@ _nm_setting_class_get_sett_info (NMSettingClass *setting_class)
 void
 _nm_setting_emit_property_changed (NMSetting *setting)
 {
+	_setting_changed (setting);
+
 	/* Some settings have "properties" that are not implemented as GObject properties.
 	 *
 	 * For example:
@@ -642,6 +773,32 @@ _nm_setting_emit_property_changed (NMSetting *setting)
 
 /*****************************************************************************/
 
+static guint64
+_content_id_ensure (NMSetting *setting)
+{
+	G_LOCK_DEFINE_STATIC (lock);
+	static guint64 id_counter;
+	NMSettingPrivate *priv = NM_SETTING_GET_PRIVATE (setting);
+
+	if (priv->content_id == 0) {
+		G_LOCK (lock);
+		priv->content_id = ++id_counter;
+		G_UNLOCK (lock);
+	}
+	return priv->content_id;
+}
+
+static gboolean
+_content_id_equal (NMSetting *a, NMSetting *b)
+{
+	guint64 content_id = NM_SETTING_GET_PRIVATE (a)->content_id;
+
+	return    content_id != 0
+	       && content_id == NM_SETTING_GET_PRIVATE (b)->content_id;
+}
+
+/*****************************************************************************/
+
 gboolean
 _nm_setting_use_legacy_property (NMSetting *setting,
                                  GVariant *connection_dict,
@@ -680,6 +837,143 @@ _nm_setting_use_legacy_property (NMSetting *setting,
 
 /*****************************************************************************/
 
+#define _property_direct_ptr(property_info, setting, type) \
+	((type *) G_STRUCT_MEMBER_P ((setting), (property_info)->direct_offset))
+
+static GVariant *
+_property_direct_to_dbus (const NMSettInfoProperty *property_info,
+                          NMSetting *setting,
+                          gboolean ignore_default)
+{
+	GParamSpec *pspec = property_info->param_spec;
+	GVariant *variant;
+
+	switch (property_info->direct_type) {
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_BOOLEAN: {
+		gboolean v = !!*_property_direct_ptr (property_info, setting, gboolean);
+
+		if (   ignore_default
+		    && v == (!!G_PARAM_SPEC_BOOLEAN (pspec)->default_value))
+			return NULL;
+		variant = g_variant_new_boolean (v);
+		break;
+	}
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT32: {
+		int v = *_property_direct_ptr (property_info, setting, int);
+
+		if (   ignore_default
+		    && v == G_PARAM_SPEC_INT (pspec)->default_value)
+			return NULL;
+		variant = g_variant_new_int32 (v);
+		break;
+	}
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32: {
+		guint32 v = *_property_direct_ptr (property_info, setting, guint32);
+
+		if (   ignore_default
+		    && v == G_PARAM_SPEC_UINT (pspec)->default_value)
+			return NULL;
+		variant = g_variant_new_uint32 (v);
+		break;
+	}
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT64: {
+		gint64 v = *_property_direct_ptr (property_info, setting, gint64);
+
+		if (   ignore_default
+		    && v == G_PARAM_SPEC_INT64 (pspec)->default_value)
+			return NULL;
+		variant = g_variant_new_int64 (v);
+		break;
+	}
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT64: {
+		guint64 v = *_property_direct_ptr (property_info, setting, guint64);
+
+		if (   ignore_default
+		    && v == G_PARAM_SPEC_UINT64 (pspec)->default_value)
+			return NULL;
+		variant = g_variant_new_uint64 (v);
+		break;
+	}
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING: {
+		const char *v = *_property_direct_ptr (property_info, setting, char *);
+
+		if (   ignore_default
+		    && nm_streq0 (v, G_PARAM_SPEC_STRING (pspec)->default_value))
+			return NULL;
+		/* like g_dbus_gvalue_to_gvariant(), a %NULL string is sent as "". */
+		variant = g_variant_new_string (v ?: "");
+		break;
+	}
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_NONE:
+	default:
+		nm_assert_not_reached ();
+		return NULL;
+	}
+
+	return g_variant_ref_sink (variant);
+}
+
+static gboolean
+_property_direct_equal (const NMSettInfoProperty *property_info,
+                        NMSetting *set_a,
+                        NMSetting *set_b)
+{
+	switch (property_info->direct_type) {
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_BOOLEAN:
+		return    (!!*_property_direct_ptr (property_info, set_a, gboolean))
+		       == (!!*_property_direct_ptr (property_info, set_b, gboolean));
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT32:
+		return *_property_direct_ptr (property_info, set_a, int) == *_property_direct_ptr (property_info, set_b, int);
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32:
+		return *_property_direct_ptr (property_info, set_a, guint32) == *_property_direct_ptr (property_info, set_b, guint32);
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT64:
+		return *_property_direct_ptr (property_info, set_a, gint64) == *_property_direct_ptr (property_info, set_b, gint64);
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT64:
+		return *_property_direct_ptr (property_info, set_a, guint64) == *_property_direct_ptr (property_info, set_b, guint64);
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING:
+		return nm_streq0 (*_property_direct_ptr (property_info, set_a, char *),
+		                  *_property_direct_ptr (property_info, set_b, char *));
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_NONE:
+		break;
+	}
+	nm_assert_not_reached ();
+	return FALSE;
+}
+
+static void
+_property_direct_copy (const NMSettInfoProperty *property_info,
+                       NMSetting *src,
+                       NMSetting *dst)
+{
+	switch (property_info->direct_type) {
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_BOOLEAN:
+		*_property_direct_ptr (property_info, dst, gboolean) = *_property_direct_ptr (property_info, src, gboolean);
+		return;
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT32:
+		*_property_direct_ptr (property_info, dst, int) = *_property_direct_ptr (property_info, src, int);
+		return;
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT32:
+		*_property_direct_ptr (property_info, dst, guint32) = *_property_direct_ptr (property_info, src, guint32);
+		return;
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_INT64:
+		*_property_direct_ptr (property_info, dst, gint64) = *_property_direct_ptr (property_info, src, gint64);
+		return;
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_UINT64:
+		*_property_direct_ptr (property_info, dst, guint64) = *_property_direct_ptr (property_info, src, guint64);
+		return;
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_STRING: {
+		char **p_dst = _property_direct_ptr (property_info, dst, char *);
+
+		g_free (*p_dst);
+		*p_dst = g_strdup (*_property_direct_ptr (property_info, src, char *));
+		return;
+	}
+	case NM_SETT_INFO_PROPERTY_DIRECT_TYPE_NONE:
+		break;
+	}
+	nm_assert_not_reached ();
+}
+
 static GVariant *
 property_to_dbus (const NMSettInfoSetting *sett_info,
                   guint property_idx,
@@ -729,7 +1023,9 @@ property_to_dbus (const NMSettInfoSetting *sett_info,
 	if (property->to_dbus_fcn) {
 		variant = property->to_dbus_fcn (sett_info, property_idx, connection, setting, flags);
 		nm_g_variant_take_ref (variant);
-	} else {
+	} else if (property->direct_type != NM_SETT_INFO_PROPERTY_DIRECT_TYPE_NONE)
+		variant = _property_direct_to_dbus (property, setting, ignore_default);
+	else {
 		nm_auto_unset_gvalue GValue prop_value = { 0, };
 
 		nm_assert (property->param_spec);
@@ -1200,6 +1496,13 @@ duplicate_copy_properties (const NMSettInfoSetting *sett_info,
 				if ((property_info->param_spec->flags & (G_PARAM_WRITABLE | G_PARAM_CONSTRUCT_ONLY)) != G_PARAM_WRITABLE)
 					continue;
 
+				if (property_info->direct_type != NM_SETT_INFO_PROPERTY_DIRECT_TYPE_NONE) {
+					/* @dst is a new instance, nobody is subscribed to its
+					 * notifications yet. We can set the field directly. */
+					_property_direct_copy (property_info, src, dst);
+					continue;
+				}
+
 				if (!frozen) {
 					g_object_freeze_notify (G_OBJECT (dst));
 					frozen = TRUE;
@@ -1245,6 +1548,9 @@ nm_setting_duplicate (NMSetting *setting)
 	nm_assert (sett_info);
 
 	klass->duplicate_copy_properties (sett_info, setting, dst);
+
+	/* the copy is identical to the original (until one of them changes). */
+	NM_SETTING_GET_PRIVATE (dst)->content_id = _content_id_ensure (setting);
 	return dst;
 }
 
@@ -1455,6 +1761,12 @@ compare_property (const NMSettInfoSetting *sett_info,
 		gs_unref_variant GVariant *value1  = NULL;
 		gs_unref_variant GVariant *value2  = NULL;
 
+		if (property_info->direct_type != NM_SETT_INFO_PROPERTY_DIRECT_TYPE_NONE) {
+			return   _property_direct_equal (property_info, set_a, set_b)
+			       ? NM_TERNARY_TRUE
+			       : NM_TERNARY_FALSE;
+		}
+
 		value1 = property_to_dbus (sett_info, property_idx, con_a, set_a, NM_CONNECTION_SERIALIZE_ALL, TRUE, TRUE);
 		value2 = property_to_dbus (sett_info, property_idx, con_b, set_b, NM_CONNECTION_SERIALIZE_ALL, TRUE, TRUE);
 		if (nm_property_compare (value1, value2) != 0)
@@ -1522,26 +1834,16 @@ nm_setting_compare (NMSetting *a,
 	return _nm_setting_compare (NULL, a, NULL, b, flags);
 }
 
-gboolean
-_nm_setting_compare (NMConnection *con_a,
-                     NMSetting *a,
-                     NMConnection *con_b,
-                     NMSetting *b,
-                     NMSettingCompareFlags flags)
+static gboolean
+_setting_compare (NMConnection *con_a,
+                  NMSetting *a,
+                  NMConnection *con_b,
+                  NMSetting *b,
+                  NMSettingCompareFlags flags)
 {
 	const NMSettInfoSetting *sett_info;
 	guint i;
 
-	g_return_val_if_fail (NM_IS_SETTING (a), FALSE);
-	g_return_val_if_fail (NM_IS_SETTING (b), FALSE);
-
-	nm_assert (!con_a || NM_IS_CONNECTION (con_a));
-	nm_assert (!con_b || NM_IS_CONNECTION (con_b));
-
-	/* First check that both have the same type */
-	if (G_OBJECT_TYPE (a) != G_OBJECT_TYPE (b))
-		return FALSE;
-
 	sett_info = _nm_setting_class_get_sett_info (NM_SETTING_GET_CLASS (a));
 
 	if (sett_info->detail.gendata_info) {
@@ -1562,6 +1864,35 @@ _nm_setting_compare (NMConnection *con_a,
 	return TRUE;
 }
 
+gboolean
+_nm_setting_compare (NMConnection *con_a,
+                     NMSetting *a,
+                     NMConnection *con_b,
+                     NMSetting *b,
+                     NMSettingCompareFlags flags)
+{
+	g_return_val_if_fail (NM_IS_SETTING (a), FALSE);
+	g_return_val_if_fail (NM_IS_SETTING (b), FALSE);
+
+	nm_assert (!con_a || NM_IS_CONNECTION (con_a));
+	nm_assert (!con_b || NM_IS_CONNECTION (con_b));
+
+	/* First check that both have the same type */
+	if (G_OBJECT_TYPE (a) != G_OBJECT_TYPE (b))
+		return FALSE;
+
+	if (_content_id_equal (a, b)) {
+		/* the settings are unmodified copies of each other. They compare
+		 * equal regardless of the flags, so skip comparing the properties. */
+#if NM_MORE_ASSERTS > 5
+		nm_assert (_setting_compare (con_a, a, con_b, b, flags));
+#endif
+		return TRUE;
+	}
+
+	return _setting_compare (con_a, a, con_b, b, flags);
+}
+
 static void
 _setting_diff_add_result (GHashTable *results, const char *prop_name, NMSettingDiffResult r)
 {
@@ -1637,6 +1968,15 @@ _nm_setting_diff (NMConnection *con_a,
 	nm_assert (!con_a || NM_IS_CONNECTION (con_a));
 	nm_assert (!con_b || NM_IS_CONNECTION (con_b));
 
+	if (   b
+	    && _content_id_equal (a, b)) {
+		/* unmodified copies of each other have no differences to report. */
+#if NM_MORE_ASSERTS > 5
+		nm_assert (_setting_compare (con_a, a, con_b, b, flags));
+#endif
+		return TRUE;
+	}
+
 	if ((flags & (NM_SETTING_COMPARE_FLAG_DIFF_RESULT_WITH_DEFAULT | NM_SETTING_COMPARE_FLAG_DIFF_RESULT_NO_DEFAULT)) ==
 	             (NM_SETTING_COMPARE_FLAG_DIFF_RESULT_WITH_DEFAULT | NM_SETTING_COMPARE_FLAG_DIFF_RESULT_NO_DEFAULT)) {
 		/* conflicting flags: default to WITH_DEFAULT (clearing NO_DEFAULT). */
@@ -2697,6 +3037,18 @@ nm_setting_init (NMSetting *setting)
 {
 }
 
+static void
+dispatch_properties_changed (GObject *object,
+                             guint n_pspecs,
+                             GParamSpec **pspecs)
+{
+	/* changes via g_object_set() were already recorded by _set_property_hooked().
+	 * This catches the C setters, which modify the field and only notify. */
+	_setting_changed (NM_SETTING (object));
+
+	G_OBJECT_CLASS (nm_setting_parent_class)->dispatch_properties_changed (object, n_pspecs, pspecs);
+}
+
 static void
 finalize (GObject *object)
 {
@@ -2719,8 +3071,9 @@ nm_setting_class_init (NMSettingClass *setting_class)
 
 	g_type_class_add_private (setting_class, sizeof (NMSettingPrivate));
 
-	object_class->get_property = get_property;
-	object_class->finalize     = finalize;
+	object_class->get_property                = get_property;
+	object_class->dispatch_properties_changed = dispatch_properties_changed;
+	object_class->finalize                    = finalize;
 
 	setting_class->update_one_secret         = update_one_secret;
 	setting_class->get_secret_flags          = get_secret_flags;
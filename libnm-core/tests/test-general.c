@@ -4592,6 +4592,78 @@ test_connection_normalize_uuid (void)
 
 /*****************************************************************************/
 
+static void
+test_connection_verify_cache (void)
+{
+	gs_unref_object NMConnection *con = NULL;
+	gs_free_error GError *error = NULL;
+	NMSettingConnection *s_con;
+	NMSettingIPConfig *s_ip4;
+	NMIPAddress *addr;
+	guint64 version_id;
+
+	con = nmtst_create_minimal_connection ("test1", NULL, NM_SETTING_WIRED_SETTING_NAME, &s_con);
+	nmtst_connection_normalize (con);
+
+	version_id = _nm_connection_get_version_id (con);
+	g_assert_cmpint (_nm_connection_verify (con, NULL), ==, NM_SETTING_VERIFY_SUCCESS);
+	g_assert_cmpint (_nm_connection_verify (con, NULL), ==, NM_SETTING_VERIFY_SUCCESS);
+	g_assert_cmpint (version_id, ==, _nm_connection_get_version_id (con));
+
+	/* modifying a setting invalidates the cached result. */
+	g_object_set (s_con, NM_SETTING_CONNECTION_ID, NULL, NULL);
+	g_assert_cmpint (version_id, !=, _nm_connection_get_version_id (con));
+	g_assert_cmpint (_nm_connection_verify (con, &error), ==, NM_SETTING_VERIFY_ERROR);
+	g_assert_error (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_MISSING_PROPERTY);
+	g_clear_error (&error);
+
+	/* a cached failure still returns the error. */
+	g_assert_cmpint (_nm_connection_verify (con, &error), ==, NM_SETTING_VERIFY_ERROR);
+	g_assert_error (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_MISSING_PROPERTY);
+	g_clear_error (&error);
+
+	g_object_set (s_con, NM_SETTING_CONNECTION_ID, "test2", NULL);
+	g_assert_cmpint (_nm_connection_verify (con, NULL), ==, NM_SETTING_VERIFY_SUCCESS);
+
+	/* removing a setting invalidates the cached result too. */
+	version_id = _nm_connection_get_version_id (con);
+	nm_connection_remove_setting (con, NM_TYPE_SETTING_WIRED);
+	g_assert_cmpint (version_id, !=, _nm_connection_get_version_id (con));
+	g_assert_cmpint (_nm_connection_verify (con, NULL), !=, NM_SETTING_VERIFY_SUCCESS);
+
+	nmtst_connection_normalize (con);
+	g_assert_cmpint (_nm_connection_verify (con, NULL), ==, NM_SETTING_VERIFY_SUCCESS);
+
+	/* the change is seen right away, not only when the notification
+	 * is emitted. */
+	g_object_freeze_notify (G_OBJECT (s_con));
+	g_object_set (s_con, NM_SETTING_CONNECTION_ID, NULL, NULL);
+	g_assert_cmpint (_nm_connection_verify (con, NULL), ==, NM_SETTING_VERIFY_ERROR);
+	g_object_set (s_con, NM_SETTING_CONNECTION_ID, "test3", NULL);
+	g_assert_cmpint (_nm_connection_verify (con, NULL), ==, NM_SETTING_VERIFY_SUCCESS);
+	g_object_thaw_notify (G_OBJECT (s_con));
+
+	/* also for properties that are installed by a parent class. */
+	s_ip4 = nm_connection_get_setting_ip4_config (con);
+	g_assert (s_ip4);
+	version_id = _nm_connection_get_version_id (con);
+	g_object_freeze_notify (G_OBJECT (s_ip4));
+	g_object_set (s_ip4, NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP4_CONFIG_METHOD_MANUAL, NULL);
+	g_assert_cmpint (version_id, !=, _nm_connection_get_version_id (con));
+	g_assert_cmpint (_nm_connection_verify (con, NULL), ==, NM_SETTING_VERIFY_ERROR);
+	g_object_thaw_notify (G_OBJECT (s_ip4));
+
+	/* and for C setters, which only emit a notification. */
+	version_id = _nm_connection_get_version_id (con);
+	addr = nm_ip_address_new (AF_INET, "192.168.1.5", 24, NULL);
+	nm_setting_ip_config_add_address (s_ip4, addr);
+	nm_ip_address_unref (addr);
+	g_assert_cmpint (version_id, !=, _nm_connection_get_version_id (con));
+	g_assert_cmpint (_nm_connection_verify (con, NULL), ==, NM_SETTING_VERIFY_SUCCESS);
+}
+
+/*****************************************************************************/
+
 /*
  * Test normalization of interface-name
  */
@@ -8164,6 +8236,7 @@ int main (int argc, char **argv)
 	g_test_add_func ("/core/general/test_connection_new_from_dbus", test_connection_new_from_dbus);
 	g_test_add_func ("/core/general/test_connection_normalize_virtual_iface_name", test_connection_normalize_virtual_iface_name);
 	g_test_add_func ("/core/general/test_connection_normalize_uuid", test_connection_normalize_uuid);
+	g_test_add_func ("/core/general/test_connection_verify_cache", test_connection_verify_cache);
 	g_test_add_func ("/core/general/test_connection_normalize_type", test_connection_normalize_type);
 	g_test_add_func ("/core/general/test_connection_normalize_slave_type_1", test_connection_normalize_slave_type_1);
 	g_test_add_func ("/core/general/test_connection_normalize_slave_type_2", test_connection_normalize_slave_type_2);
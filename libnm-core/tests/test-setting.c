@@ -3279,6 +3279,294 @@ test_parse_tc_handle (void)
 
 /*****************************************************************************/
 
+static NMConnection *
+_create_wired_connection (void)
+{
+	NMConnection *con;
+	NMSettingConnection *s_con;
+	NMSetting *s_wired;
+
+	con = nmtst_create_minimal_connection ("wired", NULL, NM_SETTING_WIRED_SETTING_NAME, &s_con);
+	g_object_set (s_con,
+	              NM_SETTING_CONNECTION_INTERFACE_NAME, "eth0",
+	              NM_SETTING_CONNECTION_ZONE, "trusted",
+	              NM_SETTING_CONNECTION_AUTOCONNECT, FALSE,
+	              NM_SETTING_CONNECTION_AUTOCONNECT_PRIORITY, 50,
+	              NM_SETTING_CONNECTION_TIMESTAMP, (guint64) 1560000000,
+	              NM_SETTING_CONNECTION_LLDP, NM_SETTING_CONNECTION_LLDP_ENABLE_RX,
+	              NULL);
+
+	s_wired = nm_connection_get_setting (con, NM_TYPE_SETTING_WIRED);
+	g_object_set (s_wired,
+	              NM_SETTING_WIRED_PORT, "tp",
+	              NM_SETTING_WIRED_SPEED, (guint) 1000,
+	              NM_SETTING_WIRED_DUPLEX, "full",
+	              NM_SETTING_WIRED_MTU, (guint) 9000,
+	              NULL);
+
+	return con;
+}
+
+static void
+_benchmark_compare (gpointer user_data)
+{
+	nm_connection_compare (user_data, user_data, NM_SETTING_COMPARE_FLAG_EXACT);
+}
+
+static void
+_benchmark_duplicate (gpointer user_data)
+{
+	gs_unref_object NMConnection *con = NULL;
+
+	con = nm_simple_connection_new_clone (user_data);
+}
+
+static void
+_benchmark_to_dbus (gpointer user_data)
+{
+	gs_unref_variant GVariant *variant = NULL;
+
+	variant = g_variant_ref_sink (nm_connection_to_dbus (user_data, NM_CONNECTION_SERIALIZE_ALL));
+}
+
+static void
+test_setting_accessors (void)
+{
+	gs_unref_object NMConnection *con = NULL;
+	gs_unref_object NMConnection *con2 = NULL;
+	gs_unref_variant GVariant *variant = NULL;
+	gs_unref_variant GVariant *variant2 = NULL;
+	NMSettingConnection *s_con2;
+
+	con = _create_wired_connection ();
+
+	/* the direct property accessors must behave exactly like the
+	 * GValue based ones. */
+	con2 = nm_simple_connection_new_clone (con);
+	nmtst_assert_connection_equals (con, FALSE, con2, FALSE);
+
+	variant = nm_connection_to_dbus (con, NM_CONNECTION_SERIALIZE_ALL);
+	g_variant_ref_sink (variant);
+	g_clear_object (&con2);
+	con2 = _connection_new_from_dbus_strict (variant, FALSE);
+	nmtst_assert_connection_equals (con, FALSE, con2, FALSE);
+	variant2 = nm_connection_to_dbus (con2, NM_CONNECTION_SERIALIZE_ALL);
+	g_variant_ref_sink (variant2);
+	g_assert (g_variant_equal (variant, variant2));
+
+	s_con2 = nm_connection_get_setting_connection (con2);
+	g_object_set (s_con2, NM_SETTING_CONNECTION_ZONE, NULL, NULL);
+	g_assert (!nm_connection_compare (con, con2, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_object_set (s_con2, NM_SETTING_CONNECTION_ZONE, "trusted", NULL);
+	g_object_set (s_con2, NM_SETTING_CONNECTION_AUTOCONNECT_PRIORITY, 0, NULL);
+	g_assert (!nm_connection_compare (con, con2, NM_SETTING_COMPARE_FLAG_EXACT));
+
+	g_clear_object (&con2);
+	con2 = nm_simple_connection_new_clone (con);
+	g_assert (nm_connection_compare (con, con2, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_assert (nm_connection_diff (con, con2, NM_SETTING_COMPARE_FLAG_EXACT, NULL));
+
+	nmtst_benchmark ("compare", 100000, _benchmark_compare, con);
+	nmtst_benchmark ("duplicate", 100000, _benchmark_duplicate, con);
+	nmtst_benchmark ("to_dbus", 100000, _benchmark_to_dbus, con);
+}
+
+/* checks that each property, which must not have its default value, is
+ * serialized, duplicated and compared like its GValue says. */
+static void
+_assert_direct_accessors (NMConnection *con, const char *setting_name, const char *const*property_names)
+{
+	gs_unref_variant GVariant *variant = NULL;
+	gs_unref_variant GVariant *setting_dict = NULL;
+	gs_unref_object NMConnection *con2 = NULL;
+	NMSetting *setting;
+	guint i;
+
+	setting = nm_connection_get_setting_by_name (con, setting_name);
+	g_assert (setting);
+
+	variant = g_variant_ref_sink (nm_connection_to_dbus (con, NM_CONNECTION_SERIALIZE_ALL));
+	g_assert (g_variant_lookup (variant, setting_name, "@a{sv}", &setting_dict));
+
+	con2 = nm_simple_connection_new_clone (con);
+	g_assert (nm_connection_compare (con, con2, NM_SETTING_COMPARE_FLAG_EXACT));
+
+	for (i = 0; property_names[i]; i++) {
+		const char *name = property_names[i];
+		const NMSettInfoProperty *property_info;
+		gs_unref_variant GVariant *value_dbus = NULL;
+		gs_unref_variant GVariant *value_expected = NULL;
+		gs_unref_hashtable GHashTable *diffs = NULL;
+		GHashTable *setting_diffs;
+		nm_auto_unset_gvalue GValue value = G_VALUE_INIT;
+		nm_auto_unset_gvalue GValue value2 = G_VALUE_INIT;
+		GParamSpec *pspec;
+		NMSetting *setting2;
+
+		property_info = _nm_setting_class_get_property_info (NM_SETTING_GET_CLASS (setting), name);
+		g_assert (property_info);
+		g_assert (property_info->direct_type != NM_SETT_INFO_PROPERTY_DIRECT_TYPE_NONE);
+
+		pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (setting), name);
+		g_assert (pspec);
+		g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (pspec));
+		g_object_get_property (G_OBJECT (setting), name, &value);
+		g_assert (!g_param_value_defaults (pspec, &value));
+
+		value_dbus = g_variant_lookup_value (setting_dict, name, NULL);
+		g_assert (value_dbus);
+		value_expected = g_dbus_gvalue_to_gvariant (&value, g_variant_get_type (value_dbus));
+		g_assert (g_variant_equal (value_dbus, value_expected));
+
+		setting2 = nm_connection_get_setting_by_name (con2, setting_name);
+		g_value_init (&value2, G_PARAM_SPEC_VALUE_TYPE (pspec));
+		g_object_get_property (G_OBJECT (setting2), name, &value2);
+		g_assert (g_param_values_cmp (pspec, &value, &value2) == 0);
+
+		/* a difference in only this property is found. */
+		g_param_value_set_default (pspec, &value2);
+		g_object_set_property (G_OBJECT (setting2), name, &value2);
+		g_assert (!nm_connection_compare (con, con2, NM_SETTING_COMPARE_FLAG_EXACT));
+		g_assert (!nm_connection_diff (con, con2, NM_SETTING_COMPARE_FLAG_EXACT, &diffs));
+		g_assert_cmpint (g_hash_table_size (diffs), ==, 1);
+		setting_diffs = g_hash_table_lookup (diffs, setting_name);
+		g_assert (setting_diffs);
+		g_assert_cmpint (g_hash_table_size (setting_diffs), ==, 1);
+		g_assert (g_hash_table_contains (setting_diffs, name));
+
+		g_object_set_property (G_OBJECT (setting2), name, &value);
+		g_assert (nm_connection_compare (con, con2, NM_SETTING_COMPARE_FLAG_EXACT));
+	}
+}
+
+static void
+test_setting_accessors_wireless (void)
+{
+	gs_unref_object NMConnection *con = NULL;
+	gs_unref_bytes GBytes *ssid = NULL;
+
+	con = nmtst_create_minimal_connection ("wifi", NULL, NM_SETTING_WIRELESS_SETTING_NAME, NULL);
+	ssid = g_bytes_new_static ("wifi", 4);
+	g_object_set (nm_connection_get_setting_wireless (con),
+	              NM_SETTING_WIRELESS_SSID, ssid,
+	              NM_SETTING_WIRELESS_MODE, NM_SETTING_WIRELESS_MODE_ADHOC,
+	              NM_SETTING_WIRELESS_BAND, "bg",
+	              NM_SETTING_WIRELESS_CHANNEL, (guint) 6,
+	              NM_SETTING_WIRELESS_RATE, (guint) 54,
+	              NM_SETTING_WIRELESS_TX_POWER, (guint) 20,
+	              NM_SETTING_WIRELESS_GENERATE_MAC_ADDRESS_MASK, "FE:FF:FF:00:00:00",
+	              NM_SETTING_WIRELESS_MTU, (guint) 1400,
+	              NM_SETTING_WIRELESS_HIDDEN, TRUE,
+	              NM_SETTING_WIRELESS_POWERSAVE, (guint) NM_SETTING_WIRELESS_POWERSAVE_DISABLE,
+	              NM_SETTING_WIRELESS_WAKE_ON_WLAN, (guint) NM_SETTING_WIRELESS_WAKE_ON_WLAN_MAGIC,
+	              NULL);
+
+	_assert_direct_accessors (con,
+	                          NM_SETTING_WIRELESS_SETTING_NAME,
+	                          NM_MAKE_STRV (NM_SETTING_WIRELESS_MODE,
+	                                        NM_SETTING_WIRELESS_BAND,
+	                                        NM_SETTING_WIRELESS_CHANNEL,
+	                                        NM_SETTING_WIRELESS_RATE,
+	                                        NM_SETTING_WIRELESS_TX_POWER,
+	                                        NM_SETTING_WIRELESS_GENERATE_MAC_ADDRESS_MASK,
+	                                        NM_SETTING_WIRELESS_MTU,
+	                                        NM_SETTING_WIRELESS_HIDDEN,
+	                                        NM_SETTING_WIRELESS_POWERSAVE,
+	                                        NM_SETTING_WIRELESS_WAKE_ON_WLAN));
+}
+
+static void
+test_setting_accessors_wireguard (void)
+{
+	gs_unref_object NMConnection *con = NULL;
+
+	con = nmtst_create_minimal_connection ("wg", NULL, NM_SETTING_WIREGUARD_SETTING_NAME, NULL);
+	g_object_set (nm_connection_get_setting_by_name (con, NM_SETTING_WIREGUARD_SETTING_NAME),
+	              NM_SETTING_WIREGUARD_FWMARK, (guint) 0x42,
+	              NM_SETTING_WIREGUARD_MTU, (guint) 1420,
+	              NULL);
+
+	_assert_direct_accessors (con,
+	                          NM_SETTING_WIREGUARD_SETTING_NAME,
+	                          NM_MAKE_STRV (NM_SETTING_WIREGUARD_FWMARK,
+	                                        NM_SETTING_WIREGUARD_MTU));
+}
+
+/*****************************************************************************/
+
+static void
+_assert_diff_only (NMConnection *a, NMConnection *b, const char *setting_name)
+{
+	gs_unref_hashtable GHashTable *diffs = NULL;
+
+	g_assert (!nm_connection_compare (a, b, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_assert (!nm_connection_diff (a, b, NM_SETTING_COMPARE_FLAG_EXACT, &diffs));
+	g_assert (diffs);
+	g_assert_cmpint (g_hash_table_size (diffs), ==, 1);
+	g_assert (g_hash_table_contains (diffs, setting_name));
+}
+
+static void
+test_setting_content_id (void)
+{
+	gs_unref_object NMConnection *con = NULL;
+	gs_unref_object NMConnection *con2 = NULL;
+	NMSettingEthtool *s_ethtool;
+	NMSettingIPConfig *s_ip4;
+	NMIPAddress *addr;
+
+	con = _create_wired_connection ();
+	s_ethtool = NM_SETTING_ETHTOOL (nm_setting_ethtool_new ());
+	nm_connection_add_setting (con, NM_SETTING (s_ethtool));
+	nm_setting_ethtool_set_feature (s_ethtool, NM_ETHTOOL_OPTNAME_FEATURE_RX, NM_TERNARY_TRUE);
+	nmtst_connection_normalize (con);
+
+	/* a clone shares the content-id of all its settings and compares
+	 * equal without looking at the properties. */
+	con2 = nm_simple_connection_new_clone (con);
+	g_assert (nm_connection_compare (con, con2, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_assert (nm_connection_diff (con, con2, NM_SETTING_COMPARE_FLAG_EXACT, NULL));
+
+	/* modifying either side must invalidate the content-id... */
+	g_object_set (nm_connection_get_setting_wired (con2), NM_SETTING_WIRED_MTU, (guint) 1400, NULL);
+	_assert_diff_only (con, con2, NM_SETTING_WIRED_SETTING_NAME);
+
+	/* ...and restoring the value makes them compare equal again, by
+	 * comparing the properties. */
+	g_object_set (nm_connection_get_setting_wired (con2), NM_SETTING_WIRED_MTU, (guint) 9000, NULL);
+	g_assert (nm_connection_compare (con, con2, NM_SETTING_COMPARE_FLAG_EXACT));
+
+	/* gendata and non-GObject properties are tracked too. */
+	nm_setting_ethtool_set_feature (s_ethtool, NM_ETHTOOL_OPTNAME_FEATURE_RX, NM_TERNARY_FALSE);
+	_assert_diff_only (con, con2, NM_SETTING_ETHTOOL_SETTING_NAME);
+
+	g_clear_object (&con2);
+	con2 = nm_simple_connection_new_clone (con);
+	g_assert (nm_connection_compare (con, con2, NM_SETTING_COMPARE_FLAG_EXACT));
+
+	s_ip4 = nm_connection_get_setting_ip4_config (con2);
+	g_object_set (s_ip4, NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP4_CONFIG_METHOD_MANUAL, NULL);
+	g_object_set (nm_connection_get_setting_ip4_config (con), NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP4_CONFIG_METHOD_MANUAL, NULL);
+	g_assert (nm_connection_compare (con, con2, NM_SETTING_COMPARE_FLAG_EXACT));
+	addr = nm_ip_address_new (AF_INET, "192.168.1.5", 24, NULL);
+	nm_setting_ip_config_add_address (s_ip4, addr);
+	nm_ip_address_unref (addr);
+	_assert_diff_only (con, con2, NM_SETTING_IP4_CONFIG_SETTING_NAME);
+
+	/* the content-id is reset right away, not only when the frozen
+	 * notification is emitted. */
+	g_clear_object (&con2);
+	con2 = nm_simple_connection_new_clone (con);
+	g_assert (nm_connection_compare (con, con2, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_object_freeze_notify (G_OBJECT (nm_connection_get_setting_wired (con2)));
+	g_object_set (nm_connection_get_setting_wired (con2), NM_SETTING_WIRED_MTU, (guint) 1400, NULL);
+	g_assert (!nm_connection_compare (con, con2, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_object_thaw_notify (G_OBJECT (nm_connection_get_setting_wired (con2)));
+	_assert_diff_only (con, con2, NM_SETTING_WIRED_SETTING_NAME);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -3366,5 +3654,10 @@ main (int argc, char **argv)
 
 	g_test_add_func ("/libnm/test_team_setting", test_team_setting);
 
+	g_test_add_func ("/libnm/settings/accessors", test_setting_accessors);
+	g_test_add_func ("/libnm/settings/accessors/wireless", test_setting_accessors_wireless);
+	g_test_add_func ("/libnm/settings/accessors/wireguard", test_setting_accessors_wireguard);
+	g_test_add_func ("/libnm/settings/content-id", test_setting_content_id);
+
 	return g_test_run ();
 }
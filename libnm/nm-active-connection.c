@@ -282,7 +282,7 @@ nm_active_connection_get_ip4_config (NMActiveConnection *connection)
 {
 	g_return_val_if_fail (NM_IS_ACTIVE_CONNECTION (connection), NULL);
 
-	return NM_ACTIVE_CONNECTION_GET_PRIVATE (connection)->ip4_config;
+	return _nm_object_get_lazy_object (NM_OBJECT (connection), NM_ACTIVE_CONNECTION_IP4_CONFIG);
 }
 
 /**
@@ -301,7 +301,7 @@ nm_active_connection_get_dhcp4_config (NMActiveConnection *connection)
 {
 	g_return_val_if_fail (NM_IS_ACTIVE_CONNECTION (connection), NULL);
 
-	return NM_ACTIVE_CONNECTION_GET_PRIVATE (connection)->dhcp4_config;
+	return _nm_object_get_lazy_object (NM_OBJECT (connection), NM_ACTIVE_CONNECTION_DHCP4_CONFIG);
 }
 
 /**
@@ -335,7 +335,7 @@ nm_active_connection_get_ip6_config (NMActiveConnection *connection)
 {
 	g_return_val_if_fail (NM_IS_ACTIVE_CONNECTION (connection), NULL);
 
-	return NM_ACTIVE_CONNECTION_GET_PRIVATE (connection)->ip6_config;
+	return _nm_object_get_lazy_object (NM_OBJECT (connection), NM_ACTIVE_CONNECTION_IP6_CONFIG);
 }
 
 /**
@@ -354,7 +354,7 @@ nm_active_connection_get_dhcp6_config (NMActiveConnection *connection)
 {
 	g_return_val_if_fail (NM_IS_ACTIVE_CONNECTION (connection), NULL);
 
-	return NM_ACTIVE_CONNECTION_GET_PRIVATE (connection)->dhcp6_config;
+	return _nm_object_get_lazy_object (NM_OBJECT (connection), NM_ACTIVE_CONNECTION_DHCP6_CONFIG);
 }
 
 /**
@@ -116,6 +116,7 @@ typedef struct {
 	GCancellable *new_object_manager_cancellable;
 	struct udev *udev;
 	bool udev_inited:1;
+	bool lazy:1;
 } NMClientPrivate;
 
 enum {
@@ -147,6 +148,7 @@ enum {
 	PROP_DNS_RC_MANAGER,
 	PROP_DNS_CONFIGURATION,
 	PROP_CHECKPOINTS,
+	PROP_LAZY,
 
 	LAST_PROP
 };
@@ -2744,12 +2746,19 @@ obj_nm_for_gdbus_object (NMClient *self, GDBusObject *object, GDBusObjectManager
 	if (type == G_TYPE_INVALID)
 		return NULL;
 
+	priv = NM_CLIENT_GET_PRIVATE (self);
+
+	/* In lazy mode, these objects are created on first access by
+	 * _nm_object_get_lazy_object(). */
+	if (   priv->lazy
+	    && _nm_object_type_is_lazy (type))
+		return NULL;
+
 	obj_nm = g_object_new (type,
 	                       NM_OBJECT_DBUS_OBJECT, object,
 	                       NM_OBJECT_DBUS_OBJECT_MANAGER, object_manager,
 	                       NULL);
 	if (NM_IS_DEVICE (obj_nm)) {
-		priv = NM_CLIENT_GET_PRIVATE (self);
 		if (G_UNLIKELY (!priv->udev_inited)) {
 			priv->udev_inited = TRUE;
 			/* for testing, we don't want to use udev in libnm. */
@@ -2804,6 +2813,8 @@ objects_created (NMClient *client, GDBusObjectManager *object_manager, GError **
 	NMObject *obj_nm;
 	GList *objects, *iter;
 
+	_nm_object_manager_set_lazy (object_manager, priv->lazy);
+
 	/* First just ensure all the NMObjects for known GDBusObjects exist. */
 	objects = g_dbus_object_manager_get_objects (object_manager);
 	for (iter = objects; iter; iter = iter->next)
@@ -3227,6 +3238,10 @@ set_property (GObject *object, guint prop_id,
 		if (priv->manager)
 			g_object_set_property (G_OBJECT (priv->manager), pspec->name, value);
 		break;
+	case PROP_LAZY:
+		/* construct-only */
+		priv->lazy = g_value_get_boolean (value);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -3360,6 +3375,10 @@ get_property (GObject *object, guint prop_id,
 		} else
 			g_value_take_boxed (value, NULL);
 		break;
+
+	case PROP_LAZY:
+		g_value_set_boolean (value, priv->lazy);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -3728,6 +3747,28 @@ nm_client_class_init (NMClientClass *client_class)
 		                     G_PARAM_READABLE |
 		                     G_PARAM_STATIC_STRINGS));
 
+	/**
+	 * NMClient:lazy:
+	 *
+	 * Whether objects are only created when they are first accessed.
+	 *
+	 * Usually, the client creates an #NMObject for every object that
+	 * NetworkManager exports when it starts. In lazy mode, #NMIPConfig and
+	 * #NMDhcpConfig objects are instead created from the cached D-Bus data
+	 * when they are first requested, for example by nm_device_get_ip4_config().
+	 * This reduces startup time and memory usage of clients that don't
+	 * need them.
+	 *
+	 * Since: 1.20
+	 */
+	g_object_class_install_property
+		(object_class, PROP_LAZY,
+		 g_param_spec_boolean (NM_CLIENT_LAZY, "", "",
+		                       FALSE,
+		                       G_PARAM_READWRITE |
+		                       G_PARAM_CONSTRUCT_ONLY |
+		                       G_PARAM_STATIC_STRINGS));
+
 	/* signals */
 
 	/**
@@ -1211,7 +1211,7 @@ nm_device_get_ip4_config (NMDevice *device)
 {
 	g_return_val_if_fail (NM_IS_DEVICE (device), NULL);
 
-	return NM_DEVICE_GET_PRIVATE (device)->ip4_config;
+	return _nm_object_get_lazy_object (NM_OBJECT (device), NM_DEVICE_IP4_CONFIG);
 }
 
 /**
@@ -1231,7 +1231,7 @@ nm_device_get_dhcp4_config (NMDevice *device)
 {
 	g_return_val_if_fail (NM_IS_DEVICE (device), NULL);
 
-	return NM_DEVICE_GET_PRIVATE (device)->dhcp4_config;
+	return _nm_object_get_lazy_object (NM_OBJECT (device), NM_DEVICE_DHCP4_CONFIG);
 }
 
 /**
@@ -1250,7 +1250,7 @@ nm_device_get_ip6_config (NMDevice *device)
 {
 	g_return_val_if_fail (NM_IS_DEVICE (device), NULL);
 
-	return NM_DEVICE_GET_PRIVATE (device)->ip6_config;
+	return _nm_object_get_lazy_object (NM_OBJECT (device), NM_DEVICE_IP6_CONFIG);
 }
 
 /**
@@ -1270,7 +1270,7 @@ nm_device_get_dhcp6_config (NMDevice *device)
 {
 	g_return_val_if_fail (NM_IS_DEVICE (device), NULL);
 
-	return NM_DEVICE_GET_PRIVATE (device)->dhcp6_config;
+	return _nm_object_get_lazy_object (NM_OBJECT (device), NM_DEVICE_DHCP6_CONFIG);
 }
 
 /**
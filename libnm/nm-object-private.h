@@ -48,6 +48,12 @@ GDBusObjectManager *_nm_object_get_dbus_object_manager (NMObject *object);
 
 GQuark _nm_object_obj_nm_quark (void);
 
+gboolean _nm_object_type_is_lazy (GType type);
+
+void _nm_object_manager_set_lazy (GDBusObjectManager *object_manager, gboolean lazy);
+
+gpointer _nm_object_get_lazy_object (NMObject *object, const char *property_name);
+
 /* DBus property accessors */
 
 void _nm_object_set_property (NMObject *object,
@@ -30,6 +30,8 @@
 #include "nm-object-private.h"
 #include "nm-dbus-helpers.h"
 #include "nm-client.h"
+#include "nm-ip-config.h"
+#include "nm-dhcp-config.h"
 #include "nm-core-internal.h"
 #include "c-list/src/c-list.h"
 
@@ -38,6 +40,8 @@ static gboolean debug = FALSE;
 
 NM_CACHED_QUARK_FCN ("nm-obj-nm", _nm_object_obj_nm_quark)
 
+NM_CACHED_QUARK_FCN ("nm-obj-lazy", _nm_object_lazy_quark)
+
 static void nm_object_initable_iface_init (GInitableIface *iface);
 static void nm_object_async_initable_iface_init (GAsyncInitableIface *iface);
 
@@ -60,8 +64,19 @@ typedef struct {
 	GType object_type;
 	gpointer field;
 	const char *signal_prefix;
+
+	/* in lazy mode, the object path of the referenced object. The
+	 * NMObject for it is only created on first access. */
+	char *lazy_path;
 } PropertyInfo;
 
+static void
+property_info_free (PropertyInfo *pi)
+{
+	g_free (pi->lazy_path);
+	g_free (pi);
+}
+
 static void reload_complete (NMObject *object, gboolean emit_now);
 static gboolean demarshal_generic (NMObject *object, GParamSpec *pspec, GVariant *value, gpointer field);
 
@@ -77,6 +92,7 @@ typedef struct {
 	                         * to defer their notifications by adding themselves here. */
 
 	CList notify_items;
+	GHashTable *notify_items_idx;   /* index of notify_items by NotifyItem key */
 	guint notify_id;
 
 	guint reload_remaining;
@@ -156,6 +172,33 @@ typedef struct {
 	NMObject *changed;
 } NotifyItem;
 
+/* The key of a NotifyItem: either a property, or the added/removed signal
+ * for an object. @property and @signal_prefix are interned strings. */
+static guint
+notify_item_hash (gconstpointer ptr)
+{
+	const NotifyItem *item = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 1037224003u);
+	nm_hash_update_vals (&h,
+	                     item->property,
+	                     item->signal_prefix,
+	                     item->changed);
+	return nm_hash_complete (&h);
+}
+
+static gboolean
+notify_item_equal (gconstpointer a, gconstpointer b)
+{
+	const NotifyItem *item_a = a;
+	const NotifyItem *item_b = b;
+
+	return    item_a->property == item_b->property
+	       && item_a->signal_prefix == item_b->signal_prefix
+	       && item_a->changed == item_b->changed;
+}
+
 static void
 notify_item_free (NotifyItem *item)
 {
@@ -186,6 +229,8 @@ deferred_notify_cb (gpointer data)
 	 */
 	c_list_link_after (&priv->notify_items, &props);
 	c_list_unlink (&priv->notify_items);
+	if (priv->notify_items_idx)
+		g_hash_table_remove_all (priv->notify_items_idx);
 
 	g_object_ref (object);
 
@@ -252,7 +297,7 @@ _nm_object_queue_notify_full (NMObject *object,
 {
 	NMObjectPrivate *priv;
 	NotifyItem *item;
-	CList *iter;
+	NotifyItem needle;
 
 	g_return_if_fail (NM_IS_OBJECT (object));
 	g_return_if_fail (!signal_prefix != !property);
@@ -263,10 +308,20 @@ _nm_object_queue_notify_full (NMObject *object,
 
 	property = g_intern_string (property);
 	signal_prefix = g_intern_string (signal_prefix);
-	c_list_for_each (iter, &priv->notify_items) {
-		item = c_list_entry (iter, NotifyItem, lst);
 
-		if (property && (property == item->property))
+	/* Arrays with many objects queue many added/removed signals at once.
+	 * Look up existing items in the index instead of searching the list. */
+	if (!priv->notify_items_idx)
+		priv->notify_items_idx = g_hash_table_new (notify_item_hash, notify_item_equal);
+
+	needle = (NotifyItem) {
+		.property      = property,
+		.signal_prefix = signal_prefix,
+		.changed       = signal_prefix ? changed : NULL,
+	};
+	item = g_hash_table_lookup (priv->notify_items_idx, &needle);
+	if (item) {
+		if (property)
 			return;
 
 		/* Collapse signals for the same object (such as "added->removed") to
@@ -285,28 +340,26 @@ _nm_object_queue_notify_full (NMObject *object,
 		 *     ADDED                 + removed -> ADDED_REMOVED
 		 *     ADDED_REMOVED         + removed -> ADDED_REMOVED (emits no signal)
 		 */
-		if (signal_prefix && (changed == item->changed) && (item->signal_prefix == signal_prefix)) {
-			switch (item->pending) {
-			case NOTIFY_SIGNAL_PENDING_ADDED:
-				if (!added)
-					item->pending = NOTIFY_SIGNAL_PENDING_ADDED_REMOVED;
-				break;
-			case NOTIFY_SIGNAL_PENDING_REMOVED:
-				if (added)
-					item->pending = NOTIFY_SIGNAL_PENDING_NONE;
-				break;
-			case NOTIFY_SIGNAL_PENDING_ADDED_REMOVED:
-				if (added)
-					item->pending = NOTIFY_SIGNAL_PENDING_ADDED;
-				break;
-			case NOTIFY_SIGNAL_PENDING_NONE:
-				item->pending = added ? NOTIFY_SIGNAL_PENDING_ADDED : NOTIFY_SIGNAL_PENDING_REMOVED;
-				break;
-			default:
-				g_assert_not_reached ();
-			}
-			return;
+		switch (item->pending) {
+		case NOTIFY_SIGNAL_PENDING_ADDED:
+			if (!added)
+				item->pending = NOTIFY_SIGNAL_PENDING_ADDED_REMOVED;
+			break;
+		case NOTIFY_SIGNAL_PENDING_REMOVED:
+			if (added)
+				item->pending = NOTIFY_SIGNAL_PENDING_NONE;
+			break;
+		case NOTIFY_SIGNAL_PENDING_ADDED_REMOVED:
+			if (added)
+				item->pending = NOTIFY_SIGNAL_PENDING_ADDED;
+			break;
+		case NOTIFY_SIGNAL_PENDING_NONE:
+			item->pending = added ? NOTIFY_SIGNAL_PENDING_ADDED : NOTIFY_SIGNAL_PENDING_REMOVED;
+			break;
+		default:
+			g_assert_not_reached ();
 		}
+		return;
 	}
 
 	item = g_slice_new0 (NotifyItem);
@@ -317,6 +370,7 @@ _nm_object_queue_notify_full (NMObject *object,
 		item->changed = changed ? g_object_ref (changed) : NULL;
 	}
 	c_list_link_tail (&priv->notify_items, &item->lst);
+	g_hash_table_add (priv->notify_items_idx, item);
 }
 
 void
@@ -333,6 +387,9 @@ typedef struct {
 	GObject **objects;
 	int length, remaining;
 
+	/* the objects before this index are known to be initialized. */
+	int n_checked;
+
 	gboolean array;
 	const char *property_name;
 } ObjectCreatedData;
@@ -372,45 +429,90 @@ wincaps_to_dash (const char *caps)
 	return g_string_free (str, FALSE);
 }
 
-/* Adds object to array if it's not already there */
-static void
-add_to_object_array_unique (GPtrArray *array, GObject *obj)
+/* Arrays up to this size are searched linearly. For larger ones (like the
+ * access points of a Wi-Fi device), a hash table is used. */
+#define OBJECT_ARRAY_LINEAR_MAX 16
+
+static gboolean
+object_array_contains (const GPtrArray *array, GHashTable *idx, gpointer obj)
 {
 	guint i;
 
-	g_return_if_fail (array != NULL);
+	if (idx)
+		return g_hash_table_contains (idx, obj);
+
+	for (i = 0; i < array->len; i++) {
+		if (array->pdata[i] == obj)
+			return TRUE;
+	}
+	return FALSE;
+}
 
-	if (obj != NULL) {
-		for (i = 0; i < array->len; i++) {
-			if (g_ptr_array_index (array, i) == obj) {
+static GHashTable *
+object_array_idx_new (const GPtrArray *array)
+{
+	GHashTable *idx;
+	guint i;
+
+	if (array->len <= OBJECT_ARRAY_LINEAR_MAX)
+		return NULL;
+
+	idx = g_hash_table_new (nm_direct_hash, NULL);
+	for (i = 0; i < array->len; i++)
+		g_hash_table_add (idx, array->pdata[i]);
+	return idx;
+}
+
+/* Builds an array of the objects, without duplicates and NULL entries. Takes
+ * ownership of the references in @objects. */
+static GPtrArray *
+object_array_new_unique (GObject **objects, int length)
+{
+	gs_unref_hashtable GHashTable *idx = NULL;
+	GPtrArray *array;
+	int i;
+
+	array = g_ptr_array_new_full (length, g_object_unref);
+	if (length > OBJECT_ARRAY_LINEAR_MAX)
+		idx = g_hash_table_new (nm_direct_hash, NULL);
+
+	for (i = 0; i < length; i++) {
+		GObject *obj = objects[i];
+
+		if (!obj)
+			continue;
+
+		if (idx) {
+			if (!nm_g_hash_table_add (idx, obj)) {
 				g_object_unref (obj);
-				return;
+				continue;
 			}
+		} else if (object_array_contains (array, NULL, obj)) {
+			g_object_unref (obj);
+			continue;
 		}
 		g_ptr_array_add (array, obj);
 	}
+	return array;
 }
 
 /* Places items from 'needles' that are not in 'haystack' into 'diff' */
 static void
 array_diff (GPtrArray *needles, GPtrArray *haystack, GPtrArray *diff)
 {
-	guint i, j;
-	GObject *obj;
+	gs_unref_hashtable GHashTable *idx = NULL;
+	guint i;
 
 	g_assert (needles);
 	g_assert (haystack);
 	g_assert (diff);
 
-	for (i = 0; i < needles->len; i++) {
-		obj = g_ptr_array_index (needles, i);
+	idx = object_array_idx_new (haystack);
 
-		for (j = 0; j < haystack->len; j++) {
-			if (g_ptr_array_index (haystack, j) == obj)
-				break;
-		}
+	for (i = 0; i < needles->len; i++) {
+		GObject *obj = g_ptr_array_index (needles, i);
 
-		if (j == haystack->len)
+		if (!object_array_contains (haystack, idx, obj))
 			g_ptr_array_add (diff, obj);
 	}
 }
@@ -459,14 +561,21 @@ object_property_maybe_complete (NMObject *self)
 		if (odata->remaining > 0)
 			return;
 
-		/* Only complete the array property load when all the objects are initialized. */
-		for (i = 0; i < odata->length; i++) {
+		/* Only complete the array property load when all the objects are initialized.
+		 *
+		 * We get called again whenever one of the objects we wait for completes its
+		 * initialization. Continue where we stopped last time, so that resolving
+		 * a large array doesn't take quadratic time. */
+		for (i = odata->n_checked; i < odata->length; i++) {
 			GObject *obj = odata->objects[i];
 			NMObjectPrivate *obj_priv;
 
 			/* Could not load the object. Perhaps it was removed. */
-			if (!obj)
+			if (!obj) {
+				if (i == odata->n_checked)
+					odata->n_checked++;
 				continue;
+			}
 
 			obj_priv = NM_OBJECT_GET_PRIVATE (obj);
 			if (!obj_priv->inited) {
@@ -479,6 +588,9 @@ object_property_maybe_complete (NMObject *self)
 					obj_priv->waiters = g_slist_prepend (obj_priv->waiters, odata);
 				return;
 			}
+
+			if (i == odata->n_checked)
+				odata->n_checked++;
 		}
 
 		if (odata->array) {
@@ -486,9 +598,7 @@ object_property_maybe_complete (NMObject *self)
 			GPtrArray *new;
 
 			/* Build up new array */
-			new = g_ptr_array_new_full (odata->length, g_object_unref);
-			for (i = 0; i < odata->length; i++)
-				add_to_object_array_unique (new, odata->objects[i]);
+			new = object_array_new_unique (odata->objects, odata->length);
 
 			*((GPtrArray **) pi->field) = new;
 
@@ -574,6 +684,141 @@ object_created (GObject *obj, const char *path, gpointer user_data)
 	object_property_maybe_complete (odata->self);
 }
 
+/*****************************************************************************/
+
+/**
+ * _nm_object_type_is_lazy:
+ * @type: the #GType of an #NMObject subclass
+ *
+ * Objects of these types are only referenced by a single object property
+ * of their owner (a device or active connection), and they don't reference
+ * other objects themselves. In lazy mode, they are created on first access
+ * instead of upfront.
+ *
+ * Returns: whether objects of @type are created lazily in lazy mode.
+ */
+gboolean
+_nm_object_type_is_lazy (GType type)
+{
+	return    g_type_is_a (type, NM_TYPE_IP_CONFIG)
+	       || g_type_is_a (type, NM_TYPE_DHCP_CONFIG);
+}
+
+void
+_nm_object_manager_set_lazy (GDBusObjectManager *object_manager, gboolean lazy)
+{
+	g_object_set_qdata (G_OBJECT (object_manager),
+	                    _nm_object_lazy_quark (),
+	                    GINT_TO_POINTER (!!lazy));
+}
+
+static gboolean
+_object_manager_is_lazy (GDBusObjectManager *object_manager)
+{
+	return    object_manager
+	       && g_object_get_qdata (G_OBJECT (object_manager), _nm_object_lazy_quark ());
+}
+
+static gboolean
+handle_object_property_lazy (NMObject *self, const char *property_name, GVariant *value,
+                             PropertyInfo *pi)
+{
+	GObject **obj_p = pi->field;
+	const char *path;
+
+	path = g_variant_get_string (value, NULL);
+	if (nm_streq (path, "/"))
+		path = NULL;
+
+	if (nm_streq0 (pi->lazy_path, path))
+		return TRUE;
+
+	/* only remember the path. The object is created by _nm_object_get_lazy_object(). */
+	g_free (pi->lazy_path);
+	pi->lazy_path = g_strdup (path);
+	g_clear_object (obj_p);
+
+	_nm_object_queue_notify (self, property_name);
+	return TRUE;
+}
+
+static PropertyInfo *
+property_info_find (NMObject *self, const char *property_name)
+{
+	NMObjectPrivate *priv = NM_OBJECT_GET_PRIVATE (self);
+	GSList *iter;
+
+	for (iter = priv->property_tables; iter; iter = g_slist_next (iter)) {
+		PropertyInfo *pi;
+
+		pi = g_hash_table_lookup ((GHashTable *) iter->data, property_name);
+		if (pi)
+			return pi;
+	}
+	return NULL;
+}
+
+/**
+ * _nm_object_get_lazy_object:
+ * @self: the #NMObject
+ * @property_name: the name of an object property of @self
+ *
+ * Returns the object referenced by @property_name. If the property is
+ * lazy and the referenced object was not created yet, it gets created
+ * now from the data cached by the object manager.
+ *
+ * Returns: (transfer none): the referenced object or %NULL.
+ */
+gpointer
+_nm_object_get_lazy_object (NMObject *self, const char *property_name)
+{
+	NMObjectPrivate *priv = NM_OBJECT_GET_PRIVATE (self);
+	gs_unref_object GDBusObject *object = NULL;
+	PropertyInfo *pi;
+	GObject **obj_p;
+	NMObject *obj;
+
+	pi = property_info_find (self, property_name);
+	if (!pi)
+		g_return_val_if_reached (NULL);
+
+	nm_assert (pi->object_type);
+
+	obj_p = pi->field;
+	if (   *obj_p
+	    || !pi->lazy_path
+	    || !priv->object_manager)
+		return *obj_p;
+
+	object = g_dbus_object_manager_get_object (priv->object_manager, pi->lazy_path);
+	if (!object) {
+		/* Like in handle_object_property(), a dangling object path is a
+		 * server bug. */
+		dbgmsg ("No object known for %s", pi->lazy_path);
+		return NULL;
+	}
+
+	obj = g_object_get_qdata (G_OBJECT (object), _nm_object_obj_nm_quark ());
+	if (!obj) {
+		obj = g_object_new (pi->object_type,
+		                    NM_OBJECT_DBUS_OBJECT, object,
+		                    NM_OBJECT_DBUS_OBJECT_MANAGER, priv->object_manager,
+		                    NULL);
+		g_object_set_qdata_full (G_OBJECT (object), _nm_object_obj_nm_quark (),
+		                         obj, g_object_unref);
+
+		/* Initialization only demarshals the properties that the object
+		 * manager already cached. It does not block on D-Bus. */
+		if (!g_initable_init (G_INITABLE (obj), NULL, NULL))
+			g_warn_if_reached ();
+	}
+
+	*obj_p = g_object_ref (obj);
+	return obj;
+}
+
+/*****************************************************************************/
+
 static gboolean
 handle_object_property (NMObject *self, const char *property_name, GVariant *value,
                         PropertyInfo *pi)
@@ -584,11 +829,16 @@ handle_object_property (NMObject *self, const char *property_name, GVariant *val
 	const char *path;
 	ObjectCreatedData *odata;
 
+	if (   _nm_object_type_is_lazy (pi->object_type)
+	    && _object_manager_is_lazy (priv->object_manager))
+		return handle_object_property_lazy (self, property_name, value, pi);
+
 	odata = g_slice_new (ObjectCreatedData);
 	odata->self = g_object_ref (self);
 	odata->pi = pi;
 	odata->objects = g_new0 (GObject *, 1);
 	odata->length = odata->remaining = 1;
+	odata->n_checked = 0;
 	odata->array = FALSE;
 	odata->property_name = property_name;
 
@@ -634,11 +884,12 @@ handle_object_array_property (NMObject *self, const char *property_name, GVarian
                               PropertyInfo *pi)
 {
 	NMObjectPrivate *priv = NM_OBJECT_GET_PRIVATE (self);
-	GObject *obj;
+	NMObjectClass *object_class = NM_OBJECT_GET_CLASS (self);
 	GVariantIter iter;
 	gsize npaths;
 	const char *path;
 	ObjectCreatedData *odata;
+	int n;
 
 	npaths = g_variant_n_children (value);
 
@@ -646,7 +897,7 @@ handle_object_array_property (NMObject *self, const char *property_name, GVarian
 	odata->self = g_object_ref (self);
 	odata->pi = pi;
 	odata->objects = g_new0 (GObject *, npaths);
-	odata->length = odata->remaining = npaths;
+	odata->n_checked = 0;
 	odata->array = TRUE;
 	odata->property_name = property_name;
 
@@ -654,27 +905,36 @@ handle_object_array_property (NMObject *self, const char *property_name, GVarian
 
 	priv->reload_remaining++;
 
-	if (npaths == 0) {
-		object_property_maybe_complete (self);
-		return TRUE;
-	}
-
+	/* Resolve the entire array in one pass against the object manager's
+	 * cache. The property is only updated (and notified) once, when all
+	 * objects are initialized. */
+	n = 0;
 	g_variant_iter_init (&iter, value);
 	while (g_variant_iter_next (&iter, "&o", &path)) {
 		gs_unref_object GDBusObject *object = NULL;
+		GObject *obj;
 
 		object = g_dbus_object_manager_get_object (priv->object_manager, path);
-		if (object) {
-			obj = g_object_get_qdata (G_OBJECT (object), _nm_object_obj_nm_quark ());
-			object_created (obj, path, odata);
-		} else {
+		if (!object) {
 			g_warning ("no object known for %s\n", path);
-			odata->remaining--;
-			odata->length--;
-			object_property_maybe_complete (self);
+			continue;
+		}
+
+		obj = g_object_get_qdata (G_OBJECT (object), _nm_object_obj_nm_quark ());
+		if (!obj) {
+			/* We assume that on error, the creator_func printed something */
+			if (object_class->object_creation_failed)
+				object_class->object_creation_failed (self, path);
+			continue;
 		}
+
+		odata->objects[n++] = g_object_ref (obj);
 	}
 
+	odata->length = n;
+	odata->remaining = 0;
+
+	object_property_maybe_complete (self);
 	return TRUE;
 }
 
@@ -950,7 +1210,7 @@ _nm_object_register_properties (NMObject *object,
 	                  G_CALLBACK (properties_changed), object);
 	g_ptr_array_add (priv->proxies, proxy);
 
-	instance = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, g_free);
+	instance = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, (GDestroyNotify) property_info_free);
 	priv->property_tables = g_slist_prepend (priv->property_tables, instance);
 
 	for (tmp = (NMPropertiesInfo *) info; tmp->name; tmp++) {
@@ -1241,6 +1501,8 @@ dispose (GObject *object)
 
 	g_slist_free_full (priv->waiters, odata_free);
 
+	nm_clear_pointer (&priv->notify_items_idx, g_hash_table_unref);
+
 	g_clear_object (&priv->object);
 	g_clear_object (&priv->object_manager);
 
@@ -1264,6 +1526,7 @@ finalize (GObject *object)
 	NMObjectPrivate *priv = NM_OBJECT_GET_PRIVATE (object);
 
 	g_slist_free_full (priv->property_tables, (GDestroyNotify) g_hash_table_destroy);
+	nm_clear_pointer (&priv->notify_items_idx, g_hash_table_unref);
 
 	G_OBJECT_CLASS (nm_object_parent_class)->finalize (object);
 }
@@ -21,6 +21,7 @@
 
 #include <sys/types.h>
 #include <signal.h>
+#include <malloc.h>
 
 #include "nm-test-libnm-utils.h"
 
@@ -414,6 +415,125 @@ test_wifi_ap_added_removed (void)
 
 /*****************************************************************************/
 
+typedef struct {
+	GMainLoop *loop;
+	guint n_expected;
+	guint n_added;
+	guint n_notified;
+} WifiApScanInfo;
+
+static void
+wifi_ap_scan_added_cb (NMDeviceWifi *w,
+                       NMAccessPoint *ap,
+                       gpointer user_data)
+{
+	WifiApScanInfo *info = user_data;
+
+	g_assert (NM_IS_ACCESS_POINT (ap));
+	info->n_added++;
+}
+
+static void
+wifi_ap_scan_notify_cb (NMDeviceWifi *w,
+                        GParamSpec *pspec,
+                        gpointer user_data)
+{
+	WifiApScanInfo *info = user_data;
+
+	info->n_notified++;
+	if (nm_device_wifi_get_access_points (w)->len == info->n_expected)
+		g_main_loop_quit (info->loop);
+}
+
+static void
+_wifi_ap_scan (NMTstcServiceInfo *service_info,
+               NMDeviceWifi *wifi,
+               guint n_aps)
+{
+	gs_unref_variant GVariant *ret = NULL;
+	gs_free_error GError *error = NULL;
+	const GPtrArray *aps;
+	WifiApScanInfo info = {
+		.loop       = loop,
+		.n_expected = n_aps,
+	};
+	guint i;
+
+	g_signal_connect (wifi, "access-point-added",
+	                  G_CALLBACK (wifi_ap_scan_added_cb), &info);
+	g_signal_connect (wifi, "notify::" NM_DEVICE_WIFI_ACCESS_POINTS,
+	                  G_CALLBACK (wifi_ap_scan_notify_cb), &info);
+
+	/* all access points appear at once, like after a scan. */
+	ret = g_dbus_proxy_call_sync (service_info->proxy,
+	                              "AddWifiAps",
+	                              g_variant_new ("(su)", nm_device_get_iface (NM_DEVICE (wifi)), n_aps),
+	                              G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                              30000,
+	                              NULL,
+	                              &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+
+	if (!nmtst_main_loop_run (loop, 30000))
+		g_assert_not_reached ();
+
+	/* the array property is resolved as a whole: one notification, but
+	 * an added signal for every access point. */
+	g_assert_cmpint (info.n_notified, ==, 1);
+	g_assert_cmpint (info.n_added, ==, n_aps);
+
+	aps = nm_device_wifi_get_access_points (wifi);
+	g_assert_cmpint (aps->len, ==, n_aps);
+	for (i = 0; i < aps->len; i++)
+		g_assert (NM_IS_ACCESS_POINT (aps->pdata[i]));
+
+	g_signal_handlers_disconnect_by_data (wifi, &info);
+}
+
+typedef struct {
+	NMTstcServiceInfo *sinfo;
+	NMDeviceWifi *wifi;
+} WifiApScanBenchmarkData;
+
+static void
+_benchmark_wifi_ap_scan (gpointer user_data)
+{
+	WifiApScanBenchmarkData *data = user_data;
+
+	_wifi_ap_scan (data->sinfo, data->wifi, 500);
+}
+
+static void
+test_wifi_ap_scan (void)
+{
+	NMTSTC_SERVICE_INFO_SETUP (my_sinfo);
+	gs_unref_object NMClient *client = NULL;
+	gs_free_error GError *error = NULL;
+	NMDeviceWifi *wifi;
+
+	client = nm_client_new (NULL, &error);
+	g_assert_no_error (error);
+
+	wifi = (NMDeviceWifi *) nmtstc_service_add_device (my_sinfo, client, "AddWifiDevice", "wlan0");
+	g_assert (NM_IS_DEVICE_WIFI (wifi));
+
+	_wifi_ap_scan (my_sinfo, wifi, 500);
+
+	if (nmtst_test_perf ()) {
+		WifiApScanBenchmarkData data = {
+			.sinfo = my_sinfo,
+		};
+
+		/* a fresh device, so that all access points are new again. */
+		data.wifi = (NMDeviceWifi *) nmtstc_service_add_device (my_sinfo, client, "AddWifiDevice", "wlan1");
+		g_assert (NM_IS_DEVICE_WIFI (data.wifi));
+		nmtst_benchmark ("resolve 500 access points of a scan", 1, _benchmark_wifi_ap_scan, &data);
+	}
+}
+
+/*****************************************************************************/
+
 static const char *expected_nsp_name = "Clear";
 
 typedef struct {
@@ -1593,6 +1713,143 @@ test_connection_invalid (void)
 
 /*****************************************************************************/
 
+static void
+_add_wired_devices (NMTstcServiceInfo *my_sinfo, guint from, guint to)
+{
+	const char *empty[] = { NULL };
+	guint i;
+
+	for (i = from; i < to; i++) {
+		gs_unref_variant GVariant *ret = NULL;
+		gs_free_error GError *error = NULL;
+		char ifname[30];
+		char hwaddr[30];
+
+		nm_sprintf_buf (ifname, "eth%u", i);
+		nm_sprintf_buf (hwaddr, "52:54:00:%02x:%02x:%02x",
+		                (i >> 16) & 0xFF,
+		                (i >> 8) & 0xFF,
+		                i & 0xFF);
+		ret = g_dbus_proxy_call_sync (my_sinfo->proxy,
+		                              "AddWiredDevice",
+		                              g_variant_new ("(ss^as)", ifname, hwaddr, empty),
+		                              G_DBUS_CALL_FLAGS_NO_AUTO_START,
+		                              3000,
+		                              NULL,
+		                              &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+	}
+}
+
+static void
+_check_client (guint n_devices, gboolean lazy)
+{
+	gs_unref_object NMClient *client = NULL;
+	gs_free_error GError *error = NULL;
+	const GPtrArray *devices;
+	guint i;
+
+	client = g_initable_new (NM_TYPE_CLIENT, NULL, &error,
+	                         NM_CLIENT_LAZY, lazy,
+	                         NULL);
+	g_assert_no_error (error);
+	g_assert (NM_IS_CLIENT (client));
+
+	devices = nm_client_get_devices (client);
+	g_assert_cmpint (devices->len, ==, n_devices);
+
+	/* in both modes, the configurations are available and stable. */
+	for (i = 0; i < devices->len; i++) {
+		NMDevice *device = devices->pdata[i];
+		NMIPConfig *ip4_config;
+		NMDhcpConfig *dhcp6_config;
+
+		ip4_config = nm_device_get_ip4_config (device);
+		g_assert (NM_IS_IP_CONFIG (ip4_config));
+		g_assert (nm_device_get_ip4_config (device) == ip4_config);
+		g_assert_cmpint (nm_ip_config_get_family (ip4_config), ==, AF_INET);
+
+		dhcp6_config = nm_device_get_dhcp6_config (device);
+		g_assert (NM_IS_DHCP_CONFIG (dhcp6_config));
+		g_assert (nm_device_get_dhcp6_config (device) == dhcp6_config);
+		g_assert_cmpint (nm_dhcp_config_get_family (dhcp6_config), ==, AF_INET6);
+	}
+}
+
+static gint64
+_heap_in_use (void)
+{
+	struct mallinfo mi;
+
+	NM_PRAGMA_WARNING_DISABLE ("-Wdeprecated-declarations")
+	mi = mallinfo ();
+	NM_PRAGMA_WARNING_REENABLE
+
+	return (gint64) ((guint) mi.uordblks) + (gint64) ((guint) mi.hblkhd);
+}
+
+static void
+_benchmark_client (guint n_devices, gboolean lazy)
+{
+	gs_unref_object NMClient *client = NULL;
+	gs_free_error GError *error = NULL;
+	GTimer *timer;
+	gint64 heap_before;
+	gint64 heap_after;
+	double elapsed;
+
+	heap_before = _heap_in_use ();
+	timer = g_timer_new ();
+
+	client = g_initable_new (NM_TYPE_CLIENT, NULL, &error,
+	                         NM_CLIENT_LAZY, lazy,
+	                         NULL);
+
+	elapsed = g_timer_elapsed (timer, NULL);
+	heap_after = _heap_in_use ();
+	g_timer_destroy (timer);
+
+	g_assert_no_error (error);
+	g_assert (NM_IS_CLIENT (client));
+	g_assert_cmpint (nm_client_get_devices (client)->len, ==, n_devices);
+
+	g_test_message ("benchmark: NMClient with %u devices (%s): %.3f sec, %"G_GINT64_FORMAT" KiB heap",
+	                n_devices,
+	                lazy ? "lazy" : "eager",
+	                elapsed,
+	                (heap_after - heap_before) / 1024);
+}
+
+static void
+test_client_lazy (void)
+{
+	NMTSTC_SERVICE_INFO_SETUP (my_sinfo);
+	const guint n_devices_perf[] = { 1000, 4000 };
+	guint n_added;
+	guint i;
+
+	_add_wired_devices (my_sinfo, 0, 20);
+	_check_client (20, TRUE);
+	_check_client (20, FALSE);
+
+	if (!nmtst_test_perf ())
+		return;
+
+	/* startup time and heap usage of the client, which is what the lazy
+	 * mode is about. */
+	n_added = 20;
+	for (i = 0; i < G_N_ELEMENTS (n_devices_perf); i++) {
+		_add_wired_devices (my_sinfo, n_added, n_devices_perf[i]);
+		n_added = n_devices_perf[i];
+
+		_benchmark_client (n_added, TRUE);
+		_benchmark_client (n_added, FALSE);
+	}
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -1607,6 +1864,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/libnm/device-added", test_device_added);
 	g_test_add_func ("/libnm/device-added-signal-after-init", test_device_added_signal_after_init);
 	g_test_add_func ("/libnm/wifi-ap-added-removed", test_wifi_ap_added_removed);
+	g_test_add_func ("/libnm/wifi-ap-scan", test_wifi_ap_scan);
 	g_test_add_func ("/libnm/wimax-nsp-added-removed", test_wimax_nsp_added_removed);
 	g_test_add_func ("/libnm/devices-array", test_devices_array);
 	g_test_add_func ("/libnm/client-nm-running", test_client_nm_running);
@@ -1615,6 +1873,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/libnm/activate-failed", test_activate_failed);
 	g_test_add_func ("/libnm/device-connection-compatibility", test_device_connection_compatibility);
 	g_test_add_func ("/libnm/connection/invalid", test_connection_invalid);
+	g_test_add_func ("/libnm/client-lazy", test_client_lazy);
 
 	return g_test_run ();
 }
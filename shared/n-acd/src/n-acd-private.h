@@ -129,7 +129,7 @@ NAcdEventNode *n_acd_event_node_free(NAcdEventNode *node);
 void n_acd_remember(NAcd *acd, uint64_t now, bool success);
 int n_acd_raise(NAcd *acd, NAcdEventNode **nodep, unsigned int event);
 int n_acd_send(NAcd *acd, const struct in_addr *tpa, const struct in_addr *spa);
-int n_acd_ensure_bpf_map_space(NAcd *acd);
+int n_acd_ensure_bpf_map_space(NAcd *acd, size_t n_ips);
 
 /* probes */
 
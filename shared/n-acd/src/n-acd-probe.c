@@ -207,7 +207,7 @@ static int n_acd_probe_link(NAcdProbe *probe) {
          * Make sure the kernel bpf map has space for at least one more
          * entry.
          */
-        r = n_acd_ensure_bpf_map_space(probe->acd);
+        r = n_acd_ensure_bpf_map_space(probe->acd, 1);
         if (r)
                 return r;
 
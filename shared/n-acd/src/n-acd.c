@@ -271,16 +271,23 @@ NAcdEventNode *n_acd_event_node_free(NAcdEventNode *node) {
         return NULL;
 }
 
-int n_acd_ensure_bpf_map_space(NAcd *acd) {
+int n_acd_ensure_bpf_map_space(NAcd *acd, size_t n_ips) {
         NAcdProbe *probe;
         _c_cleanup_(c_closep) int fd_map = -1, fd_prog = -1;
         size_t  max_map;
         int r;
 
-        if (acd->n_bpf_map < acd->max_bpf_map)
+        if (acd->n_bpf_map + n_ips <= acd->max_bpf_map)
                 return 0;
 
+        /*
+         * Grow the map in a single step, so that the map is only recreated
+         * and the filter only re-attached once, even if many addresses are
+         * added at once.
+         */
         max_map = 2 * acd->max_bpf_map;
+        while (max_map < acd->n_bpf_map + n_ips)
+                max_map *= 2;
 
         r = n_acd_bpf_map_create(&fd_map, max_map);
         if (r)
@@ -995,6 +1002,25 @@ _c_public_ int n_acd_pop_event(NAcd *acd, NAcdEvent **eventp) {
         return 0;
 }
 
+/**
+ * n_acd_reserve() - reserve space for probes
+ * @acd:                        context object to operate on
+ * @n_probes:                   number of probes to reserve space for
+ *
+ * This makes sure that @n_probes probes for distinct addresses can be added
+ * to @acd via n_acd_probe() without resizing the kernel BPF map. Otherwise,
+ * the map is grown on demand, and every time it is full it is recreated and
+ * the filter is re-attached to the socket. Callers that are about to start
+ * many probes at once should reserve space for them upfront.
+ *
+ * This only ever grows the map. Calling it is never required.
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
+_c_public_ int n_acd_reserve(NAcd *acd, size_t n_probes) {
+        return n_acd_ensure_bpf_map_space(acd, n_probes);
+}
+
 /**
  * n_acd_probe() - start new probe
  * @acd:                        context object to operate on
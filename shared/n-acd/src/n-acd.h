@@ -96,6 +96,7 @@ void n_acd_get_fd(NAcd *acd, int *fdp);
 int n_acd_dispatch(NAcd *acd);
 int n_acd_pop_event(NAcd *acd, NAcdEvent **eventp);
 
+int n_acd_reserve(NAcd *acd, size_t n_probes);
 int n_acd_probe(NAcd *acd, NAcdProbe **probep, NAcdProbeConfig *config);
 
 /* probes */
@@ -58,6 +58,7 @@ static void test_api_functions(void) {
                 (void *)n_acd_get_fd,
                 (void *)n_acd_dispatch,
                 (void *)n_acd_pop_event,
+                (void *)n_acd_reserve,
                 (void *)n_acd_probe,
 
                 (void *)n_acd_probe_free,
@@ -132,12 +132,35 @@ static void n_dhcp4_c_connection_outgoing_set_secs(NDhcp4Outgoing *message) {
         n_dhcp4_outgoing_set_secs(message, secs);
 }
 
+static void n_dhcp4_c_connection_unlink_socket(NDhcp4CConnection *connection) {
+        c_list_unlink(&connection->socket_link);
+        connection->socket_message = n_dhcp4_incoming_free(connection->socket_message);
+        connection->socket = NULL;
+}
+
 int n_dhcp4_c_connection_listen(NDhcp4CConnection *connection) {
         _c_cleanup_(c_closep) int fd_packet = -1;
+        NDhcp4ClientSocket *client_socket = connection->client_config->socket;
+        size_t bucket;
         int r;
 
         c_assert(connection->state == N_DHCP4_C_CONNECTION_STATE_INIT);
 
+        if (client_socket) {
+                /*
+                 * With a shared packet socket there is no per-connection
+                 * socket to open. We link the connection into the socket
+                 * instead, which demultiplexes incoming packets based on the
+                 * interface and transaction id, see
+                 * n_dhcp4_c_connection_match().
+                 */
+                bucket = (unsigned int)connection->client_config->ifindex % N_DHCP4_CLIENT_SOCKET_N_BUCKETS;
+                c_list_link_tail(&client_socket->buckets[bucket], &connection->socket_link);
+                connection->socket = client_socket;
+                connection->state = N_DHCP4_C_CONNECTION_STATE_PACKET;
+                return 0;
+        }
+
         r = n_dhcp4_c_socket_packet_new(&fd_packet, connection->client_config->ifindex);
         if (r)
                 return r;
@@ -184,11 +207,23 @@ int n_dhcp4_c_connection_connect(NDhcp4CConnection *connection,
                 goto exit_fd;
         }
 
-        r = packet_shutdown(connection->fd_packet);
-        if (r < 0)
-                goto exit_epoll;
+        if (connection->socket) {
+                /*
+                 * The shared packet socket stays open for the other
+                 * connections, so there is nothing to drain. Replies still
+                 * queued on it are dropped, just like packets arriving after
+                 * the shutdown of a private packet socket.
+                 */
+                n_dhcp4_c_connection_unlink_socket(connection);
+                connection->state = N_DHCP4_C_CONNECTION_STATE_UDP;
+        } else {
+                r = packet_shutdown(connection->fd_packet);
+                if (r < 0)
+                        goto exit_epoll;
+
+                connection->state = N_DHCP4_C_CONNECTION_STATE_DRAINING;
+        }
 
-        connection->state = N_DHCP4_C_CONNECTION_STATE_DRAINING;
         connection->fd_udp = fd_udp;
         connection->client_ip = client->s_addr;
         connection->server_ip = server->s_addr;
@@ -203,6 +238,9 @@ exit_fd:
 }
 
 void n_dhcp4_c_connection_close(NDhcp4CConnection *connection) {
+        if (connection->socket)
+                n_dhcp4_c_connection_unlink_socket(connection);
+
         if (connection->fd_udp >= 0) {
                 epoll_ctl(connection->fd_epoll, EPOLL_CTL_DEL, connection->fd_udp, NULL);
                 connection->fd_udp = c_close(connection->fd_udp);
@@ -362,7 +400,7 @@ static int n_dhcp4_c_connection_packet_broadcast(NDhcp4CConnection *connection,
 
         c_assert(connection->state == N_DHCP4_C_CONNECTION_STATE_PACKET);
 
-        r = n_dhcp4_c_socket_packet_send(connection->fd_packet,
+        r = n_dhcp4_c_socket_packet_send(connection->socket ? connection->socket->fd_packet : connection->fd_packet,
                                          connection->client_config->ifindex,
                                          connection->client_config->broadcast_mac,
                                          connection->client_config->n_broadcast_mac,
@@ -1068,6 +1106,19 @@ int n_dhcp4_c_connection_dispatch_io(NDhcp4CConnection *connection,
 
         switch (connection->state) {
         case N_DHCP4_C_CONNECTION_STATE_PACKET:
+                if (connection->socket) {
+                        /*
+                         * The shared socket already read the message and
+                         * passed it to us, see n_dhcp4_client_socket_dispatch().
+                         */
+                        if (!connection->socket_message)
+                                return N_DHCP4_E_AGAIN;
+
+                        message = connection->socket_message;
+                        connection->socket_message = NULL;
+                        break;
+                }
+
                 r = n_dhcp4_c_socket_packet_recv(connection->fd_packet,
                                                  connection->scratch_buffer,
                                                  sizeof(connection->scratch_buffer),
@@ -1145,3 +1196,32 @@ int n_dhcp4_c_connection_dispatch_io(NDhcp4CConnection *connection,
         message = NULL;
         return 0;
 }
+
+/**
+ * n_dhcp4_c_connection_match() - check whether a message is for a connection
+ * @connection:                 connection to operate on
+ * @ifindex:                    interface the message was received on
+ * @message:                    message to check
+ *
+ * This is used by shared packet sockets to find the connection a received
+ * message belongs to. Only listening connections on the given interface with a
+ * pending request of the same transaction id match. All further verification
+ * is done when the connection dispatches the message.
+ *
+ * Return: True if @message should be dispatched by @connection.
+ */
+bool n_dhcp4_c_connection_match(NDhcp4CConnection *connection,
+                                int ifindex,
+                                NDhcp4Incoming *message) {
+        uint32_t request_xid, xid;
+
+        if (connection->state != N_DHCP4_C_CONNECTION_STATE_PACKET ||
+            connection->client_config->ifindex != ifindex ||
+            !connection->request)
+                return false;
+
+        n_dhcp4_outgoing_get_xid(connection->request, &request_xid);
+        n_dhcp4_incoming_get_xid(message, &xid);
+
+        return xid == request_xid;
+}
@@ -518,6 +518,56 @@ _c_public_ void n_dhcp4_client_probe_get_userdata(NDhcp4ClientProbe *probe, void
         *userdatap = probe->userdata;
 }
 
+/**
+ * n_dhcp4_client_probe_release() - release the current lease
+ * @probe:                      probe to operate on
+ *
+ * Send a DHCPRELEASE for the lease that was accepted on @probe. The message is
+ * unicast to the server and there is no reply to wait for. The probe must be
+ * destroyed afterwards, it must not be used to acquire another lease.
+ *
+ * If no lease was accepted on @probe, this is a no-op.
+ *
+ * Return: 0 on success, or a negative error code on failure.
+ */
+_c_public_ int n_dhcp4_client_probe_release(NDhcp4ClientProbe *probe) {
+        _c_cleanup_(n_dhcp4_outgoing_freep) NDhcp4Outgoing *request = NULL;
+        int r;
+
+        switch (probe->state) {
+        case N_DHCP4_CLIENT_PROBE_STATE_BOUND:
+        case N_DHCP4_CLIENT_PROBE_STATE_RENEWING:
+        case N_DHCP4_CLIENT_PROBE_STATE_REBINDING:
+                r = n_dhcp4_c_connection_release_new(&probe->connection, &request, NULL);
+                if (r)
+                        return r;
+
+                /* the connection owns the request, even on failure */
+                r = n_dhcp4_c_connection_start_request(&probe->connection,
+                                                       request,
+                                                       n_dhcp4_gettime(CLOCK_BOOTTIME));
+                request = NULL;
+                if (r)
+                        return r;
+
+                probe->state = N_DHCP4_CLIENT_PROBE_STATE_EXPIRED;
+                break;
+
+        case N_DHCP4_CLIENT_PROBE_STATE_INIT:
+        case N_DHCP4_CLIENT_PROBE_STATE_INIT_REBOOT:
+        case N_DHCP4_CLIENT_PROBE_STATE_REBOOTING:
+        case N_DHCP4_CLIENT_PROBE_STATE_SELECTING:
+        case N_DHCP4_CLIENT_PROBE_STATE_REQUESTING:
+        case N_DHCP4_CLIENT_PROBE_STATE_GRANTED:
+        case N_DHCP4_CLIENT_PROBE_STATE_EXPIRED:
+        default:
+                /* ignore */
+                break;
+        }
+
+        return 0;
+}
+
 /**
  * n_dhcp4_client_probe_raise() - XXX
  */
@@ -0,0 +1,218 @@
+/*
+ * DHCP4 Client Shared Sockets
+ *
+ * This implements the public API around shared client packet sockets. Before a
+ * client has an IP address, it has to receive its replies via an AF_PACKET
+ * socket. By default, each client opens its own packet socket bound to its
+ * interface. Every such socket runs its BPF filter on every IP packet received
+ * on the interface, and every socket has to be polled separately.
+ *
+ * A shared socket is a single unbound packet socket, which uses the same BPF
+ * filter to only accept DHCP replies from all interfaces. Received packets are
+ * demultiplexed in user-space based on the interface index and the transaction
+ * id to the connection waiting for them. With many clients running in parallel
+ * this avoids one socket, one filter and one event source per client.
+ *
+ * Once a connection has an address, it switches to its private UDP socket as
+ * before, so the shared socket is only used during the initial exchange.
+ */
+
+#include <assert.h>
+#include <c-list.h>
+#include <c-stdaux.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "n-dhcp4.h"
+#include "n-dhcp4-private.h"
+
+/* maximum number of packets to read in a single dispatch */
+#define N_DHCP4_CLIENT_SOCKET_N_DISPATCH (128)
+
+/**
+ * n_dhcp4_client_socket_new() - allocate new shared client socket
+ * @client_socketp:             output argument for new socket
+ *
+ * This allocates a new shared packet socket and returns it in @client_socketp
+ * to the caller. The caller owns a single reference to the object and is
+ * responsible to drop it, when no longer needed.
+ *
+ * The socket can be attached to any number of client configurations via
+ * n_dhcp4_client_config_set_socket(). The caller must poll the FD returned by
+ * n_dhcp4_client_socket_get_fd() and call n_dhcp4_client_socket_dispatch()
+ * whenever it is readable.
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
+_c_public_ int n_dhcp4_client_socket_new(NDhcp4ClientSocket **client_socketp) {
+        _c_cleanup_(n_dhcp4_client_socket_unrefp) NDhcp4ClientSocket *client_socket = NULL;
+        size_t i;
+        int r;
+
+        c_assert(client_socketp);
+
+        client_socket = malloc(sizeof(*client_socket));
+        if (!client_socket)
+                return -ENOMEM;
+
+        *client_socket = (NDhcp4ClientSocket)N_DHCP4_CLIENT_SOCKET_NULL(*client_socket);
+
+        for (i = 0; i < N_DHCP4_CLIENT_SOCKET_N_BUCKETS; ++i)
+                c_list_init(&client_socket->buckets[i]);
+
+        r = n_dhcp4_c_socket_packet_new(&client_socket->fd_packet, 0);
+        if (r)
+                return r;
+
+        *client_socketp = client_socket;
+        client_socket = NULL;
+        return 0;
+}
+
+static void n_dhcp4_client_socket_free(NDhcp4ClientSocket *client_socket) {
+        size_t i;
+
+        /*
+         * Every listening connection pins the socket via its client
+         * configuration, so no connection can be linked anymore.
+         */
+        for (i = 0; i < N_DHCP4_CLIENT_SOCKET_N_BUCKETS; ++i)
+                c_assert(c_list_is_empty(&client_socket->buckets[i]));
+
+        if (client_socket->fd_packet >= 0)
+                close(client_socket->fd_packet);
+
+        free(client_socket);
+}
+
+/**
+ * n_dhcp4_client_socket_ref() - acquire shared socket reference
+ * @client_socket:              socket to operate on, or NULL
+ *
+ * This acquires a reference to the socket given as @client_socket. If
+ * @client_socket is NULL, this function is a no-op.
+ *
+ * Return: @client_socket is returned.
+ */
+_c_public_ NDhcp4ClientSocket *n_dhcp4_client_socket_ref(NDhcp4ClientSocket *client_socket) {
+        if (client_socket)
+                ++client_socket->n_refs;
+        return client_socket;
+}
+
+/**
+ * n_dhcp4_client_socket_unref() - release shared socket reference
+ * @client_socket:              socket to operate on, or NULL
+ *
+ * This releases a reference to the socket given as @client_socket. If
+ * @client_socket is NULL, this is a no-op.
+ *
+ * Once the last reference is dropped, the socket is closed and deallocated.
+ *
+ * Return: NULL is returned.
+ */
+_c_public_ NDhcp4ClientSocket *n_dhcp4_client_socket_unref(NDhcp4ClientSocket *client_socket) {
+        if (client_socket && !--client_socket->n_refs)
+                n_dhcp4_client_socket_free(client_socket);
+        return NULL;
+}
+
+/**
+ * n_dhcp4_client_socket_get_fd() - retrieve socket FD
+ * @client_socket:              socket to operate on
+ * @fdp:                        output argument to store FD
+ *
+ * This retrieves the FD of the shared packet socket. The FD is always valid,
+ * and returned in @fdp.
+ *
+ * The caller is expected to poll this FD for readable events and call
+ * n_dhcp4_client_socket_dispatch() whenever the FD is readable.
+ */
+_c_public_ void n_dhcp4_client_socket_get_fd(NDhcp4ClientSocket *client_socket, int *fdp) {
+        *fdp = client_socket->fd_packet;
+}
+
+static NDhcp4CConnection *n_dhcp4_client_socket_find(NDhcp4ClientSocket *client_socket,
+                                                     int ifindex,
+                                                     NDhcp4Incoming *message) {
+        NDhcp4CConnection *connection;
+        size_t bucket;
+
+        bucket = (unsigned int)ifindex % N_DHCP4_CLIENT_SOCKET_N_BUCKETS;
+
+        c_list_for_each_entry(connection, &client_socket->buckets[bucket], socket_link)
+                if (n_dhcp4_c_connection_match(connection, ifindex, message))
+                        return connection;
+
+        return NULL;
+}
+
+/**
+ * n_dhcp4_client_socket_dispatch() - dispatch shared socket
+ * @client_socket:              socket to operate on
+ * @clientp:                    output argument for the dispatched client
+ *
+ * This reads pending packets from the shared socket and dispatches them to the
+ * client they are destined for. Packets that match no listening client are
+ * dropped.
+ *
+ * Whenever a packet was dispatched to a client, this function returns and the
+ * client is stored in @clientp, and the return code is the one of the
+ * dispatch of that client. The caller is expected to fetch pending events
+ * from it via n_dhcp4_client_pop_event() and call into this function again.
+ * No reference to the client is acquired, it is only valid as long as the
+ * caller holds its own reference.
+ *
+ * If no more packets are pending, or if the limit of packets to read in one
+ * dispatch was reached, NULL is stored in @clientp. In the latter case
+ * N_DHCP4_E_PREEMPTED is returned. Like with n_dhcp4_client_dispatch(), a
+ * level-triggered event loop can treat this as success.
+ *
+ * This function never blocks.
+ *
+ * Return: 0 on success, negative error code on failure, N_DHCP4_E_PREEMPTED if
+ *         there is more data to dispatch.
+ */
+_c_public_ int n_dhcp4_client_socket_dispatch(NDhcp4ClientSocket *client_socket, NDhcp4Client **clientp) {
+        NDhcp4CConnection *connection;
+        NDhcp4ClientProbe *probe;
+        size_t i;
+        int r, ifindex;
+
+        *clientp = NULL;
+
+        for (i = 0; i < N_DHCP4_CLIENT_SOCKET_N_DISPATCH; ++i) {
+                _c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *message = NULL;
+
+                ifindex = 0;
+                r = n_dhcp4_c_socket_packet_recvfrom(client_socket->fd_packet,
+                                                     client_socket->scratch_buffer,
+                                                     sizeof(client_socket->scratch_buffer),
+                                                     &message,
+                                                     &ifindex);
+                if (r) {
+                        if (r == N_DHCP4_E_AGAIN)
+                                return 0;
+                        else if (r == N_DHCP4_E_MALFORMED || r == N_DHCP4_E_DOWN)
+                                continue;
+
+                        return r;
+                }
+
+                connection = n_dhcp4_client_socket_find(client_socket, ifindex, message);
+                if (!connection)
+                        continue;
+
+                n_dhcp4_incoming_free(connection->socket_message);
+                connection->socket_message = message;
+                message = NULL;
+
+                probe = c_container_of(connection, NDhcp4ClientProbe, connection);
+
+                *clientp = probe->client;
+                return n_dhcp4_client_dispatch_probe_io(probe->client, probe);
+        }
+
+        return N_DHCP4_E_PREEMPTED;
+}
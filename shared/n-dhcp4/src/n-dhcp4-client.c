@@ -63,6 +63,7 @@ _c_public_ NDhcp4ClientConfig *n_dhcp4_client_config_free(NDhcp4ClientConfig *co
         if (!config)
                 return NULL;
 
+        n_dhcp4_client_socket_unref(config->socket);
         free(config->client_id);
         free(config);
 
@@ -94,6 +95,7 @@ int n_dhcp4_client_config_dup(NDhcp4ClientConfig *config, NDhcp4ClientConfig **d
         dup->n_mac = config->n_mac;
         memcpy(dup->broadcast_mac, config->broadcast_mac, sizeof(dup->broadcast_mac));
         dup->n_broadcast_mac = config->n_broadcast_mac;
+        n_dhcp4_client_config_set_socket(dup, config->socket);
 
         r = n_dhcp4_client_config_set_client_id(dup,
                                                 config->client_id,
@@ -240,6 +242,27 @@ _c_public_ int n_dhcp4_client_config_set_client_id(NDhcp4ClientConfig *config, c
         return 0;
 }
 
+/**
+ * n_dhcp4_client_config_set_socket() - set shared packet socket
+ * @config:                     client configuration to operate on
+ * @client_socket:              shared socket to use, or NULL
+ *
+ * This sets the shared packet socket property of the client configuration.
+ * By default, each client opens its own packet socket bound to its interface
+ * while it has no IP address. If a shared socket is set, the client instead
+ * uses the given socket, which is shared with any number of other clients.
+ * The caller is then responsible to dispatch the shared socket, see
+ * n_dhcp4_client_socket_dispatch().
+ *
+ * The configuration acquires a reference to @client_socket, so does every
+ * client created from it.
+ */
+_c_public_ void n_dhcp4_client_config_set_socket(NDhcp4ClientConfig *config, NDhcp4ClientSocket *client_socket) {
+        n_dhcp4_client_socket_ref(client_socket);
+        n_dhcp4_client_socket_unref(config->socket);
+        config->socket = client_socket;
+}
+
 /**
  * n_dhcp4_c_event_node_new() - allocate new event
  * @nodep:                      output argument for new event
@@ -584,6 +607,41 @@ static int n_dhcp4_client_dispatch_io(NDhcp4Client *client, struct epoll_event *
         return r;
 }
 
+/**
+ * n_dhcp4_client_dispatch_probe_io() - dispatch message of a shared socket
+ * @client:                     client to operate on
+ * @probe:                      probe of @client the message is for
+ *
+ * This dispatches a message that a shared packet socket passed to the
+ * connection of @probe. This is the equivalent of n_dhcp4_client_dispatch()
+ * for I/O events that are not signalled via the epoll-fd of @client.
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
+int n_dhcp4_client_dispatch_probe_io(NDhcp4Client *client, NDhcp4ClientProbe *probe) {
+        int r;
+
+        c_assert(probe->client == client);
+
+        r = n_dhcp4_client_probe_dispatch_io(probe, EPOLLIN);
+        if (r) {
+                if (r != N_DHCP4_E_DOWN) {
+                        c_assert(r < _N_DHCP4_E_INTERNAL);
+                        return r;
+                }
+
+                r = n_dhcp4_client_raise(client,
+                                         NULL,
+                                         N_DHCP4_CLIENT_EVENT_DOWN);
+                if (r)
+                        return r;
+        }
+
+        n_dhcp4_client_arm_timer(client);
+
+        return 0;
+}
+
 /**
  * n_dhcp4_client_dispatch() - dispatch client
  * @client:                     client to operate on
@@ -240,6 +240,7 @@ struct NDhcp4ClientConfig {
         size_t n_broadcast_mac;
         uint8_t *client_id;
         size_t n_client_id;
+        NDhcp4ClientSocket *socket;
 };
 
 #define N_DHCP4_CLIENT_CONFIG_NULL(_x) {                                        \
@@ -283,6 +284,24 @@ struct NDhcp4CEventNode {
                 .probe_link = C_LIST_INIT((_x).probe_link),                     \
         }
 
+#define N_DHCP4_CLIENT_SOCKET_N_BUCKETS (256)
+
+struct NDhcp4ClientSocket {
+        unsigned long n_refs;
+        int fd_packet;                  /* packet socket on all interfaces */
+
+        /* listening connections, hashed by ifindex */
+        CList buckets[N_DHCP4_CLIENT_SOCKET_N_BUCKETS];
+
+        /* see NDhcp4CConnection.scratch_buffer */
+        uint8_t scratch_buffer[UINT16_MAX];
+};
+
+#define N_DHCP4_CLIENT_SOCKET_NULL(_x) {                                        \
+                .n_refs = 1,                                                    \
+                .fd_packet = -1,                                                \
+        }
+
 struct NDhcp4CConnection {
         NDhcp4ClientConfig *client_config;
         NDhcp4ClientProbeConfig *probe_config;
@@ -292,6 +311,10 @@ struct NDhcp4CConnection {
         int fd_packet;                  /* packet socket */
         int fd_udp;                     /* udp socket */
 
+        NDhcp4ClientSocket *socket;     /* shared packet socket, or NULL */
+        CList socket_link;              /* link into @socket, while listening */
+        NDhcp4Incoming *socket_message; /* message demultiplexed by @socket */
+
         NDhcp4Outgoing *request;        /* current request */
 
         uint32_t client_ip;             /* client IP address, or 0 */
@@ -311,6 +334,7 @@ struct NDhcp4CConnection {
 #define N_DHCP4_C_CONNECTION_NULL(_x) {                                         \
                 .fd_packet = -1,                                                \
                 .fd_udp = -1,                                                   \
+                .socket_link = C_LIST_INIT((_x).socket_link),                   \
         }
 
 struct NDhcp4Client {
@@ -444,7 +468,11 @@ struct NDhcp4ServerLease {
         CList server_link;
 
         NDhcp4Incoming *request;
-        NDhcp4Incoming *reply;
+
+        struct in_addr yiaddr;          /* address to offer/ack */
+        uint32_t lifetime;              /* lifetime of @yiaddr in seconds */
+        uint8_t *options;               /* appended options as code/length/data */
+        size_t n_options;
 };
 
 #define N_DHCP4_SERVER_LEASE_NULL(_x) {                                         \
@@ -529,6 +557,11 @@ int n_dhcp4_c_socket_packet_recv(int sockfd,
                                  uint8_t *buf,
                                  size_t n_buf,
                                  NDhcp4Incoming **messagep);
+int n_dhcp4_c_socket_packet_recvfrom(int sockfd,
+                                     uint8_t *buf,
+                                     size_t n_buf,
+                                     NDhcp4Incoming **messagep,
+                                     int *ifindexp);
 int n_dhcp4_c_socket_udp_recv(int sockfd,
                               uint8_t *buf,
                               size_t n_buf,
@@ -601,11 +634,15 @@ int n_dhcp4_c_connection_dispatch_timer(NDhcp4CConnection *connection,
                                         uint64_t timestamp);
 int n_dhcp4_c_connection_dispatch_io(NDhcp4CConnection *connection,
                                      NDhcp4Incoming **messagep);
+bool n_dhcp4_c_connection_match(NDhcp4CConnection *connection,
+                                int ifindex,
+                                NDhcp4Incoming *message);
 
 /* clients */
 
 int n_dhcp4_client_raise(NDhcp4Client *client, NDhcp4CEventNode **nodep, unsigned int event);
 void n_dhcp4_client_arm_timer(NDhcp4Client *client);
+int n_dhcp4_client_dispatch_probe_io(NDhcp4Client *client, NDhcp4ClientProbe *probe);
 
 /* client probes */
 
@@ -666,6 +703,19 @@ void n_dhcp4_s_connection_ip_deinit(NDhcp4SConnectionIp *ip);
 void n_dhcp4_s_connection_ip_link(NDhcp4SConnectionIp *ip, NDhcp4SConnection *connection);
 void n_dhcp4_s_connection_ip_unlink(NDhcp4SConnectionIp *ip);
 
+/* servers */
+
+int n_dhcp4_s_event_node_new(NDhcp4SEventNode **nodep);
+NDhcp4SEventNode *n_dhcp4_s_event_node_free(NDhcp4SEventNode *node);
+
+int n_dhcp4_server_raise(NDhcp4Server *server, NDhcp4SEventNode **nodep, unsigned int event);
+
+/* server leases */
+
+int n_dhcp4_server_lease_new(NDhcp4ServerLease **leasep, NDhcp4Incoming *message);
+void n_dhcp4_server_lease_link(NDhcp4ServerLease *lease, NDhcp4Server *server);
+void n_dhcp4_server_lease_unlink(NDhcp4ServerLease *lease);
+
 /* inline helpers */
 
 static inline void n_dhcp4_outgoing_freep(NDhcp4Outgoing **outgoing) {
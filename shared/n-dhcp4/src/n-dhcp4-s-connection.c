@@ -260,8 +260,11 @@ static int n_dhcp4_s_connection_new_reply(NDhcp4SConnection *connection,
         size_t n_client_identifier;
         int r;
 
+        /* clients are not required to send a maximum message size */
         r = n_dhcp4_incoming_query_max_message_size(request, &max_message_size);
-        if (r)
+        if (r == N_DHCP4_E_UNSET)
+                max_message_size = 0;
+        else if (r)
                 return r;
 
         r = n_dhcp4_outgoing_new(&message,
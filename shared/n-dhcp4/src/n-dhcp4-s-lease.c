@@ -38,6 +38,7 @@ static void n_dhcp4_server_lease_free(NDhcp4ServerLease *lease) {
         c_list_unlink(&lease->server_link);
 
         n_dhcp4_incoming_free(lease->request);
+        free(lease->options);
         free(lease);
 }
 
@@ -59,6 +60,34 @@ _c_public_ NDhcp4ServerLease *n_dhcp4_server_lease_unref(NDhcp4ServerLease *leas
         return NULL;
 }
 
+/**
+ * n_dhcp4_server_lease_link() - link lease into server
+ * @lease:                      the lease to operate on
+ * @server:                     the server to link the lease into
+ *
+ * Associate a lease with the server that received its request. Only linked
+ * leases can be replied to. The lease may not already be linked.
+ */
+void n_dhcp4_server_lease_link(NDhcp4ServerLease *lease, NDhcp4Server *server) {
+        c_assert(!lease->server);
+        c_assert(!c_list_is_linked(&lease->server_link));
+
+        lease->server = server;
+        c_list_link_tail(&server->lease_list, &lease->server_link);
+}
+
+/**
+ * n_dhcp4_server_lease_unlink() - unlink lease from its server
+ * @lease:                      the lease to operate on
+ *
+ * Disassociate a lease from its server if it is associated with one.
+ * Otherwise, this is a noop.
+ */
+void n_dhcp4_server_lease_unlink(NDhcp4ServerLease *lease) {
+        lease->server = NULL;
+        c_list_unlink(&lease->server_link);
+}
+
 /**
  * n_dhcp4_server_lease_query() - XXX
  */
@@ -82,22 +111,208 @@ _c_public_ int n_dhcp4_server_lease_query(NDhcp4ServerLease *lease, uint8_t opti
         return n_dhcp4_incoming_query(lease->request, option, datap, n_datap);
 }
 
+/**
+ * n_dhcp4_server_lease_get_chaddr() - get client hardware address
+ * @lease:                      lease to operate on
+ * @chaddrp:                    output argument for the hardware address
+ * @n_chaddrp:                  output argument for its length
+ *
+ * Return the client hardware address of the request, as given in the
+ * message header.
+ */
+_c_public_ void n_dhcp4_server_lease_get_chaddr(NDhcp4ServerLease *lease, const uint8_t **chaddrp, size_t *n_chaddrp) {
+        NDhcp4Header *header = n_dhcp4_incoming_get_header(lease->request);
+
+        *chaddrp = header->chaddr;
+        *n_chaddrp = c_min(header->hlen, sizeof(header->chaddr));
+}
+
+/**
+ * n_dhcp4_server_lease_get_requested_ip() - get address requested by client
+ * @lease:                      lease to operate on
+ * @ipp:                        output argument for the address
+ *
+ * Return the address the client asks for. This is the REQUESTED_IP_ADDRESS
+ * option if present (SELECTING, INIT-REBOOT), or otherwise the 'ciaddr' of
+ * the request (RENEWING, REBINDING).
+ *
+ * Return: 0 on success, N_DHCP4_E_UNSET if the client did not ask for an
+ *         address, or a negative error code on failure.
+ */
+_c_public_ int n_dhcp4_server_lease_get_requested_ip(NDhcp4ServerLease *lease, struct in_addr *ipp) {
+        NDhcp4Header *header;
+        int r;
+
+        r = n_dhcp4_incoming_query_requested_ip(lease->request, ipp);
+        if (r != N_DHCP4_E_UNSET)
+                return r;
+
+        header = n_dhcp4_incoming_get_header(lease->request);
+        if (!header->ciaddr)
+                return N_DHCP4_E_UNSET;
+
+        ipp->s_addr = header->ciaddr;
+        return 0;
+}
+
+/**
+ * n_dhcp4_server_lease_set_yiaddr() - set address to hand out
+ * @lease:                      lease to operate on
+ * @yiaddr:                     address to offer or acknowledge
+ * @lifetime:                   lifetime of @yiaddr in seconds
+ *
+ * Set the address and its lifetime, which are sent with a subsequent
+ * n_dhcp4_server_lease_offer() or n_dhcp4_server_lease_ack().
+ */
+_c_public_ void n_dhcp4_server_lease_set_yiaddr(NDhcp4ServerLease *lease, struct in_addr yiaddr, uint32_t lifetime) {
+        lease->yiaddr = yiaddr;
+        lease->lifetime = lifetime;
+}
+
+/**
+ * n_dhcp4_server_lease_append() - append option to the reply
+ * @lease:                      lease to operate on
+ * @option:                     option code
+ * @data:                       option payload
+ * @n_data:                     length of @data
+ *
+ * Remember an option to be sent with a subsequent offer or ack. Options
+ * managed by the server itself cannot be appended.
+ *
+ * Return: 0 on success, N_DHCP4_E_INTERNAL if @option cannot be appended, or
+ *         a negative error code on failure.
+ */
 _c_public_ int n_dhcp4_server_lease_append(NDhcp4ServerLease *lease, uint8_t option, uint8_t *data, size_t n_data) {
-        /* XXX */
-        return -ENOTRECOVERABLE;
+        uint8_t *options;
+
+        switch (option) {
+        case N_DHCP4_OPTION_PAD:
+        case N_DHCP4_OPTION_REQUESTED_IP_ADDRESS:
+        case N_DHCP4_OPTION_IP_ADDRESS_LEASE_TIME:
+        case N_DHCP4_OPTION_OVERLOAD:
+        case N_DHCP4_OPTION_MESSAGE_TYPE:
+        case N_DHCP4_OPTION_SERVER_IDENTIFIER:
+        case N_DHCP4_OPTION_PARAMETER_REQUEST_LIST:
+        case N_DHCP4_OPTION_ERROR_MESSAGE:
+        case N_DHCP4_OPTION_MAXIMUM_MESSAGE_SIZE:
+        case N_DHCP4_OPTION_RENEWAL_T1_TIME:
+        case N_DHCP4_OPTION_REBINDING_T2_TIME:
+        case N_DHCP4_OPTION_CLIENT_IDENTIFIER:
+        case N_DHCP4_OPTION_END:
+                return N_DHCP4_E_INTERNAL;
+        }
+
+        if (n_data > UINT8_MAX)
+                return N_DHCP4_E_INTERNAL;
+
+        options = realloc(lease->options, lease->n_options + 2 + n_data);
+        if (!options)
+                return -ENOMEM;
+
+        options[lease->n_options++] = option;
+        options[lease->n_options++] = n_data;
+        if (n_data)
+                memcpy(options + lease->n_options, data, n_data);
+        lease->n_options += n_data;
+        lease->options = options;
+
+        return 0;
 }
 
+static int n_dhcp4_server_lease_send(NDhcp4ServerLease *lease, uint8_t type) {
+        _c_cleanup_(n_dhcp4_outgoing_freep) NDhcp4Outgoing *reply = NULL;
+        NDhcp4SConnection *connection;
+        const struct in_addr *server_address;
+        size_t i;
+        int r;
+
+        if (!lease->server || !lease->server->connection.ip)
+                return -ENOTCONN;
+
+        connection = &lease->server->connection;
+        server_address = &connection->ip->ip;
+
+        switch (type) {
+        case N_DHCP4_MESSAGE_OFFER:
+                r = n_dhcp4_s_connection_offer_new(connection,
+                                                   &reply,
+                                                   lease->request,
+                                                   server_address,
+                                                   &lease->yiaddr,
+                                                   lease->lifetime);
+                break;
+        case N_DHCP4_MESSAGE_ACK:
+                r = n_dhcp4_s_connection_ack_new(connection,
+                                                 &reply,
+                                                 lease->request,
+                                                 server_address,
+                                                 &lease->yiaddr,
+                                                 lease->lifetime);
+                break;
+        default:
+                r = n_dhcp4_s_connection_nak_new(connection,
+                                                 &reply,
+                                                 lease->request,
+                                                 server_address);
+                break;
+        }
+        if (r)
+                return r;
+
+        if (type != N_DHCP4_MESSAGE_NAK) {
+                for (i = 0; i < lease->n_options; i += 2 + lease->options[i + 1]) {
+                        r = n_dhcp4_outgoing_append(reply,
+                                                    lease->options[i],
+                                                    lease->options + i + 2,
+                                                    lease->options[i + 1]);
+                        if (r)
+                                return r;
+                }
+        }
+
+        return n_dhcp4_s_connection_send_reply(connection, server_address, reply);
+}
+
+/**
+ * n_dhcp4_server_lease_offer() - send DHCPOFFER
+ * @lease:                      lease to operate on
+ *
+ * Offer the address set via n_dhcp4_server_lease_set_yiaddr() to the client,
+ * together with all appended options.
+ *
+ * Return: 0 on success, or an error code on failure.
+ */
 _c_public_ int n_dhcp4_server_lease_offer(NDhcp4ServerLease *lease) {
-        /* XXX */
-        return -ENOTRECOVERABLE;
+        if (!lease->yiaddr.s_addr)
+                return N_DHCP4_E_INVALID_ADDRESS;
+
+        return n_dhcp4_server_lease_send(lease, N_DHCP4_MESSAGE_OFFER);
 }
 
+/**
+ * n_dhcp4_server_lease_ack() - send DHCPACK
+ * @lease:                      lease to operate on
+ *
+ * Acknowledge the address set via n_dhcp4_server_lease_set_yiaddr() to the
+ * client, together with all appended options.
+ *
+ * Return: 0 on success, or an error code on failure.
+ */
 _c_public_ int n_dhcp4_server_lease_ack(NDhcp4ServerLease *lease) {
-        /* XXX */
-        return -ENOTRECOVERABLE;
+        if (!lease->yiaddr.s_addr)
+                return N_DHCP4_E_INVALID_ADDRESS;
+
+        return n_dhcp4_server_lease_send(lease, N_DHCP4_MESSAGE_ACK);
 }
 
+/**
+ * n_dhcp4_server_lease_nack() - send DHCPNAK
+ * @lease:                      lease to operate on
+ *
+ * Reject the request of the client.
+ *
+ * Return: 0 on success, or an error code on failure.
+ */
 _c_public_ int n_dhcp4_server_lease_nack(NDhcp4ServerLease *lease) {
-        /* XXX */
-        return -ENOTRECOVERABLE;
+        return n_dhcp4_server_lease_send(lease, N_DHCP4_MESSAGE_NAK);
 }
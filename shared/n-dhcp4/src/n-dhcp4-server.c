@@ -78,6 +78,24 @@ NDhcp4SEventNode *n_dhcp4_s_event_node_free(NDhcp4SEventNode *node) {
         if (!node)
                 return NULL;
 
+        switch (node->event.event) {
+        case N_DHCP4_SERVER_EVENT_DISCOVER:
+        case N_DHCP4_SERVER_EVENT_REQUEST:
+        case N_DHCP4_SERVER_EVENT_RENEW:
+        case N_DHCP4_SERVER_EVENT_DECLINE:
+        case N_DHCP4_SERVER_EVENT_RELEASE:
+                /*
+                 * All lease events share the same layout. A lease can be
+                 * replied to until its event is dropped, that is, until the
+                 * next event is popped.
+                 */
+                n_dhcp4_server_lease_unlink(node->event.discover.lease);
+                n_dhcp4_server_lease_unref(node->event.discover.lease);
+                break;
+        default:
+                break;
+        }
+
         c_list_unlink(&node->server_link);
         free(node);
 
@@ -111,9 +129,16 @@ _c_public_ int n_dhcp4_server_new(NDhcp4Server **serverp, NDhcp4ServerConfig *co
 static void n_dhcp4_server_free(NDhcp4Server *server) {
         NDhcp4SEventNode *node, *t_node;
 
+        /* this unlinks all leases, they may outlive the server */
         c_list_for_each_entry_safe(node, t_node, &server->event_list, server_link)
                 n_dhcp4_s_event_node_free(node);
 
+        c_assert(c_list_is_empty(&server->lease_list));
+
+        if (server->connection.ip)
+                n_dhcp4_s_connection_ip_unlink(server->connection.ip);
+        n_dhcp4_s_connection_deinit(&server->connection);
+
         free(server);
 }
 
@@ -161,6 +186,55 @@ _c_public_ void n_dhcp4_server_get_fd(NDhcp4Server *server, int *fdp) {
         n_dhcp4_s_connection_get_fd(&server->connection, fdp);
 }
 
+static int n_dhcp4_server_dispatch_message(NDhcp4Server *server, NDhcp4Incoming *message) {
+        NDhcp4ServerLease *lease;
+        NDhcp4SEventNode *node;
+        unsigned int event;
+        int r;
+
+        switch (message->userdata.type) {
+        case N_DHCP4_C_MESSAGE_DISCOVER:
+                event = N_DHCP4_SERVER_EVENT_DISCOVER;
+                break;
+        case N_DHCP4_C_MESSAGE_SELECT:
+        case N_DHCP4_C_MESSAGE_REBOOT:
+                event = N_DHCP4_SERVER_EVENT_REQUEST;
+                break;
+        case N_DHCP4_C_MESSAGE_RENEW:
+        case N_DHCP4_C_MESSAGE_REBIND:
+                event = N_DHCP4_SERVER_EVENT_RENEW;
+                break;
+        case N_DHCP4_C_MESSAGE_DECLINE:
+                event = N_DHCP4_SERVER_EVENT_DECLINE;
+                break;
+        case N_DHCP4_C_MESSAGE_RELEASE:
+                event = N_DHCP4_SERVER_EVENT_RELEASE;
+                break;
+        default:
+                /* requests addressed to other servers */
+                n_dhcp4_incoming_free(message);
+                return 0;
+        }
+
+        r = n_dhcp4_server_lease_new(&lease, message);
+        if (r) {
+                n_dhcp4_incoming_free(message);
+                return r;
+        }
+
+        r = n_dhcp4_server_raise(server, &node, event);
+        if (r) {
+                n_dhcp4_server_lease_unref(lease);
+                return r;
+        }
+
+        n_dhcp4_server_lease_link(lease, server);
+
+        /* all lease events share the same layout */
+        node->event.discover.lease = lease;
+        return 0;
+}
+
 /**
  * n_dhcp4_server_dispatch() - XXX
  */
@@ -176,6 +250,15 @@ _c_public_ int n_dhcp4_server_dispatch(NDhcp4Server *server) {
                                 return 0;
                         return r;
                 }
+
+                if (!message)
+                        continue;
+
+                /* ownership is transferred, even on failure */
+                r = n_dhcp4_server_dispatch_message(server, message);
+                message = NULL;
+                if (r)
+                        return r;
         }
 
         return N_DHCP4_E_PREEMPTED;
@@ -233,7 +316,8 @@ _c_public_ NDhcp4ServerIp *n_dhcp4_server_ip_free(NDhcp4ServerIp *ip) {
         if (!ip)
                 return NULL;
 
-        n_dhcp4_s_connection_ip_unlink(&ip->ip);
+        if (ip->ip.connection)
+                n_dhcp4_s_connection_ip_unlink(&ip->ip);
         n_dhcp4_s_connection_ip_deinit(&ip->ip);
 
         free(ip);
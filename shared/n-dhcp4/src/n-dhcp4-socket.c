@@ -22,13 +22,14 @@
 /**
  * n_dhcp4_c_socket_packet_new() - create a new DHCP4 client packet socket
  * @sockfdp:            return argumnet for the new socket
- * @ifindex:            interface index to bind to
+ * @ifindex:            interface index to bind to, or 0
  *
  * Create a new AF_PACKET/SOCK_DGRAM socket usable to listen to and send DHCP client
  * packets before an IP address has been configured.
  *
  * Only unfragmented DHCP packets from a server to a client destined for the given
- * ifindex is returned.
+ * ifindex is returned. If @ifindex is 0, the socket is not bound and receives
+ * such packets from all interfaces, see n_dhcp4_c_socket_packet_recvfrom().
  *
  * Return: 0 on success, or a negative error code on failure.
  */
@@ -210,6 +211,14 @@ int n_dhcp4_c_socket_udp_new(int *sockfdp,
         if (r < 0)
                 return -errno;
 
+        /*
+         * The lease is accepted before the caller had a chance to configure
+         * the address on the interface, allow binding to it anyway.
+         */
+        r = setsockopt(sockfd, IPPROTO_IP, IP_FREEBIND, &on, sizeof(on));
+        if (r < 0)
+                return -errno;
+
         r = bind(sockfd, (struct sockaddr*)&saddr, sizeof(saddr));
         if (r < 0)
                 return -errno;
@@ -545,15 +554,16 @@ int n_dhcp4_s_socket_udp_broadcast(int sockfd,
                                          message);
 }
 
-int n_dhcp4_c_socket_packet_recv(int sockfd,
-                                 uint8_t *buf,
-                                 size_t n_buf,
-                                 NDhcp4Incoming **messagep) {
+int n_dhcp4_c_socket_packet_recvfrom(int sockfd,
+                                     uint8_t *buf,
+                                     size_t n_buf,
+                                     NDhcp4Incoming **messagep,
+                                     int *ifindexp) {
         _c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *message = NULL;
         size_t len;
         int r;
 
-        r = packet_recv_udp(sockfd, buf, n_buf, &len);
+        r = packet_recvfrom_udp(sockfd, buf, n_buf, &len, NULL, ifindexp);
         if (r < 0) {
                 if (r == -ENETDOWN)
                         return N_DHCP4_E_DOWN;
@@ -574,6 +584,13 @@ int n_dhcp4_c_socket_packet_recv(int sockfd,
         return 0;
 }
 
+int n_dhcp4_c_socket_packet_recv(int sockfd,
+                                 uint8_t *buf,
+                                 size_t n_buf,
+                                 NDhcp4Incoming **messagep) {
+        return n_dhcp4_c_socket_packet_recvfrom(sockfd, buf, n_buf, messagep, NULL);
+}
+
 static int n_dhcp4_socket_udp_recv(int sockfd,
                                    uint8_t *buf,
                                    size_t n_buf,
@@ -23,6 +23,7 @@ typedef struct NDhcp4ClientEvent NDhcp4ClientEvent;
 typedef struct NDhcp4ClientLease NDhcp4ClientLease;
 typedef struct NDhcp4ClientProbe NDhcp4ClientProbe;
 typedef struct NDhcp4ClientProbeConfig NDhcp4ClientProbeConfig;
+typedef struct NDhcp4ClientSocket NDhcp4ClientSocket;
 typedef struct NDhcp4Server NDhcp4Server;
 typedef struct NDhcp4ServerConfig NDhcp4ServerConfig;
 typedef struct NDhcp4ServerEvent NDhcp4ServerEvent;
@@ -96,7 +97,7 @@ struct NDhcp4ServerEvent {
                 } down;
                 struct {
                         NDhcp4ServerLease *lease;
-                } discover, request, decline, release;
+                } discover, request, renew, decline, release;
         };
 };
 
@@ -111,6 +112,16 @@ void n_dhcp4_client_config_set_request_broadcast(NDhcp4ClientConfig *config, boo
 void n_dhcp4_client_config_set_mac(NDhcp4ClientConfig *config, const uint8_t *mac, size_t n_mac);
 void n_dhcp4_client_config_set_broadcast_mac(NDhcp4ClientConfig *config, const uint8_t *mac, size_t n_mac);
 int n_dhcp4_client_config_set_client_id(NDhcp4ClientConfig *config, const uint8_t *id, size_t n_id);
+void n_dhcp4_client_config_set_socket(NDhcp4ClientConfig *config, NDhcp4ClientSocket *client_socket);
+
+/* client sockets */
+
+int n_dhcp4_client_socket_new(NDhcp4ClientSocket **client_socketp);
+NDhcp4ClientSocket *n_dhcp4_client_socket_ref(NDhcp4ClientSocket *client_socket);
+NDhcp4ClientSocket *n_dhcp4_client_socket_unref(NDhcp4ClientSocket *client_socket);
+
+void n_dhcp4_client_socket_get_fd(NDhcp4ClientSocket *client_socket, int *fdp);
+int n_dhcp4_client_socket_dispatch(NDhcp4ClientSocket *client_socket, NDhcp4Client **clientp);
 
 /* client-probe configs */
 
@@ -149,6 +160,7 @@ NDhcp4ClientProbe *n_dhcp4_client_probe_free(NDhcp4ClientProbe *probe);
 
 void n_dhcp4_client_probe_set_userdata(NDhcp4ClientProbe *probe, void *userdata);
 void n_dhcp4_client_probe_get_userdata(NDhcp4ClientProbe *probe, void **userdatap);
+int n_dhcp4_client_probe_release(NDhcp4ClientProbe *probe);
 
 /* client leases */
 
@@ -192,6 +204,9 @@ NDhcp4ServerLease *n_dhcp4_server_lease_ref(NDhcp4ServerLease *lease);
 NDhcp4ServerLease *n_dhcp4_server_lease_unref(NDhcp4ServerLease *lease);
 
 int n_dhcp4_server_lease_query(NDhcp4ServerLease *lease, uint8_t option, uint8_t **datap, size_t *n_datap);
+void n_dhcp4_server_lease_get_chaddr(NDhcp4ServerLease *lease, const uint8_t **chaddrp, size_t *n_chaddrp);
+int n_dhcp4_server_lease_get_requested_ip(NDhcp4ServerLease *lease, struct in_addr *ipp);
+void n_dhcp4_server_lease_set_yiaddr(NDhcp4ServerLease *lease, struct in_addr yiaddr, uint32_t lifetime);
 int n_dhcp4_server_lease_append(NDhcp4ServerLease *lease, uint8_t option, uint8_t *data, size_t n_data);
 
 int n_dhcp4_server_lease_offer(NDhcp4ServerLease *lease);
@@ -218,6 +233,15 @@ static inline void n_dhcp4_client_probe_config_freev(NDhcp4ClientProbeConfig *p)
         n_dhcp4_client_probe_config_free(p);
 }
 
+static inline void n_dhcp4_client_socket_unrefp(NDhcp4ClientSocket **p) {
+        if (*p)
+                n_dhcp4_client_socket_unref(*p);
+}
+
+static inline void n_dhcp4_client_socket_unrefv(NDhcp4ClientSocket *p) {
+        n_dhcp4_client_socket_unref(p);
+}
+
 static inline void n_dhcp4_client_unrefp(NDhcp4Client **p) {
         if (*p)
                 n_dhcp4_client_unref(*p);
@@ -245,19 +245,24 @@ int packet_sendto_udp(int sockfd,
  * @n_buf:              max length of payload in bytes
  * @n_transmittedp:     output argument for number transmitted bytes
  * @src:                return argumnet for source address, or NULL, see ip(7)
+ * @ifindexp:           return argument for the receiving interface, or NULL
  *
  * Receives an UDP packet on a AF_PACKET socket. The difference between
  * this and recvfrom() on an AF_INET socket is that the packet will be
  * received even if the destination IP address has not been configured
  * on the interface.
  *
+ * If the socket is not bound to a specific interface, @ifindexp can be used
+ * to learn which interface the packet was received on.
+ *
  * Return: 0 on success, negative error code on failure.
  */
 int packet_recvfrom_udp(int sockfd,
                         void *buf,
                         size_t n_buf,
                         size_t *n_transmittedp,
-                        struct sockaddr_in *src) {
+                        struct sockaddr_in *src,
+                        int *ifindexp) {
         union {
                 struct iphdr hdr;
                 /*
@@ -282,7 +287,10 @@ int packet_recvfrom_udp(int sockfd,
                 },
         };
         uint8_t cmsgbuf[CMSG_LEN(sizeof(struct tpacket_auxdata))];
+        struct sockaddr_ll haddr = {};
         struct msghdr msg = {
+                .msg_name = &haddr,
+                .msg_namelen = sizeof(haddr),
                 .msg_iov = iov,
                 .msg_iovlen = sizeof(iov) / sizeof(iov[0]),
                 .msg_control = cmsgbuf,
@@ -422,6 +430,9 @@ int packet_recvfrom_udp(int sockfd,
                 src->sin_port = udp_hdr.source;
         }
 
+        if (ifindexp)
+                *ifindexp = haddr.sll_ifindex;
+
         /* Return length of UDP payload (i.e., data written to @buf). */
         *n_transmittedp = pktlen;
         return 0;
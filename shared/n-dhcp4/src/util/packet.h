@@ -48,7 +48,8 @@ int packet_recvfrom_udp(int sockfd,
                         void *buf,
                         size_t n_buf,
                         size_t *n_transmittedp,
-                        struct sockaddr_in *src);
+                        struct sockaddr_in *src,
+                        int *ifindexp);
 
 int packet_shutdown(int sockfd);
 
@@ -58,5 +59,5 @@ static inline int packet_recv_udp(int sockfd,
                                   void *buf,
                                   size_t n_buf,
                                   size_t *n_transmittedp) {
-        return packet_recvfrom_udp(sockfd, buf, n_buf, n_transmittedp, NULL);
+        return packet_recvfrom_udp(sockfd, buf, n_buf, n_transmittedp, NULL, NULL);
 }
@@ -25,22 +25,51 @@
 #include <syslog.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
 
 #include "nm-io-utils.h"
 
 /*****************************************************************************/
 
+/* NMKeyFileDB persists its content in two files: the keyfile itself (@filename)
+ * and an append-only journal (@journal_filename).
+ *
+ * Regular flushes only append the entries that changed since the last flush
+ * to the journal. That way, updating one timestamp does not require rewriting
+ * the entire file. Each record in the journal is one line, either
+ * "+<key>=<escaped-value>" (set) or "-<key>" (remove). The value is in the
+ * escaped form of g_key_file_get_value().
+ *
+ * Once the journal grows beyond JOURNAL_MAX_RECORDS, or when forced, the keyfile
+ * is rewritten in full and the journal deleted ("compaction").
+ *
+ * On start, the journal is replayed on top of the keyfile. Records are absolute
+ * values, so replaying them is idempotent and it does not matter if we crashed
+ * between rewriting the keyfile and deleting the journal. A record that
+ * was only partially written is ignored, and the journal gets compacted
+ * with the next flush. */
+#define JOURNAL_MAX_RECORDS 500
+
 struct _NMKeyFileDB {
 	NMKeyFileDBLogFcn log_fcn;
 	NMKeyFileDBGotDirtyFcn got_dirty_fcn;
 	gpointer user_data;
 	const char *group_name;
+	const char *journal_filename;
 	GKeyFile *kf;
+
+	/* the keys that changed since the last flush. */
+	GHashTable *journal_keys;
+
+	/* the number of records in the journal file. */
+	guint journal_len;
+
 	guint ref_count;
 
 	bool is_started:1;
 	bool dirty:1;
 	bool destroyed:1;
+	bool journal_needs_compact:1;
 
 	char filename[];
 };
@@ -96,6 +125,7 @@ nm_key_file_db_new (const char *filename,
 	NMKeyFileDB *self;
 	gsize l_filename;
 	gsize l_group;
+	char *s;
 
 	g_return_val_if_fail (filename && filename[0], NULL);
 	g_return_val_if_fail (group_name && group_name[0], NULL);
@@ -103,16 +133,22 @@ nm_key_file_db_new (const char *filename,
 	l_filename = strlen (filename);
 	l_group = strlen (group_name);
 
-	self = g_malloc0 (sizeof (NMKeyFileDB) + l_filename + 1 + l_group + 1);
+	self = g_malloc0 (sizeof (NMKeyFileDB) + l_filename + 1 + l_group + 1 + l_filename + NM_STRLEN (".journal") + 1);
 	self->ref_count = 1;
 	self->log_fcn = log_fcn;
 	self->got_dirty_fcn = got_dirty_fcn;
 	self->user_data = user_data;
 	self->kf = g_key_file_new ();
 	g_key_file_set_list_separator (self->kf, ',');
+	self->journal_keys = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, NULL);
 	memcpy (self->filename, filename, l_filename + 1);
-	self->group_name = &self->filename[l_filename + 1];
-	memcpy ((char *) self->group_name, group_name, l_group + 1);
+	s = &self->filename[l_filename + 1];
+	self->group_name = s;
+	memcpy (s, group_name, l_group + 1);
+	s = &s[l_group + 1];
+	self->journal_filename = s;
+	memcpy (s, filename, l_filename);
+	memcpy (&s[l_filename], ".journal", NM_STRLEN (".journal") + 1);
 
 	return self;
 }
@@ -142,6 +178,7 @@ nm_key_file_db_unref (NMKeyFileDB *self)
 		return;
 
 	g_key_file_unref (self->kf);
+	g_hash_table_unref (self->journal_keys);
 
 	g_free (self);
 }
@@ -177,6 +214,64 @@ nm_key_file_db_destroy (NMKeyFileDB *self)
 
 /*****************************************************************************/
 
+static void
+_journal_replay (NMKeyFileDB *self,
+                 const char *contents,
+                 gsize contents_len)
+{
+	const char *s = contents;
+	const char *end = &contents[contents_len];
+	guint n_invalid = 0;
+
+	while (s < end) {
+		gs_free char *line = NULL;
+		const char *eol;
+		char *eq;
+
+		eol = memchr (s, '\n', end - s);
+		if (!eol) {
+			/* an incomplete record at the end. We likely crashed while
+			 * appending it. Ignore it. */
+			_LOGD ("journal \"%s\" has incomplete trailing record", self->journal_filename);
+			self->journal_needs_compact = TRUE;
+			break;
+		}
+
+		line = g_strndup (s, eol - s);
+		s = &eol[1];
+
+		if (line[0] == '\0')
+			continue;
+
+		if (line[0] == '+') {
+			eq = strchr (&line[1], '=');
+			if (   !eq
+			    || eq == &line[1]) {
+				n_invalid++;
+				continue;
+			}
+			*eq = '\0';
+			g_key_file_set_value (self->kf, self->group_name, &line[1], &eq[1]);
+		} else if (line[0] == '-') {
+			if (line[1] == '\0') {
+				n_invalid++;
+				continue;
+			}
+			g_key_file_remove_key (self->kf, self->group_name, &line[1], NULL);
+		} else {
+			n_invalid++;
+			continue;
+		}
+
+		self->journal_len++;
+	}
+
+	if (n_invalid > 0) {
+		_LOGD ("journal \"%s\" has %u invalid records", self->journal_filename, n_invalid);
+		self->journal_needs_compact = TRUE;
+	}
+}
+
 /* nm_key_file_db_start() is supposed to be called right away, after creating the
  * instance.
  *
@@ -203,21 +298,37 @@ nm_key_file_db_start (NMKeyFileDB *self)
 	                                &contents,
 	                                &contents_len,
 	                                &error);
-	if (r < 0) {
+	if (r < 0)
 		_LOGD ("failed to read \"%s\": %s", self->filename, error->message);
-		return;
-	}
-
-	if (!g_key_file_load_from_data (self->kf,
-	                                contents,
-	                                contents_len,
-	                                G_KEY_FILE_KEEP_COMMENTS,
-	                                &error)) {
+	else if (!g_key_file_load_from_data (self->kf,
+	                                     contents,
+	                                     contents_len,
+	                                     G_KEY_FILE_KEEP_COMMENTS,
+	                                     &error))
 		_LOGD ("failed to load keyfile \"%s\": %s", self->filename, error->message);
+	else
+		_LOGD ("loaded keyfile-db for \"%s\"", self->filename);
+
+	g_clear_error (&error);
+	nm_clear_g_free (&contents);
+
+	r = nm_utils_file_get_contents (-1,
+	                                self->journal_filename,
+	                                20*1024*1024,
+	                                NM_UTILS_FILE_GET_CONTENTS_FLAG_NONE,
+	                                &contents,
+	                                &contents_len,
+	                                &error);
+	if (r < 0) {
+		if (r != -ENOENT) {
+			_LOGD ("failed to read journal \"%s\": %s", self->journal_filename, error->message);
+			self->journal_needs_compact = TRUE;
+		}
 		return;
 	}
 
-	_LOGD ("loaded keyfile-db for \"%s\"", self->filename);
+	_journal_replay (self, contents, contents_len);
+	_LOGD ("replayed %u records from journal \"%s\"", self->journal_len, self->journal_filename);
 }
 
 /*****************************************************************************/
@@ -270,6 +381,7 @@ _got_dirty (NMKeyFileDB *self,
 
 	_LOGD ("updated entry for %s.%s", self->group_name, key);
 
+	g_hash_table_add (self->journal_keys, g_strdup (key));
 	self->dirty = TRUE;
 	if (self->got_dirty_fcn)
 		self->got_dirty_fcn (self, self->user_data);
@@ -288,12 +400,11 @@ nm_key_file_db_remove_key (NMKeyFileDB *self,
 	if (!key)
 		return;
 
-	if (!self->dirty) {
-		gs_free_error GError *error = NULL;
+	if (!self->dirty)
+		got_dirty = g_key_file_has_key (self->kf, self->group_name, key, NULL);
+	else
+		g_hash_table_add (self->journal_keys, g_strdup (key));
 
-		g_key_file_has_key (self->kf, self->group_name, key, &error);
-		got_dirty = (error != NULL);
-	}
 	g_key_file_remove_key (self->kf, self->group_name, key, NULL);
 
 	if (got_dirty)
@@ -340,6 +451,8 @@ nm_key_file_db_set_value (NMKeyFileDB *self,
 
 	if (got_dirty)
 		_got_dirty (self, key);
+	else if (self->dirty)
+		g_hash_table_add (self->journal_keys, g_strdup (key));
 }
 
 void
@@ -386,6 +499,101 @@ nm_key_file_db_set_string_list (NMKeyFileDB *self,
 
 	if (got_dirty)
 		_got_dirty (self, key);
+	else if (self->dirty)
+		g_hash_table_add (self->journal_keys, g_strdup (key));
+}
+
+/*****************************************************************************/
+
+static gboolean
+_journal_append (NMKeyFileDB *self)
+{
+	nm_auto_free_gstring GString *str = NULL;
+	nm_auto_close int fd = -1;
+	GHashTableIter iter;
+	const char *key;
+	const char *buf;
+	gsize len;
+	guint n;
+
+	n = g_hash_table_size (self->journal_keys);
+	if (n == 0)
+		return TRUE;
+
+	str = g_string_sized_new (n * 64);
+	g_hash_table_iter_init (&iter, self->journal_keys);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &key, NULL)) {
+		gs_free char *value = NULL;
+
+		value = g_key_file_get_value (self->kf, self->group_name, key, NULL);
+		if (value)
+			g_string_append_printf (str, "+%s=%s\n", key, value);
+		else
+			g_string_append_printf (str, "-%s\n", key);
+	}
+
+	fd = open (self->journal_filename, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		int errsv = errno;
+
+		_LOGD ("failure to open journal \"%s\": %s", self->journal_filename, nm_strerror_native (errsv));
+		return FALSE;
+	}
+
+	buf = str->str;
+	len = str->len;
+	while (len > 0) {
+		gssize w;
+
+		w = write (fd, buf, len);
+		if (w < 0) {
+			int errsv = errno;
+
+			if (errsv == EINTR)
+				continue;
+			_LOGD ("failure to append to journal \"%s\": %s", self->journal_filename, nm_strerror_native (errsv));
+
+			/* the journal might now contain a partial record. Don't append
+			 * to it anymore. */
+			self->journal_needs_compact = TRUE;
+			return FALSE;
+		}
+		buf += w;
+		len -= w;
+	}
+
+	self->journal_len += n;
+	g_hash_table_remove_all (self->journal_keys);
+	_LOGD ("append %u records to journal \"%s\" (%u total)", n, self->journal_filename, self->journal_len);
+	return TRUE;
+}
+
+static void
+_compact (NMKeyFileDB *self)
+{
+	gs_free_error GError *error = NULL;
+
+	if (!g_key_file_save_to_file (self->kf,
+	                              self->filename,
+	                              &error)) {
+		/* keep tracking the pending keys, so that they are retried. */
+		_LOGD ("failure to write keyfile \"%s\": %s", self->filename, error->message);
+		return;
+	}
+
+	_LOGD ("write keyfile: \"%s\"", self->filename);
+
+	g_hash_table_remove_all (self->journal_keys);
+
+	/* the keyfile now contains everything. Drop the journal. */
+	if (   unlink (self->journal_filename) != 0
+	    && errno != ENOENT) {
+		int errsv = errno;
+
+		_LOGD ("failure to delete journal \"%s\": %s", self->journal_filename, nm_strerror_native (errsv));
+	}
+	self->journal_len = 0;
+	self->journal_needs_compact = FALSE;
 }
 
 /*****************************************************************************/
@@ -394,8 +602,6 @@ void
 nm_key_file_db_to_file (NMKeyFileDB *self,
                         gboolean force)
 {
-	gs_free_error GError *error = NULL;
-
 	g_return_if_fail (_IS_KEY_FILE_DB (self, TRUE, FALSE));
 
 	if (   !force
@@ -404,10 +610,11 @@ nm_key_file_db_to_file (NMKeyFileDB *self,
 
 	self->dirty = FALSE;
 
-	if (!g_key_file_save_to_file (self->kf,
-	                              self->filename,
-	                              &error)) {
-		_LOGD ("failure to write keyfile \"%s\": %s", self->filename, error->message);
-	} else
-		_LOGD ("write keyfile: \"%s\"", self->filename);
+	if (   !force
+	    && !self->journal_needs_compact
+	    && self->journal_len + g_hash_table_size (self->journal_keys) <= JOURNAL_MAX_RECORDS
+	    && _journal_append (self))
+		return;
+
+	_compact (self);
 }
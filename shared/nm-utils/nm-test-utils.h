@@ -677,6 +677,51 @@ nmtst_test_quick (void)
 	return __nmtst_internal.test_quick;
 }
 
+/* Whether the test runs in perf mode ("-m perf"), see nmtst_benchmark(). */
+static inline gboolean
+nmtst_test_perf (void)
+{
+	g_assert (nmtst_initialized ());
+	return g_test_perf ();
+}
+
+/**
+ * nmtst_benchmark:
+ * @name: what is measured, for the log message
+ * @n_iterations: how often to call @func
+ * @func: the operation to measure
+ * @user_data: the argument for @func
+ *
+ * Calls @func @n_iterations times and logs the time it took. A benchmark
+ * asserts no behavior, so this does nothing unless the test runs in perf
+ * mode.
+ */
+static inline void
+nmtst_benchmark (const char *name,
+                 guint n_iterations,
+                 void (*func) (gpointer user_data),
+                 gpointer user_data)
+{
+	GTimer *timer;
+	double elapsed;
+	guint i;
+
+	if (!nmtst_test_perf ())
+		return;
+
+	timer = g_timer_new ();
+	for (i = 0; i < n_iterations; i++)
+		func (user_data);
+	elapsed = g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	g_test_message ("benchmark: %s: %u iterations in %.3f sec (%.0f/sec)",
+	                name,
+	                n_iterations,
+	                elapsed,
+	                elapsed > 0 ? n_iterations / elapsed : 0.0);
+}
+
 #if GLIB_CHECK_VERSION(2,34,0)
 #undef g_test_expect_message
 #define g_test_expect_message(...) \
@@ -21,9 +21,13 @@
 
 #include "nm-default.h"
 
+#include <fcntl.h>
+
 #include "nm-std-aux/unaligned.h"
 #include "nm-glib-aux/nm-random-utils.h"
 #include "nm-glib-aux/nm-time-utils.h"
+#include "nm-glib-aux/nm-keyfile-aux.h"
+#include "nm-glib-aux/nm-io-utils.h"
 
 #include "nm-utils/nm-test-utils.h"
 
@@ -429,6 +433,87 @@ test_strstrip_avoid_copy (void)
 }
 /*****************************************************************************/
 
+static NMKeyFileDB *
+_kf_db_new_started (const char *filename)
+{
+	NMKeyFileDB *kf_db;
+
+	kf_db = nm_key_file_db_new (filename, "group", NULL, NULL, NULL);
+	nm_key_file_db_start (kf_db);
+	return kf_db;
+}
+
+static void
+test_key_file_db_journal (void)
+{
+	gs_free char *tmpdir = NULL;
+	gs_free char *filename = NULL;
+	gs_free char *filename_journal = NULL;
+	gs_free char *value = NULL;
+	gs_strfreev char **strv = NULL;
+	gsize len;
+	NMKeyFileDB *kf_db;
+	int fd;
+
+	tmpdir = g_dir_make_tmp ("nm-test-kf-db-XXXXXX", NULL);
+	g_assert (tmpdir);
+	filename = g_build_filename (tmpdir, "timestamps", NULL);
+	filename_journal = g_strdup_printf ("%s.journal", filename);
+
+	kf_db = _kf_db_new_started (filename);
+	nm_key_file_db_set_value (kf_db, "k1", "1");
+	nm_key_file_db_set_value (kf_db, "k2", "2");
+	g_assert (nm_key_file_db_is_dirty (kf_db));
+	nm_key_file_db_to_file (kf_db, FALSE);
+	g_assert (!nm_key_file_db_is_dirty (kf_db));
+
+	/* regular flushes only append to the journal. */
+	g_assert (!g_file_test (filename, G_FILE_TEST_EXISTS));
+	g_assert (g_file_test (filename_journal, G_FILE_TEST_EXISTS));
+
+	nm_key_file_db_remove_key (kf_db, "k1");
+	nm_key_file_db_set_value (kf_db, "k2", "3");
+	{
+		const char *const bssids[] = { "aa:bb:cc:dd:ee:ff", "11:22:33:44:55:66", NULL };
+
+		nm_key_file_db_set_string_list (kf_db, "k3", bssids, -1);
+	}
+	nm_key_file_db_to_file (kf_db, FALSE);
+	nm_key_file_db_destroy (kf_db);
+
+	/* simulate a crash while appending a record. */
+	fd = open (filename_journal, O_WRONLY | O_APPEND | O_CLOEXEC);
+	g_assert (fd >= 0);
+	g_assert_cmpint (write (fd, "+k2=4", 5), ==, 5);
+	nm_close (fd);
+
+	kf_db = _kf_db_new_started (filename);
+	value = nm_key_file_db_get_value (kf_db, "k1");
+	g_assert_cmpstr (value, ==, NULL);
+	value = nm_key_file_db_get_value (kf_db, "k2");
+	g_assert_cmpstr (value, ==, "3");
+	nm_clear_g_free (&value);
+	strv = nm_key_file_db_get_string_list (kf_db, "k3", &len);
+	g_assert_cmpint (len, ==, 2);
+	g_assert_cmpstr (strv[1], ==, "11:22:33:44:55:66");
+
+	/* forcing a write compacts the journal into the keyfile. */
+	nm_key_file_db_to_file (kf_db, TRUE);
+	g_assert (g_file_test (filename, G_FILE_TEST_EXISTS));
+	g_assert (!g_file_test (filename_journal, G_FILE_TEST_EXISTS));
+	nm_key_file_db_destroy (kf_db);
+
+	kf_db = _kf_db_new_started (filename);
+	value = nm_key_file_db_get_value (kf_db, "k2");
+	g_assert_cmpstr (value, ==, "3");
+	nm_key_file_db_destroy (kf_db);
+
+	g_assert_cmpint (unlink (filename), ==, 0);
+	g_assert_cmpint (rmdir (tmpdir), ==, 0);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int main (int argc, char **argv)
@@ -444,6 +529,7 @@ int main (int argc, char **argv)
 	g_test_add_func ("/general/test_unaligned", test_unaligned);
 	g_test_add_func ("/general/test_strv_cmp", test_strv_cmp);
 	g_test_add_func ("/general/test_strstrip_avoid_copy", test_strstrip_avoid_copy);
+	g_test_add_func ("/general/test_key_file_db_journal", test_key_file_db_journal);
 
 	return g_test_run ();
 }
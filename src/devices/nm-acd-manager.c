@@ -35,7 +35,21 @@ typedef enum {
 	STATE_ANNOUNCING,
 } State;
 
+/* All managers of an interface share one NAcd context, so that there is
+ * only one packet socket, BPF map and event source per interface, no matter
+ * how many addresses are probed or announced. The probes of all managers run
+ * concurrently on it. */
 typedef struct {
+	int            ref_count;
+	int            ifindex;
+	guint8         hwaddr[ETH_ALEN];
+	NAcd          *acd;
+	GIOChannel    *channel;
+	guint          event_id;
+} AcdContext;
+
+typedef struct {
+	NMAcdManager *self;
 	in_addr_t address;
 	gboolean duplicate;
 	NAcdProbe *probe;
@@ -47,14 +61,15 @@ struct _NMAcdManager {
 	State          state;
 	GHashTable    *addresses;
 	guint          completed;
-	NAcd          *acd;
-	GIOChannel    *channel;
-	guint          event_id;
+	AcdContext    *context;
 
 	NMAcdCallbacks callbacks;
 	gpointer user_data;
 };
 
+/* ifindex -> AcdContext */
+static GHashTable *acd_contexts;
+
 /*****************************************************************************/
 
 #define _NMLOG_DOMAIN         LOGD_IP4
@@ -159,6 +174,7 @@ nm_acd_manager_add_address (NMAcdManager *self, in_addr_t address)
 		return FALSE;
 
 	info = g_slice_new0 (AddressInfo);
+	info->self = self;
 	info->address = address;
 
 	g_hash_table_insert (self->addresses, GUINT_TO_POINTER (address), info);
@@ -166,84 +182,185 @@ nm_acd_manager_add_address (NMAcdManager *self, in_addr_t address)
 	return TRUE;
 }
 
-static gboolean
-acd_event (GIOChannel *source, GIOCondition condition, gpointer data)
+static void
+acd_handle_event (NMAcdManager *self, AddressInfo *info, NAcdEvent *event)
 {
-	NMAcdManager *self = data;
-	NAcdEvent *event;
-	AddressInfo *info;
-	gboolean emit_probe_terminated = FALSE;
+	gboolean check_probing_done = FALSE;
 	char address_str[INET_ADDRSTRLEN];
 	gs_free char *hwaddr_str = NULL;
 	int r;
 
-	if (n_acd_dispatch (self->acd))
+	switch (event->event) {
+	case N_ACD_EVENT_READY:
+		info->duplicate = FALSE;
+		if (self->state == STATE_ANNOUNCING) {
+			/* fake probe ended, start announcing */
+			r = n_acd_probe_announce (info->probe, N_ACD_DEFEND_ONCE);
+			if (r) {
+				_LOGW ("couldn't announce address %s on interface '%s': %s",
+				       nm_utils_inet4_ntop (info->address, address_str),
+				       nm_platform_link_get_name (NM_PLATFORM_GET, self->ifindex),
+				       acd_error_to_string (r));
+			} else {
+				_LOGD ("announcing address %s",
+				       nm_utils_inet4_ntop (info->address, address_str));
+			}
+		}
+		check_probing_done = TRUE;
+		break;
+	case N_ACD_EVENT_USED:
+		info->duplicate = TRUE;
+		check_probing_done = TRUE;
+		break;
+	case N_ACD_EVENT_DEFENDED:
+		_LOGD ("defended address %s from host %s",
+		       nm_utils_inet4_ntop (info->address, address_str),
+		       (hwaddr_str = nm_utils_hwaddr_ntoa (event->defended.sender,
+		                                           event->defended.n_sender)));
+		break;
+	case N_ACD_EVENT_CONFLICT:
+		_LOGW ("conflict for address %s detected with host %s on interface '%s'",
+		       nm_utils_inet4_ntop (info->address, address_str),
+		       (hwaddr_str = nm_utils_hwaddr_ntoa (event->conflict.sender,
+		                                           event->conflict.n_sender)),
+		       nm_platform_link_get_name (NM_PLATFORM_GET, self->ifindex));
+		break;
+	default:
+		nm_assert_not_reached ();
+		break;
+	}
+
+	if (   check_probing_done
+	    && self->state == STATE_PROBING
+	    && ++self->completed == g_hash_table_size (self->addresses)) {
+		self->state = STATE_PROBE_DONE;
+
+		/* the callback may free the manager. */
+		if (self->callbacks.probe_terminated_callback) {
+			self->callbacks.probe_terminated_callback (self,
+			                                           self->user_data);
+		}
+	}
+}
+
+static void acd_context_unref (AcdContext *context);
+
+static gboolean
+acd_context_event (GIOChannel *source, GIOCondition condition, gpointer data)
+{
+	AcdContext *context = data;
+	NMAcdManager *self = NULL;
+	NAcdEvent *event;
+	AddressInfo *info;
+
+	if (n_acd_dispatch (context->acd))
 		return G_SOURCE_CONTINUE;
 
-	while (   !n_acd_pop_event (self->acd, &event)
+	/* the managers notified below may drop the last reference. */
+	context->ref_count++;
+
+	while (   !n_acd_pop_event (context->acd, &event)
 	       && event) {
-		gboolean check_probing_done = FALSE;
+		NAcdProbe *probe;
 
 		switch (event->event) {
 		case N_ACD_EVENT_READY:
-			n_acd_probe_get_userdata (event->ready.probe, (void **) &info);
-			info->duplicate = FALSE;
-			if (self->state == STATE_ANNOUNCING) {
-				/* fake probe ended, start announcing */
-				r = n_acd_probe_announce (info->probe, N_ACD_DEFEND_ONCE);
-				if (r) {
-					_LOGW ("couldn't announce address %s on interface '%s': %s",
-					       nm_utils_inet4_ntop (info->address, address_str),
-					       nm_platform_link_get_name (NM_PLATFORM_GET, self->ifindex),
-					       acd_error_to_string (r));
-				} else {
-					_LOGD ("announcing address %s",
-					       nm_utils_inet4_ntop (info->address, address_str));
-				}
-			}
-			check_probing_done = TRUE;
+			probe = event->ready.probe;
 			break;
 		case N_ACD_EVENT_USED:
-			n_acd_probe_get_userdata (event->used.probe, (void **) &info);
-			info->duplicate = TRUE;
-			check_probing_done = TRUE;
+			probe = event->used.probe;
 			break;
 		case N_ACD_EVENT_DEFENDED:
-			n_acd_probe_get_userdata (event->defended.probe, (void **) &info);
-			_LOGD ("defended address %s from host %s",
-			       nm_utils_inet4_ntop (info->address, address_str),
-			       (hwaddr_str = nm_utils_hwaddr_ntoa (event->defended.sender,
-			                                           event->defended.n_sender)));
+			probe = event->defended.probe;
 			break;
 		case N_ACD_EVENT_CONFLICT:
-			n_acd_probe_get_userdata (event->conflict.probe, (void **) &info);
-			_LOGW ("conflict for address %s detected with host %s on interface '%s'",
-			       nm_utils_inet4_ntop (info->address, address_str),
-			       (hwaddr_str = nm_utils_hwaddr_ntoa (event->defended.sender,
-			                                           event->defended.n_sender)),
-			       nm_platform_link_get_name (NM_PLATFORM_GET, self->ifindex));
+			probe = event->conflict.probe;
 			break;
 		default:
-			_LOGD ("unhandled event '%s'", acd_event_to_string_a (event->event));
-			break;
+			_LOGD ("unhandled event '%s' on interface %d",
+			       acd_event_to_string_a (event->event),
+			       context->ifindex);
+			continue;
 		}
 
-		if (   check_probing_done
-		    && self->state == STATE_PROBING
-		    && ++self->completed == g_hash_table_size (self->addresses)) {
-			self->state = STATE_PROBE_DONE;
-			emit_probe_terminated = TRUE;
-		}
+		/* the event is dispatched to the manager owning the probe. If that
+		 * manager (or any other) is freed, the pending events of its probes
+		 * are dropped by n-acd, so we never see a stale probe here. */
+		n_acd_probe_get_userdata (probe, (void **) &info);
+		acd_handle_event (info->self, info, event);
 	}
 
-	if (emit_probe_terminated) {
-		if (self->callbacks.probe_terminated_callback) {
-			self->callbacks.probe_terminated_callback (self,
-			                                           self->user_data);
+	acd_context_unref (context);
+	return G_SOURCE_CONTINUE;
+}
+
+static AcdContext *
+acd_context_get (int ifindex, const guint8 *hwaddr, int *out_error)
+{
+	AcdContext *context;
+	NAcdConfig *config;
+	int fd, r;
+
+	if (acd_contexts) {
+		context = g_hash_table_lookup (acd_contexts, GINT_TO_POINTER (ifindex));
+		if (   context
+		    && memcmp (context->hwaddr, hwaddr, ETH_ALEN) == 0) {
+			context->ref_count++;
+			return context;
 		}
 	}
 
-	return G_SOURCE_CONTINUE;
+	r = n_acd_config_new (&config);
+	if (r) {
+		*out_error = r;
+		return NULL;
+	}
+
+	n_acd_config_set_ifindex (config, ifindex);
+	n_acd_config_set_transport (config, N_ACD_TRANSPORT_ETHERNET);
+	n_acd_config_set_mac (config, hwaddr, ETH_ALEN);
+
+	context = g_slice_new0 (AcdContext);
+	context->ref_count = 1;
+	context->ifindex = ifindex;
+	memcpy (context->hwaddr, hwaddr, ETH_ALEN);
+
+	r = n_acd_new (&context->acd, config);
+	n_acd_config_free (config);
+	if (r) {
+		g_slice_free (AcdContext, context);
+		*out_error = r;
+		return NULL;
+	}
+
+	n_acd_get_fd (context->acd, &fd);
+	context->channel = g_io_channel_unix_new (fd);
+	context->event_id = g_io_add_watch (context->channel, G_IO_IN, acd_context_event, context);
+
+	/* if the MAC address of the interface changed, the contexts that are
+	 * still in use keep running with the old one, but are no longer shared. */
+	if (!acd_contexts)
+		acd_contexts = g_hash_table_new (nm_direct_hash, NULL);
+	g_hash_table_insert (acd_contexts, GINT_TO_POINTER (ifindex), context);
+
+	return context;
+}
+
+static void
+acd_context_unref (AcdContext *context)
+{
+	nm_assert (context && context->ref_count > 0);
+
+	if (--context->ref_count > 0)
+		return;
+
+	if (g_hash_table_lookup (acd_contexts, GINT_TO_POINTER (context->ifindex)) == context)
+		g_hash_table_remove (acd_contexts, GINT_TO_POINTER (context->ifindex));
+
+	nm_clear_g_source (&context->event_id);
+	nm_clear_pointer (&context->channel, g_io_channel_unref);
+	nm_clear_pointer (&context->acd, n_acd_unref);
+	g_slice_free (AcdContext, context);
 }
 
 static gboolean
@@ -267,7 +384,7 @@ acd_probe_add (NMAcdManager *self,
 	n_acd_probe_config_set_ip (probe_config, (struct in_addr) { info->address });
 	n_acd_probe_config_set_timeout (probe_config, timeout);
 
-	r = n_acd_probe (self->acd, &info->probe, probe_config);
+	r = n_acd_probe (self->context->acd, &info->probe, probe_config);
 	if (r) {
 		_LOGW ("could not start probe for %s on interface '%s': %s",
 		       nm_utils_inet4_ntop (info->address, sbuf),
@@ -286,22 +403,12 @@ acd_probe_add (NMAcdManager *self,
 static int
 acd_init (NMAcdManager *self)
 {
-	NAcdConfig *config;
-	int r;
+	int r = 0;
 
-	if (self->acd)
+	if (self->context)
 		return 0;
 
-	r = n_acd_config_new (&config);
-	if (r)
-		return r;
-
-	n_acd_config_set_ifindex (config, self->ifindex);
-	n_acd_config_set_transport (config, N_ACD_TRANSPORT_ETHERNET);
-	n_acd_config_set_mac (config, self->hwaddr, ETH_ALEN);
-
-	r = n_acd_new (&self->acd, config);
-	n_acd_config_free (config);
+	self->context = acd_context_get (self->ifindex, self->hwaddr, &r);
 	return r;
 }
 
@@ -322,7 +429,7 @@ nm_acd_manager_start_probe (NMAcdManager *self, guint timeout)
 	GHashTableIter iter;
 	AddressInfo *info;
 	gboolean success = FALSE;
-	int fd, r;
+	int r;
 
 	g_return_val_if_fail (self, FALSE);
 	g_return_val_if_fail (self->state == STATE_INIT, FALSE);
@@ -337,6 +444,16 @@ nm_acd_manager_start_probe (NMAcdManager *self, guint timeout)
 
 	self->completed = 0;
 
+	/* all probes are added at once and run in parallel, so the probing is
+	 * done after a single probe interval. Make room for them in the BPF
+	 * map upfront, instead of growing it step by step. */
+	r = n_acd_reserve (self->context->acd, g_hash_table_size (self->addresses));
+	if (r) {
+		_LOGD ("couldn't reserve space for %u addresses: %s",
+		       g_hash_table_size (self->addresses),
+		       acd_error_to_string (r));
+	}
+
 	g_hash_table_iter_init (&iter, self->addresses);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info))
 		success |= acd_probe_add (self, info, timeout);
@@ -344,10 +461,6 @@ nm_acd_manager_start_probe (NMAcdManager *self, guint timeout)
 	if (success)
 		self->state = STATE_PROBING;
 
-	n_acd_get_fd (self->acd, &fd);
-	self->channel = g_io_channel_unix_new (fd);
-	self->event_id = g_io_add_watch (self->channel, G_IO_IN, acd_event, self);
-
 	return success ? 0 : -NME_UNSPEC;
 }
 
@@ -479,9 +592,7 @@ nm_acd_manager_free (NMAcdManager *self)
 		self->callbacks.user_data_destroy (self->user_data);
 
 	nm_clear_pointer (&self->addresses, g_hash_table_destroy);
-	nm_clear_pointer (&self->channel, g_io_channel_unref);
-	nm_clear_g_source (&self->event_id);
-	nm_clear_pointer (&self->acd, n_acd_unref);
+	nm_clear_pointer (&self->context, acd_context_unref);
 
 	g_slice_free (NMAcdManager, self);
 }
@@ -57,6 +57,7 @@
 #include "nm-ip6-config.h"
 #include "nm-pacrunner-manager.h"
 #include "dnsmasq/nm-dnsmasq-manager.h"
+#include "dhcp/nm-dhcp-server.h"
 #include "nm-dhcp4-config.h"
 #include "nm-dhcp6-config.h"
 #include "nm-rfkill-manager.h"
@@ -485,6 +486,9 @@ typedef struct _NMDevicePrivate {
 	/* dnsmasq stuff for shared connections */
 	NMDnsMasqManager *dnsmasq_manager;
 	gulong            dnsmasq_state_id;
+	NMDhcpServer     *dhcp_server;
+	gulong            dhcp_server_failed_id;
+	gulong            dhcp_server_dns_changed_id;
 
 	/* Firewall */
 	FirewallState fw_state:4;
@@ -6087,6 +6091,28 @@ dnsmasq_state_changed_cb (NMDnsMasqManager *manager, guint32 status, gpointer us
 	}
 }
 
+static void
+dhcp_server_failed_cb (NMDhcpServer *server, gpointer user_data)
+{
+	NMDevice *self = NM_DEVICE (user_data);
+
+	nm_device_ip_method_failed (self, AF_INET, NM_DEVICE_STATE_REASON_SHARED_START_FAILED);
+}
+
+static void
+dhcp_server_dns_changed_cb (NMDnsManager *dns_manager, GParamSpec *pspec, gpointer user_data)
+{
+	NMDevice *self = NM_DEVICE (user_data);
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	gs_unref_array GArray *upstream_nameservers = NULL;
+
+	if (!priv->dhcp_server)
+		return;
+
+	upstream_nameservers = nm_dns_manager_get_ip4_nameservers (dns_manager);
+	nm_dhcp_server_set_upstream_nameservers (priv->dhcp_server, upstream_nameservers);
+}
+
 /*****************************************************************************/
 
 static gboolean
@@ -8038,6 +8064,18 @@ shared_ip_release (gpointer data)
 		g_clear_pointer (&shared_ips, g_hash_table_unref);
 }
 
+static gboolean
+shared_dhcp_use_nettools (void)
+{
+	gs_free char *value = NULL;
+
+	value = nm_config_data_get_value (NM_CONFIG_GET_DATA,
+	                                  NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                  NM_CONFIG_KEYFILE_KEY_MAIN_SHARED_DHCP,
+	                                  NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY);
+	return nm_streq0 (value, "nettools");
+}
+
 static NMIP4Config *
 shared4_new_config (NMDevice *self, NMConnection *connection)
 {
@@ -9996,7 +10034,11 @@ act_stage3_ip_config_start (NMDevice *self,
 			if (out_config) {
 				*out_config = shared4_new_config (self, connection);
 				if (*out_config) {
-					priv->dnsmasq_manager = nm_dnsmasq_manager_new (nm_device_get_ip_iface (self));
+					if (shared_dhcp_use_nettools ()) {
+						priv->dhcp_server = nm_dhcp_server_new (nm_device_get_ip_iface (self),
+						                                        nm_device_get_ip_ifindex (self));
+					} else
+						priv->dnsmasq_manager = nm_dnsmasq_manager_new (nm_device_get_ip_iface (self));
 					ret = NM_ACT_STAGE_RETURN_SUCCESS;
 				} else {
 					NM_SET_OUT (out_failure_reason, NM_DEVICE_STATE_REASON_IP_CONFIG_UNAVAILABLE);
@@ -10548,6 +10590,35 @@ start_sharing (NMDevice *self, NMIP4Config *config, GError **error)
 	}
 
 
+	if (priv->dhcp_server) {
+		gs_unref_array GArray *upstream_nameservers = NULL;
+
+		/* dnsmasq announces itself as name server and forwards the queries. The
+		 * DHCP server can't do that, so it announces the upstream name servers
+		 * instead, and is updated whenever the DNS configuration changes. */
+		upstream_nameservers = nm_dns_manager_get_ip4_nameservers (nm_dns_manager_get ());
+		if (!nm_dhcp_server_start (priv->dhcp_server,
+		                           config,
+		                           upstream_nameservers,
+		                           announce_android_metered,
+		                           &local)) {
+			g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
+			             "could not start DHCP server due to %s", local->message);
+			g_error_free (local);
+			nm_act_request_set_shared (req, FALSE);
+			return FALSE;
+		}
+
+		priv->dhcp_server_failed_id = g_signal_connect (priv->dhcp_server, NM_DHCP_SERVER_FAILED,
+		                                                G_CALLBACK (dhcp_server_failed_cb),
+		                                                self);
+		priv->dhcp_server_dns_changed_id = g_signal_connect (nm_dns_manager_get (),
+		                                                     "notify::" NM_DNS_MANAGER_CONFIGURATION,
+		                                                     G_CALLBACK (dhcp_server_dns_changed_cb),
+		                                                     self);
+		return TRUE;
+	}
+
 	if (!nm_dnsmasq_manager_start (priv->dnsmasq_manager,
 	                               config,
 	                               announce_android_metered,
@@ -10941,6 +11012,13 @@ dnsmasq_cleanup (NMDevice *self)
 {
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
 
+	if (priv->dhcp_server) {
+		nm_clear_g_signal_handler (priv->dhcp_server, &priv->dhcp_server_failed_id);
+		nm_clear_g_signal_handler (nm_dns_manager_get (), &priv->dhcp_server_dns_changed_id);
+		nm_dhcp_server_stop (priv->dhcp_server);
+		g_clear_object (&priv->dhcp_server);
+	}
+
 	if (!priv->dnsmasq_manager)
 		return;
 
@@ -22,6 +22,10 @@
 #include "nm-lldp-listener.h"
 
 #include <net/ethernet.h>
+#include <sys/socket.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
 
 #include "nm-std-aux/unaligned.h"
 #include "platform/nm-platform.h"
@@ -33,6 +37,9 @@
 #define MAX_NEIGHBORS         4096
 #define MIN_UPDATE_INTERVAL_NS (2 * NM_UTILS_NS_PER_SECOND)
 
+/* the maximum number of frames read from the shared socket in one go. */
+#define SHARED_SOCKET_N_DISPATCH 128
+
 #define LLDP_MAC_NEAREST_BRIDGE          ((const struct ether_addr *) ((uint8_t[ETH_ALEN]) { 0x01, 0x80, 0xc2, 0x00, 0x00, 0x0e }))
 #define LLDP_MAC_NEAREST_NON_TPMR_BRIDGE ((const struct ether_addr *) ((uint8_t[ETH_ALEN]) { 0x01, 0x80, 0xc2, 0x00, 0x00, 0x03 }))
 #define LLDP_MAC_NEAREST_CUSTOMER_BRIDGE ((const struct ether_addr *) ((uint8_t[ETH_ALEN]) { 0x01, 0x80, 0xc2, 0x00, 0x00, 0x00 }))
@@ -66,16 +73,34 @@ typedef enum {
 	_LLDP_ATTR_ID_COUNT,
 } LldpAttrId;
 
+/* The payload of a TLV that is exposed as vardict. It is only converted
+ * to a GVariant when the neighbors are actually read. */
+typedef struct {
+	CList lst;
+	guint16 len;
+	guint8 data[];
+} LldpAttrRaw;
+
 typedef struct {
 	LldpAttrType attr_type;
 	union {
 		guint32 v_uint32;
 		char *v_string;
-		GVariant *v_variant;
-		CList v_variant_list;
+		LldpAttrRaw *v_raw;
+		CList v_raw_list;
 	};
 } LldpAttrData;
 
+/* The packet socket shared by all listeners, see nm_lldp_listener_set_shared_socket(). */
+typedef struct {
+	int ref_count;
+	int fd;
+	GIOChannel *channel;
+	guint event_id;
+	GHashTable *listeners;
+	guint8 buf[9216];
+} SharedSocket;
+
 /*****************************************************************************/
 
 NM_GOBJECT_PROPERTIES_DEFINE (NMLldpListener,
@@ -86,8 +111,13 @@ typedef struct {
 	char         *iface;
 	int           ifindex;
 	sd_lldp      *lldp_handle;
+	SharedSocket *shared_socket;
 	GHashTable   *lldp_neighbors;
 
+	/* with the shared socket, we age out the neighbors ourselves. */
+	gint64        expiry_next;
+	guint         expiry_id;
+
 	/* the timestamp in nsec until which we delay updates. */
 	gint64        ratelimit_next;
 	guint         ratelimit_id;
@@ -118,6 +148,10 @@ typedef struct {
 
 	struct ether_addr destination_address;
 
+	/* the timestamp in msec when the neighbor expires, or zero
+	 * if sd-lldp takes care of it. */
+	gint64 expiry;
+
 	bool valid:1;
 
 	LldpAttrData attrs[_LLDP_ATTR_ID_COUNT];
@@ -254,42 +288,72 @@ _lldp_attr_set_uint32 (LldpAttrData *pdata, LldpAttrId attr_id, guint32 v_uint32
 	pdata->v_uint32 = v_uint32;
 }
 
-static void
-_lldp_attr_set_vardict (LldpAttrData *pdata, LldpAttrId attr_id, GVariant *variant)
+static LldpAttrRaw *
+_lldp_attr_raw_new (const guint8 *data, gsize len)
+{
+	LldpAttrRaw *raw;
+
+	nm_assert (len <= G_MAXUINT16);
+
+	raw = g_malloc (G_STRUCT_OFFSET (LldpAttrRaw, data) + len);
+	raw->len = len;
+	memcpy (raw->data, data, len);
+	return raw;
+}
+
+static gboolean
+_lldp_attr_raw_equal (const LldpAttrRaw *a, const LldpAttrRaw *b)
 {
+	return    a->len == b->len
+	       && memcmp (a->data, b->data, a->len) == 0;
+}
 
+static gboolean
+_lldp_attr_raw_list_equal (const CList *a, const CList *b)
+{
+	const CList *iter_a, *iter_b;
+
+	for (iter_a = a->next, iter_b = b->next;
+	     iter_a != a && iter_b != b;
+	     iter_a = iter_a->next, iter_b = iter_b->next) {
+		if (!_lldp_attr_raw_equal (c_list_entry (iter_a, LldpAttrRaw, lst),
+		                           c_list_entry (iter_b, LldpAttrRaw, lst)))
+			return FALSE;
+	}
+	return iter_a == a && iter_b == b;
+}
+
+static void
+_lldp_attr_set_raw (LldpAttrData *pdata, LldpAttrId attr_id, const guint8 *data, gsize len)
+{
 	nm_assert (pdata);
 	nm_assert (_lldp_attr_id_to_type (attr_id) == LLDP_ATTR_TYPE_VARDICT);
 
 	pdata = &pdata[attr_id];
 
 	/* we ignore duplicate fields silently */
-	if (pdata->attr_type != LLDP_ATTR_TYPE_NONE) {
-		if (g_variant_is_floating (variant))
-			g_variant_unref (variant);
+	if (pdata->attr_type != LLDP_ATTR_TYPE_NONE)
 		return;
-	}
 
 	pdata->attr_type = LLDP_ATTR_TYPE_VARDICT;
-	pdata->v_variant = g_variant_ref_sink (variant);
+	pdata->v_raw = _lldp_attr_raw_new (data, len);
 }
 
 static void
-_lldp_attr_add_vardict (LldpAttrData *pdata, LldpAttrId attr_id, GVariant *variant)
+_lldp_attr_add_raw (LldpAttrData *pdata, LldpAttrId attr_id, const guint8 *data, gsize len)
 {
 	nm_assert (pdata);
 	nm_assert (_lldp_attr_id_to_type (attr_id) == LLDP_ATTR_TYPE_ARRAY_OF_VARDICTS);
 
-	g_variant_ref_sink (variant);
 	pdata = &pdata[attr_id];
 
 	if (pdata->attr_type == LLDP_ATTR_TYPE_NONE) {
-		c_list_init (&pdata->v_variant_list);
+		c_list_init (&pdata->v_raw_list);
 		pdata->attr_type = LLDP_ATTR_TYPE_ARRAY_OF_VARDICTS;
 	} else
 		nm_assert (pdata->attr_type == LLDP_ATTR_TYPE_ARRAY_OF_VARDICTS);
 
-	c_list_link_tail (&pdata->v_variant_list, &nm_c_list_elem_new_stale (variant)->lst);
+	c_list_link_tail (&pdata->v_raw_list, &_lldp_attr_raw_new (data, len)->lst);
 }
 
 /*****************************************************************************/
@@ -350,12 +414,17 @@ lldp_neighbor_free (LldpNeighbor *neighbor)
 				g_free (neighbor->attrs[attr_id].v_string);
 				break;
 			case LLDP_ATTR_TYPE_VARDICT:
-				g_variant_unref (neighbor->attrs[attr_id].v_variant);
+				g_free (neighbor->attrs[attr_id].v_raw);
 				break;
-			case LLDP_ATTR_TYPE_ARRAY_OF_VARDICTS:
-				nm_c_list_elem_free_all (&neighbor->attrs[attr_id].v_variant_list,
-				                         (GDestroyNotify) g_variant_unref);
+			case LLDP_ATTR_TYPE_ARRAY_OF_VARDICTS: {
+				LldpAttrRaw *raw, *raw_safe;
+
+				c_list_for_each_entry_safe (raw, raw_safe, &neighbor->attrs[attr_id].v_raw_list, lst) {
+					c_list_unlink_stale (&raw->lst);
+					g_free (raw);
+				}
 				break;
+			}
 			default:
 				;
 			}
@@ -381,7 +450,7 @@ lldp_neighbor_equal (LldpNeighbor *a, LldpNeighbor *b)
 
 	if (   a->chassis_id_type != b->chassis_id_type
 	    || a->port_id_type != b->port_id_type
-	    || ether_addr_equal (&a->destination_address, &b->destination_address)
+	    || !ether_addr_equal (&a->destination_address, &b->destination_address)
 	    || !nm_streq0 (a->chassis_id, b->chassis_id)
 	    || !nm_streq0 (a->port_id, b->port_id))
 		return FALSE;
@@ -398,6 +467,14 @@ lldp_neighbor_equal (LldpNeighbor *a, LldpNeighbor *b)
 			if (!nm_streq (a->attrs[attr_id].v_string, b->attrs[attr_id].v_string))
 				return FALSE;
 			break;
+		case LLDP_ATTR_TYPE_VARDICT:
+			if (!_lldp_attr_raw_equal (a->attrs[attr_id].v_raw, b->attrs[attr_id].v_raw))
+				return FALSE;
+			break;
+		case LLDP_ATTR_TYPE_ARRAY_OF_VARDICTS:
+			if (!_lldp_attr_raw_list_equal (&a->attrs[attr_id].v_raw_list, &b->attrs[attr_id].v_raw_list))
+				return FALSE;
+			break;
 		default:
 			nm_assert (a->attrs[attr_id].attr_type == LLDP_ATTR_TYPE_NONE);
 			break;
@@ -407,11 +484,11 @@ lldp_neighbor_equal (LldpNeighbor *a, LldpNeighbor *b)
 	return TRUE;
 }
 
-static GVariant *
-parse_management_address_tlv (uint8_t *data, gsize len)
+static gboolean
+parse_management_address_tlv (const uint8_t *data, gsize len, GVariant **out_variant)
 {
 	GVariantDict dict;
-	GVariant *variant;
+	const uint8_t *addr, *ifnum, *oid;
 	gsize addr_len, oid_len;
 
 	/* 802.1AB-2009 - Figure 8-11
@@ -427,53 +504,96 @@ parse_management_address_tlv (uint8_t *data, gsize len)
 	 */
 
 	if (len < 11)
-		goto err;
+		return FALSE;
 
 	nm_assert ((data[0] >> 1) == SD_LLDP_TYPE_MGMT_ADDRESS);
 	nm_assert ((((data[0] & 1) << 8) + data[1]) + 2 == len);
 
-	data += 2;
-	len -= 2;
-	addr_len = *data; /* length of (address subtype + address) */
+	addr_len = data[2]; /* length of (address subtype + address) */
 
 	if (addr_len < 2 || addr_len > 32)
-		goto err;
-	if (len < (  1         /* address stringth length */
+		return FALSE;
+	if (len < (  2         /* TLV type / length */
+	           + 1         /* address stringth length */
 	           + addr_len  /* address subtype + address */
 	           + 5         /* interface */
 	           + 1))       /* oid */
-		goto err;
+		return FALSE;
 
-	g_variant_dict_init (&dict, NULL);
+	addr = &data[3];
+	ifnum = &addr[addr_len];
+	oid_len = ifnum[5];
+	oid = &ifnum[6];
 
-	data++;
-	len--;
-	g_variant_dict_insert (&dict, "address-subtype", "u", (guint32) *data);
-	variant = g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, data + 1, addr_len - 1, 1);
-	g_variant_dict_insert_value (&dict, "address", variant);
+	if (len < (gsize) (oid - data) + oid_len)
+		return FALSE;
 
-	data += addr_len;
-	len -= addr_len;
-	g_variant_dict_insert (&dict, "interface-number-subtype", "u", (guint32) *data);
+	if (!out_variant)
+		return TRUE;
 
-	data++;
-	len--;
-	g_variant_dict_insert (&dict, "interface-number", "u", unaligned_read_be32 (data));
+	g_variant_dict_init (&dict, NULL);
+	g_variant_dict_insert (&dict, "address-subtype", "u", (guint32) addr[0]);
+	g_variant_dict_insert_value (&dict, "address",
+	                             g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, &addr[1], addr_len - 1, 1));
+	g_variant_dict_insert (&dict, "interface-number-subtype", "u", (guint32) ifnum[0]);
+	g_variant_dict_insert (&dict, "interface-number", "u", unaligned_read_be32 (&ifnum[1]));
+	g_variant_dict_insert_value (&dict, "object-id",
+	                             g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, oid, oid_len, 1));
+	*out_variant = g_variant_dict_end (&dict);
+	return TRUE;
+}
+
+static GVariant *
+_lldp_attr_raw_to_variant (LldpAttrId attr_id, const LldpAttrRaw *raw)
+{
+	GVariantDict dict;
+	const guint8 *data = raw->data;
 
-	data += 4;
-	len -= 4;
-	oid_len = *data;
+	/* the payload was validated when parsing the neighbor. */
+	switch (attr_id) {
+	case LLDP_ATTR_ID_MANAGEMENT_ADDRESSES: {
+		GVariant *variant = NULL;
 
-	if (len < (1 + oid_len))
-		goto err;
+		if (!parse_management_address_tlv (data, raw->len, &variant))
+			g_return_val_if_reached (NULL);
+		return variant;
+	}
+	case LLDP_ATTR_ID_IEEE_802_1_PPVIDS:
+		nm_assert (raw->len == 3);
+		g_variant_dict_init (&dict, NULL);
+		g_variant_dict_insert (&dict, "ppvid", "u", (guint32) unaligned_read_be16 (&data[1]));
+		g_variant_dict_insert (&dict, "flags", "u", (guint32) data[0]);
+		break;
+	case LLDP_ATTR_ID_IEEE_802_1_VLANS: {
+		gs_free char *name_to_free = NULL;
+		const char *name;
+
+		nm_assert (raw->len == 3 + data[2]);
+		name = nm_utils_buf_utf8safe_escape (&data[3], data[2], 0, &name_to_free);
+		g_variant_dict_init (&dict, NULL);
+		g_variant_dict_insert (&dict, "vid", "u", (guint32) unaligned_read_be16 (&data[0]));
+		g_variant_dict_insert (&dict, "name", "s", name);
+		break;
+	}
+	case LLDP_ATTR_ID_IEEE_802_3_MAC_PHY_CONF:
+		nm_assert (raw->len == 5);
+		g_variant_dict_init (&dict, NULL);
+		g_variant_dict_insert (&dict, "autoneg", "u", (guint32) data[0]);
+		g_variant_dict_insert (&dict, "pmd-autoneg-cap", "u", (guint32) unaligned_read_be16 (&data[1]));
+		g_variant_dict_insert (&dict, "operational-mau-type", "u", (guint32) unaligned_read_be16 (&data[3]));
+		break;
+	case LLDP_ATTR_ID_IEEE_802_3_POWER_VIA_MDI:
+		nm_assert (raw->len == 3);
+		g_variant_dict_init (&dict, NULL);
+		g_variant_dict_insert (&dict, "mdi-power-support", "u", (guint32) data[0]);
+		g_variant_dict_insert (&dict, "pse-power-pair", "u", (guint32) data[1]);
+		g_variant_dict_insert (&dict, "power-class", "u", (guint32) data[2]);
+		break;
+	default:
+		g_return_val_if_reached (NULL);
+	}
 
-	data++;
-	variant = g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, data, oid_len, 1);
-	g_variant_dict_insert_value (&dict, "object-id", variant);
 	return g_variant_dict_end (&dict);
-err:
-	g_variant_dict_clear (&dict);
-	return NULL;
 }
 
 static LldpNeighbor *
@@ -578,7 +698,6 @@ lldp_neighbor_new (sd_lldp_neighbor *neighbor_sd, GError **error)
 	do {
 		guint8 oui[3];
 		guint8 type, subtype;
-		GVariant *variant;
 
 		if (sd_lldp_neighbor_tlv_get_type (neighbor_sd, &type) < 0)
 			continue;
@@ -588,11 +707,10 @@ lldp_neighbor_new (sd_lldp_neighbor *neighbor_sd, GError **error)
 
 		switch (type) {
 		case SD_LLDP_TYPE_MGMT_ADDRESS:
-			variant = parse_management_address_tlv (data8, len);
-			if (variant) {
-				_lldp_attr_add_vardict (neigh->attrs,
-				                        LLDP_ATTR_ID_MANAGEMENT_ADDRESSES,
-				                        variant);
+			if (parse_management_address_tlv (data8, len, NULL)) {
+				_lldp_attr_add_raw (neigh->attrs,
+				                    LLDP_ATTR_ID_MANAGEMENT_ADDRESSES,
+				                    data8, len);
 			}
 			continue;
 		case SD_LLDP_TYPE_PRIVATE:
@@ -633,8 +751,6 @@ lldp_neighbor_new (sd_lldp_neighbor *neighbor_sd, GError **error)
 		len -= 6;
 
 		if (memcmp (oui, SD_LLDP_OUI_802_1, sizeof (oui)) == 0) {
-			GVariantDict dict;
-
 			switch (subtype) {
 			case SD_LLDP_OUI_802_1_SUBTYPE_PORT_VLAN_ID:
 				if (len != 2)
@@ -649,18 +765,12 @@ lldp_neighbor_new (sd_lldp_neighbor *neighbor_sd, GError **error)
 				                       data8[0]);
 				_lldp_attr_set_uint32 (neigh->attrs, LLDP_ATTR_ID_IEEE_802_1_PPVID,
 				                       unaligned_read_be16 (&data8[1]));
-
-				g_variant_dict_init (&dict, NULL);
-				g_variant_dict_insert (&dict, "ppvid", "u", (guint32) unaligned_read_be16 (&data8[1]));
-				g_variant_dict_insert (&dict, "flags", "u", (guint32) data8[0]);
-
-				_lldp_attr_add_vardict (neigh->attrs,
-				                        LLDP_ATTR_ID_IEEE_802_1_PPVIDS,
-				                        g_variant_dict_end (&dict));
+				_lldp_attr_add_raw (neigh->attrs,
+				                    LLDP_ATTR_ID_IEEE_802_1_PPVIDS,
+				                    data8, len);
 				break;
 			case SD_LLDP_OUI_802_1_SUBTYPE_VLAN_NAME: {
 				int l;
-				guint32 vid;
 				const char *name;
 				char *name_to_free;
 
@@ -674,17 +784,13 @@ lldp_neighbor_new (sd_lldp_neighbor *neighbor_sd, GError **error)
 					continue;
 
 				name = nm_utils_buf_utf8safe_escape (&data8[3], l, 0, &name_to_free);
-				vid = unaligned_read_be16 (&data8[0]);
-
-				g_variant_dict_init (&dict, NULL);
-				g_variant_dict_insert (&dict, "vid", "u", vid);
-				g_variant_dict_insert (&dict, "name", "s", name);
 
-				_lldp_attr_add_vardict (neigh->attrs,
-				                        LLDP_ATTR_ID_IEEE_802_1_VLANS,
-				                        g_variant_dict_end (&dict));
+				_lldp_attr_add_raw (neigh->attrs,
+				                    LLDP_ATTR_ID_IEEE_802_1_VLANS,
+				                    data8, len);
 
-				_lldp_attr_set_uint32 (neigh->attrs, LLDP_ATTR_ID_IEEE_802_1_VID, vid);
+				_lldp_attr_set_uint32 (neigh->attrs, LLDP_ATTR_ID_IEEE_802_1_VID,
+				                       unaligned_read_be16 (&data8[0]));
 				_lldp_attr_take_str_ptr (neigh->attrs,
 				                         LLDP_ATTR_ID_IEEE_802_1_VLAN_NAME,
 				                         name_to_free ?: g_strdup (name));
@@ -694,34 +800,20 @@ lldp_neighbor_new (sd_lldp_neighbor *neighbor_sd, GError **error)
 				continue;
 			}
 		} else if (memcmp (oui, SD_LLDP_OUI_802_3, sizeof (oui)) == 0) {
-			GVariantDict dict;
-
 			switch (subtype) {
 			case SD_LLDP_OUI_802_3_SUBTYPE_MAC_PHY_CONFIG_STATUS:
 				if (len != 5)
 					continue;
-
-				g_variant_dict_init (&dict, NULL);
-				g_variant_dict_insert (&dict, "autoneg", "u", (guint32) data8[0]);
-				g_variant_dict_insert (&dict, "pmd-autoneg-cap", "u", (guint32) unaligned_read_be16 (&data8[1]));
-				g_variant_dict_insert (&dict, "operational-mau-type", "u", (guint32) unaligned_read_be16 (&data8[3]));
-
-				_lldp_attr_set_vardict (neigh->attrs,
-				                        LLDP_ATTR_ID_IEEE_802_3_MAC_PHY_CONF,
-				                        g_variant_dict_end (&dict));
+				_lldp_attr_set_raw (neigh->attrs,
+				                    LLDP_ATTR_ID_IEEE_802_3_MAC_PHY_CONF,
+				                    data8, len);
 				break;
 			case SD_LLDP_OUI_802_3_SUBTYPE_POWER_VIA_MDI:
 				if (len != 3)
 					continue;
-
-				g_variant_dict_init (&dict, NULL);
-				g_variant_dict_insert (&dict, "mdi-power-support", "u", (guint32) data8[0]);
-				g_variant_dict_insert (&dict, "pse-power-pair", "u", (guint32) data8[1]);
-				g_variant_dict_insert (&dict, "power-class", "u", (guint32) data8[2]);
-
-				_lldp_attr_set_vardict (neigh->attrs,
-				                        LLDP_ATTR_ID_IEEE_802_3_POWER_VIA_MDI,
-				                        g_variant_dict_end (&dict));
+				_lldp_attr_set_raw (neigh->attrs,
+				                    LLDP_ATTR_ID_IEEE_802_3_POWER_VIA_MDI,
+				                    data8, len);
 				break;
 			case SD_LLDP_OUI_802_3_SUBTYPE_MAXIMUM_FRAME_SIZE:
 				if (len != 2)
@@ -796,16 +888,16 @@ lldp_neighbor_to_variant (LldpNeighbor *neigh)
 		case LLDP_ATTR_TYPE_VARDICT:
 			g_variant_builder_add (&builder, "{sv}",
 			                       _lldp_attr_id_to_name (attr_id),
-			                       data->v_variant);
+			                       _lldp_attr_raw_to_variant (attr_id, data->v_raw));
 			break;
 		case LLDP_ATTR_TYPE_ARRAY_OF_VARDICTS: {
-			NMCListElem *elem;
+			const LldpAttrRaw *raw;
 			GVariantBuilder builder2;
 
 			g_variant_builder_init (&builder2, G_VARIANT_TYPE ("aa{sv}"));
 
-			c_list_for_each_entry (elem, &data->v_variant_list, lst)
-				g_variant_builder_add_value (&builder2, elem->data);
+			c_list_for_each_entry (raw, &data->v_raw_list, lst)
+				g_variant_builder_add_value (&builder2, _lldp_attr_raw_to_variant (attr_id, raw));
 
 			g_variant_builder_add (&builder, "{sv}",
 			                       _lldp_attr_id_to_name (attr_id),
@@ -860,8 +952,66 @@ data_changed_schedule (NMLldpListener *self)
 		priv->ratelimit_id = g_timeout_add (NM_UTILS_NS_TO_MSEC_CEIL (priv->ratelimit_next - now), data_changed_timeout, self);
 }
 
+static gboolean
+expiry_timeout (gpointer user_data)
+{
+	NMLldpListener *self = user_data;
+	NMLldpListenerPrivate *priv = NM_LLDP_LISTENER_GET_PRIVATE (self);
+	GHashTableIter iter;
+	LldpNeighbor *neigh;
+	gint64 now, expiry_next = 0;
+	gboolean changed = FALSE;
+
+	priv->expiry_id = 0;
+	priv->expiry_next = 0;
+
+	now = nm_utils_get_monotonic_timestamp_ms ();
+
+	g_hash_table_iter_init (&iter, priv->lldp_neighbors);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &neigh, NULL)) {
+		if (neigh->expiry == 0)
+			continue;
+		if (neigh->expiry <= now) {
+			_LOGT ("process: %s neigh: "LOG_NEIGH_FMT,
+			       "expire", LOG_NEIGH_ARG (neigh));
+			g_hash_table_iter_remove (&iter);
+			changed = TRUE;
+			continue;
+		}
+		if (expiry_next == 0 || neigh->expiry < expiry_next)
+			expiry_next = neigh->expiry;
+	}
+
+	if (expiry_next) {
+		priv->expiry_next = expiry_next;
+		priv->expiry_id = g_timeout_add (expiry_next - now, expiry_timeout, self);
+	}
+
+	if (changed)
+		data_changed_schedule (self);
+	return G_SOURCE_REMOVE;
+}
+
 static void
-process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboolean neighbor_valid)
+expiry_schedule (NMLldpListener *self, gint64 expiry)
+{
+	NMLldpListenerPrivate *priv = NM_LLDP_LISTENER_GET_PRIVATE (self);
+
+	/* the timeout only needs to fire for the earliest neighbor. It
+	 * rearms itself for the others. */
+	if (   priv->expiry_id
+	    && priv->expiry_next <= expiry)
+		return;
+
+	nm_clear_g_source (&priv->expiry_id);
+	priv->expiry_next = expiry;
+	priv->expiry_id = g_timeout_add (NM_MAX (expiry - nm_utils_get_monotonic_timestamp_ms (), 0),
+	                                 expiry_timeout,
+	                                 self);
+}
+
+static void
+process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboolean neighbor_valid, gint64 expiry)
 {
 	NMLldpListenerPrivate *priv;
 	nm_auto (lldp_neighbor_freep) LldpNeighbor *neigh = NULL;
@@ -874,7 +1024,7 @@ process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboo
 
 	priv = NM_LLDP_LISTENER_GET_PRIVATE (self);
 
-	g_return_if_fail (priv->lldp_handle);
+	g_return_if_fail (priv->lldp_handle || priv->shared_socket);
 	g_return_if_fail (neighbor_sd);
 
 	p_parse_error = _LOGT_ENABLED () ? &parse_error : NULL;
@@ -888,6 +1038,8 @@ process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboo
 	if (!neigh->valid)
 		neighbor_valid = FALSE;
 
+	neigh->expiry = expiry;
+
 	neigh_old = g_hash_table_lookup (priv->lldp_neighbors, neigh);
 	if (neigh_old) {
 		if (!neighbor_valid) {
@@ -898,8 +1050,11 @@ process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboo
 			g_hash_table_remove (priv->lldp_neighbors, neigh_old);
 			changed = TRUE;
 			goto done;
-		} else if (lldp_neighbor_equal (neigh_old, neigh))
+		} else if (lldp_neighbor_equal (neigh_old, neigh)) {
+			/* a refresh only extends the lifetime. */
+			neigh_old->expiry = expiry;
 			return;
+		}
 	} else if (!neighbor_valid) {
 		if (parse_error)
 			_LOGT ("process: failed to parse neighbor: %s", parse_error->message);
@@ -919,6 +1074,8 @@ process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboo
 
 	changed = TRUE;
 	g_hash_table_add (priv->lldp_neighbors, g_steal_pointer (&neigh));
+	if (expiry)
+		expiry_schedule (self, expiry);
 
 done:
 	if (changed)
@@ -928,7 +1085,293 @@ done:
 static void
 lldp_event_handler (sd_lldp *lldp, sd_lldp_event event, sd_lldp_neighbor *n, void *userdata)
 {
-	process_lldp_neighbor (userdata, n, event != SD_LLDP_EVENT_REMOVED);
+	process_lldp_neighbor (userdata, n, event != SD_LLDP_EVENT_REMOVED, 0);
+}
+
+/*****************************************************************************/
+
+static gboolean shared_socket_enabled;
+static SharedSocket *shared_socket_singleton;
+
+/**
+ * nm_lldp_listener_set_shared_socket:
+ * @enabled: whether listeners share a packet socket
+ *
+ * By default, each listener runs sd-lldp with its own AF_PACKET socket bound
+ * to the interface, which needs its own filter and watch. When enabled, all
+ * listeners started afterwards receive the frames of their interface from one
+ * unbound packet socket instead. The frames are passed to the listener by
+ * ifindex, and the listener ages out its neighbors itself.
+ */
+void
+nm_lldp_listener_set_shared_socket (gboolean enabled)
+{
+	shared_socket_enabled = enabled;
+}
+
+static int
+shared_socket_set_membership (SharedSocket *shared, int ifindex, gboolean add)
+{
+	static const guint8 addresses[][ETH_ALEN] = {
+		{ 0x01, 0x80, 0xc2, 0x00, 0x00, 0x00 },
+		{ 0x01, 0x80, 0xc2, 0x00, 0x00, 0x03 },
+		{ 0x01, 0x80, 0xc2, 0x00, 0x00, 0x0e },
+	};
+	struct packet_mreq mreq = {
+		.mr_ifindex = ifindex,
+		.mr_type = PACKET_MR_MULTICAST,
+		.mr_alen = ETH_ALEN,
+	};
+	gsize i;
+
+	for (i = 0; i < G_N_ELEMENTS (addresses); i++) {
+		memcpy (mreq.mr_address, addresses[i], ETH_ALEN);
+		if (setsockopt (shared->fd,
+		                SOL_PACKET,
+		                add ? PACKET_ADD_MEMBERSHIP : PACKET_DROP_MEMBERSHIP,
+		                &mreq,
+		                sizeof (mreq)) < 0) {
+			/* when dropping, the interface might be already gone. */
+			if (add)
+				return -errno;
+		}
+	}
+	return 0;
+}
+
+static SharedSocket *
+shared_socket_ref (SharedSocket *shared)
+{
+	nm_assert (shared && shared->ref_count > 0);
+
+	shared->ref_count++;
+	return shared;
+}
+
+static void
+shared_socket_unref (SharedSocket *shared)
+{
+	nm_assert (shared && shared->ref_count > 0);
+
+	if (--shared->ref_count > 0)
+		return;
+
+	nm_assert (g_hash_table_size (shared->listeners) == 0);
+
+	if (shared_socket_singleton == shared)
+		shared_socket_singleton = NULL;
+
+	nm_clear_g_source (&shared->event_id);
+	nm_clear_pointer (&shared->channel, g_io_channel_unref);
+	nm_close (shared->fd);
+	g_hash_table_unref (shared->listeners);
+	g_free (shared);
+}
+
+static void shared_socket_restart_listeners (SharedSocket *shared);
+
+static gboolean
+shared_socket_event_cb (GIOChannel *source, GIOCondition condition, gpointer data)
+{
+	SharedSocket *shared = data;
+	guint i;
+
+	/* processing a frame may stop the last listener. */
+	shared_socket_ref (shared);
+
+	for (i = 0; i < SHARED_SOCKET_N_DISPATCH; i++) {
+		nm_auto (sd_lldp_neighbor_unrefp) sd_lldp_neighbor *neighbor_sd = NULL;
+		struct sockaddr_ll sll;
+		socklen_t sll_len = sizeof (sll);
+		NMLldpListener *self;
+		uint16_t ttl;
+		gssize n;
+		int r;
+
+		n = recvfrom (shared->fd, shared->buf, sizeof (shared->buf), MSG_DONTWAIT | MSG_TRUNC,
+		              (struct sockaddr *) &sll, &sll_len);
+		if (n < 0) {
+			int errsv = errno;
+
+			if (NM_IN_SET (errsv, EAGAIN, EINTR))
+				break;
+
+			nm_log_warn (LOGD_DEVICE, "lldp: error reading shared socket: %s",
+			             nm_strerror_native (errsv));
+			shared->event_id = 0;
+			shared_socket_restart_listeners (shared);
+			shared_socket_unref (shared);
+			return G_SOURCE_REMOVE;
+		}
+
+		/* like sd-lldp, ignore what we sent ourselves. */
+		if (   sll.sll_pkttype == PACKET_OUTGOING
+		    || (gsize) n > sizeof (shared->buf))
+			continue;
+
+		self = g_hash_table_lookup (shared->listeners, GINT_TO_POINTER (sll.sll_ifindex));
+		if (!self)
+			continue;
+
+		r = sd_lldp_neighbor_from_raw (&neighbor_sd, shared->buf, n);
+		if (r < 0) {
+			_LOGT ("process: failed to parse frame: %s", nm_strerror_native (-r));
+			continue;
+		}
+
+		if (sd_lldp_neighbor_get_ttl (neighbor_sd, &ttl) < 0)
+			ttl = 0;
+
+		/* a TTL of zero means the neighbor is gone. */
+		process_lldp_neighbor (self,
+		                       neighbor_sd,
+		                       ttl > 0,
+		                       nm_utils_get_monotonic_timestamp_ms () + ((gint64) ttl) * 1000);
+	}
+
+	shared_socket_unref (shared);
+	return G_SOURCE_CONTINUE;
+}
+
+static SharedSocket *
+shared_socket_acquire (GError **error)
+{
+	static const struct sock_filter filter[] = {
+		BPF_STMT (BPF_LD + BPF_W + BPF_ABS, offsetof (struct ethhdr, h_dest)),      /* A <- 4 bytes of destination MAC */
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, 0x0180c200, 1, 0),                     /* A != 01:80:c2:00 */
+		BPF_STMT (BPF_RET + BPF_K, 0),                                              /* drop packet */
+		BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct ethhdr, h_dest) + 4),  /* A <- remaining 2 bytes of destination MAC */
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, 0x0000, 3, 0),                         /* A != 00:00 */
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, 0x0003, 2, 0),                         /* A != 00:03 */
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, 0x000e, 1, 0),                         /* A != 00:0e */
+		BPF_STMT (BPF_RET + BPF_K, 0),                                              /* drop packet */
+		BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct ethhdr, h_proto)),     /* A <- protocol */
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ETH_P_LLDP, 1, 0),                     /* A != ETH_P_LLDP */
+		BPF_STMT (BPF_RET + BPF_K, 0),                                              /* drop packet */
+		BPF_STMT (BPF_RET + BPF_K, (guint32) -1),                                   /* accept packet */
+	};
+	static const struct sock_fprog fprog = {
+		.len = G_N_ELEMENTS (filter),
+		.filter = (struct sock_filter *) filter,
+	};
+	nm_auto_close int fd = -1;
+	SharedSocket *shared;
+
+	if (shared_socket_singleton)
+		return shared_socket_ref (shared_socket_singleton);
+
+	/* unlike sd-lldp's socket, this one is not bound to an interface. */
+	fd = socket (PF_PACKET, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, htons (ETH_P_LLDP));
+	if (fd < 0) {
+		nm_utils_error_set_errno (error, errno, "failed to create shared packet socket: %s");
+		return NULL;
+	}
+
+	if (setsockopt (fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof (fprog)) < 0) {
+		nm_utils_error_set_errno (error, errno, "failed to attach filter to shared packet socket: %s");
+		return NULL;
+	}
+
+	shared = g_new0 (SharedSocket, 1);
+	shared->ref_count = 1;
+	shared->fd = nm_steal_fd (&fd);
+	shared->listeners = g_hash_table_new (nm_direct_hash, NULL);
+
+	shared->channel = g_io_channel_unix_new (shared->fd);
+	shared->event_id = g_io_add_watch (shared->channel, G_IO_IN, shared_socket_event_cb, shared);
+
+	shared_socket_singleton = shared;
+	return shared;
+}
+
+static gboolean
+shared_socket_add_listener (NMLldpListener *self, int ifindex, GError **error)
+{
+	NMLldpListenerPrivate *priv = NM_LLDP_LISTENER_GET_PRIVATE (self);
+	SharedSocket *shared;
+	int r;
+
+	nm_assert (!priv->shared_socket);
+
+	shared = shared_socket_acquire (error);
+	if (!shared)
+		return FALSE;
+
+	if (g_hash_table_contains (shared->listeners, GINT_TO_POINTER (ifindex))) {
+		g_set_error_literal (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		                     "already running on interface");
+		shared_socket_unref (shared);
+		return FALSE;
+	}
+
+	r = shared_socket_set_membership (shared, ifindex, TRUE);
+	if (r < 0) {
+		nm_utils_error_set_errno (error, r, "failed adding multicast membership: %s");
+		shared_socket_set_membership (shared, ifindex, FALSE);
+		shared_socket_unref (shared);
+		return FALSE;
+	}
+
+	g_hash_table_insert (shared->listeners, GINT_TO_POINTER (ifindex), self);
+	priv->shared_socket = shared;
+	return TRUE;
+}
+
+static void
+shared_socket_remove_listener (NMLldpListener *self)
+{
+	NMLldpListenerPrivate *priv = NM_LLDP_LISTENER_GET_PRIVATE (self);
+	SharedSocket *shared = g_steal_pointer (&priv->shared_socket);
+
+	if (!shared)
+		return;
+
+	nm_assert (g_hash_table_lookup (shared->listeners, GINT_TO_POINTER (priv->ifindex)) == self);
+
+	g_hash_table_remove (shared->listeners, GINT_TO_POINTER (priv->ifindex));
+	shared_socket_set_membership (shared, priv->ifindex, FALSE);
+	shared_socket_unref (shared);
+}
+
+/*****************************************************************************/
+
+/* Move all listeners of a socket that can no longer be read to a new
+ * socket. Their neighbors are kept. A listener that cannot get a new
+ * socket is stopped. */
+static void
+shared_socket_restart_listeners (SharedSocket *shared)
+{
+	gs_unref_ptrarray GPtrArray *listeners = NULL;
+	GHashTableIter iter;
+	NMLldpListener *self;
+	guint i;
+
+	/* the listeners must not get the same socket again. */
+	if (shared_socket_singleton == shared)
+		shared_socket_singleton = NULL;
+
+	listeners = g_ptr_array_new_with_free_func (g_object_unref);
+	g_hash_table_iter_init (&iter, shared->listeners);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &self))
+		g_ptr_array_add (listeners, g_object_ref (self));
+
+	for (i = 0; i < listeners->len; i++) {
+		NMLldpListenerPrivate *priv;
+		gs_free_error GError *error = NULL;
+
+		self = listeners->pdata[i];
+		priv = NM_LLDP_LISTENER_GET_PRIVATE (self);
+
+		shared_socket_remove_listener (self);
+		if (!shared_socket_add_listener (self, priv->ifindex, &error)) {
+			_LOGW ("failed to restart on a new shared socket: %s", error->message);
+			if (g_hash_table_size (priv->lldp_neighbors) > 0) {
+				g_hash_table_remove_all (priv->lldp_neighbors);
+				data_changed_notify (self, priv);
+			}
+			nm_lldp_listener_stop (self);
+		}
+	}
 }
 
 gboolean
@@ -943,12 +1386,20 @@ nm_lldp_listener_start (NMLldpListener *self, int ifindex, GError **error)
 
 	priv = NM_LLDP_LISTENER_GET_PRIVATE (self);
 
-	if (priv->lldp_handle) {
+	if (priv->lldp_handle || priv->shared_socket) {
 		g_set_error_literal (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
 		                     "already running");
 		return FALSE;
 	}
 
+	if (shared_socket_enabled) {
+		if (!shared_socket_add_listener (self, ifindex, error))
+			return FALSE;
+		priv->ifindex = ifindex;
+		_LOGD ("start (shared socket)");
+		return TRUE;
+	}
+
 	ret = sd_lldp_new (&priv->lldp_handle);
 	if (ret < 0) {
 		g_set_error_literal (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
@@ -1009,12 +1460,15 @@ nm_lldp_listener_stop (NMLldpListener *self)
 	g_return_if_fail (NM_IS_LLDP_LISTENER (self));
 	priv = NM_LLDP_LISTENER_GET_PRIVATE (self);
 
-	if (priv->lldp_handle) {
+	if (priv->lldp_handle || priv->shared_socket) {
 		_LOGD ("stop");
-		sd_lldp_stop (priv->lldp_handle);
-		sd_lldp_detach_event (priv->lldp_handle);
-		sd_lldp_unref (priv->lldp_handle);
-		priv->lldp_handle = NULL;
+		if (priv->lldp_handle) {
+			sd_lldp_stop (priv->lldp_handle);
+			sd_lldp_detach_event (priv->lldp_handle);
+			sd_lldp_unref (priv->lldp_handle);
+			priv->lldp_handle = NULL;
+		} else
+			shared_socket_remove_listener (self);
 
 		size = g_hash_table_size (priv->lldp_neighbors);
 		g_hash_table_remove_all (priv->lldp_neighbors);
@@ -1024,6 +1478,8 @@ nm_lldp_listener_stop (NMLldpListener *self)
 
 	nm_clear_g_source (&priv->ratelimit_id);
 	priv->ratelimit_next = 0;
+	nm_clear_g_source (&priv->expiry_id);
+	priv->expiry_next = 0;
 	priv->ifindex = 0;
 
 	if (changed)
@@ -1038,7 +1494,7 @@ nm_lldp_listener_is_running (NMLldpListener *self)
 	g_return_val_if_fail (NM_IS_LLDP_LISTENER (self), FALSE);
 
 	priv = NM_LLDP_LISTENER_GET_PRIVATE (self);
-	return !!priv->lldp_handle;
+	return priv->lldp_handle || priv->shared_socket;
 }
 
 GVariant *
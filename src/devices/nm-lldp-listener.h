@@ -37,6 +37,8 @@ gboolean nm_lldp_listener_start (NMLldpListener *self, int ifindex, GError **err
 void nm_lldp_listener_stop (NMLldpListener *self);
 gboolean nm_lldp_listener_is_running (NMLldpListener *self);
 
+void nm_lldp_listener_set_shared_socket (gboolean enabled);
+
 GVariant *nm_lldp_listener_get_neighbors (NMLldpListener *self);
 
 #endif /* __NM_LLDP_LISTENER__ */
@@ -196,6 +196,75 @@ test_acd_probe_2 (test_fixture *fixture, gconstpointer user_data)
 	test_acd_common (fixture, &info);
 }
 
+typedef struct {
+	GMainLoop *loop;
+	guint n_pending;
+} MultiData;
+
+static void
+acd_manager_probe_terminated_multi (NMAcdManager *acd_manager, gpointer user_data)
+{
+	MultiData *data = user_data;
+
+	g_assert_cmpint (data->n_pending, >, 0);
+	if (--data->n_pending == 0)
+		g_main_loop_quit (data->loop);
+}
+
+static void
+test_acd_probe_multi (test_fixture *fixture, gconstpointer user_data)
+{
+	nm_auto_free_acdmgr NMAcdManager *manager1 = NULL;
+	nm_auto_free_acdmgr NMAcdManager *manager2 = NULL;
+	nm_auto_unref_gmainloop GMainLoop *loop = NULL;
+	static const NMAcdCallbacks callbacks = {
+		.probe_terminated_callback = acd_manager_probe_terminated_multi,
+	};
+	const guint N = 32;
+	const in_addr_t peer_addr = htonl (0x0a010005);
+	MultiData data = { .n_pending = 2, };
+	guint i;
+
+	if (_skip_acd_test ())
+		return;
+
+	loop = g_main_loop_new (NULL, FALSE);
+	data.loop = loop;
+
+	/* two managers on the same interface, which share one NAcd context. */
+	manager1 = nm_acd_manager_new (fixture->ifindex0,
+	                               fixture->hwaddr0,
+	                               fixture->hwaddr0_len,
+	                               &callbacks,
+	                               &data);
+	manager2 = nm_acd_manager_new (fixture->ifindex0,
+	                               fixture->hwaddr0,
+	                               fixture->hwaddr0_len,
+	                               &callbacks,
+	                               &data);
+
+	for (i = 1; i <= N; i++) {
+		g_assert (nm_acd_manager_add_address (manager1, htonl (0x0a010000 + i)));
+		g_assert (nm_acd_manager_add_address (manager2, htonl (0x0a020000 + i)));
+	}
+
+	nmtstp_ip4_address_add (NULL, FALSE, fixture->ifindex1, peer_addr,
+	                        16, 0, 3600, 1800, 0, NULL);
+
+	g_assert_cmpint (nm_acd_manager_start_probe (manager1, 500), ==, 0);
+	g_assert_cmpint (nm_acd_manager_start_probe (manager2, 500), ==, 0);
+
+	/* all probes run in parallel, so this takes about one probe interval. */
+	g_assert (nmtst_main_loop_run (loop, 2000));
+
+	for (i = 1; i <= N; i++) {
+		in_addr_t addr = htonl (0x0a010000 + i);
+
+		g_assert (nm_acd_manager_check_address (manager1, addr) == (addr != peer_addr));
+		g_assert (nm_acd_manager_check_address (manager2, htonl (0x0a020000 + i)));
+	}
+}
+
 static void
 test_acd_announce (test_fixture *fixture, gconstpointer user_data)
 {
@@ -242,5 +311,6 @@ _nmtstp_setup_tests (void)
 {
 	g_test_add ("/acd/probe/1", test_fixture, NULL, fixture_setup, test_acd_probe_1, fixture_teardown);
 	g_test_add ("/acd/probe/2", test_fixture, NULL, fixture_setup, test_acd_probe_2, fixture_teardown);
+	g_test_add ("/acd/probe/multi", test_fixture, NULL, fixture_setup, test_acd_probe_multi, fixture_teardown);
 	g_test_add ("/acd/announce", test_fixture, NULL, fixture_setup, test_acd_announce, fixture_teardown);
 }
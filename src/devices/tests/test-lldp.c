@@ -113,7 +113,8 @@ typedef struct {
 		.frames = { __VA_ARGS__ }, \
 	}
 
-#define TEST_IFNAME "nm-tap-test0"
+#define TEST_IFNAME  "nm-tap-test0"
+#define TEST_IFNAME1 "nm-tap-test1"
 
 TEST_RECV_FRAME_DEFINE (_test_recv_data0_frame0,
 	/* Ethernet header */
@@ -405,7 +406,7 @@ _test_recv_data2_ttl1_check (GMainLoop *loop, NMLldpListener *listener)
 TEST_RECV_DATA_DEFINE (_test_recv_data2_ttl1, 1, _test_recv_data2_ttl1_check,  &_test_recv_data2_frame0_ttl1);
 
 static void
-_test_recv_fixture_setup (TestRecvFixture *fixture, gconstpointer user_data)
+_test_recv_tap_setup (TestRecvFixture *fixture, const char *ifname)
 {
 	const NMPlatformLink *link;
 	nm_auto_close int fd = -1;
@@ -430,18 +431,18 @@ _test_recv_fixture_setup (TestRecvFixture *fixture, gconstpointer user_data)
 
 		link = nmtstp_link_tun_add (NM_PLATFORM_GET,
 		                            FALSE,
-		                            TEST_IFNAME,
+		                            ifname,
 		                            &lnk,
 		                            &fd);
 		g_assert (link);
 		nmtstp_link_set_updown (NM_PLATFORM_GET, -1, link->ifindex, TRUE);
-		link = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, TEST_IFNAME, NM_LINK_TYPE_TUN, 0);
+		link = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, ifname, NM_LINK_TYPE_TUN, 0);
 	} else {
 		int s;
 		struct ifreq ifr = { };
 
 		ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
-		nm_utils_ifname_cpy (ifr.ifr_name, TEST_IFNAME);
+		nm_utils_ifname_cpy (ifr.ifr_name, ifname);
 		g_assert (ioctl (fd, TUNSETIFF, &ifr) >= 0);
 
 		/* Bring the interface up */
@@ -451,7 +452,7 @@ _test_recv_fixture_setup (TestRecvFixture *fixture, gconstpointer user_data)
 		g_assert (ioctl (s, SIOCSIFFLAGS, &ifr) >= 0);
 		nm_close (s);
 
-		link = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, TEST_IFNAME, NM_LINK_TYPE_TUN, 100);
+		link = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, ifname, NM_LINK_TYPE_TUN, 100);
 	}
 
 	fixture->ifindex = link->ifindex;
@@ -459,6 +460,12 @@ _test_recv_fixture_setup (TestRecvFixture *fixture, gconstpointer user_data)
 	memcpy (fixture->mac, link->l_address.data, ETH_ALEN);
 }
 
+static void
+_test_recv_fixture_setup (TestRecvFixture *fixture, gconstpointer user_data)
+{
+	_test_recv_tap_setup (fixture, TEST_IFNAME);
+}
+
 typedef struct {
 	int num_called;
 } TestRecvCallbackInfo;
@@ -518,6 +525,14 @@ test_recv (TestRecvFixture *fixture, gconstpointer user_data)
 	g_clear_pointer (&loop, g_main_loop_unref);
 }
 
+static void
+test_recv_shared (TestRecvFixture *fixture, gconstpointer user_data)
+{
+	nm_lldp_listener_set_shared_socket (TRUE);
+	test_recv (fixture, user_data);
+	nm_lldp_listener_set_shared_socket (FALSE);
+}
+
 static void
 _test_recv_fixture_teardown (TestRecvFixture *fixture, gconstpointer user_data)
 {
@@ -527,6 +542,112 @@ _test_recv_fixture_teardown (TestRecvFixture *fixture, gconstpointer user_data)
 
 /*****************************************************************************/
 
+typedef struct {
+	TestRecvFixture tap0;
+	TestRecvFixture tap1;
+} TestRecvMultiFixture;
+
+static void
+_test_recv_multi_fixture_setup (TestRecvMultiFixture *fixture, gconstpointer user_data)
+{
+	_test_recv_tap_setup (&fixture->tap0, TEST_IFNAME);
+	if (fixture->tap0.ifindex)
+		_test_recv_tap_setup (&fixture->tap1, TEST_IFNAME1);
+}
+
+static void
+test_recv_shared_multi (TestRecvMultiFixture *fixture, gconstpointer user_data)
+{
+	gs_unref_object NMLldpListener *listener0 = NULL;
+	gs_unref_object NMLldpListener *listener1 = NULL;
+	TestRecvCallbackInfo info0 = { };
+	TestRecvCallbackInfo info1 = { };
+	gs_unref_variant GVariant *neighbor = NULL;
+	GVariant *neighbors;
+	GMainLoop *loop;
+	gulong notify_id0;
+	gulong notify_id1;
+	gulong notify_id;
+	GError *error = NULL;
+
+	if (   fixture->tap0.ifindex == 0
+	    || fixture->tap1.ifindex == 0) {
+		g_test_skip ("Tun device not available");
+		return;
+	}
+
+	nm_lldp_listener_set_shared_socket (TRUE);
+
+	listener0 = nm_lldp_listener_new ();
+	g_assert (nm_lldp_listener_start (listener0, fixture->tap0.ifindex, &error));
+	g_assert_no_error (error);
+
+	listener1 = nm_lldp_listener_new ();
+	g_assert (nm_lldp_listener_start (listener1, fixture->tap1.ifindex, &error));
+	g_assert_no_error (error);
+
+	notify_id0 = g_signal_connect (listener0, "notify::" NM_LLDP_LISTENER_NEIGHBORS,
+	                               (GCallback) lldp_neighbors_changed, &info0);
+	notify_id1 = g_signal_connect (listener1, "notify::" NM_LLDP_LISTENER_NEIGHBORS,
+	                               (GCallback) lldp_neighbors_changed, &info1);
+	loop = g_main_loop_new (NULL, FALSE);
+
+	/* each neighbor only reaches the listener of its interface. */
+	g_assert (write (fixture->tap0.fd, _test_recv_data0_frame0.frame, _test_recv_data0_frame0.frame_len) == _test_recv_data0_frame0.frame_len);
+	g_assert (write (fixture->tap1.fd, _test_recv_data1_frame0.frame, _test_recv_data1_frame0.frame_len) == _test_recv_data1_frame0.frame_len);
+
+	if (nmtst_main_loop_run (loop, 500))
+		g_assert_not_reached ();
+
+	g_assert_cmpint (info0.num_called, ==, 1);
+	g_assert_cmpint (info1.num_called, ==, 1);
+	_test_recv_data0_check (loop, listener0);
+	_test_recv_data1_check (loop, listener1);
+
+	/* stopping one listener doesn't affect the other. */
+	nm_lldp_listener_stop (listener0);
+	g_assert (!nm_lldp_listener_is_running (listener0));
+	g_assert (nm_lldp_listener_is_running (listener1));
+	info0.num_called = 0;
+
+	g_assert (write (fixture->tap0.fd, _test_recv_data0_frame0.frame, _test_recv_data0_frame0.frame_len) == _test_recv_data0_frame0.frame_len);
+	g_assert (write (fixture->tap1.fd, _test_recv_data0_frame0.frame, _test_recv_data0_frame0.frame_len) == _test_recv_data0_frame0.frame_len);
+
+	/* the update of listener1 is rate limited. */
+	notify_id = g_signal_connect (listener1, "notify::" NM_LLDP_LISTENER_NEIGHBORS,
+	                              nmtst_main_loop_quit_on_notify, loop);
+	if (!nmtst_main_loop_run (loop, 5000))
+		g_assert_not_reached ();
+	nm_clear_g_signal_handler (listener1, &notify_id);
+
+	g_assert_cmpint (info0.num_called, ==, 0);
+	neighbors = nm_lldp_listener_get_neighbors (listener0);
+	g_assert_cmpint (g_variant_n_children (neighbors), ==, 0);
+
+	neighbors = nm_lldp_listener_get_neighbors (listener1);
+	g_assert_cmpint (g_variant_n_children (neighbors), ==, 2);
+	neighbor = get_lldp_neighbor (neighbors,
+	                              SD_LLDP_CHASSIS_SUBTYPE_MAC_ADDRESS, "00:01:02:03:04:05",
+	                              SD_LLDP_PORT_SUBTYPE_INTERFACE_NAME, "1/3");
+	g_assert (neighbor);
+
+	nm_clear_g_signal_handler (listener0, &notify_id0);
+	nm_clear_g_signal_handler (listener1, &notify_id1);
+	nm_lldp_listener_stop (listener1);
+	g_clear_pointer (&loop, g_main_loop_unref);
+
+	nm_lldp_listener_set_shared_socket (FALSE);
+}
+
+static void
+_test_recv_multi_fixture_teardown (TestRecvMultiFixture *fixture, gconstpointer user_data)
+{
+	_test_recv_fixture_teardown (&fixture->tap0, user_data);
+	_test_recv_fixture_teardown (&fixture->tap1, user_data);
+}
+
+/*****************************************************************************/
+
 NMTstpSetupFunc const _nmtstp_setup_platform_func = nm_linux_platform_setup;
 
 void
@@ -544,4 +665,13 @@ _nmtstp_setup_tests (void)
 	_TEST_ADD_RECV ("/lldp/recv/0_twice", &_test_recv_data0_twice);
 	_TEST_ADD_RECV ("/lldp/recv/1",       &_test_recv_data1);
 	_TEST_ADD_RECV ("/lldp/recv/2_ttl1",  &_test_recv_data2_ttl1);
+
+#define _TEST_ADD_RECV_SHARED(testpath, testdata) \
+	g_test_add (testpath, TestRecvFixture, testdata, _test_recv_fixture_setup, test_recv_shared, _test_recv_fixture_teardown)
+	_TEST_ADD_RECV_SHARED ("/lldp/recv/shared/0",       &_test_recv_data0);
+	_TEST_ADD_RECV_SHARED ("/lldp/recv/shared/0_twice", &_test_recv_data0_twice);
+	_TEST_ADD_RECV_SHARED ("/lldp/recv/shared/1",       &_test_recv_data1);
+	_TEST_ADD_RECV_SHARED ("/lldp/recv/shared/2_ttl1",  &_test_recv_data2_ttl1);
+
+	g_test_add ("/lldp/recv/shared/multi", TestRecvMultiFixture, NULL, _test_recv_multi_fixture_setup, test_recv_shared_multi, _test_recv_multi_fixture_teardown);
 }
@@ -63,6 +63,11 @@ _LOG_DECLARE_SELF(NMDeviceWifi);
 
 #define SCAN_RAND_MAC_ADDRESS_EXPIRE_MIN 5
 
+
+/* the kernel's scan dump also contains cached BSS. Only use those that
+ * were seen recently. */
+#define NATIVE_SCAN_RESULT_MAX_AGE_S 5
+
 /*****************************************************************************/
 
 NM_GOBJECT_PROPERTIES_DEFINE (NMDeviceWifi,
@@ -88,6 +93,7 @@ typedef struct {
 	gint8             invalid_strength_counter;
 
 	CList             aps_lst_head;
+	NMWifiAPsIdx      aps_idx;
 
 	NMWifiAP *        current_ap;
 	guint32           rate;
@@ -97,6 +103,9 @@ typedef struct {
 	bool              is_scanning:1;
 	bool              hidden_probe_scan_warn:1;
 
+	/* the ifindex for which we watch the nl80211 scan results, or zero. */
+	int               native_scan_results_ifindex;
+
 	gint64            last_scan; /* milliseconds */
 	gint32            scheduled_scan_time; /* seconds */
 	guint8            scan_interval; /* seconds */
@@ -196,15 +205,23 @@ static void request_wireless_scan (NMDeviceWifi *self,
                                    gboolean force_if_scanning,
                                    const GPtrArray *ssids);
 
-static void ap_add_remove (NMDeviceWifi *self,
-                           gboolean is_adding,
-                           NMWifiAP *ap,
-                           gboolean recheck_available_connections);
+static void ap_add_remove_full (NMDeviceWifi *self,
+                                gboolean is_adding,
+                                NMWifiAP *ap,
+                                gboolean recheck_available_connections,
+                                gboolean coalesce);
+
+#define ap_add_remove(self, is_adding, ap, recheck_available_connections) \
+	ap_add_remove_full (self, is_adding, ap, recheck_available_connections, FALSE)
 
 static void _hw_addr_set_scanning (NMDeviceWifi *self, gboolean do_reset);
 
 static void recheck_p2p_availability (NMDeviceWifi *self);
 
+static void native_scan_results_cb (int ifindex,
+                                    GPtrArray *bss_props,
+                                    gpointer user_data);
+
 /*****************************************************************************/
 
 static void
@@ -303,11 +320,49 @@ supplicant_interface_acquire (NMDeviceWifi *self)
 	                  G_CALLBACK (supplicant_iface_notify_p2p_available),
 	                  self);
 
+	if (nm_config_data_get_device_config_boolean (NM_CONFIG_GET_DATA,
+	                                              NM_CONFIG_KEYFILE_KEY_DEVICE_WIFI_SCAN_NL80211_RESULTS,
+	                                              NM_DEVICE (self),
+	                                              FALSE, FALSE)) {
+		int ifindex = nm_device_get_ifindex (NM_DEVICE (self));
+
+		if (   ifindex > 0
+		    && nm_platform_wifi_watch_scan_results (nm_device_get_platform (NM_DEVICE (self)),
+		                                            ifindex,
+		                                            native_scan_results_cb,
+		                                            self)) {
+			priv->native_scan_results_ifindex = ifindex;
+
+			/* the nl80211 results refresh the APs, no need to also receive
+			 * every property change of every BSS over D-Bus. */
+			nm_supplicant_interface_set_watch_bss_properties (priv->sup_iface, FALSE);
+		} else
+			_LOGD (LOGD_WIFI, "wifi-scan: nl80211 scan results are not supported by the driver");
+	}
+
 	_notify_scanning (self);
 
 	return TRUE;
 }
 
+static void
+native_scan_results_unwatch (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	int ifindex;
+
+	ifindex = nm_steal_int (&priv->native_scan_results_ifindex);
+	if (ifindex <= 0)
+		return;
+
+	/* the device may already be gone. Always unregister with the ifindex we
+	 * registered, so that the platform does not keep calling us. */
+	nm_platform_wifi_watch_scan_results (nm_device_get_platform (NM_DEVICE (self)), ifindex, NULL, self);
+
+	if (priv->sup_iface)
+		nm_supplicant_interface_set_watch_bss_properties (priv->sup_iface, TRUE);
+}
+
 static void
 _requested_scan_set (NMDeviceWifi *self, gboolean value)
 {
@@ -348,6 +403,8 @@ supplicant_interface_release (NMDeviceWifi *self)
 
 	nm_clear_g_source (&priv->ap_dump_id);
 
+	native_scan_results_unwatch (self);
+
 	if (priv->sup_iface) {
 		/* Clear supplicant interface signal handlers */
 		g_signal_handlers_disconnect_by_data (priv->sup_iface, self);
@@ -477,11 +534,32 @@ periodic_update_cb (gpointer user_data)
 	return TRUE;
 }
 
+static NMWifiAP *
+_ap_find_by_supplicant_path (NMDeviceWifi *self, const char *path)
+{
+	nm_assert (path);
+
+	return nm_wifi_aps_idx_lookup (&NM_DEVICE_WIFI_GET_PRIVATE (self)->aps_idx, path);
+}
+
+static void
+_ap_list_changed_cb (gboolean recheck_available_connections,
+                     gpointer user_data)
+{
+	NMDeviceWifi *self = user_data;
+
+	_notify (self, PROP_ACCESS_POINTS);
+	nm_device_emit_recheck_auto_activate (NM_DEVICE (self));
+	if (recheck_available_connections)
+		nm_device_recheck_available_connections (NM_DEVICE (self));
+}
+
 static void
-ap_add_remove (NMDeviceWifi *self,
-               gboolean is_adding, /* or else removing */
-               NMWifiAP *ap,
-               gboolean recheck_available_connections)
+ap_add_remove_full (NMDeviceWifi *self,
+                    gboolean is_adding, /* or else removing */
+                    NMWifiAP *ap,
+                    gboolean recheck_available_connections,
+                    gboolean coalesce)
 {
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
@@ -489,22 +567,32 @@ ap_add_remove (NMDeviceWifi *self,
 		g_object_ref (ap);
 		ap->wifi_device = NM_DEVICE (self);
 		c_list_link_tail (&priv->aps_lst_head, &ap->aps_lst);
+		nm_wifi_aps_idx_add (&priv->aps_idx, ap);
 		nm_dbus_object_export (NM_DBUS_OBJECT (ap));
 		_ap_dump (self, LOGL_DEBUG, ap, "added", 0);
 		nm_device_wifi_emit_signal_access_point (NM_DEVICE (self), ap, TRUE);
 	} else {
 		ap->wifi_device = NULL;
 		c_list_unlink (&ap->aps_lst);
+		nm_wifi_aps_idx_remove (&priv->aps_idx, ap);
 		_ap_dump (self, LOGL_DEBUG, ap, "removed", 0);
 	}
 
-	_notify (self, PROP_ACCESS_POINTS);
+	if (coalesce) {
+		/* the AccessPoints property and the rechecks are only updated once
+		 * per batch of scan results. See nm_wifi_aps_idx_changed_flush(). */
+		nm_wifi_aps_idx_changed_schedule (&priv->aps_idx, recheck_available_connections);
+	} else
+		_notify (self, PROP_ACCESS_POINTS);
 
 	if (!is_adding) {
 		nm_device_wifi_emit_signal_access_point (NM_DEVICE (self), ap, FALSE);
 		nm_dbus_object_clear_and_unexport (&ap);
 	}
 
+	if (coalesce)
+		return;
+
 	nm_device_emit_recheck_auto_activate (NM_DEVICE (self));
 	if (recheck_available_connections)
 		nm_device_recheck_available_connections (NM_DEVICE (self));
@@ -1449,6 +1537,8 @@ supplicant_iface_scan_done_cb (NMSupplicantInterface *iface,
 
 	_LOGD (LOGD_WIFI, "wifi-scan: scan-done callback: %s", success ? "successful" : "failed");
 
+	nm_wifi_aps_idx_changed_flush (&priv->aps_idx);
+
 	priv->last_scan = nm_utils_get_monotonic_timestamp_ms ();
 	_notify (self, PROP_LAST_SCAN);
 	schedule_scan (self, success);
@@ -1545,7 +1635,7 @@ supplicant_iface_bss_updated_cb (NMSupplicantInterface *iface,
 	if (NM_DEVICE_WIFI_GET_PRIVATE (self)->mode == NM_802_11_MODE_AP)
 		return;
 
-	found_ap = nm_wifi_aps_find_by_supplicant_path (&priv->aps_lst_head, object_path);
+	found_ap = _ap_find_by_supplicant_path (self, object_path);
 	if (found_ap) {
 		if (!nm_wifi_ap_update_from_properties (found_ap, object_path, properties))
 			return;
@@ -1581,7 +1671,7 @@ supplicant_iface_bss_updated_cb (NMSupplicantInterface *iface,
 			}
 		}
 
-		ap_add_remove (self, TRUE, ap, TRUE);
+		ap_add_remove_full (self, TRUE, ap, TRUE, TRUE);
 	}
 
 	/* Update the current AP if the supplicant notified a current BSS change
@@ -1593,6 +1683,59 @@ supplicant_iface_bss_updated_cb (NMSupplicantInterface *iface,
 	schedule_ap_list_dump (self);
 }
 
+static void
+native_scan_results_merge_cb (NMWifiAP *ap,
+                              GVariant *properties,
+                              gpointer user_data)
+{
+	NMDeviceWifi *self = user_data;
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	/* the supplicant re-announces its BSS properties after every scan.
+	 * Since we don't watch their changes, keep them current so that it
+	 * doesn't send us back to older values. */
+	if (priv->sup_iface) {
+		nm_supplicant_interface_merge_bss_properties (priv->sup_iface,
+		                                              nm_wifi_ap_get_supplicant_path (ap),
+		                                              properties);
+	}
+}
+
+static void
+native_scan_results_cb (int ifindex,
+                        GPtrArray *bss_props,
+                        gpointer user_data)
+{
+	NMDeviceWifi *self = user_data;
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	guint n_updated;
+
+	/* The supplicant is still the source of the AP list, as it is needed for
+	 * association. The results from nl80211 only refresh the properties
+	 * (like signal strength and last-seen) of APs we already know, without
+	 * waiting for the supplicant to relay them over D-Bus. */
+
+	if (nm_device_get_state (NM_DEVICE (self)) <= NM_DEVICE_STATE_UNAVAILABLE)
+		return;
+	if (priv->mode == NM_802_11_MODE_AP)
+		return;
+
+	n_updated = nm_wifi_aps_update_from_scan_results (&priv->aps_lst_head,
+	                                                  bss_props,
+	                                                  NATIVE_SCAN_RESULT_MAX_AGE_S,
+	                                                  native_scan_results_merge_cb,
+	                                                  self);
+
+	_LOGT (LOGD_WIFI_SCAN, "wifi-scan: nl80211 scan results: %u BSS, %u APs updated",
+	       bss_props->len, n_updated);
+
+	priv->last_scan = nm_utils_get_monotonic_timestamp_ms ();
+	_notify (self, PROP_LAST_SCAN);
+
+	if (n_updated > 0)
+		schedule_ap_list_dump (self);
+}
+
 static void
 supplicant_iface_bss_removed_cb (NMSupplicantInterface *iface,
                                  const char *object_path,
@@ -1605,7 +1748,7 @@ supplicant_iface_bss_removed_cb (NMSupplicantInterface *iface,
 	g_return_if_fail (object_path != NULL);
 
 	priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
-	ap = nm_wifi_aps_find_by_supplicant_path (&priv->aps_lst_head, object_path);
+	ap = _ap_find_by_supplicant_path (self, object_path);
 	if (!ap)
 		return;
 
@@ -1618,7 +1761,7 @@ supplicant_iface_bss_removed_cb (NMSupplicantInterface *iface,
 		if (nm_wifi_ap_set_fake (ap, TRUE))
 			_ap_dump (self, LOGL_DEBUG, ap, "updated", 0);
 	} else {
-		ap_add_remove (self, FALSE, ap, TRUE);
+		ap_add_remove_full (self, FALSE, ap, TRUE, TRUE);
 		schedule_ap_list_dump (self);
 	}
 }
@@ -2170,7 +2313,7 @@ supplicant_iface_notify_current_bss (NMSupplicantInterface *iface,
 
 	current_bss = nm_supplicant_interface_get_current_bss (iface);
 	if (current_bss)
-		new_ap = nm_wifi_aps_find_by_supplicant_path (&priv->aps_lst_head, current_bss);
+		new_ap = _ap_find_by_supplicant_path (self, current_bss);
 
 	if (new_ap != priv->current_ap) {
 		const char *new_bssid = NULL;
@@ -3263,6 +3406,7 @@ nm_device_wifi_init (NMDeviceWifi *self)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
 	c_list_init (&priv->aps_lst_head);
+	nm_wifi_aps_idx_init (&priv->aps_idx, _ap_list_changed_cb, self);
 
 	priv->hidden_probe_scan_warn = TRUE;
 	priv->mode = NM_802_11_MODE_INFRA;
@@ -3304,6 +3448,8 @@ dispose (GObject *object)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
 	nm_clear_g_source (&priv->periodic_source_id);
+	nm_clear_g_source (&priv->aps_idx.changed_id);
+	native_scan_results_unwatch (self);
 
 	wifi_secrets_cancel (self);
 
@@ -3331,6 +3477,9 @@ finalize (GObject *object)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
 	nm_assert (c_list_is_empty (&priv->aps_lst_head));
+	nm_assert (g_hash_table_size (priv->aps_idx.by_supplicant_path) == 0);
+
+	nm_wifi_aps_idx_clear (&priv->aps_idx);
 
 	G_OBJECT_CLASS (nm_device_wifi_parent_class)->finalize (object);
 }
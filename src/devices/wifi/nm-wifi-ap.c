@@ -1512,18 +1512,187 @@ nm_wifi_aps_find_first_compatible (const CList *aps_lst_head,
 	return NULL;
 }
 
-NMWifiAP *
-nm_wifi_aps_find_by_supplicant_path (const CList *aps_lst_head, const char *path)
+/**
+ * nm_wifi_aps_update_from_scan_results:
+ * @aps_lst_head: the list of APs
+ * @scan_results: the BSS properties of a scan, as returned by the
+ *   nl80211 scan results
+ * @max_age_s: ignore results that are older than this many seconds
+ * @func: (allow-none): called for every AP that is updated, before it
+ *   gets updated
+ * @user_data: user data for @func
+ *
+ * Refreshes the APs in @aps_lst_head that match a BSS of @scan_results
+ * by BSSID. APs without a supplicant path are skipped. The result does
+ * not add new APs.
+ *
+ * Returns: the number of APs that changed.
+ */
+guint
+nm_wifi_aps_update_from_scan_results (const CList *aps_lst_head,
+                                      const GPtrArray *scan_results,
+                                      guint32 max_age_s,
+                                      NMWifiAPScanResultFunc func,
+                                      gpointer user_data)
 {
+	gs_unref_hashtable GHashTable *by_bssid = NULL;
 	NMWifiAP *ap;
+	guint n_updated = 0;
+	guint i;
+
+	if (   !scan_results
+	    || scan_results->len == 0
+	    || c_list_is_empty (aps_lst_head))
+		return 0;
+
+	by_bssid = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, NULL);
+	for (i = 0; i < scan_results->len; i++) {
+		GVariant *props = scan_results->pdata[i];
+		gs_unref_variant GVariant *v = NULL;
+		const guint8 *bytes;
+		gsize len;
+		guint32 age;
+
+		if (   g_variant_lookup (props, "Age", "u", &age)
+		    && age > max_age_s)
+			continue;
+
+		v = g_variant_lookup_value (props, "BSSID", G_VARIANT_TYPE_BYTESTRING);
+		if (!v)
+			continue;
+		bytes = g_variant_get_fixed_array (v, &len, 1);
+		if (len != ETH_ALEN)
+			continue;
+
+		g_hash_table_insert (by_bssid, nm_utils_hwaddr_ntoa (bytes, ETH_ALEN), props);
+	}
 
-	g_return_val_if_fail (path != NULL, NULL);
+	if (g_hash_table_size (by_bssid) == 0)
+		return 0;
 
 	c_list_for_each_entry (ap, aps_lst_head, aps_lst) {
-		if (nm_streq0 (path, nm_wifi_ap_get_supplicant_path (ap)))
-			return ap;
+		const char *supplicant_path;
+		const char *address;
+		GVariant *props;
+
+		supplicant_path = nm_wifi_ap_get_supplicant_path (ap);
+		address = nm_wifi_ap_get_address (ap);
+		if (   !supplicant_path
+		    || !address)
+			continue;
+
+		props = g_hash_table_lookup (by_bssid, address);
+		if (!props)
+			continue;
+
+		if (func)
+			func (ap, props, user_data);
+
+		if (nm_wifi_ap_update_from_properties (ap, supplicant_path, props))
+			n_updated++;
 	}
-	return NULL;
+
+	return n_updated;
+}
+
+/*****************************************************************************/
+
+void
+nm_wifi_aps_idx_init (NMWifiAPsIdx *idx,
+                      NMWifiAPsChangedFunc changed_func,
+                      gpointer changed_user_data)
+{
+	nm_assert (idx);
+	nm_assert (changed_func);
+
+	*idx = (NMWifiAPsIdx) {
+		.by_supplicant_path = g_hash_table_new (nm_str_hash, g_str_equal),
+		.changed_func       = changed_func,
+		.changed_user_data  = changed_user_data,
+	};
+}
+
+void
+nm_wifi_aps_idx_clear (NMWifiAPsIdx *idx)
+{
+	nm_clear_g_source (&idx->changed_id);
+	idx->changed_pending = FALSE;
+	idx->changed_recheck = FALSE;
+	nm_clear_pointer (&idx->by_supplicant_path, g_hash_table_unref);
+}
+
+void
+nm_wifi_aps_idx_add (NMWifiAPsIdx *idx,
+                     NMWifiAP *ap)
+{
+	const char *supplicant_path;
+
+	supplicant_path = nm_wifi_ap_get_supplicant_path (ap);
+	if (supplicant_path)
+		g_hash_table_insert (idx->by_supplicant_path, (char *) supplicant_path, ap);
+}
+
+void
+nm_wifi_aps_idx_remove (NMWifiAPsIdx *idx,
+                        NMWifiAP *ap)
+{
+	const char *supplicant_path;
+
+	/* another AP might have taken over the path in the meantime. Only drop
+	 * the entry if it still points to @ap. */
+	supplicant_path = nm_wifi_ap_get_supplicant_path (ap);
+	if (   supplicant_path
+	    && g_hash_table_lookup (idx->by_supplicant_path, supplicant_path) == ap)
+		g_hash_table_remove (idx->by_supplicant_path, supplicant_path);
+}
+
+NMWifiAP *
+nm_wifi_aps_idx_lookup (const NMWifiAPsIdx *idx,
+                        const char *supplicant_path)
+{
+	nm_assert (supplicant_path);
+
+	return g_hash_table_lookup (idx->by_supplicant_path, supplicant_path);
+}
+
+static gboolean
+_aps_idx_changed_cb (gpointer user_data)
+{
+	NMWifiAPsIdx *idx = user_data;
+
+	idx->changed_id = 0;
+	nm_wifi_aps_idx_changed_flush (idx);
+	return G_SOURCE_REMOVE;
+}
+
+void
+nm_wifi_aps_idx_changed_schedule (NMWifiAPsIdx *idx,
+                                  gboolean recheck_available_connections)
+{
+	idx->changed_pending = TRUE;
+	idx->changed_recheck |= !!recheck_available_connections;
+	if (!idx->changed_id) {
+		idx->changed_id = g_timeout_add (NM_WIFI_APS_CHANGED_COALESCE_MSEC,
+		                                 _aps_idx_changed_cb,
+		                                 idx);
+	}
+}
+
+void
+nm_wifi_aps_idx_changed_flush (NMWifiAPsIdx *idx)
+{
+	gboolean recheck;
+
+	nm_clear_g_source (&idx->changed_id);
+
+	if (!idx->changed_pending)
+		return;
+
+	recheck = idx->changed_recheck;
+	idx->changed_pending = FALSE;
+	idx->changed_recheck = FALSE;
+
+	idx->changed_func (recheck, idx->changed_user_data);
 }
 
 /*****************************************************************************/
@@ -107,7 +107,53 @@ const char      **nm_wifi_aps_get_paths        (const CList *aps_lst_head,
 NMWifiAP         *nm_wifi_aps_find_first_compatible (const CList *aps_lst_head,
                                                      NMConnection *connection);
 
-NMWifiAP         *nm_wifi_aps_find_by_supplicant_path (const CList *aps_lst_head, const char *path);
+typedef void (*NMWifiAPScanResultFunc) (NMWifiAP *ap,
+                                        GVariant *properties,
+                                        gpointer user_data);
+
+guint             nm_wifi_aps_update_from_scan_results (const CList *aps_lst_head,
+                                                        const GPtrArray *scan_results,
+                                                        guint32 max_age_s,
+                                                        NMWifiAPScanResultFunc func,
+                                                        gpointer user_data);
+
+/*****************************************************************************/
+
+/* scan results arriving within this window are announced together. The
+ * pending changes are flushed early when the supplicant signals scan-done. */
+#define NM_WIFI_APS_CHANGED_COALESCE_MSEC 300
+
+typedef void (*NMWifiAPsChangedFunc) (gboolean recheck_available_connections,
+                                      gpointer user_data);
+
+/* indexes the APs of a device by their supplicant path and coalesces the
+ * notifications about changes to the list. */
+typedef struct {
+	GHashTable *by_supplicant_path;
+	NMWifiAPsChangedFunc changed_func;
+	gpointer changed_user_data;
+	guint changed_id;
+	bool changed_pending:1;
+	bool changed_recheck:1;
+} NMWifiAPsIdx;
+
+void              nm_wifi_aps_idx_init           (NMWifiAPsIdx *idx,
+                                                  NMWifiAPsChangedFunc changed_func,
+                                                  gpointer changed_user_data);
+void              nm_wifi_aps_idx_clear          (NMWifiAPsIdx *idx);
+
+void              nm_wifi_aps_idx_add            (NMWifiAPsIdx *idx,
+                                                  NMWifiAP *ap);
+void              nm_wifi_aps_idx_remove         (NMWifiAPsIdx *idx,
+                                                  NMWifiAP *ap);
+NMWifiAP         *nm_wifi_aps_idx_lookup         (const NMWifiAPsIdx *idx,
+                                                  const char *supplicant_path);
+
+void              nm_wifi_aps_idx_changed_schedule (NMWifiAPsIdx *idx,
+                                                    gboolean recheck_available_connections);
+void              nm_wifi_aps_idx_changed_flush    (NMWifiAPsIdx *idx);
+
+/*****************************************************************************/
 
 NMWifiAP         *nm_wifi_ap_lookup_for_device (NMDevice *device, const char *exported_path);
 
@@ -19,7 +19,11 @@
 
 #include "nm-default.h"
 
+#include <linux/nl80211.h>
+
 #include "devices/wifi/nm-wifi-utils.h"
+#include "devices/wifi/nm-wifi-ap.h"
+#include "platform/wifi/nm-wifi-utils-nl80211.h"
 #include "nm-core-internal.h"
 
 #include "nm-test-utils-core.h"
@@ -1350,6 +1354,372 @@ test_strength_all (void)
 
 /*****************************************************************************/
 
+static GVariant *
+_bss_props_new (const char *ssid, guint16 freq, gint16 signal)
+{
+	static const guint8 bssid[ETH_ALEN] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+	GVariantBuilder builder;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&builder, "{sv}", "BSSID",
+	                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, bssid, ETH_ALEN, 1));
+	if (ssid) {
+		g_variant_builder_add (&builder, "{sv}", "SSID",
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, ssid, strlen (ssid), 1));
+	}
+	g_variant_builder_add (&builder, "{sv}", "Frequency", g_variant_new_uint16 (freq));
+	g_variant_builder_add (&builder, "{sv}", "Signal", g_variant_new_int16 (signal));
+	g_variant_builder_add (&builder, "{sv}", "Mode", g_variant_new_string ("infrastructure"));
+	g_variant_builder_add (&builder, "{sv}", "Privacy", g_variant_new_boolean (FALSE));
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+static void
+test_ap_update_from_nl80211 (void)
+{
+	gs_unref_object NMWifiAP *ap = NULL;
+	gs_unref_variant GVariant *props = NULL;
+	gs_unref_variant GVariant *props_nl80211 = NULL;
+	GBytes *ssid;
+	gint8 strength;
+
+	/* the AP is created from the supplicant's BSS properties. */
+	props = _bss_props_new ("blahblah", 2412, -80);
+	ap = nm_wifi_ap_new_from_properties ("/fi/w1/wpa_supplicant1/Interfaces/0/BSSs/0", props);
+	g_assert (ap);
+	g_assert_cmpstr (nm_wifi_ap_get_address (ap), ==, "00:11:22:33:44:55");
+	g_assert_cmpint (nm_wifi_ap_get_freq (ap), ==, 2412);
+	strength = nm_wifi_ap_get_strength (ap);
+
+	/* the nl80211 scan results use the same property names. A hidden
+	 * network has no SSID there, which must not clear the known one. */
+	props_nl80211 = _bss_props_new (NULL, 2437, -40);
+	g_assert (nm_wifi_ap_update_from_properties (ap, "/fi/w1/wpa_supplicant1/Interfaces/0/BSSs/0", props_nl80211));
+	g_assert_cmpint (nm_wifi_ap_get_freq (ap), ==, 2437);
+	g_assert_cmpint (nm_wifi_ap_get_strength (ap), >, strength);
+	g_assert_cmpint (nm_wifi_ap_get_mode (ap), ==, NM_802_11_MODE_INFRA);
+
+	ssid = nm_wifi_ap_get_ssid (ap);
+	g_assert (ssid);
+	g_assert_cmpmem (g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid), "blahblah", 8);
+}
+
+static GVariant *
+_nl80211_scan_result_new (guint8 bssid_last, guint32 freq, gint32 signal_mbm, guint32 seen_ms_ago, const char *ssid)
+{
+	nm_auto_nlmsg struct nl_msg *msg = NULL;
+	struct nlattr *nest;
+	guint8 bssid[ETH_ALEN] = { 0x00, 0x11, 0x22, 0x33, 0x44, bssid_last };
+	guint8 ies[2 + 32];
+	gsize ssid_len = ssid ? strlen (ssid) : 0;
+
+	g_assert (ssid_len <= 32);
+
+	/* a message like the kernel sends for a NL80211_CMD_GET_SCAN dump. */
+	msg = nlmsg_alloc ();
+	genlmsg_put (msg, 0, 0, 0x1c, 0, NLM_F_MULTI, NL80211_CMD_NEW_SCAN_RESULTS, 0);
+	NLA_PUT_U32 (msg, NL80211_ATTR_IFINDEX, 3);
+
+	nest = nla_nest_start (msg, NL80211_ATTR_BSS);
+	g_assert (nest);
+	NLA_PUT (msg, NL80211_BSS_BSSID, ETH_ALEN, bssid);
+	NLA_PUT_U32 (msg, NL80211_BSS_FREQUENCY, freq);
+	NLA_PUT_U32 (msg, NL80211_BSS_SIGNAL_MBM, (guint32) signal_mbm);
+	NLA_PUT_U32 (msg, NL80211_BSS_SEEN_MS_AGO, seen_ms_ago);
+	NLA_PUT_U16 (msg, NL80211_BSS_CAPABILITY, 0x1 /* WLAN_CAPABILITY_ESS */);
+
+	/* the SSID element, empty for hidden networks. */
+	ies[0] = 0;
+	ies[1] = ssid_len;
+	if (ssid_len)
+		memcpy (&ies[2], ssid, ssid_len);
+	NLA_PUT (msg, NL80211_BSS_INFORMATION_ELEMENTS, 2 + ssid_len, ies);
+
+	nla_nest_end (msg, nest);
+
+	return nm_wifi_utils_nl80211_parse_scan_result (msg);
+
+nla_put_failure:
+	g_assert_not_reached ();
+	return NULL;
+}
+
+static void
+test_nl80211_parse_scan_result (void)
+{
+	nm_auto_nlmsg struct nl_msg *msg = NULL;
+	gs_unref_variant GVariant *props = NULL;
+	gs_unref_variant GVariant *props_hidden = NULL;
+	gs_unref_variant GVariant *v = NULL;
+	const guint8 *bytes;
+	gsize len;
+	guint16 freq;
+	gint16 signal;
+	guint32 age;
+	gboolean privacy;
+	const char *mode;
+
+	props = _nl80211_scan_result_new (0x55, 5180, -4500, 2500, "blahblah");
+	g_assert (props);
+
+	v = g_variant_lookup_value (props, "BSSID", G_VARIANT_TYPE_BYTESTRING);
+	g_assert (v);
+	bytes = g_variant_get_fixed_array (v, &len, 1);
+	g_assert_cmpmem (bytes, len, ((guint8 []) { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 }), ETH_ALEN);
+	nm_clear_pointer (&v, g_variant_unref);
+
+	v = g_variant_lookup_value (props, "SSID", G_VARIANT_TYPE_BYTESTRING);
+	g_assert (v);
+	bytes = g_variant_get_fixed_array (v, &len, 1);
+	g_assert_cmpmem (bytes, len, "blahblah", 8);
+
+	g_assert (g_variant_lookup (props, "Frequency", "q", &freq));
+	g_assert_cmpint (freq, ==, 5180);
+	g_assert (g_variant_lookup (props, "Signal", "n", &signal));
+	g_assert_cmpint (signal, ==, -45);
+	g_assert (g_variant_lookup (props, "Age", "u", &age));
+	g_assert_cmpint (age, ==, 2);
+	g_assert (g_variant_lookup (props, "Privacy", "b", &privacy));
+	g_assert (!privacy);
+	g_assert (g_variant_lookup (props, "Mode", "&s", &mode));
+	g_assert_cmpstr (mode, ==, "infrastructure");
+	g_assert (g_variant_lookup (props, "IEs", "@ay", NULL));
+
+	/* a hidden network reports no SSID. */
+	props_hidden = _nl80211_scan_result_new (0x55, 2412, -7000, 0, NULL);
+	g_assert (props_hidden);
+	g_assert (!g_variant_lookup (props_hidden, "SSID", "@ay", NULL));
+
+	/* a message without BSS is skipped. */
+	msg = nlmsg_alloc ();
+	genlmsg_put (msg, 0, 0, 0x1c, 0, NLM_F_MULTI, NL80211_CMD_NEW_SCAN_RESULTS, 0);
+	g_assert (!nm_wifi_utils_nl80211_parse_scan_result (msg));
+}
+
+typedef struct {
+	NMWifiAP *ap;
+	guint n_called;
+} ScanResultData;
+
+static void
+_scan_result_cb (NMWifiAP *ap, GVariant *properties, gpointer user_data)
+{
+	ScanResultData *data = user_data;
+	guint16 freq;
+
+	data->ap = ap;
+	data->n_called++;
+
+	/* called with the scan result, before the AP is updated. */
+	g_assert (g_variant_lookup (properties, "Frequency", "q", &freq));
+	g_assert_cmpint (nm_wifi_ap_get_freq (ap), !=, freq);
+}
+
+static void
+test_aps_update_from_scan_results (void)
+{
+	gs_unref_object NMWifiAP *ap1 = NULL;
+	gs_unref_object NMWifiAP *ap2 = NULL;
+	gs_unref_variant GVariant *props = NULL;
+	gs_unref_variant GVariant *props2 = NULL;
+	gs_unref_ptrarray GPtrArray *results = NULL;
+	ScanResultData data = { 0 };
+	CList aps_lst_head = C_LIST_INIT (aps_lst_head);
+	gint8 strength;
+
+	props = _bss_props_new ("blahblah", 2412, -80);
+	ap1 = nm_wifi_ap_new_from_properties ("/fi/w1/wpa_supplicant1/Interfaces/0/BSSs/0", props);
+	g_assert (ap1);
+	strength = nm_wifi_ap_get_strength (ap1);
+
+	props2 = _nl80211_scan_result_new (0x66, 2462, -6000, 0, "foobar");
+	ap2 = nm_wifi_ap_new_from_properties ("/fi/w1/wpa_supplicant1/Interfaces/0/BSSs/1", props2);
+	g_assert (ap2);
+	g_assert_cmpstr (nm_wifi_ap_get_address (ap2), ==, "00:11:22:33:44:66");
+
+	c_list_link_tail (&aps_lst_head, &ap1->aps_lst);
+	c_list_link_tail (&aps_lst_head, &ap2->aps_lst);
+
+	/* nothing to do without results. */
+	results = g_ptr_array_new_with_free_func ((GDestroyNotify) g_variant_unref);
+	g_assert_cmpint (nm_wifi_aps_update_from_scan_results (&aps_lst_head, results, 5, _scan_result_cb, &data), ==, 0);
+	g_assert_cmpint (data.n_called, ==, 0);
+
+	/* the first AP is refreshed from a hidden result. The result for the
+	 * second AP is too old, the third result belongs to no AP. */
+	g_ptr_array_add (results, _nl80211_scan_result_new (0x55, 2437, -4000, 1000, NULL));
+	g_ptr_array_add (results, _nl80211_scan_result_new (0x66, 2412, -3000, 30000, "foobar"));
+	g_ptr_array_add (results, _nl80211_scan_result_new (0x77, 2412, -3000, 0, "other"));
+
+	g_assert_cmpint (nm_wifi_aps_update_from_scan_results (&aps_lst_head, results, 5, _scan_result_cb, &data), ==, 1);
+	g_assert_cmpint (data.n_called, ==, 1);
+	g_assert (data.ap == ap1);
+
+	g_assert_cmpint (nm_wifi_ap_get_freq (ap1), ==, 2437);
+	g_assert_cmpint (nm_wifi_ap_get_strength (ap1), >, strength);
+	g_assert (nm_wifi_ap_get_ssid (ap1));
+	g_assert_cmpint (nm_wifi_ap_get_freq (ap2), ==, 2462);
+
+	c_list_unlink (&ap1->aps_lst);
+	c_list_unlink (&ap2->aps_lst);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GMainLoop *loop;
+	gint64 changed_at;
+	guint n_changed;
+	bool recheck:1;
+} APsChangedData;
+
+static void
+_aps_changed_cb (gboolean recheck_available_connections, gpointer user_data)
+{
+	APsChangedData *data = user_data;
+
+	data->n_changed++;
+	data->recheck = recheck_available_connections;
+	data->changed_at = g_get_monotonic_time () / 1000;
+	if (data->loop)
+		g_main_loop_quit (data->loop);
+}
+
+static void
+test_aps_idx_flush_on_scan_done (void)
+{
+	APsChangedData data = { 0 };
+	NMWifiAPsIdx idx;
+
+	data.loop = g_main_loop_new (NULL, FALSE);
+	nm_wifi_aps_idx_init (&idx, _aps_changed_cb, &data);
+
+	/* flushing without changes does nothing. */
+	nm_wifi_aps_idx_changed_flush (&idx);
+	g_assert_cmpint (data.n_changed, ==, 0);
+
+	/* a batch of scan results is announced only once, and the recheck
+	 * is requested if any change needed it. */
+	nm_wifi_aps_idx_changed_schedule (&idx, FALSE);
+	nm_wifi_aps_idx_changed_schedule (&idx, TRUE);
+	nm_wifi_aps_idx_changed_schedule (&idx, FALSE);
+	g_assert_cmpint (data.n_changed, ==, 0);
+
+	/* scan-done flushes right away... */
+	nm_wifi_aps_idx_changed_flush (&idx);
+	g_assert_cmpint (data.n_changed, ==, 1);
+	g_assert (data.recheck);
+	g_assert_cmpint (idx.changed_id, ==, 0);
+
+	/* ... and there is nothing left for the timeout. */
+	nm_wifi_aps_idx_changed_flush (&idx);
+	g_assert (!nmtst_main_loop_run (data.loop, NM_WIFI_APS_CHANGED_COALESCE_MSEC + 200));
+	g_assert_cmpint (data.n_changed, ==, 1);
+
+	/* the next batch starts over. */
+	nm_wifi_aps_idx_changed_schedule (&idx, FALSE);
+	nm_wifi_aps_idx_changed_flush (&idx);
+	g_assert_cmpint (data.n_changed, ==, 2);
+	g_assert (!data.recheck);
+
+	nm_wifi_aps_idx_clear (&idx);
+	g_main_loop_unref (data.loop);
+}
+
+static void
+test_aps_idx_flush_timeout (void)
+{
+	APsChangedData data = { 0 };
+	NMWifiAPsIdx idx;
+	gint64 scheduled_at;
+
+	data.loop = g_main_loop_new (NULL, FALSE);
+	nm_wifi_aps_idx_init (&idx, _aps_changed_cb, &data);
+
+	/* without scan-done, the changes are announced after the coalescing
+	 * window. Further changes don't postpone it. */
+	scheduled_at = g_get_monotonic_time () / 1000;
+	nm_wifi_aps_idx_changed_schedule (&idx, TRUE);
+	g_assert (!nmtst_main_loop_run (data.loop, NM_WIFI_APS_CHANGED_COALESCE_MSEC / 2));
+	g_assert_cmpint (data.n_changed, ==, 0);
+	nm_wifi_aps_idx_changed_schedule (&idx, FALSE);
+
+	g_assert (nmtst_main_loop_run (data.loop, NM_WIFI_APS_CHANGED_COALESCE_MSEC + 1000));
+	g_assert_cmpint (data.n_changed, ==, 1);
+	g_assert (data.recheck);
+	g_assert_cmpint (data.changed_at - scheduled_at, >=, NM_WIFI_APS_CHANGED_COALESCE_MSEC - 1);
+	g_assert_cmpint (data.changed_at - scheduled_at, <, NM_WIFI_APS_CHANGED_COALESCE_MSEC + 1000);
+	g_assert_cmpint (idx.changed_id, ==, 0);
+
+	/* a later flush finds nothing pending. */
+	nm_wifi_aps_idx_changed_flush (&idx);
+	g_assert_cmpint (data.n_changed, ==, 1);
+
+	/* clearing the index drops a pending notification. */
+	nm_wifi_aps_idx_changed_schedule (&idx, FALSE);
+	nm_wifi_aps_idx_clear (&idx);
+	g_assert (!nmtst_main_loop_run (data.loop, NM_WIFI_APS_CHANGED_COALESCE_MSEC + 200));
+	g_assert_cmpint (data.n_changed, ==, 1);
+
+	g_main_loop_unref (data.loop);
+}
+
+static void
+test_aps_idx_remove (void)
+{
+	gs_unref_variant GVariant *props = NULL;
+	APsChangedData data = { 0 };
+	NMWifiAP *aps[4];
+	NMWifiAPsIdx idx;
+	guint i;
+
+	nm_wifi_aps_idx_init (&idx, _aps_changed_cb, &data);
+
+	props = _bss_props_new ("blahblah", 2412, -80);
+	aps[0] = nm_wifi_ap_new_from_properties ("/fi/w1/wpa_supplicant1/Interfaces/0/BSSs/0", props);
+	aps[1] = nm_wifi_ap_new_from_properties ("/fi/w1/wpa_supplicant1/Interfaces/0/BSSs/1", props);
+	aps[2] = nm_wifi_ap_new_from_properties ("/fi/w1/wpa_supplicant1/Interfaces/0/BSSs/2", props);
+	/* the supplicant reuses the path of a vanished BSS. */
+	aps[3] = nm_wifi_ap_new_from_properties ("/fi/w1/wpa_supplicant1/Interfaces/0/BSSs/0", props);
+
+	for (i = 0; i < 3; i++)
+		nm_wifi_aps_idx_add (&idx, aps[i]);
+	for (i = 0; i < 3; i++)
+		g_assert (nm_wifi_aps_idx_lookup (&idx, nm_wifi_ap_get_supplicant_path (aps[i])) == aps[i]);
+	g_assert (!nm_wifi_aps_idx_lookup (&idx, "/fi/w1/wpa_supplicant1/Interfaces/0/BSSs/3"));
+
+	/* removing an AP in the middle keeps the others indexed. */
+	nm_wifi_aps_idx_remove (&idx, aps[1]);
+	g_assert (!nm_wifi_aps_idx_lookup (&idx, "/fi/w1/wpa_supplicant1/Interfaces/0/BSSs/1"));
+	g_assert (nm_wifi_aps_idx_lookup (&idx, "/fi/w1/wpa_supplicant1/Interfaces/0/BSSs/0") == aps[0]);
+	g_assert (nm_wifi_aps_idx_lookup (&idx, "/fi/w1/wpa_supplicant1/Interfaces/0/BSSs/2") == aps[2]);
+	g_assert_cmpint (g_hash_table_size (idx.by_supplicant_path), ==, 2);
+
+	/* removing it twice is harmless. */
+	nm_wifi_aps_idx_remove (&idx, aps[1]);
+	g_assert_cmpint (g_hash_table_size (idx.by_supplicant_path), ==, 2);
+
+	/* a new AP with the same path replaces the old one. Removing the
+	 * old AP afterwards must not drop the new one. */
+	nm_wifi_aps_idx_add (&idx, aps[3]);
+	g_assert (nm_wifi_aps_idx_lookup (&idx, "/fi/w1/wpa_supplicant1/Interfaces/0/BSSs/0") == aps[3]);
+	nm_wifi_aps_idx_remove (&idx, aps[0]);
+	g_assert (nm_wifi_aps_idx_lookup (&idx, "/fi/w1/wpa_supplicant1/Interfaces/0/BSSs/0") == aps[3]);
+
+	nm_wifi_aps_idx_remove (&idx, aps[3]);
+	nm_wifi_aps_idx_remove (&idx, aps[2]);
+	g_assert_cmpint (g_hash_table_size (idx.by_supplicant_path), ==, 0);
+
+	/* the index never notifies by itself. */
+	g_assert_cmpint (data.n_changed, ==, 0);
+
+	nm_wifi_aps_idx_clear (&idx);
+	for (i = 0; i < G_N_ELEMENTS (aps); i++)
+		g_object_unref (aps[i]);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -1514,5 +1884,18 @@ main (int argc, char **argv)
 	g_test_add_func ("/wifi/strength/all",
 	                 test_strength_all);
 
+	g_test_add_func ("/wifi/nl80211/parse-scan-result",
+	                 test_nl80211_parse_scan_result);
+	g_test_add_func ("/wifi/ap/update-from-scan-results",
+	                 test_aps_update_from_scan_results);
+	g_test_add_func ("/wifi/ap/update-from-nl80211",
+	                 test_ap_update_from_nl80211);
+	g_test_add_func ("/wifi/aps-idx/flush-on-scan-done",
+	                 test_aps_idx_flush_on_scan_done);
+	g_test_add_func ("/wifi/aps-idx/flush-timeout",
+	                 test_aps_idx_flush_timeout);
+	g_test_add_func ("/wifi/aps-idx/remove",
+	                 test_aps_idx_remove);
+
 	return g_test_run ();
 }
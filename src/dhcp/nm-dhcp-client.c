@@ -68,6 +68,7 @@ typedef struct _NMDhcpClientPrivate {
 	char *       uuid;
 	GBytes *     client_id;
 	char *       hostname;
+	NMDhcpLeaseDb *lease_db;
 	pid_t        pid;
 	guint        timeout_id;
 	guint        watch_id;
@@ -135,6 +136,31 @@ nm_dhcp_client_get_uuid (NMDhcpClient *self)
 	return NM_DHCP_CLIENT_GET_PRIVATE (self)->uuid;
 }
 
+NMDhcpLeaseDb *
+nm_dhcp_client_get_lease_db (NMDhcpClient *self)
+{
+	g_return_val_if_fail (NM_IS_DHCP_CLIENT (self), NULL);
+
+	return NM_DHCP_CLIENT_GET_PRIVATE (self)->lease_db;
+}
+
+void
+nm_dhcp_client_set_lease_db (NMDhcpClient *self, NMDhcpLeaseDb *lease_db)
+{
+	NMDhcpClientPrivate *priv;
+
+	g_return_if_fail (NM_IS_DHCP_CLIENT (self));
+
+	priv = NM_DHCP_CLIENT_GET_PRIVATE (self);
+	if (priv->lease_db == lease_db)
+		return;
+	if (lease_db)
+		nm_dhcp_lease_db_ref (lease_db);
+	if (priv->lease_db)
+		nm_dhcp_lease_db_unref (priv->lease_db);
+	priv->lease_db = lease_db;
+}
+
 GBytes *
 nm_dhcp_client_get_hw_addr (NMDhcpClient *self)
 {
@@ -475,7 +501,10 @@ nm_dhcp_client_start_timeout (NMDhcpClient *self)
 {
 	NMDhcpClientPrivate *priv = NM_DHCP_CLIENT_GET_PRIVATE (self);
 
-	g_return_if_fail (priv->timeout_id == 0);
+	/* the timeout may already be armed, if NMDhcpManager queued the start
+	 * of the client. The time spent in the queue counts against it. */
+	if (priv->timeout_id)
+		return;
 
 	/* Set up a timeout on the transaction to kill it after the timeout */
 
@@ -966,6 +995,7 @@ dispose (GObject *object)
 	g_clear_pointer (&priv->uuid, g_free);
 	g_clear_pointer (&priv->client_id, g_bytes_unref);
 	g_clear_pointer (&priv->hwaddr, g_bytes_unref);
+	nm_clear_pointer (&priv->lease_db, nm_dhcp_lease_db_unref);
 
 	G_OBJECT_CLASS (nm_dhcp_client_parent_class)->dispose (object);
 
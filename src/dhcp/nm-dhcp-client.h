@@ -23,6 +23,7 @@
 #include "nm-ip4-config.h"
 #include "nm-ip6-config.h"
 #include "nm-dhcp-utils.h"
+#include "nm-dhcp-lease-db.h"
 
 #define NM_DHCP_TIMEOUT_DEFAULT ((guint32) 45) /* default DHCP timeout, in seconds */
 #define NM_DHCP_TIMEOUT_INFINITY G_MAXINT32
@@ -122,6 +123,10 @@ GBytes *nm_dhcp_client_get_duid (NMDhcpClient *self);
 
 GBytes *nm_dhcp_client_get_hw_addr (NMDhcpClient *self);
 
+NMDhcpLeaseDb *nm_dhcp_client_get_lease_db (NMDhcpClient *self);
+
+void nm_dhcp_client_set_lease_db (NMDhcpClient *self, NMDhcpLeaseDb *lease_db);
+
 guint32 nm_dhcp_client_get_route_table (NMDhcpClient *self);
 
 void nm_dhcp_client_set_route_table (NMDhcpClient *self, guint32 route_table);
@@ -199,5 +204,8 @@ extern const NMDhcpClientFactory _nm_dhcp_client_factory_dhcpcanon;
 extern const NMDhcpClientFactory _nm_dhcp_client_factory_dhclient;
 extern const NMDhcpClientFactory _nm_dhcp_client_factory_dhcpcd;
 extern const NMDhcpClientFactory _nm_dhcp_client_factory_internal;
+extern const NMDhcpClientFactory _nm_dhcp_client_factory_nettools;
+
+void nm_dhcp_nettools_set_shared_socket (gboolean enabled);
 
 #endif /* __NETWORKMANAGER_DHCP_CLIENT_H__ */
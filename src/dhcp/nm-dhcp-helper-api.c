@@ -0,0 +1,175 @@
+/* NetworkManager -- Network link manager
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2019 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-dhcp-helper-api.h"
+
+/* This file is compiled both into nm-dhcp-helper and into the daemon.
+ * It must only depend on glib. */
+
+/*****************************************************************************/
+
+typedef struct _nm_packed {
+	guint16 key_len;
+	guint16 value_len;
+} MsgEntry;
+
+/*****************************************************************************/
+
+void
+nm_dhcp_helper_msg_init (GByteArray *msg, NMDhcpHelperMsgType type)
+{
+	NMDhcpHelperMsgHeader header = {
+		.magic     = NM_DHCP_HELPER_MSG_MAGIC,
+		.version   = NM_DHCP_HELPER_MSG_VERSION,
+		.type      = type,
+		.n_entries = 0,
+	};
+
+	g_byte_array_set_size (msg, 0);
+	g_byte_array_append (msg, (const guint8 *) &header, sizeof (header));
+}
+
+gboolean
+nm_dhcp_helper_msg_append (GByteArray *msg,
+                           const char *key,
+                           gsize key_len,
+                           const char *value,
+                           gsize value_len)
+{
+	NMDhcpHelperMsgHeader header;
+	MsgEntry entry;
+
+	nm_assert (msg);
+	nm_assert (msg->len >= sizeof (header));
+	nm_assert (key && key_len > 0);
+	nm_assert (value || value_len == 0);
+
+	if (   key_len > G_MAXUINT16
+	    || value_len > G_MAXUINT16
+	    || msg->len + sizeof (entry) + key_len + value_len > NM_DHCP_HELPER_MSG_SIZE_MAX)
+		return FALSE;
+
+	memcpy (&header, msg->data, sizeof (header));
+	if (header.n_entries == G_MAXUINT16)
+		return FALSE;
+	header.n_entries++;
+	memcpy (msg->data, &header, sizeof (header));
+
+	entry.key_len = key_len;
+	entry.value_len = value_len;
+	g_byte_array_append (msg, (const guint8 *) &entry, sizeof (entry));
+	g_byte_array_append (msg, (const guint8 *) key, key_len);
+	if (value_len > 0)
+		g_byte_array_append (msg, (const guint8 *) value, value_len);
+	return TRUE;
+}
+
+gboolean
+nm_dhcp_helper_msg_parse_header (gconstpointer data,
+                                 gsize len,
+                                 NMDhcpHelperMsgType *out_type)
+{
+	NMDhcpHelperMsgHeader header;
+
+	if (len < sizeof (header))
+		return FALSE;
+
+	memcpy (&header, data, sizeof (header));
+	if (   header.magic != NM_DHCP_HELPER_MSG_MAGIC
+	    || header.version != NM_DHCP_HELPER_MSG_VERSION)
+		return FALSE;
+
+	if (!NM_IN_SET (header.type, NM_DHCP_HELPER_MSG_TYPE_EVENT,
+	                             NM_DHCP_HELPER_MSG_TYPE_ACK))
+		return FALSE;
+
+	NM_SET_OUT (out_type, header.type);
+	return TRUE;
+}
+
+/**
+ * nm_dhcp_helper_msg_parse_event:
+ * @data: the received datagram
+ * @len: the length of @data
+ *
+ * Returns: (transfer full): the options of the event as "a{sv}" dictionary
+ *   with "ay" values, like the helper sends them via D-Bus. %NULL if @data
+ *   is not a valid event message.
+ */
+GVariant *
+nm_dhcp_helper_msg_parse_event (gconstpointer data, gsize len)
+{
+	NMDhcpHelperMsgHeader header;
+	GVariantBuilder builder;
+	const guint8 *p;
+	const guint8 *end;
+	guint i;
+
+	if (!nm_dhcp_helper_msg_parse_header (data, len, NULL))
+		return NULL;
+
+	memcpy (&header, data, sizeof (header));
+	if (header.type != NM_DHCP_HELPER_MSG_TYPE_EVENT)
+		return NULL;
+
+	p = &((const guint8 *) data)[sizeof (header)];
+	end = &((const guint8 *) data)[len];
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+	for (i = 0; i < header.n_entries; i++) {
+		gs_free char *key = NULL;
+		MsgEntry entry;
+
+		if ((gsize) (end - p) < sizeof (entry))
+			goto fail;
+		memcpy (&entry, p, sizeof (entry));
+		p += sizeof (entry);
+
+		if (   entry.key_len == 0
+		    || (gsize) (end - p) < (gsize) entry.key_len + entry.value_len)
+			goto fail;
+
+		/* keys end up as D-Bus strings, they must be valid UTF-8 without NUL. */
+		if (   memchr (p, '\0', entry.key_len)
+		    || !g_utf8_validate ((const char *) p, entry.key_len, NULL))
+			goto fail;
+
+		key = g_strndup ((const char *) p, entry.key_len);
+		p += entry.key_len;
+
+		g_variant_builder_add (&builder, "{sv}",
+		                       key,
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+		                                                  p, entry.value_len, 1));
+		p += entry.value_len;
+	}
+
+	if (p != end)
+		goto fail;
+
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+
+fail:
+	g_variant_builder_clear (&builder);
+	return NULL;
+}
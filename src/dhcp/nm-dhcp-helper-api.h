@@ -32,4 +32,49 @@
 
 /*****************************************************************************/
 
+/* Besides the D-Bus "Notify" call on the private D-Bus socket, the helper
+ * can deliver its event over a SOCK_SEQPACKET socket. Each event is a single
+ * datagram: a NMDhcpHelperMsgHeader followed by @n_entries entries of
+ *
+ *   guint16 key_len, guint16 value_len, key bytes, value bytes
+ *
+ * The socket is local to the host, so all integers are in host byte order.
+ * The daemon answers every event with a header-only message of type
+ * NM_DHCP_HELPER_MSG_TYPE_ACK once it handled it. If anything goes wrong,
+ * the helper falls back to D-Bus. */
+
+#define NM_DHCP_HELPER_SEQPACKET_PATH           NMRUNDIR "/private-dhcp-seqpacket"
+
+#define NM_DHCP_HELPER_MSG_MAGIC                ((guint32) 0x4e4d4448u) /* "NMDH" */
+#define NM_DHCP_HELPER_MSG_VERSION              1
+#define NM_DHCP_HELPER_MSG_SIZE_MAX             ((gsize) (64u * 1024u))
+
+typedef enum {
+	NM_DHCP_HELPER_MSG_TYPE_EVENT           = 1,
+	NM_DHCP_HELPER_MSG_TYPE_ACK             = 2,
+} NMDhcpHelperMsgType;
+
+typedef struct _nm_packed {
+	guint32 magic;
+	guint8 version;
+	guint8 type;
+	guint16 n_entries;
+} NMDhcpHelperMsgHeader;
+
+void nm_dhcp_helper_msg_init (GByteArray *msg, NMDhcpHelperMsgType type);
+
+gboolean nm_dhcp_helper_msg_append (GByteArray *msg,
+                                    const char *key,
+                                    gsize key_len,
+                                    const char *value,
+                                    gsize value_len);
+
+gboolean nm_dhcp_helper_msg_parse_header (gconstpointer data,
+                                          gsize len,
+                                          NMDhcpHelperMsgType *out_type);
+
+GVariant *nm_dhcp_helper_msg_parse_event (gconstpointer data, gsize len);
+
+/*****************************************************************************/
+
 #endif /* __NM_DHCP_HELPER_API_H__ */
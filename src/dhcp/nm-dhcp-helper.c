@@ -22,6 +22,8 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include "nm-utils/nm-vpn-plugin-macros.h"
 
@@ -62,6 +64,30 @@
 
 static const char * ignore[] = {"PATH", "SHLVL", "_", "PWD", "dhc_dbus", NULL};
 
+static gboolean
+env_item_split (const char *item,
+                gsize *out_name_len,
+                const char **out_val)
+{
+	const char *val;
+	const char **p;
+
+	/* Split on the = */
+	val = strchr (item, '=');
+	if (!val || val == item)
+		return FALSE;
+
+	/* Ignore non-DCHP-related environment variables */
+	for (p = ignore; *p; p++) {
+		if (strncmp (item, *p, strlen (*p)) == 0)
+			return FALSE;
+	}
+
+	*out_name_len = val - item;
+	*out_val = &val[1];
+	return TRUE;
+}
+
 static GVariant *
 build_signal_parameters (void)
 {
@@ -72,20 +98,14 @@ build_signal_parameters (void)
 
 	/* List environment and format for dbus dict */
 	for (item = environ; *item; item++) {
-		char *name, *val, **p;
-
-		/* Split on the = */
-		name = g_strdup (*item);
-		val = strchr (name, '=');
-		if (!val || val == name)
-			goto next;
-		*val++ = '\0';
-
-		/* Ignore non-DCHP-related environment variables */
-		for (p = (char **) ignore; *p; p++) {
-			if (strncmp (name, *p, strlen (*p)) == 0)
-				goto next;
-		}
+		gs_free char *name = NULL;
+		const char *val;
+		gsize name_len;
+
+		if (!env_item_split (*item, &name_len, &val))
+			continue;
+
+		name = g_strndup (*item, name_len);
 
 		/* Value passed as a byte array rather than a string, because there are
 		 * no character encoding guarantees with DHCP, and D-Bus requires
@@ -98,14 +118,86 @@ build_signal_parameters (void)
 		                       name,
 		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
 		                                                  val, strlen (val), 1));
-
-	next:
-		g_free (name);
 	}
 
 	return g_variant_ref_sink (g_variant_new ("(a{sv})", &builder));
 }
 
+static gboolean
+notify_seqpacket (void)
+{
+	struct sockaddr_un addr = {
+		.sun_family = AF_UNIX,
+		.sun_path   = NM_DHCP_HELPER_SEQPACKET_PATH,
+	};
+	const struct timeval timeout = {
+		.tv_sec = 1,
+	};
+	nm_auto_unref_bytearray GByteArray *msg = NULL;
+	NMDhcpHelperMsgHeader ack;
+	NMDhcpHelperMsgType type;
+	nm_auto_close int fd = -1;
+	char **item;
+	ssize_t n;
+
+	msg = g_byte_array_sized_new (4096);
+	nm_dhcp_helper_msg_init (msg, NM_DHCP_HELPER_MSG_TYPE_EVENT);
+
+	for (item = environ; *item; item++) {
+		const char *val;
+		gsize name_len;
+
+		if (!env_item_split (*item, &name_len, &val))
+			continue;
+
+		if (!nm_dhcp_helper_msg_append (msg, *item, name_len, val, strlen (val))) {
+			_LOGi ("event too large for seqpacket socket (try D-Bus)");
+			return FALSE;
+		}
+	}
+
+	fd = socket (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		_LOGi ("could not create seqpacket socket: %s (try D-Bus)", g_strerror (errno));
+		return FALSE;
+	}
+
+	/* the daemon handles the event synchronously. Don't wait longer than
+	 * the D-Bus call would. */
+	if (   setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout)) != 0
+	    || setsockopt (fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof (timeout)) != 0) {
+		_LOGi ("could not set seqpacket socket timeout: %s (try D-Bus)", g_strerror (errno));
+		return FALSE;
+	}
+
+	if (connect (fd, (struct sockaddr *) &addr, sizeof (addr)) != 0) {
+		/* an older daemon doesn't provide the socket. That is expected. */
+		_LOGi ("could not connect to seqpacket socket: %s (try D-Bus)", g_strerror (errno));
+		return FALSE;
+	}
+
+	n = send (fd, msg->data, msg->len, MSG_NOSIGNAL);
+	if (n != (ssize_t) msg->len) {
+		_LOGi ("could not send event via seqpacket socket: %s (try D-Bus)",
+		       n < 0 ? g_strerror (errno) : "short write");
+		return FALSE;
+	}
+
+	/* From here on the event was delivered and the daemon will handle it.
+	 * Falling back to D-Bus now would let it handle the event twice, so
+	 * a missing acknowledgement is only logged, just like we consider the
+	 * asynchronous "Event" signal a success. */
+	n = recv (fd, &ack, sizeof (ack), 0);
+	if (   n != sizeof (ack)
+	    || !nm_dhcp_helper_msg_parse_header (&ack, n, &type)
+	    || type != NM_DHCP_HELPER_MSG_TYPE_ACK) {
+		_LOGw ("no acknowledgement on seqpacket socket: %s",
+		       n < 0 ? g_strerror (errno) : "invalid reply");
+	}
+
+	return TRUE;
+}
+
 static void
 kill_pid (void)
 {
@@ -132,6 +224,11 @@ main (int argc, char *argv[])
 	guint try_count = 0;
 	gint64 time_end;
 
+	/* Prefer the lightweight seqpacket socket. It spares us the D-Bus
+	 * authentication handshake and the GVariant marshalling. */
+	if (notify_seqpacket ())
+		return EXIT_SUCCESS;
+
 	/* FIXME: g_dbus_connection_new_for_address_sync() tries to connect to the socket in
 	 * non-blocking mode, which can easily fail with EAGAIN, causing the creation of the
 	 * socket to fail with "Could not connect: Resource temporarily unavailable".
@@ -0,0 +1,652 @@
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2019 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-dhcp-lease-db.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+
+#include "c-siphash/src/c-siphash.h"
+#include "nm-glib-aux/nm-io-utils.h"
+
+/* The lease database replaces the per-interface lease files of the internal
+ * DHCP client with a single file, that is mapped into memory. The file is a
+ * header followed by an array of fixed-size records. Every record has its own
+ * checksum, so that a torn write only ever loses the record being written.
+ *
+ * A record is never updated in place. The new version is written to a free
+ * slot with a higher sequence number and synced to disk, and only then the
+ * old slot is cleared. If both survive a crash or a power loss, the one with
+ * the higher sequence number wins. */
+
+#define LEASE_DB_MAGIC           0x444c4d4e /* "NMLD" */
+#define LEASE_DB_VERSION         1
+#define LEASE_DB_INITIAL_RECORDS 64
+
+typedef struct {
+	guint64 checksum;
+	guint32 magic;
+	guint32 version;
+	guint32 record_size;
+	guint32 n_records;
+	guint8 _reserved[40];
+} LeaseDbHeader;
+
+G_STATIC_ASSERT (sizeof (LeaseDbHeader) == 64);
+
+typedef struct {
+	guint64 checksum;
+
+	/* 0 marks a free slot. */
+	guint64 seqnum;
+
+	/* CLOCK_REALTIME, in seconds. */
+	gint64 timestamp;
+
+	guint8 addr_family;
+	guint8 _pad[7];
+	guint8 address[16];
+
+	/* NUL terminated. */
+	char iface[IFNAMSIZ];
+	char uuid[48];
+
+	guint8 _reserved[16];
+} LeaseDbRecord;
+
+G_STATIC_ASSERT (sizeof (LeaseDbRecord) == 128);
+
+struct _NMDhcpLeaseDb {
+	int ref_count;
+	int fd;
+	char *path;
+	guint8 *map;
+	gsize map_size;
+	guint32 n_records;
+	guint64 seqnum;
+
+	/* "family/iface/uuid" -> slot index + 1 */
+	GHashTable *index;
+
+	/* guint32 slot indexes, used as stack. */
+	GArray *free_slots;
+
+	bool is_new:1;
+};
+
+/*****************************************************************************/
+
+#define _NMLOG_DOMAIN      LOGD_DHCP
+#define _NMLOG(level, ...) __NMLOG_DEFAULT (level, _NMLOG_DOMAIN, "dhcp-lease-db", __VA_ARGS__)
+
+/*****************************************************************************/
+
+/* the checksums only need to detect corruption, the key is fixed so that
+ * they are stable across restarts. */
+static const guint8 checksum_seed[16] = {
+	0x6e, 0x6d, 0x2d, 0x64, 0x68, 0x63, 0x70, 0x2d,
+	0x6c, 0x65, 0x61, 0x73, 0x65, 0x2d, 0x64, 0x62,
+};
+
+static guint64
+_checksum (gconstpointer data, gsize len)
+{
+	/* the checksum is always the first field, and not part of itself. */
+	return c_siphash_hash (checksum_seed,
+	                       &((const guint8 *) data)[sizeof (guint64)],
+	                       len - sizeof (guint64));
+}
+
+static LeaseDbHeader *
+_header (NMDhcpLeaseDb *db)
+{
+	return (LeaseDbHeader *) db->map;
+}
+
+static LeaseDbRecord *
+_record (NMDhcpLeaseDb *db, guint32 slot)
+{
+	nm_assert (slot < db->n_records);
+
+	return (LeaseDbRecord *) &db->map[sizeof (LeaseDbHeader) + (gsize) slot * sizeof (LeaseDbRecord)];
+}
+
+static gsize
+_file_size (guint32 n_records)
+{
+	return sizeof (LeaseDbHeader) + (gsize) n_records * sizeof (LeaseDbRecord);
+}
+
+static char *
+_key (int addr_family, const char *iface, const char *uuid)
+{
+	return g_strdup_printf ("%d/%s/%s", addr_family, iface, uuid);
+}
+
+static gboolean
+_record_is_valid (const LeaseDbRecord *record)
+{
+	return    record->seqnum != 0
+	       && NM_IN_SET (record->addr_family, AF_INET, AF_INET6)
+	       && memchr (record->iface, '\0', sizeof (record->iface))
+	       && memchr (record->uuid, '\0', sizeof (record->uuid))
+	       && record->checksum == _checksum (record, sizeof (*record));
+}
+
+/* write the pages of [@ptr, @ptr + @len) back to the file and wait for it. */
+static void
+_sync (NMDhcpLeaseDb *db, gconstpointer ptr, gsize len)
+{
+	const gsize page_mask = ((gsize) nm_utils_getpagesize ()) - 1;
+	gsize start = (const guint8 *) ptr - db->map;
+	gsize end = start + len;
+
+	nm_assert (end <= db->map_size);
+
+	start &= ~page_mask;
+	if (msync (&db->map[start], end - start, MS_SYNC) < 0)
+		_LOGW ("failed to sync lease database: %s", nm_strerror_native (errno));
+}
+
+static void
+_record_clear (NMDhcpLeaseDb *db, guint32 slot)
+{
+	memset (_record (db, slot), 0, sizeof (LeaseDbRecord));
+	g_array_append_val (db->free_slots, slot);
+}
+
+static void
+_header_update (NMDhcpLeaseDb *db)
+{
+	LeaseDbHeader *header = _header (db);
+
+	header->magic = LEASE_DB_MAGIC;
+	header->version = LEASE_DB_VERSION;
+	header->record_size = sizeof (LeaseDbRecord);
+	header->n_records = db->n_records;
+	header->checksum = _checksum (header, sizeof (*header));
+	_sync (db, header, sizeof (*header));
+}
+
+static gboolean
+_header_is_valid (const LeaseDbHeader *header, gsize file_size)
+{
+	return    header->magic == LEASE_DB_MAGIC
+	       && header->version == LEASE_DB_VERSION
+	       && header->record_size == sizeof (LeaseDbRecord)
+	       && header->n_records > 0
+	       && file_size >= _file_size (header->n_records)
+	       && header->checksum == _checksum (header, sizeof (*header));
+}
+
+static gboolean
+_map (NMDhcpLeaseDb *db, gsize size, GError **error)
+{
+	gpointer map;
+
+	if (db->map)
+		map = mremap (db->map, db->map_size, size, MREMAP_MAYMOVE);
+	else
+		map = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, db->fd, 0);
+	if (map == MAP_FAILED) {
+		nm_utils_error_set_errno (error, errno, "failed to map lease database: %s");
+		return FALSE;
+	}
+
+	db->map = map;
+	db->map_size = size;
+	return TRUE;
+}
+
+static gboolean
+_resize (NMDhcpLeaseDb *db, guint32 n_records, GError **error)
+{
+	guint32 i;
+
+	nm_assert (n_records > db->n_records);
+
+	if (ftruncate (db->fd, _file_size (n_records)) < 0) {
+		nm_utils_error_set_errno (error, errno, "failed to resize lease database: %s");
+		return FALSE;
+	}
+
+	if (!_map (db, _file_size (n_records), error))
+		return FALSE;
+
+	/* the new slots are zero, hence free. Push them in reverse order,
+	 * so that they are used from the front. */
+	for (i = n_records; i > db->n_records; i--) {
+		guint32 slot = i - 1;
+
+		g_array_append_val (db->free_slots, slot);
+	}
+	db->n_records = n_records;
+
+	/* if we crash before this, the file is just larger than needed. */
+	_header_update (db);
+	return TRUE;
+}
+
+static void
+_load (NMDhcpLeaseDb *db)
+{
+	gboolean changed = FALSE;
+	guint32 slot;
+
+	for (slot = db->n_records; slot > 0; slot--) {
+		LeaseDbRecord *record = _record (db, slot - 1);
+		gs_free char *key = NULL;
+		gpointer other_ptr;
+		guint32 other;
+
+		if (!_record_is_valid (record)) {
+			if (record->seqnum != 0) {
+				_LOGD ("drop corrupt record #%u", slot - 1);
+				changed = TRUE;
+			}
+			_record_clear (db, slot - 1);
+			continue;
+		}
+
+		db->seqnum = MAX (db->seqnum, record->seqnum);
+
+		key = _key (record->addr_family, record->iface, record->uuid);
+		other_ptr = g_hash_table_lookup (db->index, key);
+		if (other_ptr) {
+			/* an update was interrupted after writing the new record. */
+			other = GPOINTER_TO_UINT (other_ptr) - 1;
+			changed = TRUE;
+			if (_record (db, other)->seqnum > record->seqnum) {
+				_record_clear (db, slot - 1);
+				continue;
+			}
+			_record_clear (db, other);
+		}
+
+		g_hash_table_insert (db->index, g_steal_pointer (&key), GUINT_TO_POINTER (slot));
+	}
+
+	if (changed)
+		_sync (db, _record (db, 0), (gsize) db->n_records * sizeof (LeaseDbRecord));
+}
+
+/*****************************************************************************/
+
+/**
+ * nm_dhcp_lease_db_open:
+ * @path: the file of the database
+ * @error: return location for a #GError, or %NULL
+ *
+ * Opens the database at @path, or creates a new one. If the header of an
+ * existing file is damaged, the valid records are kept and a new header
+ * is written. A file without any valid record is replaced by an empty
+ * database.
+ *
+ * Returns: (transfer full): the database, or %NULL on error.
+ */
+NMDhcpLeaseDb *
+nm_dhcp_lease_db_open (const char *path, GError **error)
+{
+	nm_auto_unref_dhcp_lease_db NMDhcpLeaseDb *db = NULL;
+	struct stat st;
+
+	g_return_val_if_fail (path, NULL);
+	g_return_val_if_fail (!error || !*error, NULL);
+
+	db = g_slice_new0 (NMDhcpLeaseDb);
+	db->ref_count = 1;
+	db->fd = -1;
+	db->path = g_strdup (path);
+	db->index = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, NULL);
+	db->free_slots = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+	db->fd = open (path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (db->fd < 0) {
+		nm_utils_error_set_errno (error, errno, "failed to open lease database: %s");
+		return NULL;
+	}
+
+	if (fstat (db->fd, &st) < 0) {
+		nm_utils_error_set_errno (error, errno, "failed to stat lease database: %s");
+		return NULL;
+	}
+
+	if ((gsize) st.st_size >= sizeof (LeaseDbHeader)) {
+		if (!_map (db, st.st_size, error))
+			return NULL;
+
+		if (_header_is_valid (_header (db), st.st_size)) {
+			db->n_records = _header (db)->n_records;
+			_load (db);
+			_LOGD ("opened %s with %u leases", path, g_hash_table_size (db->index));
+			return g_steal_pointer (&db);
+		}
+
+		/* every record has its own checksum, so a damaged header doesn't
+		 * lose them. Assume the current layout and keep what is valid. */
+		db->n_records = MIN ((st.st_size - sizeof (LeaseDbHeader)) / sizeof (LeaseDbRecord),
+		                     (gsize) G_MAXUINT32);
+		if (db->n_records > 0) {
+			_load (db);
+			if (g_hash_table_size (db->index) > 0) {
+				_LOGW ("%s has an invalid header, recovered %u leases",
+				       path, g_hash_table_size (db->index));
+				_header_update (db);
+				return g_steal_pointer (&db);
+			}
+			db->n_records = 0;
+			db->seqnum = 0;
+			g_array_set_size (db->free_slots, 0);
+		}
+
+		_LOGW ("%s is not a valid lease database, replace it", path);
+		munmap (db->map, db->map_size);
+		db->map = NULL;
+		db->map_size = 0;
+	}
+
+	/* start from scratch. */
+	if (ftruncate (db->fd, 0) < 0) {
+		nm_utils_error_set_errno (error, errno, "failed to truncate lease database: %s");
+		return NULL;
+	}
+	if (!_resize (db, LEASE_DB_INITIAL_RECORDS, error))
+		return NULL;
+
+	db->is_new = TRUE;
+	_LOGD ("created %s", path);
+	return g_steal_pointer (&db);
+}
+
+NMDhcpLeaseDb *
+nm_dhcp_lease_db_ref (NMDhcpLeaseDb *db)
+{
+	g_return_val_if_fail (db && db->ref_count > 0, NULL);
+
+	db->ref_count++;
+	return db;
+}
+
+void
+nm_dhcp_lease_db_unref (NMDhcpLeaseDb *db)
+{
+	g_return_if_fail (db && db->ref_count > 0);
+
+	if (--db->ref_count > 0)
+		return;
+
+	if (db->map)
+		munmap (db->map, db->map_size);
+	nm_close (db->fd);
+	g_hash_table_unref (db->index);
+	g_array_unref (db->free_slots);
+	g_free (db->path);
+	g_slice_free (NMDhcpLeaseDb, db);
+}
+
+/**
+ * nm_dhcp_lease_db_is_new:
+ * @db: the database
+ *
+ * Returns: whether @db was created from scratch by nm_dhcp_lease_db_open().
+ *   The caller should then import the leases of the existing lease files.
+ */
+gboolean
+nm_dhcp_lease_db_is_new (NMDhcpLeaseDb *db)
+{
+	g_return_val_if_fail (db, FALSE);
+
+	return db->is_new;
+}
+
+guint
+nm_dhcp_lease_db_get_num (NMDhcpLeaseDb *db)
+{
+	g_return_val_if_fail (db, 0);
+
+	return g_hash_table_size (db->index);
+}
+
+gboolean
+nm_dhcp_lease_db_get (NMDhcpLeaseDb *db,
+                      int addr_family,
+                      const char *iface,
+                      const char *uuid,
+                      NMIPAddr *out_address,
+                      gint64 *out_timestamp)
+{
+	gs_free char *key = NULL;
+	const LeaseDbRecord *record;
+	gpointer slot_ptr;
+
+	g_return_val_if_fail (db, FALSE);
+	g_return_val_if_fail (iface, FALSE);
+	g_return_val_if_fail (uuid, FALSE);
+
+	key = _key (addr_family, iface, uuid);
+	slot_ptr = g_hash_table_lookup (db->index, key);
+	if (!slot_ptr)
+		return FALSE;
+
+	record = _record (db, GPOINTER_TO_UINT (slot_ptr) - 1);
+	nm_assert (record->addr_family == addr_family);
+
+	if (out_address) {
+		*out_address = nm_ip_addr_zero;
+		memcpy (out_address, record->address, nm_utils_addr_family_to_size (addr_family));
+	}
+	NM_SET_OUT (out_timestamp, record->timestamp);
+	return TRUE;
+}
+
+/**
+ * nm_dhcp_lease_db_set:
+ * @db: the database
+ * @addr_family: the address family of the lease
+ * @iface: the interface of the lease
+ * @uuid: the UUID of the connection
+ * @address: the leased address, an in_addr_t or struct in6_addr
+ * @timestamp: when the lease was obtained, in seconds of CLOCK_REALTIME
+ *
+ * Adds or replaces the lease for (@addr_family, @iface, @uuid). The
+ * update is atomic and synced to disk: after a crash or a power loss,
+ * either the old or the new lease is found.
+ *
+ * Returns: %FALSE if the lease could not be stored.
+ */
+gboolean
+nm_dhcp_lease_db_set (NMDhcpLeaseDb *db,
+                      int addr_family,
+                      const char *iface,
+                      const char *uuid,
+                      gconstpointer address,
+                      gint64 timestamp)
+{
+	gs_free_error GError *error = NULL;
+	gs_free char *key = NULL;
+	LeaseDbRecord record = { 0 };
+	gpointer old_ptr;
+	guint32 slot;
+
+	g_return_val_if_fail (db, FALSE);
+	g_return_val_if_fail (NM_IN_SET (addr_family, AF_INET, AF_INET6), FALSE);
+	g_return_val_if_fail (iface, FALSE);
+	g_return_val_if_fail (uuid, FALSE);
+	g_return_val_if_fail (address, FALSE);
+
+	if (   strlen (iface) >= sizeof (record.iface)
+	    || strlen (uuid) >= sizeof (record.uuid)) {
+		_LOGW ("cannot store lease for %s/%s: name too long", iface, uuid);
+		return FALSE;
+	}
+
+	if (   db->free_slots->len == 0
+	    && !_resize (db, db->n_records * 2, &error)) {
+		_LOGW ("cannot store lease for %s/%s: %s", iface, uuid, error->message);
+		return FALSE;
+	}
+
+	record.seqnum = ++db->seqnum;
+	record.timestamp = timestamp;
+	record.addr_family = addr_family;
+	memcpy (record.address, address, nm_utils_addr_family_to_size (addr_family));
+	g_strlcpy (record.iface, iface, sizeof (record.iface));
+	g_strlcpy (record.uuid, uuid, sizeof (record.uuid));
+	record.checksum = _checksum (&record, sizeof (record));
+
+	slot = g_array_index (db->free_slots, guint32, db->free_slots->len - 1);
+	g_array_set_size (db->free_slots, db->free_slots->len - 1);
+	memcpy (_record (db, slot), &record, sizeof (record));
+	_sync (db, _record (db, slot), sizeof (record));
+
+	key = _key (addr_family, iface, uuid);
+	old_ptr = g_hash_table_lookup (db->index, key);
+	if (old_ptr) {
+		_record_clear (db, GPOINTER_TO_UINT (old_ptr) - 1);
+		_sync (db, _record (db, GPOINTER_TO_UINT (old_ptr) - 1), sizeof (LeaseDbRecord));
+	}
+	g_hash_table_insert (db->index, g_steal_pointer (&key), GUINT_TO_POINTER (slot + 1));
+
+	return TRUE;
+}
+
+/**
+ * nm_dhcp_lease_db_remove:
+ * @db: the database
+ * @uuid: the UUID of the connection
+ *
+ * Removes the leases of @uuid, of all address families and interfaces.
+ * Used when the connection is deleted, so that its leases don't take up
+ * slots forever.
+ *
+ * Returns: the number of removed leases.
+ */
+guint
+nm_dhcp_lease_db_remove (NMDhcpLeaseDb *db, const char *uuid)
+{
+	GHashTableIter iter;
+	gpointer slot_ptr;
+	guint n = 0;
+
+	g_return_val_if_fail (db, 0);
+	g_return_val_if_fail (uuid, 0);
+
+	g_hash_table_iter_init (&iter, db->index);
+	while (g_hash_table_iter_next (&iter, NULL, &slot_ptr)) {
+		guint32 slot = GPOINTER_TO_UINT (slot_ptr) - 1;
+
+		if (!nm_streq (_record (db, slot)->uuid, uuid))
+			continue;
+
+		_record_clear (db, slot);
+		_sync (db, _record (db, slot), sizeof (LeaseDbRecord));
+		g_hash_table_iter_remove (&iter);
+		n++;
+	}
+
+	if (n > 0)
+		_LOGD ("removed %u leases of %s", n, uuid);
+	return n;
+}
+
+static gboolean
+_import_file (NMDhcpLeaseDb *db, const char *dirname, const char *filename)
+{
+	gs_free char *path = NULL;
+	gs_free char *contents = NULL;
+	gs_free char *uuid = NULL;
+	gs_free char *iface = NULL;
+	gs_strfreev char **lines = NULL;
+	struct stat st;
+	in_addr_t addr = 0;
+	gsize i;
+
+	/* "internal-$UUID-$IFACE.lease". The interface name and the UUID
+	 * may both contain dashes, but UUIDs have a fixed length. */
+	if (strlen (filename) <= NM_STRLEN ("internal-") + 36 + 1 + NM_STRLEN (".lease"))
+		return FALSE;
+	uuid = g_strndup (&filename[NM_STRLEN ("internal-")], 36);
+	if (   !nm_utils_is_uuid (uuid)
+	    || filename[NM_STRLEN ("internal-") + 36] != '-')
+		return FALSE;
+	iface = g_strndup (&filename[NM_STRLEN ("internal-") + 36 + 1],
+	                   strlen (filename) - (NM_STRLEN ("internal-") + 36 + 1) - NM_STRLEN (".lease"));
+
+	path = g_build_filename (dirname, filename, NULL);
+	if (   nm_utils_file_get_contents (-1, path, 64 * 1024, NM_UTILS_FILE_GET_CONTENTS_FLAG_NONE,
+	                                   &contents, NULL, NULL) < 0
+	    || stat (path, &st) < 0)
+		return FALSE;
+
+	lines = g_strsplit (contents, "\n", -1);
+	for (i = 0; lines[i]; i++) {
+		if (g_str_has_prefix (lines[i], "ADDRESS=")) {
+			if (inet_pton (AF_INET, &lines[i][NM_STRLEN ("ADDRESS=")], &addr) != 1)
+				addr = 0;
+			break;
+		}
+	}
+	if (!addr)
+		return FALSE;
+
+	return nm_dhcp_lease_db_set (db, AF_INET, iface, uuid, &addr, st.st_mtime);
+}
+
+/**
+ * nm_dhcp_lease_db_import_files:
+ * @db: the database
+ * @dirname: the directory with lease files
+ *
+ * Imports the lease files of the internal DHCP client from @dirname.
+ * Existing entries are replaced. The files themselves are left alone.
+ *
+ * Returns: the number of imported leases.
+ */
+guint
+nm_dhcp_lease_db_import_files (NMDhcpLeaseDb *db, const char *dirname)
+{
+	GDir *dir;
+	const char *filename;
+	guint n = 0;
+
+	g_return_val_if_fail (db, 0);
+	g_return_val_if_fail (dirname, 0);
+
+	dir = g_dir_open (dirname, 0, NULL);
+	if (!dir)
+		return 0;
+
+	while ((filename = g_dir_read_name (dir))) {
+		if (   !g_str_has_prefix (filename, "internal-")
+		    || !g_str_has_suffix (filename, ".lease"))
+			continue;
+		if (_import_file (db, dirname, filename))
+			n++;
+		else
+			_LOGD ("cannot import lease file %s/%s", dirname, filename);
+	}
+	g_dir_close (dir);
+
+	if (n > 0)
+		_LOGI ("imported %u leases from %s", n, dirname);
+	return n;
+}
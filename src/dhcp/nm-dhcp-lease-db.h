@@ -0,0 +1,53 @@
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2019 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_DHCP_LEASE_DB_H__
+#define __NETWORKMANAGER_DHCP_LEASE_DB_H__
+
+typedef struct _NMDhcpLeaseDb NMDhcpLeaseDb;
+
+NMDhcpLeaseDb *nm_dhcp_lease_db_open (const char *path, GError **error);
+
+NMDhcpLeaseDb *nm_dhcp_lease_db_ref (NMDhcpLeaseDb *db);
+void nm_dhcp_lease_db_unref (NMDhcpLeaseDb *db);
+
+NM_AUTO_DEFINE_FCN0 (NMDhcpLeaseDb *, _nm_auto_unref_dhcp_lease_db, nm_dhcp_lease_db_unref)
+#define nm_auto_unref_dhcp_lease_db nm_auto (_nm_auto_unref_dhcp_lease_db)
+
+gboolean nm_dhcp_lease_db_is_new (NMDhcpLeaseDb *db);
+
+guint nm_dhcp_lease_db_get_num (NMDhcpLeaseDb *db);
+
+gboolean nm_dhcp_lease_db_get (NMDhcpLeaseDb *db,
+                               int addr_family,
+                               const char *iface,
+                               const char *uuid,
+                               NMIPAddr *out_address,
+                               gint64 *out_timestamp);
+
+gboolean nm_dhcp_lease_db_set (NMDhcpLeaseDb *db,
+                               int addr_family,
+                               const char *iface,
+                               const char *uuid,
+                               gconstpointer address,
+                               gint64 timestamp);
+
+guint nm_dhcp_lease_db_remove (NMDhcpLeaseDb *db, const char *uuid);
+
+guint nm_dhcp_lease_db_import_files (NMDhcpLeaseDb *db, const char *dirname);
+
+#endif /* __NETWORKMANAGER_DHCP_LEASE_DB_H__ */
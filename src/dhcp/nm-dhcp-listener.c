@@ -21,11 +21,14 @@
 #include "nm-dhcp-listener.h"
 
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <unistd.h>
 
+#include "c-list/src/c-list.h"
+
 #include "nm-dhcp-helper-api.h"
 #include "nm-dhcp-client.h"
 #include "nm-dhcp-manager.h"
@@ -38,7 +41,7 @@
 
 /*****************************************************************************/
 
-const NMDhcpClientFactory *const _nm_dhcp_manager_factories[4] = {
+const NMDhcpClientFactory *const _nm_dhcp_manager_factories[5] = {
 	/* the order here matters, as we will try the plugins in this order to find
 	 * the first available plugin. */
 
@@ -52,6 +55,7 @@ const NMDhcpClientFactory *const _nm_dhcp_manager_factories[4] = {
 	&_nm_dhcp_client_factory_dhcpcd,
 #endif
 	&_nm_dhcp_client_factory_internal,
+	&_nm_dhcp_client_factory_nettools,
 };
 
 /*****************************************************************************/
@@ -61,6 +65,11 @@ typedef struct {
 	gulong              new_conn_id;
 	gulong              dis_conn_id;
 	GHashTable *        connections;
+
+	CList               seqpacket_clients;
+	guint8 *            seqpacket_buf;
+	GIOChannel *        seqpacket_channel;
+	guint               seqpacket_id;
 } NMDhcpListenerPrivate;
 
 struct _NMDhcpListener {
@@ -137,17 +146,14 @@ get_option (GVariant *options, const char *key)
 
 static void
 _method_call_handle (NMDhcpListener *self,
-                     GVariant *parameters)
+                     GVariant *options)
 {
 	gs_free char *iface = NULL;
 	gs_free char *pid_str = NULL;
 	gs_free char *reason = NULL;
-	gs_unref_variant GVariant *options = NULL;
 	int pid;
 	gboolean handled = FALSE;
 
-	g_variant_get (parameters, "(@a{sv})", &options);
-
 	iface = get_option (options, "interface");
 	if (iface == NULL) {
 		_LOGW ("dhcp-event: didn't have associated interface.");
@@ -199,7 +205,12 @@ _method_call (GDBusConnection *connection,
 		return;
 	}
 
-	_method_call_handle (self, parameters);
+	{
+		gs_unref_variant GVariant *options = NULL;
+
+		g_variant_get (parameters, "(@a{sv})", &options);
+		_method_call_handle (self, options);
+	}
 	g_dbus_method_invocation_return_value (invocation, NULL);
 }
 
@@ -273,6 +284,195 @@ dis_connection_cb (NMDBusManager *mgr,
 
 /*****************************************************************************/
 
+typedef struct {
+	CList lst;
+	NMDhcpListener *self;
+	guint watch_id;
+} SeqpacketClient;
+
+static void
+seqpacket_client_free (SeqpacketClient *client)
+{
+	c_list_unlink_stale (&client->lst);
+	nm_clear_g_source (&client->watch_id);
+	g_slice_free (SeqpacketClient, client);
+}
+
+static gboolean
+seqpacket_client_cb (GIOChannel *source,
+                     GIOCondition condition,
+                     gpointer user_data)
+{
+	SeqpacketClient *client = user_data;
+	NMDhcpListener *self = client->self;
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	const NMDhcpHelperMsgHeader ack = {
+		.magic   = NM_DHCP_HELPER_MSG_MAGIC,
+		.version = NM_DHCP_HELPER_MSG_VERSION,
+		.type    = NM_DHCP_HELPER_MSG_TYPE_ACK,
+	};
+	int fd = g_io_channel_unix_get_fd (source);
+	ssize_t n;
+
+	/* the helper sends one event per datagram and waits for our acknowledgement
+	 * before sending the next one (if any). */
+	n = recv (fd, priv->seqpacket_buf, NM_DHCP_HELPER_MSG_SIZE_MAX, MSG_DONTWAIT | MSG_TRUNC);
+	if (n < 0) {
+		int errsv = errno;
+
+		if (NM_IN_SET (errsv, EAGAIN, EINTR))
+			return G_SOURCE_CONTINUE;
+		_LOGD ("seqpacket: receive failed: %s", nm_strerror_native (errsv));
+		goto out_close;
+	}
+	if (n == 0)
+		goto out_close;
+
+	if ((gsize) n > NM_DHCP_HELPER_MSG_SIZE_MAX) {
+		_LOGW ("seqpacket: dropping truncated message of %zd bytes", n);
+		goto out_close;
+	}
+
+	{
+		gs_unref_variant GVariant *options = NULL;
+
+		options = nm_dhcp_helper_msg_parse_event (priv->seqpacket_buf, n);
+		if (!options) {
+			_LOGW ("seqpacket: invalid message");
+			goto out_close;
+		}
+		_method_call_handle (self, options);
+	}
+
+	n = send (fd, &ack, sizeof (ack), MSG_DONTWAIT | MSG_NOSIGNAL);
+	if (n != sizeof (ack)) {
+		_LOGD ("seqpacket: failed to acknowledge event: %s",
+		       n < 0 ? nm_strerror_native (errno) : "short write");
+		goto out_close;
+	}
+
+	return G_SOURCE_CONTINUE;
+
+out_close:
+	client->watch_id = 0;
+	seqpacket_client_free (client);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+seqpacket_accept_cb (GIOChannel *source,
+                     GIOCondition condition,
+                     gpointer user_data)
+{
+	NMDhcpListener *self = user_data;
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	SeqpacketClient *client;
+	GIOChannel *channel;
+	struct ucred cred;
+	socklen_t cred_len = sizeof (cred);
+	int fd;
+
+	fd = accept4 (g_io_channel_unix_get_fd (source), NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (fd < 0) {
+		int errsv = errno;
+
+		if (!NM_IN_SET (errsv, EAGAIN, EINTR, ECONNABORTED))
+			_LOGD ("seqpacket: accept failed: %s", nm_strerror_native (errsv));
+		return G_SOURCE_CONTINUE;
+	}
+
+	/* like the private D-Bus server, only accept connections from root. */
+	if (   getsockopt (fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) != 0
+	    || cred.uid != 0) {
+		_LOGW ("seqpacket: rejecting connection from unauthorized peer");
+		nm_close (fd);
+		return G_SOURCE_CONTINUE;
+	}
+
+	if (!priv->seqpacket_buf)
+		priv->seqpacket_buf = g_malloc (NM_DHCP_HELPER_MSG_SIZE_MAX);
+
+	client = g_slice_new0 (SeqpacketClient);
+	client->self = self;
+	c_list_link_tail (&priv->seqpacket_clients, &client->lst);
+
+	channel = g_io_channel_unix_new (fd);
+	g_io_channel_set_close_on_unref (channel, TRUE);
+	g_io_channel_set_encoding (channel, NULL, NULL);
+	g_io_channel_set_buffered (channel, FALSE);
+	client->watch_id = g_io_add_watch (channel,
+	                                   G_IO_IN | G_IO_ERR | G_IO_HUP,
+	                                   seqpacket_client_cb,
+	                                   client);
+	/* the watch keeps the channel (and the file descriptor) alive. */
+	g_io_channel_unref (channel);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+seqpacket_server_start (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	struct sockaddr_un addr = {
+		.sun_family = AF_UNIX,
+		.sun_path   = NM_DHCP_HELPER_SEQPACKET_PATH,
+	};
+	nm_auto_close int fd = -1;
+	int errsv;
+
+	fd = socket (AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		errsv = errno;
+		goto fail;
+	}
+
+	/* a stale socket from a previous instance. */
+	unlink (NM_DHCP_HELPER_SEQPACKET_PATH);
+
+	if (   bind (fd, (struct sockaddr *) &addr, sizeof (addr)) != 0
+	    || listen (fd, 64) != 0) {
+		errsv = errno;
+		goto fail;
+	}
+
+	priv->seqpacket_channel = g_io_channel_unix_new (nm_steal_fd (&fd));
+	g_io_channel_set_close_on_unref (priv->seqpacket_channel, TRUE);
+	g_io_channel_set_encoding (priv->seqpacket_channel, NULL, NULL);
+	g_io_channel_set_buffered (priv->seqpacket_channel, FALSE);
+	priv->seqpacket_id = g_io_add_watch (priv->seqpacket_channel,
+	                                     G_IO_IN,
+	                                     seqpacket_accept_cb,
+	                                     self);
+	return;
+
+fail:
+	/* not fatal, the helper falls back to D-Bus. */
+	_LOGW ("seqpacket: cannot listen on %s: %s",
+	       NM_DHCP_HELPER_SEQPACKET_PATH,
+	       nm_strerror_native (errsv));
+}
+
+static void
+seqpacket_server_stop (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	SeqpacketClient *client;
+
+	while ((client = c_list_first_entry (&priv->seqpacket_clients, SeqpacketClient, lst)))
+		seqpacket_client_free (client);
+
+	if (priv->seqpacket_channel) {
+		nm_clear_g_source (&priv->seqpacket_id);
+		g_clear_pointer (&priv->seqpacket_channel, g_io_channel_unref);
+		unlink (NM_DHCP_HELPER_SEQPACKET_PATH);
+	}
+
+	nm_clear_g_free (&priv->seqpacket_buf);
+}
+
+/*****************************************************************************/
+
 static void
 nm_dhcp_listener_init (NMDhcpListener *self)
 {
@@ -281,6 +481,8 @@ nm_dhcp_listener_init (NMDhcpListener *self)
 	/* Maps GDBusConnection :: signal-id */
 	priv->connections = g_hash_table_new (nm_direct_hash, NULL);
 
+	c_list_init (&priv->seqpacket_clients);
+
 	priv->dbus_mgr = nm_dbus_manager_get ();
 
 	/* Register the socket our DHCP clients will return lease info on */
@@ -293,12 +495,17 @@ nm_dhcp_listener_init (NMDhcpListener *self)
 	                                      NM_DBUS_MANAGER_PRIVATE_CONNECTION_DISCONNECTED "::" PRIV_SOCK_TAG,
 	                                      G_CALLBACK (dis_connection_cb),
 	                                      self);
+
+	seqpacket_server_start (self);
 }
 
 static void
 dispose (GObject *object)
 {
-	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE ((NMDhcpListener *) object);
+	NMDhcpListener *self = NM_DHCP_LISTENER (object);
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+
+	seqpacket_server_stop (self);
 
 	nm_clear_g_signal_handler (priv->dbus_mgr, &priv->new_conn_id);
 	nm_clear_g_signal_handler (priv->dbus_mgr, &priv->dis_conn_id);
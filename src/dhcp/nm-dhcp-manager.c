@@ -38,10 +38,17 @@
 
 /*****************************************************************************/
 
+/* a client never holds a slot of the start scheduler for longer than this,
+ * even if it doesn't get a lease. The slots only serve to spread out the
+ * initial DISCOVER/SOLICIT messages. */
+#define SCHED_SLOT_HOLD_MSEC 10000
+
 typedef struct {
 	const NMDhcpClientFactory *client_factory;
 	char *default_hostname;
 	CList dhcp_client_lst_head;
+	NMDhcpLeaseDb *lease_db;
+	NMDhcpStartSched *sched;
 } NMDhcpManagerPrivate;
 
 struct _NMDhcpManager {
@@ -64,6 +71,61 @@ const char *nm_dhcp_helper_path = LIBEXECDIR "/nm-dhcp-helper";
 
 /*****************************************************************************/
 
+struct _NMDhcpStartSched {
+	/* NMDhcpClient -> StartRequest */
+	GHashTable *requests;
+	CList queue_lst_head;
+	guint n_queued;
+	guint n_running;
+
+	/* the configuration. 0 means unlimited. */
+	guint limit;
+	guint rate;
+	guint jitter_msec;
+	guint slot_hold_msec;
+
+	/* the token bucket, in thousandths of a token. */
+	gint64 tokens;
+	gint64 tokens_timestamp;
+
+	gint64 timer_expiry;
+	guint timer_id;
+};
+
+typedef struct {
+	CList queue_lst;
+	NMDhcpStartSched *sched;
+
+	/* not owned. The request is dropped when the client gets destroyed. */
+	NMDhcpClient *client;
+
+	GBytes *client_id;
+	char *anycast_addr;
+	char *last_ip4_address;
+	struct in6_addr ll_addr;
+	NMSettingIP6ConfigPrivacy privacy;
+	guint needed_prefixes;
+	gint64 queued_at;
+	guint timer_id;
+	bool enforce_duid:1;
+	bool has_ll_addr:1;
+	bool running:1;
+} StartRequest;
+
+#define _LOG_REQ(level, req, fmt, ...) \
+	G_STMT_START { \
+		const StartRequest *_req = (req); \
+		const char *_iface = nm_dhcp_client_get_iface (_req->client); \
+		\
+		nm_log ((level), LOGD_DHCP, _iface, nm_dhcp_client_get_uuid (_req->client), \
+		        "dhcp%c (%s): " fmt, \
+		        nm_utils_addr_family_to_char (nm_dhcp_client_get_addr_family (_req->client)), \
+		        _iface, \
+		        ##__VA_ARGS__); \
+	} G_STMT_END
+
+/*****************************************************************************/
+
 static const NMDhcpClientFactory *
 _client_factory_find_by_name (const char *name)
 {
@@ -169,8 +231,12 @@ static void client_state_changed (NMDhcpClient *client,
 static void
 remove_client (NMDhcpManager *self, NMDhcpClient *client)
 {
+	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
+
 	g_signal_handlers_disconnect_by_func (client, client_state_changed, self);
 	c_list_unlink (&client->dhcp_client_lst);
+	if (priv->sched)
+		nm_dhcp_start_sched_finish (priv->sched, client);
 
 	/* Stopping the client is left up to the controlling device
 	 * explicitly since we may want to quit NetworkManager but not terminate
@@ -197,6 +263,394 @@ client_state_changed (NMDhcpClient *client,
 		remove_client_unref (self, client);
 }
 
+static gboolean
+start_client (NMDhcpClient *client,
+              GBytes *dhcp_client_id,
+              gboolean enforce_duid,
+              const char *dhcp_anycast_addr,
+              const char *last_ip4_address,
+              const struct in6_addr *ipv6_ll_addr,
+              NMSettingIP6ConfigPrivacy privacy,
+              guint needed_prefixes,
+              GError **error)
+{
+	/* unfortunately, our implementations work differently per address-family regarding client-id/DUID.
+	 *
+	 * - for IPv4, the calling code may determine a client-id (from NM's connection profile).
+	 *   If present, it is taken. If not present, the DHCP plugin uses a plugin specific default.
+	 *     - for "internal" plugin, the default is just "mac".
+	 *     - for "dhclient", we try to get the configuration from dhclient's /etc/dhcp or fallback
+	 *       to whatever dhclient uses by default.
+	 *   We do it this way, because for dhclient the user may configure a default
+	 *   outside of NM, and we want to honor that. Worse, dhclient could be a wapper
+	 *   script where the wrapper script overwrites the client-id. We need to distinguish
+	 *   between: force a particular client-id and leave it unspecified to whatever dhclient
+	 *   wants.
+	 *
+	 * - for IPv6, the calling code always determines a client-id. It also specifies @enforce_duid,
+	 *   to determine whether the given client-id must be used.
+	 *     - for "internal" plugin @enforce_duid doesn't matter and the given client-id is
+	 *       always used.
+	 *     - for "dhclient", @enforce_duid FALSE means to first try to load the DUID from the
+	 *       lease file, and only otherwise fallback to the given client-id.
+	 *     - other plugins don't support DHCPv6.
+	 *   It's done this way, so that existing dhclient setups don't change behavior on upgrade.
+	 *
+	 * This difference is cumbersome and only exists because of "dhclient" which supports hacking the
+	 * default outside of NetworkManager API.
+	 */
+
+	if (nm_dhcp_client_get_addr_family (client) == AF_INET) {
+		return nm_dhcp_client_start_ip4 (client,
+		                                 dhcp_client_id,
+		                                 dhcp_anycast_addr,
+		                                 last_ip4_address,
+		                                 error);
+	}
+
+	return nm_dhcp_client_start_ip6 (client,
+	                                 dhcp_client_id,
+	                                 enforce_duid,
+	                                 dhcp_anycast_addr,
+	                                 ipv6_ll_addr,
+	                                 privacy,
+	                                 needed_prefixes,
+	                                 error);
+}
+
+/*****************************************************************************/
+
+static void sched_schedule (NMDhcpStartSched *sched, gint64 delay_msec);
+
+static void sched_client_state_changed (NMDhcpClient *client,
+                                        NMDhcpState state,
+                                        GObject *ip_config,
+                                        GVariant *options,
+                                        const char *event_id,
+                                        StartRequest *req);
+
+static void sched_client_weak_notify (gpointer user_data, GObject *where_the_object_was);
+
+static void
+sched_request_free (StartRequest *req)
+{
+	NMDhcpStartSched *sched = req->sched;
+
+	if (req->running) {
+		nm_assert (sched->n_running > 0);
+		sched->n_running--;
+	} else {
+		nm_assert (sched->n_queued > 0);
+		sched->n_queued--;
+		c_list_unlink (&req->queue_lst);
+	}
+
+	if (req->client) {
+		g_signal_handlers_disconnect_by_func (req->client, sched_client_state_changed, req);
+		g_object_weak_unref (G_OBJECT (req->client), sched_client_weak_notify, req);
+	}
+
+	nm_clear_g_source (&req->timer_id);
+	if (req->client_id)
+		g_bytes_unref (req->client_id);
+	g_free (req->anycast_addr);
+	g_free (req->last_ip4_address);
+	g_slice_free (StartRequest, req);
+}
+
+/* Drops the scheduler state of @client. A queued client is never started,
+ * a running one frees its slot. */
+static void
+sched_request_drop (NMDhcpStartSched *sched, gconstpointer client)
+{
+	if (!g_hash_table_remove (sched->requests, client))
+		return;
+
+	if (!c_list_is_empty (&sched->queue_lst_head))
+		sched_schedule (sched, 0);
+}
+
+static void
+sched_client_state_changed (NMDhcpClient *client,
+                            NMDhcpState state,
+                            GObject *ip_config,
+                            GVariant *options,
+                            const char *event_id,
+                            StartRequest *req)
+{
+	if (   state == NM_DHCP_STATE_BOUND
+	    || state >= NM_DHCP_STATE_TIMEOUT)
+		sched_request_drop (req->sched, client);
+}
+
+static void
+sched_client_weak_notify (gpointer user_data, GObject *where_the_object_was)
+{
+	StartRequest *req = user_data;
+
+	/* the signal handlers of the client are already gone. */
+	req->client = NULL;
+	sched_request_drop (req->sched, where_the_object_was);
+}
+
+static gboolean
+sched_slot_expired_cb (gpointer user_data)
+{
+	StartRequest *req = user_data;
+
+	req->timer_id = 0;
+	_LOG_REQ (LOGL_DEBUG, req, "start slot released (no lease after %u msec)",
+	          req->sched->slot_hold_msec);
+	sched_request_drop (req->sched, req->client);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+sched_request_start (StartRequest *req)
+{
+	NMDhcpStartSched *sched = req->sched;
+	gs_unref_object NMDhcpClient *client = g_object_ref (req->client);
+	gs_free_error GError *error = NULL;
+
+	nm_clear_g_source (&req->timer_id);
+
+	_LOG_REQ (LOGL_INFO, req, "starting queued client after %"G_GINT64_FORMAT" msec",
+	          nm_utils_get_monotonic_timestamp_ms () - req->queued_at);
+
+	if (!start_client (req->client,
+	                   req->client_id,
+	                   req->enforce_duid,
+	                   req->anycast_addr,
+	                   req->last_ip4_address,
+	                   req->has_ll_addr ? &req->ll_addr : NULL,
+	                   req->privacy,
+	                   req->needed_prefixes,
+	                   &error)) {
+		_LOG_REQ (LOGL_WARN, req, "failure to start queued client: %s", error->message);
+		/* this drops the request and frees @req. */
+		nm_dhcp_client_set_state (client, NM_DHCP_STATE_FAIL, NULL, NULL);
+		return;
+	}
+
+	if (g_hash_table_lookup (sched->requests, client) != req) {
+		/* the client already got a lease or failed while starting. */
+		return;
+	}
+
+	req->timer_id = g_timeout_add (sched->slot_hold_msec, sched_slot_expired_cb, req);
+}
+
+static gboolean
+sched_jitter_cb (gpointer user_data)
+{
+	StartRequest *req = user_data;
+
+	req->timer_id = 0;
+	sched_request_start (req);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+sched_dispatch_cb (gpointer user_data)
+{
+	NMDhcpStartSched *sched = user_data;
+	StartRequest *req;
+	gint64 now;
+
+	sched->timer_id = 0;
+
+	now = nm_utils_get_monotonic_timestamp_ms ();
+
+	if (sched->rate > 0) {
+		gint64 burst = (gint64) sched->rate * 1000;
+
+		/* refill the bucket. One token is 1000, and we gain @rate tokens
+		 * per second, thus @rate thousandths per millisecond. */
+		sched->tokens += (now - sched->tokens_timestamp) * sched->rate;
+		sched->tokens = NM_MIN (sched->tokens, burst);
+		sched->tokens_timestamp = now;
+	}
+
+	while ((req = c_list_first_entry (&sched->queue_lst_head, StartRequest, queue_lst))) {
+		guint jitter;
+
+		if (   sched->limit > 0
+		    && sched->n_running >= sched->limit) {
+			/* we get rescheduled when a slot becomes free. */
+			break;
+		}
+
+		if (sched->rate > 0) {
+			if (sched->tokens < 1000) {
+				sched_schedule (sched,
+				                (1000 - sched->tokens + sched->rate - 1) / sched->rate);
+				break;
+			}
+			sched->tokens -= 1000;
+		}
+
+		c_list_unlink (&req->queue_lst);
+		sched->n_queued--;
+		sched->n_running++;
+		req->running = TRUE;
+
+		jitter = sched->jitter_msec > 0
+		         ? g_random_int_range (0, sched->jitter_msec + 1)
+		         : 0;
+		if (jitter > 0) {
+			_LOG_REQ (LOGL_DEBUG, req, "start delayed by %u msec jitter", jitter);
+			req->timer_id = g_timeout_add (jitter, sched_jitter_cb, req);
+		} else
+			sched_request_start (req);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+static void
+sched_schedule (NMDhcpStartSched *sched, gint64 delay_msec)
+{
+	gint64 expiry;
+
+	/* never dispatch synchronously. Starting a client can emit signals, and
+	 * we are often called from signal handlers ourself. */
+	expiry = nm_utils_get_monotonic_timestamp_ms () + delay_msec;
+
+	if (sched->timer_id) {
+		if (sched->timer_expiry <= expiry)
+			return;
+		nm_clear_g_source (&sched->timer_id);
+	}
+
+	sched->timer_expiry = expiry;
+	sched->timer_id = g_timeout_add (delay_msec, sched_dispatch_cb, sched);
+}
+
+/**
+ * nm_dhcp_start_sched_new:
+ * @limit: the maximum number of clients that are starting at the same time,
+ *   or 0 for no limit.
+ * @rate: the maximum number of clients to start per second, or 0 for no limit.
+ * @jitter_msec: each start is delayed by a random time up to this.
+ * @slot_hold_msec: a started client frees its slot after this time at
+ *   the latest, even if it didn't get a lease yet.
+ *
+ * Returns: (transfer full): a new start scheduler. Free with
+ *   nm_dhcp_start_sched_free().
+ */
+NMDhcpStartSched *
+nm_dhcp_start_sched_new (guint limit,
+                         guint rate,
+                         guint jitter_msec,
+                         guint slot_hold_msec)
+{
+	NMDhcpStartSched *sched;
+
+	g_return_val_if_fail (slot_hold_msec > 0, NULL);
+
+	sched = g_slice_new0 (NMDhcpStartSched);
+	c_list_init (&sched->queue_lst_head);
+	sched->requests = g_hash_table_new_full (nm_direct_hash, NULL, NULL, (GDestroyNotify) sched_request_free);
+	sched->limit = limit;
+	sched->rate = rate;
+	sched->jitter_msec = jitter_msec;
+	sched->slot_hold_msec = slot_hold_msec;
+	return sched;
+}
+
+void
+nm_dhcp_start_sched_free (NMDhcpStartSched *sched)
+{
+	if (!sched)
+		return;
+
+	nm_clear_g_source (&sched->timer_id);
+	g_hash_table_destroy (sched->requests);
+	nm_assert (c_list_is_empty (&sched->queue_lst_head));
+	g_slice_free (NMDhcpStartSched, sched);
+}
+
+/**
+ * nm_dhcp_start_sched_queue:
+ * @sched: the #NMDhcpStartSched
+ * @client: the client to start
+ *
+ * Queues the start of @client. The remaining arguments are passed on
+ * to nm_dhcp_client_start_ip4() or nm_dhcp_client_start_ip6().
+ *
+ * The request is dropped when the client gets a lease, fails, is stopped
+ * or gets destroyed, or when the caller calls nm_dhcp_start_sched_finish().
+ */
+void
+nm_dhcp_start_sched_queue (NMDhcpStartSched *sched,
+                           NMDhcpClient *client,
+                           GBytes *client_id,
+                           gboolean enforce_duid,
+                           const char *anycast_addr,
+                           const char *last_ip4_address,
+                           const struct in6_addr *ipv6_ll_addr,
+                           NMSettingIP6ConfigPrivacy privacy,
+                           guint needed_prefixes)
+{
+	StartRequest *req;
+
+	g_return_if_fail (sched);
+	g_return_if_fail (NM_IS_DHCP_CLIENT (client));
+	g_return_if_fail (!g_hash_table_contains (sched->requests, client));
+
+	req = g_slice_new0 (StartRequest);
+	req->sched = sched;
+	req->client = client;
+	req->client_id = client_id ? g_bytes_ref (client_id) : NULL;
+	req->anycast_addr = g_strdup (anycast_addr);
+	req->last_ip4_address = g_strdup (last_ip4_address);
+	if (ipv6_ll_addr) {
+		req->ll_addr = *ipv6_ll_addr;
+		req->has_ll_addr = TRUE;
+	}
+	req->privacy = privacy;
+	req->needed_prefixes = needed_prefixes;
+	req->enforce_duid = enforce_duid;
+	req->queued_at = nm_utils_get_monotonic_timestamp_ms ();
+	g_hash_table_insert (sched->requests, client, req);
+
+	g_signal_connect (client, NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED, G_CALLBACK (sched_client_state_changed), req);
+	g_object_weak_ref (G_OBJECT (client), sched_client_weak_notify, req);
+
+	c_list_link_tail (&sched->queue_lst_head, &req->queue_lst);
+	sched->n_queued++;
+
+	_LOG_REQ (LOGL_DEBUG, req, "start queued (position %u, %u running)",
+	          sched->n_queued, sched->n_running);
+
+	/* the dhcp-timeout starts now, not when the client leaves the queue. */
+	nm_dhcp_client_start_timeout (client);
+
+	sched_schedule (sched, 0);
+}
+
+void
+nm_dhcp_start_sched_finish (NMDhcpStartSched *sched, NMDhcpClient *client)
+{
+	g_return_if_fail (sched);
+	g_return_if_fail (NM_IS_DHCP_CLIENT (client));
+
+	sched_request_drop (sched, client);
+}
+
+void
+nm_dhcp_start_sched_get_counts (const NMDhcpStartSched *sched,
+                                guint *out_n_queued,
+                                guint *out_n_running)
+{
+	g_return_if_fail (sched);
+
+	NM_SET_OUT (out_n_queued, sched->n_queued);
+	NM_SET_OUT (out_n_running, sched->n_running);
+}
+
+/*****************************************************************************/
+
 static NMDhcpClient *
 client_start (NMDhcpManager *self,
               int addr_family,
@@ -222,7 +676,6 @@ client_start (NMDhcpManager *self,
 {
 	NMDhcpManagerPrivate *priv;
 	NMDhcpClient *client;
-	gboolean success = FALSE;
 	gsize hwaddr_len;
 	const NMDhcpClientFactory *client_factory;
 
@@ -284,53 +737,32 @@ client_start (NMDhcpManager *self,
 	                       ),
 	                       NULL);
 	nm_assert (client && c_list_is_empty (&client->dhcp_client_lst));
+	nm_dhcp_client_set_lease_db (client, priv->lease_db);
 	c_list_link_tail (&priv->dhcp_client_lst_head, &client->dhcp_client_lst);
 	g_signal_connect (client, NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED, G_CALLBACK (client_state_changed), self);
 
-	/* unfortunately, our implementations work differently per address-family regarding client-id/DUID.
-	 *
-	 * - for IPv4, the calling code may determine a client-id (from NM's connection profile).
-	 *   If present, it is taken. If not present, the DHCP plugin uses a plugin specific default.
-	 *     - for "internal" plugin, the default is just "mac".
-	 *     - for "dhclient", we try to get the configuration from dhclient's /etc/dhcp or fallback
-	 *       to whatever dhclient uses by default.
-	 *   We do it this way, because for dhclient the user may configure a default
-	 *   outside of NM, and we want to honor that. Worse, dhclient could be a wapper
-	 *   script where the wrapper script overwrites the client-id. We need to distinguish
-	 *   between: force a particular client-id and leave it unspecified to whatever dhclient
-	 *   wants.
-	 *
-	 * - for IPv6, the calling code always determines a client-id. It also specifies @enforce_duid,
-	 *   to determine whether the given client-id must be used.
-	 *     - for "internal" plugin @enforce_duid doesn't matter and the given client-id is
-	 *       always used.
-	 *     - for "dhclient", @enforce_duid FALSE means to first try to load the DUID from the
-	 *       lease file, and only otherwise fallback to the given client-id.
-	 *     - other plugins don't support DHCPv6.
-	 *   It's done this way, so that existing dhclient setups don't change behavior on upgrade.
-	 *
-	 * This difference is cumbersome and only exists because of "dhclient" which supports hacking the
-	 * default outside of NetworkManager API.
-	 */
-
-	if (addr_family == AF_INET) {
-		success = nm_dhcp_client_start_ip4 (client,
-		                                    dhcp_client_id,
-		                                    dhcp_anycast_addr,
-		                                    last_ip4_address,
-		                                    error);
-	} else {
-		success = nm_dhcp_client_start_ip6 (client,
-		                                    dhcp_client_id,
-		                                    enforce_duid,
-		                                    dhcp_anycast_addr,
-		                                    ipv6_ll_addr,
-		                                    privacy,
-		                                    needed_prefixes,
-		                                    error);
+	if (priv->sched) {
+		nm_dhcp_start_sched_queue (priv->sched,
+		                           client,
+		                           dhcp_client_id,
+		                           enforce_duid,
+		                           dhcp_anycast_addr,
+		                           last_ip4_address,
+		                           ipv6_ll_addr,
+		                           privacy,
+		                           needed_prefixes);
+		return g_object_ref (client);
 	}
 
-	if (!success) {
+	if (!start_client (client,
+	                   dhcp_client_id,
+	                   enforce_duid,
+	                   dhcp_anycast_addr,
+	                   last_ip4_address,
+	                   ipv6_ll_addr,
+	                   privacy,
+	                   needed_prefixes,
+	                   error)) {
 		remove_client_unref (self, client);
 		return NULL;
 	}
@@ -492,6 +924,26 @@ nm_dhcp_manager_get_config (NMDhcpManager *self)
 	return factory ? factory->name : NULL;
 }
 
+/**
+ * nm_dhcp_manager_remove_leases:
+ * @self: the #NMDhcpManager
+ * @uuid: the UUID of a deleted connection
+ *
+ * Forgets the leases of @uuid in the lease database, if it is enabled.
+ */
+void
+nm_dhcp_manager_remove_leases (NMDhcpManager *self, const char *uuid)
+{
+	NMDhcpManagerPrivate *priv;
+
+	g_return_if_fail (NM_IS_DHCP_MANAGER (self));
+	g_return_if_fail (uuid);
+
+	priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
+	if (priv->lease_db)
+		nm_dhcp_lease_db_remove (priv->lease_db, uuid);
+}
+
 /*****************************************************************************/
 
 NM_DEFINE_SINGLETON_GETTER (NMDhcpManager, nm_dhcp_manager_get, NM_TYPE_DHCP_MANAGER);
@@ -511,9 +963,35 @@ nm_dhcp_manager_init (NMDhcpManager *self)
 	const char *client;
 	int i;
 	const NMDhcpClientFactory *client_factory = NULL;
+	guint sched_limit;
+	guint sched_rate;
+	guint sched_jitter_msec;
 
 	c_list_init (&priv->dhcp_client_lst_head);
 
+	sched_limit = nm_config_data_get_value_int64 (nm_config_get_data_orig (config),
+	                                              NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                              NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_START_LIMIT,
+	                                              10, 0, G_MAXINT32, 0);
+	sched_rate = nm_config_data_get_value_int64 (nm_config_get_data_orig (config),
+	                                             NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                             NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_START_RATE,
+	                                             10, 0, 100000, 0);
+	sched_jitter_msec = nm_config_data_get_value_int64 (nm_config_get_data_orig (config),
+	                                                    NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                                    NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_START_JITTER,
+	                                                    10, 0, 60000, 0);
+	if (   sched_limit > 0
+	    || sched_rate > 0
+	    || sched_jitter_msec > 0) {
+		nm_log_info (LOGD_DHCP, "dhcp-init: start scheduler enabled (limit %u, rate %u/sec, jitter %u msec)",
+		             sched_limit, sched_rate, sched_jitter_msec);
+		priv->sched = nm_dhcp_start_sched_new (sched_limit,
+		                                       sched_rate,
+		                                       sched_jitter_msec,
+		                                       SCHED_SLOT_HOLD_MSEC);
+	}
+
 	for (i = 0; i < G_N_ELEMENTS (_nm_dhcp_manager_factories); i++) {
 		const NMDhcpClientFactory *f = _nm_dhcp_manager_factories[i];
 
@@ -525,6 +1003,30 @@ nm_dhcp_manager_init (NMDhcpManager *self)
 		            _client_factory_available (f) ? "" : " (not available)");
 	}
 
+	if (nm_config_data_get_value_boolean (nm_config_get_data_orig (config),
+	                                      NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                      NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_SHARED_SOCKET,
+	                                      FALSE))
+		nm_dhcp_nettools_set_shared_socket (TRUE);
+
+	if (   nm_config_data_get_value_boolean (nm_config_get_data_orig (config),
+	                                         NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                         NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_LEASE_DB,
+	                                         FALSE)
+	    && nm_config_get_configure_and_quit (config) != NM_CONFIG_CONFIGURE_AND_QUIT_INITRD) {
+		gs_free_error GError *error = NULL;
+
+		priv->lease_db = nm_dhcp_lease_db_open (NMSTATEDIR "/dhcp-leases.db", &error);
+		if (!priv->lease_db)
+			nm_log_warn (LOGD_DHCP, "dhcp-init: cannot open lease database: %s", error->message);
+		else if (nm_dhcp_lease_db_is_new (priv->lease_db)) {
+			/* leases in NMRUNDIR are more recent than the ones in NMSTATEDIR,
+			 * see get_leasefile_path() of the internal client. */
+			nm_dhcp_lease_db_import_files (priv->lease_db, NMSTATEDIR);
+			nm_dhcp_lease_db_import_files (priv->lease_db, NMRUNDIR);
+		}
+	}
+
 	/* Client-specific setup */
 	client_free = nm_config_data_get_value (nm_config_get_data_orig (config),
 	                                        NM_CONFIG_KEYFILE_GROUP_MAIN,
@@ -581,6 +1083,9 @@ dispose (GObject *object)
 	c_list_for_each_entry_safe (client, client_safe, &priv->dhcp_client_lst_head, dhcp_client_lst)
 		remove_client_unref (self, client);
 
+	nm_clear_pointer (&priv->sched, nm_dhcp_start_sched_free);
+	nm_clear_pointer (&priv->lease_db, nm_dhcp_lease_db_unref);
+
 	G_OBJECT_CLASS (nm_dhcp_manager_parent_class)->dispose (object);
 
 	nm_clear_g_free (&priv->default_hostname);
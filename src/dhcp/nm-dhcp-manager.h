@@ -41,6 +41,8 @@ NMDhcpManager *nm_dhcp_manager_get (void);
 
 const char *nm_dhcp_manager_get_config (NMDhcpManager *self);
 
+void nm_dhcp_manager_remove_leases (NMDhcpManager *self, const char *uuid);
+
 void           nm_dhcp_manager_set_default_hostname (NMDhcpManager *manager,
                                                      const char *hostname);
 
@@ -84,8 +86,35 @@ NMDhcpClient * nm_dhcp_manager_start_ip6     (NMDhcpManager *manager,
 /* For testing only */
 extern const char* nm_dhcp_helper_path;
 
-extern const NMDhcpClientFactory *const _nm_dhcp_manager_factories[4];
+extern const NMDhcpClientFactory *const _nm_dhcp_manager_factories[5];
 
 void nmtst_dhcp_manager_unget (gpointer singleton_instance);
 
+/* The start scheduler of the manager, exposed for testing. */
+typedef struct _NMDhcpStartSched NMDhcpStartSched;
+
+NMDhcpStartSched *nm_dhcp_start_sched_new (guint limit,
+                                           guint rate,
+                                           guint jitter_msec,
+                                           guint slot_hold_msec);
+
+void nm_dhcp_start_sched_free (NMDhcpStartSched *sched);
+
+void nm_dhcp_start_sched_queue (NMDhcpStartSched *sched,
+                                NMDhcpClient *client,
+                                GBytes *client_id,
+                                gboolean enforce_duid,
+                                const char *anycast_addr,
+                                const char *last_ip4_address,
+                                const struct in6_addr *ipv6_ll_addr,
+                                NMSettingIP6ConfigPrivacy privacy,
+                                guint needed_prefixes);
+
+void nm_dhcp_start_sched_finish (NMDhcpStartSched *sched,
+                                 NMDhcpClient *client);
+
+void nm_dhcp_start_sched_get_counts (const NMDhcpStartSched *sched,
+                                     guint *out_n_queued,
+                                     guint *out_n_running);
+
 #endif /* __NETWORKMANAGER_DHCP_MANAGER_H__ */
@@ -0,0 +1,1397 @@
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2019 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <net/ethernet.h>
+#include <net/if_arp.h>
+
+#include "nm-glib-aux/nm-dedup-multi.h"
+#include "nm-std-aux/unaligned.h"
+
+#include "nm-utils.h"
+#include "nm-core-internal.h"
+#include "nm-dhcp-utils.h"
+#include "nm-core-utils.h"
+#include "NetworkManagerUtils.h"
+#include "platform/nm-platform.h"
+#include "nm-dhcp-client-logging.h"
+#include "n-dhcp4/src/n-dhcp4.h"
+
+/*****************************************************************************/
+
+#define NM_TYPE_DHCP_NETTOOLS            (nm_dhcp_nettools_get_type ())
+#define NM_DHCP_NETTOOLS(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), NM_TYPE_DHCP_NETTOOLS, NMDhcpNettools))
+#define NM_DHCP_NETTOOLS_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), NM_TYPE_DHCP_NETTOOLS, NMDhcpNettoolsClass))
+#define NM_IS_DHCP_NETTOOLS(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NM_TYPE_DHCP_NETTOOLS))
+#define NM_IS_DHCP_NETTOOLS_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), NM_TYPE_DHCP_NETTOOLS))
+#define NM_DHCP_NETTOOLS_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), NM_TYPE_DHCP_NETTOOLS, NMDhcpNettoolsClass))
+
+typedef struct _NMDhcpNettools NMDhcpNettools;
+typedef struct _NMDhcpNettoolsClass NMDhcpNettoolsClass;
+
+static GType nm_dhcp_nettools_get_type (void);
+
+/*****************************************************************************/
+
+/* The packet socket shared by all clients, see nm_dhcp_nettools_set_shared_socket(). */
+typedef struct {
+	int ref_count;
+	NDhcp4ClientSocket *socket;
+	GIOChannel *channel;
+	guint event_id;
+	GHashTable *clients;
+} SharedSocket;
+
+typedef struct {
+	NDhcp4Client *client;
+	NDhcp4ClientProbe *probe;
+	NDhcp4ClientLease *lease;
+	GIOChannel *channel;
+	guint event_id;
+	SharedSocket *shared_socket;
+} NMDhcpNettoolsPrivate;
+
+struct _NMDhcpNettools {
+	NMDhcpClient parent;
+	NMDhcpNettoolsPrivate _priv;
+};
+
+struct _NMDhcpNettoolsClass {
+	NMDhcpClientClass parent;
+};
+
+G_DEFINE_TYPE (NMDhcpNettools, nm_dhcp_nettools, NM_TYPE_DHCP_CLIENT)
+
+#define NM_DHCP_NETTOOLS_GET_PRIVATE(self) _NM_GET_PRIVATE (self, NMDhcpNettools, NM_IS_DHCP_NETTOOLS)
+
+/*****************************************************************************/
+
+/* The option numbers are the same as in RFC 2132 and later. n-dhcp4 keeps
+ * its own enumeration in a private header, so spell out what we need. */
+#define DHCP_OPTION_SUBNET_MASK                     1
+#define DHCP_OPTION_TIME_OFFSET                     2
+#define DHCP_OPTION_ROUTER                          3
+#define DHCP_OPTION_DOMAIN_NAME_SERVER              6
+#define DHCP_OPTION_HOST_NAME                      12
+#define DHCP_OPTION_DOMAIN_NAME                    15
+#define DHCP_OPTION_ROOT_PATH                      17
+#define DHCP_OPTION_INTERFACE_MTU                  26
+#define DHCP_OPTION_BROADCAST                      28
+#define DHCP_OPTION_STATIC_ROUTE                   33
+#define DHCP_OPTION_NIS_DOMAIN                     40
+#define DHCP_OPTION_NIS_SERVERS                    41
+#define DHCP_OPTION_NTP_SERVER                     42
+#define DHCP_OPTION_VENDOR_SPECIFIC                43
+#define DHCP_OPTION_IP_ADDRESS_LEASE_TIME          51
+#define DHCP_OPTION_CLIENT_IDENTIFIER              61
+#define DHCP_OPTION_FQDN                           81
+#define DHCP_OPTION_DOMAIN_SEARCH_LIST            119
+#define DHCP_OPTION_CLASSLESS_STATIC_ROUTE        121
+#define DHCP_OPTION_PRIVATE_PROXY_AUTODISCOVERY   252
+
+/* Internal values */
+#define DHCP_OPTION_IP_ADDRESS                   1024
+
+/* sd-dhcp ignores an interface MTU smaller than the minimal
+ * DHCP message size. Do the same. */
+#define DHCP_MIN_MTU                              576
+
+typedef struct {
+	const char *name;
+	uint16_t option_num;
+	bool include;
+} ReqOption;
+
+#define REQPREFIX "requested_"
+
+#define REQ(_num, _name, _include) \
+	{ \
+		.name = REQPREFIX""_name, \
+		.option_num = _num, \
+		.include = _include, \
+	}
+
+static const ReqOption dhcp4_requests[] = {
+	REQ (DHCP_OPTION_SUBNET_MASK,                    "subnet_mask",                     TRUE ),
+	REQ (DHCP_OPTION_TIME_OFFSET,                    "time_offset",                     TRUE ),
+	REQ (DHCP_OPTION_DOMAIN_NAME_SERVER,             "domain_name_servers",             TRUE ),
+	REQ (DHCP_OPTION_HOST_NAME,                      "host_name",                       TRUE ),
+	REQ (DHCP_OPTION_DOMAIN_NAME,                    "domain_name",                     TRUE ),
+	REQ (DHCP_OPTION_INTERFACE_MTU,                  "interface_mtu",                   TRUE ),
+	REQ (DHCP_OPTION_BROADCAST,                      "broadcast_address",               TRUE ),
+
+	/* RFC 3442: The Classless Static Routes option code MUST appear in the parameter
+	 *   request list prior to both the Router option code and the Static
+	 *   Routes option code, if present. */
+	REQ (DHCP_OPTION_CLASSLESS_STATIC_ROUTE,         "rfc3442_classless_static_routes", TRUE ),
+	REQ (DHCP_OPTION_ROUTER,                         "routers",                         TRUE ),
+	REQ (DHCP_OPTION_STATIC_ROUTE,                   "static_routes",                   TRUE ),
+
+	REQ (DHCP_OPTION_NIS_DOMAIN,                     "nis_domain",                      TRUE ),
+	REQ (DHCP_OPTION_NIS_SERVERS,                    "nis_servers",                     TRUE ),
+	REQ (DHCP_OPTION_NTP_SERVER,                     "ntp_servers",                     TRUE ),
+	REQ (DHCP_OPTION_DOMAIN_SEARCH_LIST,             "domain_search",                   TRUE ),
+	REQ (DHCP_OPTION_PRIVATE_PROXY_AUTODISCOVERY,    "wpad",                            TRUE ),
+	REQ (DHCP_OPTION_ROOT_PATH,                      "root_path",                       TRUE ),
+	REQ (DHCP_OPTION_VENDOR_SPECIFIC,                "vendor_encapsulated_options",     FALSE ),
+
+	/* Internal values */
+	REQ (DHCP_OPTION_IP_ADDRESS_LEASE_TIME,          "expiry",                          FALSE ),
+	REQ (DHCP_OPTION_CLIENT_IDENTIFIER,              "dhcp_client_identifier",          FALSE ),
+	REQ (DHCP_OPTION_IP_ADDRESS,                     "ip_address",                      FALSE ),
+
+	{ 0 }
+};
+
+static void
+take_option (GHashTable *options,
+             const ReqOption *requests,
+             guint option,
+             char *value)
+{
+	guint i;
+
+	nm_assert (options);
+	nm_assert (requests);
+	nm_assert (value);
+
+	for (i = 0; requests[i].name; i++) {
+		nm_assert (g_str_has_prefix (requests[i].name, REQPREFIX));
+		if (requests[i].option_num == option) {
+			g_hash_table_insert (options,
+			                     (gpointer) (requests[i].name + NM_STRLEN (REQPREFIX)),
+			                     value);
+			return;
+		}
+	}
+
+	/* Option should always be found */
+	nm_assert_not_reached ();
+}
+
+static void
+add_option (GHashTable *options, const ReqOption *requests, guint option, const char *value)
+{
+	if (options)
+		take_option (options, requests, option, g_strdup (value));
+}
+
+static void
+add_option_u64 (GHashTable *options, const ReqOption *requests, guint option, guint64 value)
+{
+	if (options)
+		take_option (options, requests, option, g_strdup_printf ("%" G_GUINT64_FORMAT, value));
+}
+
+static void
+add_requests_to_options (GHashTable *options, const ReqOption *requests)
+{
+	guint i;
+
+	if (!options)
+		return;
+
+	for (i = 0; requests[i].name; i++) {
+		if (requests[i].include)
+			g_hash_table_insert (options, (gpointer) requests[i].name, g_strdup ("1"));
+	}
+}
+
+static GHashTable *
+create_options_dict (void)
+{
+	return g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, g_free);
+}
+
+/*****************************************************************************/
+
+static gboolean
+lease_get_in_addr (NDhcp4ClientLease *lease, guint8 option, in_addr_t *out_addr)
+{
+	guint8 *data;
+	size_t n_data;
+
+	if (   n_dhcp4_client_lease_query (lease, option, &data, &n_data)
+	    || n_data != sizeof (in_addr_t))
+		return FALSE;
+
+	memcpy (out_addr, data, sizeof (in_addr_t));
+	return TRUE;
+}
+
+static gboolean
+lease_get_in_addrs (NDhcp4ClientLease *lease, guint8 option, const guint8 **out_data, gsize *out_n_addrs)
+{
+	guint8 *data;
+	size_t n_data;
+
+	if (   n_dhcp4_client_lease_query (lease, option, &data, &n_data)
+	    || n_data == 0
+	    || n_data % sizeof (in_addr_t) != 0)
+		return FALSE;
+
+	*out_data = data;
+	*out_n_addrs = n_data / sizeof (in_addr_t);
+	return TRUE;
+}
+
+static char *
+lease_get_str (NDhcp4ClientLease *lease, guint8 option)
+{
+	guint8 *data;
+	size_t n_data;
+
+	if (   n_dhcp4_client_lease_query (lease, option, &data, &n_data)
+	    || n_data == 0)
+		return NULL;
+
+	/* some servers include the trailing NUL. */
+	if (data[n_data - 1] == '\0')
+		n_data--;
+
+	if (   n_data == 0
+	    || memchr (data, '\0', n_data)
+	    || !g_utf8_validate ((const char *) data, n_data, NULL))
+		return NULL;
+
+	return g_strndup ((const char *) data, n_data);
+}
+
+static gboolean
+lease_parse_domain_name (const guint8 *data,
+                         gsize n_data,
+                         gsize *offset,
+                         GString *str)
+{
+	gsize pos = *offset;
+	gsize end = 0;
+	guint n_jumps = 0;
+
+	nm_assert (str);
+
+	g_string_truncate (str, 0);
+
+	for (;;) {
+		guint8 c;
+
+		if (pos >= n_data)
+			return FALSE;
+
+		c = data[pos++];
+
+		if (c == 0) {
+			/* end of name */
+			break;
+		}
+
+		if ((c & 0xC0) == 0xC0) {
+			/* RFC 1035, section 4.1.4: message compression. The pointer is
+			 * relative to the start of the option data, see RFC 3397. */
+			if (pos >= n_data)
+				return FALSE;
+			if (end == 0)
+				end = pos + 1;
+			pos = ((gsize) (c & 0x3F) << 8) | data[pos];
+			if (++n_jumps > n_data)
+				return FALSE;
+			continue;
+		}
+
+		if (c & 0xC0) {
+			/* reserved label type */
+			return FALSE;
+		}
+
+		if (   pos + c > n_data
+		    || memchr (&data[pos], '\0', c)
+		    || memchr (&data[pos], '.', c))
+			return FALSE;
+
+		if (str->len > 0)
+			g_string_append_c (str, '.');
+		g_string_append_len (str, (const char *) &data[pos], c);
+		pos += c;
+	}
+
+	*offset = end ?: pos;
+	return str->len > 0;
+}
+
+static char **
+lease_get_domain_search (NDhcp4ClientLease *lease)
+{
+	nm_auto_free_gstring GString *str = NULL;
+	gs_unref_ptrarray GPtrArray *domains = NULL;
+	guint8 *data;
+	size_t n_data;
+	gsize offset = 0;
+
+	if (   n_dhcp4_client_lease_query (lease, DHCP_OPTION_DOMAIN_SEARCH_LIST, &data, &n_data)
+	    || n_data == 0)
+		return NULL;
+
+	str = g_string_sized_new (64);
+	domains = g_ptr_array_new_with_free_func (g_free);
+	while (offset < n_data) {
+		if (!lease_parse_domain_name (data, n_data, &offset, str))
+			return NULL;
+		if (g_utf8_validate (str->str, str->len, NULL))
+			g_ptr_array_add (domains, g_strdup (str->str));
+	}
+
+	if (domains->len == 0)
+		return NULL;
+
+	g_ptr_array_add (domains, NULL);
+	return (char **) g_ptr_array_free (g_steal_pointer (&domains), FALSE);
+}
+
+static gboolean
+lease_parse_address (NDhcp4ClientLease *lease,
+                     GHashTable *options,
+                     in_addr_t *out_address,
+                     guint *out_plen,
+                     guint32 *out_lifetime,
+                     GError **error)
+{
+	char addr_str[NM_UTILS_INET_ADDRSTRLEN];
+	struct in_addr a_address;
+	in_addr_t a_netmask;
+	guint64 nettools_lifetime;
+	gint64 now_boottime;
+	guint32 a_lifetime;
+
+	n_dhcp4_client_lease_get_yiaddr (lease, &a_address);
+	if (a_address.s_addr == INADDR_ANY) {
+		nm_utils_error_set_literal (error, NM_UTILS_ERROR_UNKNOWN, "could not get address from lease");
+		return FALSE;
+	}
+
+	if (!lease_get_in_addr (lease, DHCP_OPTION_SUBNET_MASK, &a_netmask)) {
+		nm_utils_error_set_literal (error, NM_UTILS_ERROR_UNKNOWN, "could not get netmask from lease");
+		return FALSE;
+	}
+
+	/* n-dhcp4 reports the end of the lease in CLOCK_BOOTTIME. */
+	n_dhcp4_client_lease_get_lifetime (lease, &nettools_lifetime);
+	if (nettools_lifetime == G_MAXUINT64)
+		a_lifetime = NM_PLATFORM_LIFETIME_PERMANENT;
+	else {
+		now_boottime = nm_utils_monotonic_timestamp_as_boottime (nm_utils_get_monotonic_timestamp_ns (), 1);
+		if (nettools_lifetime <= (guint64) now_boottime)
+			a_lifetime = 0;
+		else {
+			a_lifetime = NM_MIN ((nettools_lifetime - now_boottime) / NM_UTILS_NS_PER_SECOND,
+			                     (guint64) (NM_PLATFORM_LIFETIME_PERMANENT - 1));
+		}
+	}
+
+	if (a_lifetime == 0) {
+		nm_utils_error_set_literal (error, NM_UTILS_ERROR_UNKNOWN, "lease is already expired");
+		return FALSE;
+	}
+
+	nm_utils_inet4_ntop (a_address.s_addr, addr_str);
+	add_option (options, dhcp4_requests, DHCP_OPTION_IP_ADDRESS, addr_str);
+
+	add_option (options,
+	            dhcp4_requests,
+	            DHCP_OPTION_SUBNET_MASK,
+	            nm_utils_inet4_ntop (a_netmask, addr_str));
+
+	if (a_lifetime != NM_PLATFORM_LIFETIME_PERMANENT) {
+		add_option_u64 (options,
+		                dhcp4_requests,
+		                DHCP_OPTION_IP_ADDRESS_LEASE_TIME,
+		                (guint64) (time (NULL) + a_lifetime));
+	}
+
+	*out_address = a_address.s_addr;
+	*out_plen = nm_utils_ip4_netmask_to_prefix (a_netmask);
+	*out_lifetime = a_lifetime;
+	return TRUE;
+}
+
+static guint
+_in_addr_class_plen (in_addr_t addr)
+{
+	guint32 a = ntohl (addr);
+
+	/* RFC 2132, 5.8: the subnet mask of a static route is determined
+	 * by the class of the destination. */
+	if ((a >> 31) == 0)
+		return 8;
+	if ((a >> 30) == 2)
+		return 16;
+	if ((a >> 29) == 6)
+		return 24;
+	return 33;
+}
+
+#define LOG_LEASE(domain, ...) \
+G_STMT_START { \
+	if (log_lease) { \
+		_LOG2I ((domain), (iface), "  "__VA_ARGS__); \
+	} \
+} G_STMT_END
+
+static NMIP4Config *
+lease_to_ip4_config (NMDedupMultiIndex *multi_idx,
+                     const char *iface,
+                     int ifindex,
+                     NDhcp4ClientLease *lease,
+                     guint32 route_table,
+                     guint32 route_metric,
+                     gboolean log_lease,
+                     GHashTable **out_options,
+                     GError **error)
+{
+	gs_unref_object NMIP4Config *ip4_config = NULL;
+	gs_unref_hashtable GHashTable *options = NULL;
+	char addr_str[NM_UTILS_INET_ADDRSTRLEN];
+	nm_auto_free_gstring GString *str = NULL;
+	gs_strfreev char **search_domains = NULL;
+	gs_free char *s = NULL;
+	const guint8 *l_data;
+	gsize l_n;
+	guint8 *data;
+	size_t n_data;
+	gsize i;
+	gboolean metered = FALSE;
+	gboolean has_router_from_classless = FALSE;
+	gboolean has_classless_route = FALSE;
+	const gint32 ts = nm_utils_get_monotonic_timestamp_s ();
+	in_addr_t a_address;
+	guint a_plen;
+	guint32 a_lifetime;
+
+	g_return_val_if_fail (lease != NULL, NULL);
+
+	options = out_options ? create_options_dict () : NULL;
+
+	if (!lease_parse_address (lease, options, &a_address, &a_plen, &a_lifetime, error))
+		return NULL;
+
+	ip4_config = nm_ip4_config_new (multi_idx, ifindex);
+
+	LOG_LEASE (LOGD_DHCP4, "address %s", nm_utils_inet4_ntop (a_address, addr_str));
+	LOG_LEASE (LOGD_DHCP4, "plen %u", a_plen);
+	if (a_lifetime == NM_PLATFORM_LIFETIME_PERMANENT)
+		LOG_LEASE (LOGD_DHCP4, "lease is permanent");
+	else {
+		LOG_LEASE (LOGD_DHCP4, "expires in %u seconds (at %lld)",
+		           (guint) a_lifetime,
+		           (long long) (time (NULL) + a_lifetime));
+	}
+
+	nm_ip4_config_add_address (ip4_config,
+	                           &((const NMPlatformIP4Address) {
+	                               .address      = a_address,
+	                               .peer_address = a_address,
+	                               .plen         = a_plen,
+	                               .addr_source  = NM_IP_CONFIG_SOURCE_DHCP,
+	                               .timestamp    = ts,
+	                               .lifetime     = a_lifetime,
+	                               .preferred    = a_lifetime,
+	                           }));
+
+	if (lease_get_in_addrs (lease, DHCP_OPTION_DOMAIN_NAME_SERVER, &l_data, &l_n)) {
+		nm_gstring_prepare (&str);
+		for (i = 0; i < l_n; i++) {
+			in_addr_t addr = unaligned_read_ne32 (&l_data[i * 4]);
+
+			nm_utils_inet4_ntop (addr, addr_str);
+			g_string_append (nm_gstring_add_space_delimiter (str), addr_str);
+
+			if (   addr == 0
+			    || nm_ip4_addr_is_localhost (addr)) {
+				/* Skip localhost addresses, like also networkd does.
+				 * See https://github.com/systemd/systemd/issues/4524. */
+				continue;
+			}
+			nm_ip4_config_add_nameserver (ip4_config, addr);
+		}
+		LOG_LEASE (LOGD_DHCP4, "nameserver '%s'", str->str);
+		add_option (options, dhcp4_requests, DHCP_OPTION_DOMAIN_NAME_SERVER, str->str);
+	}
+
+	search_domains = lease_get_domain_search (lease);
+	if (search_domains) {
+		nm_gstring_prepare (&str);
+		for (i = 0; search_domains[i]; i++) {
+			g_string_append (nm_gstring_add_space_delimiter (str), search_domains[i]);
+			nm_ip4_config_add_search (ip4_config, search_domains[i]);
+		}
+		LOG_LEASE (LOGD_DHCP4, "domain search '%s'", str->str);
+		add_option (options, dhcp4_requests, DHCP_OPTION_DOMAIN_SEARCH_LIST, str->str);
+	}
+
+	s = lease_get_str (lease, DHCP_OPTION_DOMAIN_NAME);
+	if (s) {
+		gs_free const char **domains = NULL;
+		const char *const*d;
+
+		LOG_LEASE (LOGD_DHCP4, "domain name '%s'", s);
+		add_option (options, dhcp4_requests, DHCP_OPTION_DOMAIN_NAME, s);
+
+		/* Multiple domains sometimes stuffed into option 15 "Domain Name". */
+		domains = nm_utils_strsplit_set (s, " ");
+		for (d = domains; d && *d; d++)
+			nm_ip4_config_add_domain (ip4_config, *d);
+	}
+	nm_clear_g_free (&s);
+
+	s = lease_get_str (lease, DHCP_OPTION_HOST_NAME);
+	if (s) {
+		LOG_LEASE (LOGD_DHCP4, "hostname '%s'", s);
+		add_option (options, dhcp4_requests, DHCP_OPTION_HOST_NAME, s);
+	}
+	nm_clear_g_free (&s);
+
+	if (   !n_dhcp4_client_lease_query (lease, DHCP_OPTION_CLASSLESS_STATIC_ROUTE, &data, &n_data)
+	    && n_data > 0) {
+		guint32 default_route_metric = route_metric;
+		gsize pos = 0;
+
+		has_classless_route = TRUE;
+		nm_gstring_prepare (&str);
+
+		/* RFC 3442: each route is a prefix length, the significant octets
+		 * of the destination and the router address. */
+		while (pos < n_data) {
+			char network_net_str[NM_UTILS_INET_ADDRSTRLEN];
+			char gateway_str[NM_UTILS_INET_ADDRSTRLEN];
+			guint8 r_plen;
+			guint n_octets;
+			in_addr_t r_network = 0;
+			in_addr_t r_gateway;
+			in_addr_t network_net;
+			guint32 m;
+
+			r_plen = data[pos++];
+			if (r_plen > 32)
+				break;
+			n_octets = (r_plen + 7) / 8;
+			if (pos + n_octets + 4 > n_data)
+				break;
+			memcpy (&r_network, &data[pos], n_octets);
+			pos += n_octets;
+			memcpy (&r_gateway, &data[pos], 4);
+			pos += 4;
+
+			network_net = nm_utils_ip4_address_clear_host_address (r_network, r_plen);
+			nm_utils_inet4_ntop (network_net, network_net_str);
+			nm_utils_inet4_ntop (r_gateway, gateway_str);
+
+			LOG_LEASE (LOGD_DHCP4,
+			           "classless static route %s/%d gw %s",
+			           network_net_str,
+			           (int) r_plen,
+			           gateway_str);
+			g_string_append_printf (nm_gstring_add_space_delimiter (str),
+			                        "%s/%d %s",
+			                        network_net_str,
+			                        (int) r_plen,
+			                        gateway_str);
+
+			if (r_plen == 0) {
+				/* if there are multiple default routes, we add them with differing
+				 * metrics. */
+				m = default_route_metric;
+				if (default_route_metric < G_MAXUINT32)
+					default_route_metric++;
+
+				has_router_from_classless = TRUE;
+			} else
+				m = route_metric;
+
+			nm_ip4_config_add_route (ip4_config,
+			                         &((const NMPlatformIP4Route) {
+			                             .network       = network_net,
+			                             .plen          = r_plen,
+			                             .gateway       = r_gateway,
+			                             .rt_source     = NM_IP_CONFIG_SOURCE_DHCP,
+			                             .metric        = m,
+			                             .table_coerced = nm_platform_route_table_coerce (route_table),
+			                         }),
+			                         NULL);
+		}
+
+		if (str->len > 0)
+			add_option (options, dhcp4_requests, DHCP_OPTION_CLASSLESS_STATIC_ROUTE, str->str);
+	}
+
+	if (lease_get_in_addrs (lease, DHCP_OPTION_STATIC_ROUTE, &l_data, &l_n)) {
+		nm_gstring_prepare (&str);
+		for (i = 0; i + 1 < l_n; i += 2) {
+			char network_net_str[NM_UTILS_INET_ADDRSTRLEN];
+			char gateway_str[NM_UTILS_INET_ADDRSTRLEN];
+			in_addr_t r_network = unaligned_read_ne32 (&l_data[i * 4]);
+			in_addr_t r_gateway = unaligned_read_ne32 (&l_data[(i + 1) * 4]);
+			guint r_plen;
+
+			r_plen = _in_addr_class_plen (r_network);
+			if (r_plen > 32)
+				continue;
+
+			nm_utils_inet4_ntop (r_network, network_net_str);
+			nm_utils_inet4_ntop (r_gateway, gateway_str);
+
+			LOG_LEASE (LOGD_DHCP4,
+			           "static route %s/%d gw %s",
+			           network_net_str,
+			           (int) r_plen,
+			           gateway_str);
+			g_string_append_printf (nm_gstring_add_space_delimiter (str),
+			                        "%s/%d %s",
+			                        network_net_str,
+			                        (int) r_plen,
+			                        gateway_str);
+
+			if (has_classless_route) {
+				/* RFC 3443: if the DHCP server returns both a Classless Static Routes
+				 * option and a Static Routes option, the DHCP client MUST ignore the
+				 * Static Routes option. */
+				continue;
+			}
+
+			if (r_network == INADDR_ANY) {
+				/* for option 33 (static route), RFC 2132 says:
+				 *
+				 * The default route (0.0.0.0) is an illegal destination for a static
+				 * route. */
+				continue;
+			}
+
+			nm_ip4_config_add_route (ip4_config,
+			                         &((const NMPlatformIP4Route) {
+			                             .network       = nm_utils_ip4_address_clear_host_address (r_network, r_plen),
+			                             .plen          = r_plen,
+			                             .gateway       = r_gateway,
+			                             .rt_source     = NM_IP_CONFIG_SOURCE_DHCP,
+			                             .metric        = route_metric,
+			                             .table_coerced = nm_platform_route_table_coerce (route_table),
+			                         }),
+			                         NULL);
+		}
+
+		if (str->len > 0)
+			add_option (options, dhcp4_requests, DHCP_OPTION_STATIC_ROUTE, str->str);
+	}
+
+	if (lease_get_in_addrs (lease, DHCP_OPTION_ROUTER, &l_data, &l_n)) {
+		guint32 default_route_metric = route_metric;
+
+		nm_gstring_prepare (&str);
+		for (i = 0; i < l_n; i++) {
+			in_addr_t gateway = unaligned_read_ne32 (&l_data[i * 4]);
+			guint32 m;
+
+			g_string_append (nm_gstring_add_space_delimiter (str),
+			                 nm_utils_inet4_ntop (gateway, addr_str));
+
+			if (gateway == 0) {
+				/* silently skip 0.0.0.0 */
+				continue;
+			}
+
+			if (has_router_from_classless) {
+				/* If the DHCP server returns both a Classless Static Routes option and a
+				 * Router option, the DHCP client MUST ignore the Router option [RFC 3442].
+				 *
+				 * Be more lenient and ignore the Router option only if Classless Static
+				 * Routes contain a default gateway (as other DHCP backends do).
+				 */
+				continue;
+			}
+
+			/* if there are multiple default routes, we add them with differing
+			 * metrics. */
+			m = default_route_metric;
+			if (default_route_metric < G_MAXUINT32)
+				default_route_metric++;
+
+			nm_ip4_config_add_route (ip4_config,
+			                         &((const NMPlatformIP4Route) {
+			                             .rt_source     = NM_IP_CONFIG_SOURCE_DHCP,
+			                             .gateway       = gateway,
+			                             .table_coerced = nm_platform_route_table_coerce (route_table),
+			                             .metric        = m,
+			                         }),
+			                         NULL);
+		}
+		LOG_LEASE (LOGD_DHCP4, "router %s", str->str);
+		add_option (options, dhcp4_requests, DHCP_OPTION_ROUTER, str->str);
+	}
+
+	if (   !n_dhcp4_client_lease_query (lease, DHCP_OPTION_INTERFACE_MTU, &data, &n_data)
+	    && n_data == 2) {
+		guint16 mtu = unaligned_read_be16 (data);
+
+		if (mtu >= DHCP_MIN_MTU) {
+			LOG_LEASE (LOGD_DHCP4, "mtu %u", mtu);
+			add_option_u64 (options, dhcp4_requests, DHCP_OPTION_INTERFACE_MTU, mtu);
+			nm_ip4_config_set_mtu (ip4_config, mtu, NM_IP_CONFIG_SOURCE_DHCP);
+		}
+	}
+
+	if (lease_get_in_addrs (lease, DHCP_OPTION_NTP_SERVER, &l_data, &l_n)) {
+		nm_gstring_prepare (&str);
+		for (i = 0; i < l_n; i++) {
+			g_string_append (nm_gstring_add_space_delimiter (str),
+			                 nm_utils_inet4_ntop (unaligned_read_ne32 (&l_data[i * 4]), addr_str));
+		}
+		LOG_LEASE (LOGD_DHCP4, "ntp server '%s'", str->str);
+		add_option (options, dhcp4_requests, DHCP_OPTION_NTP_SERVER, str->str);
+	}
+
+	s = lease_get_str (lease, DHCP_OPTION_ROOT_PATH);
+	if (s) {
+		LOG_LEASE (LOGD_DHCP4, "root path '%s'", s);
+		add_option (options, dhcp4_requests, DHCP_OPTION_ROOT_PATH, s);
+	}
+	nm_clear_g_free (&s);
+
+	s = lease_get_str (lease, DHCP_OPTION_PRIVATE_PROXY_AUTODISCOVERY);
+	if (s) {
+		LOG_LEASE (LOGD_DHCP4, "wpad '%s'", s);
+		add_option (options, dhcp4_requests, DHCP_OPTION_PRIVATE_PROXY_AUTODISCOVERY, s);
+	}
+	nm_clear_g_free (&s);
+
+	if (   !n_dhcp4_client_lease_query (lease, DHCP_OPTION_VENDOR_SPECIFIC, &data, &n_data)
+	    && n_data > 0)
+		metered = !!memmem (data, n_data, "ANDROID_METERED", NM_STRLEN ("ANDROID_METERED"));
+	nm_ip4_config_set_metered (ip4_config, metered);
+
+	NM_SET_OUT (out_options, g_steal_pointer (&options));
+	return g_steal_pointer (&ip4_config);
+}
+
+/*****************************************************************************/
+
+static void
+bound4_handle (NMDhcpNettools *self, NDhcp4ClientLease *lease)
+{
+	const char *iface = nm_dhcp_client_get_iface (NM_DHCP_CLIENT (self));
+	gs_unref_object NMIP4Config *ip4_config = NULL;
+	gs_unref_hashtable GHashTable *options = NULL;
+	GError *error = NULL;
+
+	_LOGD ("lease available");
+
+	ip4_config = lease_to_ip4_config (nm_dhcp_client_get_multi_idx (NM_DHCP_CLIENT (self)),
+	                                  iface,
+	                                  nm_dhcp_client_get_ifindex (NM_DHCP_CLIENT (self)),
+	                                  lease,
+	                                  nm_dhcp_client_get_route_table (NM_DHCP_CLIENT (self)),
+	                                  nm_dhcp_client_get_route_metric (NM_DHCP_CLIENT (self)),
+	                                  TRUE,
+	                                  &options,
+	                                  &error);
+	if (!ip4_config) {
+		_LOGW ("%s", error->message);
+		g_clear_error (&error);
+		nm_dhcp_client_set_state (NM_DHCP_CLIENT (self), NM_DHCP_STATE_FAIL, NULL, NULL);
+		return;
+	}
+
+	add_requests_to_options (options, dhcp4_requests);
+
+	nm_dhcp_client_set_state (NM_DHCP_CLIENT (self),
+	                          NM_DHCP_STATE_BOUND,
+	                          NM_IP_CONFIG_CAST (ip4_config),
+	                          options);
+}
+
+static void
+dhcp4_event_handle (NMDhcpNettools *self,
+                    NDhcp4ClientEvent *event)
+{
+	NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE (self);
+	char addr_str[NM_UTILS_INET_ADDRSTRLEN];
+	struct in_addr yiaddr;
+	int r;
+
+	_LOGT ("client event %d", event->event);
+
+	switch (event->event) {
+	case N_DHCP4_CLIENT_EVENT_OFFER:
+		n_dhcp4_client_lease_get_yiaddr (event->offer.lease, &yiaddr);
+		_LOGD ("selecting offered address %s",
+		       nm_utils_inet4_ntop (yiaddr.s_addr, addr_str));
+		r = n_dhcp4_client_lease_select (event->offer.lease);
+		if (r)
+			_LOGW ("failed to select lease (%d)", r);
+		break;
+	case N_DHCP4_CLIENT_EVENT_GRANTED:
+		r = n_dhcp4_client_lease_accept (event->granted.lease);
+		if (r) {
+			_LOGW ("failed to accept lease (%d)", r);
+			nm_dhcp_client_set_state (NM_DHCP_CLIENT (self), NM_DHCP_STATE_FAIL, NULL, NULL);
+			break;
+		}
+		n_dhcp4_client_lease_unref (priv->lease);
+		priv->lease = n_dhcp4_client_lease_ref (event->granted.lease);
+		bound4_handle (self, priv->lease);
+		break;
+	case N_DHCP4_CLIENT_EVENT_EXTENDED:
+		n_dhcp4_client_lease_unref (priv->lease);
+		priv->lease = n_dhcp4_client_lease_ref (event->extended.lease);
+		bound4_handle (self, priv->lease);
+		break;
+	case N_DHCP4_CLIENT_EVENT_RETRACTED:
+	case N_DHCP4_CLIENT_EVENT_EXPIRED:
+		nm_clear_pointer (&priv->lease, n_dhcp4_client_lease_unref);
+		nm_dhcp_client_set_state (NM_DHCP_CLIENT (self), NM_DHCP_STATE_EXPIRE, NULL, NULL);
+		break;
+	case N_DHCP4_CLIENT_EVENT_CANCELLED:
+		nm_clear_pointer (&priv->lease, n_dhcp4_client_lease_unref);
+		nm_dhcp_client_set_state (NM_DHCP_CLIENT (self), NM_DHCP_STATE_FAIL, NULL, NULL);
+		break;
+	case N_DHCP4_CLIENT_EVENT_DOWN:
+		/* purely informational, the probe keeps running. */
+		_LOGD ("interface went down");
+		break;
+	default:
+		_LOGW ("unhandled DHCP event %d", event->event);
+		break;
+	}
+}
+
+static void
+dhcp4_pop_events (NMDhcpNettools *self)
+{
+	NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE (self);
+	gs_unref_object NMDhcpNettools *self_keep_alive = NULL;
+	NDhcp4ClientEvent *event;
+
+	/* handling an event may cause the owner to drop the last reference. */
+	self_keep_alive = g_object_ref (self);
+
+	while (   priv->client
+	       && !n_dhcp4_client_pop_event (priv->client, &event)
+	       && event)
+		dhcp4_event_handle (self, event);
+}
+
+static gboolean
+dhcp4_event_cb (GIOChannel *source, GIOCondition condition, gpointer data)
+{
+	NMDhcpNettools *self = data;
+	NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE (self);
+	int r;
+
+	r = n_dhcp4_client_dispatch (priv->client);
+	if (r < 0) {
+		/* N_DHCP4_E_PREEMPTED is positive and only tells us that there is more
+		 * to do. Our watch is level-triggered, so we will be called again. */
+		_LOGW ("error %d dispatching events", r);
+		priv->event_id = 0;
+		nm_dhcp_client_set_state (NM_DHCP_CLIENT (self), NM_DHCP_STATE_FAIL, NULL, NULL);
+		return G_SOURCE_REMOVE;
+	}
+
+	dhcp4_pop_events (self);
+	return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************/
+
+static gboolean shared_socket_enabled;
+static SharedSocket *shared_socket_singleton;
+
+/**
+ * nm_dhcp_nettools_set_shared_socket:
+ * @enabled: whether clients share a packet socket
+ *
+ * Until a client has an address, n-dhcp4 receives the replies on an AF_PACKET
+ * socket bound to the interface. With many interfaces, each of these sockets
+ * runs its filter on every IPv4 packet of its interface and needs its own
+ * watch. When enabled, all clients created afterwards use one unbound packet
+ * socket instead, and n-dhcp4 passes each reply to the client by ifindex
+ * and transaction id.
+ */
+void
+nm_dhcp_nettools_set_shared_socket (gboolean enabled)
+{
+	shared_socket_enabled = enabled;
+}
+
+static SharedSocket *
+shared_socket_ref (SharedSocket *shared)
+{
+	nm_assert (shared && shared->ref_count > 0);
+
+	shared->ref_count++;
+	return shared;
+}
+
+static void
+shared_socket_unref (SharedSocket *shared)
+{
+	nm_assert (shared && shared->ref_count > 0);
+
+	if (--shared->ref_count > 0)
+		return;
+
+	nm_assert (g_hash_table_size (shared->clients) == 0);
+
+	if (shared_socket_singleton == shared)
+		shared_socket_singleton = NULL;
+
+	nm_clear_g_source (&shared->event_id);
+	nm_clear_pointer (&shared->channel, g_io_channel_unref);
+	n_dhcp4_client_socket_unref (shared->socket);
+	g_hash_table_unref (shared->clients);
+	g_slice_free (SharedSocket, shared);
+}
+
+static gboolean
+shared_socket_event_cb (GIOChannel *source, GIOCondition condition, gpointer data)
+{
+	SharedSocket *shared = data;
+	NMDhcpNettools *self;
+	NDhcp4Client *client;
+	int r;
+
+	/* handling the events of the last client may release the socket. */
+	shared_socket_ref (shared);
+
+	for (;;) {
+		r = n_dhcp4_client_socket_dispatch (shared->socket, &client);
+		if (!client)
+			break;
+
+		self = g_hash_table_lookup (shared->clients, client);
+		if (!self)
+			continue;
+
+		if (r < 0) {
+			_LOGW ("error %d dispatching events", r);
+			nm_dhcp_client_set_state (NM_DHCP_CLIENT (self), NM_DHCP_STATE_FAIL, NULL, NULL);
+			continue;
+		}
+
+		dhcp4_pop_events (self);
+	}
+
+	if (r < 0) {
+		gs_unref_ptrarray GPtrArray *clients = NULL;
+		GHashTableIter iter;
+		guint i;
+
+		nm_log_warn (LOGD_DHCP4, "dhcp4: error %d dispatching shared socket", r);
+		shared->event_id = 0;
+
+		/* the socket no longer receives anything. Don't hand it out to new
+		 * clients, they get a new socket instead. */
+		if (shared_socket_singleton == shared)
+			shared_socket_singleton = NULL;
+
+		/* and fail the clients that use it, instead of letting them wait
+		 * for replies that never arrive. Failing a client may release it,
+		 * so don't iterate the hash while doing so. */
+		clients = g_ptr_array_new_with_free_func (g_object_unref);
+		g_hash_table_iter_init (&iter, shared->clients);
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &self))
+			g_ptr_array_add (clients, g_object_ref (self));
+		for (i = 0; i < clients->len; i++)
+			nm_dhcp_client_set_state (clients->pdata[i], NM_DHCP_STATE_FAIL, NULL, NULL);
+
+		shared_socket_unref (shared);
+		return G_SOURCE_REMOVE;
+	}
+
+	shared_socket_unref (shared);
+	return G_SOURCE_CONTINUE;
+}
+
+static SharedSocket *
+shared_socket_acquire (GError **error)
+{
+	SharedSocket *shared;
+	NDhcp4ClientSocket *client_socket;
+	int r, fd;
+
+	if (shared_socket_singleton)
+		return shared_socket_ref (shared_socket_singleton);
+
+	r = n_dhcp4_client_socket_new (&client_socket);
+	if (r) {
+		nm_utils_error_set_errno (error, r, "failed to create shared packet socket: %s");
+		return NULL;
+	}
+
+	shared = g_slice_new0 (SharedSocket);
+	shared->ref_count = 1;
+	shared->socket = client_socket;
+	shared->clients = g_hash_table_new (nm_direct_hash, NULL);
+
+	n_dhcp4_client_socket_get_fd (client_socket, &fd);
+	shared->channel = g_io_channel_unix_new (fd);
+	shared->event_id = g_io_add_watch (shared->channel, G_IO_IN, shared_socket_event_cb, shared);
+
+	shared_socket_singleton = shared;
+	return shared;
+}
+
+static void
+shared_socket_remove_client (NMDhcpNettools *self)
+{
+	NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE (self);
+	SharedSocket *shared = g_steal_pointer (&priv->shared_socket);
+
+	if (!shared)
+		return;
+
+	if (priv->client)
+		g_hash_table_remove (shared->clients, priv->client);
+	shared_socket_unref (shared);
+}
+
+static gboolean
+nettools_create (NMDhcpNettools *self,
+                 GBytes *client_id,
+                 const char *dhcp_anycast_addr,
+                 GError **error)
+{
+	NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE (self);
+	nm_auto (n_dhcp4_client_config_freep) NDhcp4ClientConfig *config = NULL;
+	nm_auto (n_dhcp4_client_unrefp) NDhcp4Client *client = NULL;
+	const NMPlatformLink *plink;
+	GBytes *hwaddr;
+	const uint8_t *hwaddr_arr;
+	gsize hwaddr_len;
+	const uint8_t *broadcast_arr = NULL;
+	gsize broadcast_len = 0;
+	guint8 anycast_arr[NM_UTILS_HWADDR_LEN_MAX];
+	gsize anycast_len;
+	const uint8_t *client_id_arr;
+	size_t client_id_len;
+	int ifindex;
+	int r, fd, arp_type, transport;
+
+	g_return_val_if_fail (!priv->client, FALSE);
+
+	hwaddr = nm_dhcp_client_get_hw_addr (NM_DHCP_CLIENT (self));
+	if (   !hwaddr
+	    || !(hwaddr_arr = g_bytes_get_data (hwaddr, &hwaddr_len))
+	    || (arp_type = nm_utils_arp_type_detect_from_hwaddrlen (hwaddr_len)) < 0) {
+		nm_utils_error_set_literal (error, NM_UTILS_ERROR_UNKNOWN, "invalid MAC address");
+		return FALSE;
+	}
+
+	ifindex = nm_dhcp_client_get_ifindex (NM_DHCP_CLIENT (self));
+
+	/* n-dhcp4 needs the link-layer broadcast address, which for infiniband
+	 * depends on the partition. Take it from the platform cache. */
+	plink = nm_platform_link_get (NM_PLATFORM_GET, ifindex);
+	if (   plink
+	    && plink->l_broadcast.len == hwaddr_len) {
+		broadcast_arr = plink->l_broadcast.data;
+		broadcast_len = plink->l_broadcast.len;
+	}
+
+	switch (arp_type) {
+	case ARPHRD_ETHER:
+		transport = N_DHCP4_TRANSPORT_ETHERNET;
+		if (!broadcast_arr) {
+			broadcast_arr = (const uint8_t[ETH_ALEN]) { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+			broadcast_len = ETH_ALEN;
+		}
+		break;
+	case ARPHRD_INFINIBAND:
+		transport = N_DHCP4_TRANSPORT_INFINIBAND;
+		if (!broadcast_arr) {
+			nm_utils_error_set_literal (error, NM_UTILS_ERROR_UNKNOWN, "unknown broadcast address");
+			return FALSE;
+		}
+		break;
+	default:
+		nm_utils_error_set_literal (error, NM_UTILS_ERROR_UNKNOWN, "unsupported ARP type");
+		return FALSE;
+	}
+
+	/* like dhclient's "anycast-mac", the anycast address replaces the
+	 * link-layer broadcast address as destination of our requests. */
+	if (dhcp_anycast_addr) {
+		if (   _nm_utils_hwaddr_aton (dhcp_anycast_addr, anycast_arr, sizeof (anycast_arr), &anycast_len)
+		    && anycast_len == hwaddr_len) {
+			broadcast_arr = anycast_arr;
+			broadcast_len = anycast_len;
+		} else
+			_LOGW ("ignoring invalid dhcp-anycast-address \"%s\"", dhcp_anycast_addr);
+	}
+
+	if (   !(client_id_arr = g_bytes_get_data (client_id, &client_id_len))
+	    || client_id_len < 2) {
+
+		/* invalid client-ids are not expected. */
+		nm_assert_not_reached ();
+
+		nm_utils_error_set_literal (error, NM_UTILS_ERROR_UNKNOWN, "no valid IPv4 client-id");
+		return FALSE;
+	}
+
+	r = n_dhcp4_client_config_new (&config);
+	if (r) {
+		nm_utils_error_set_errno (error, r, "failed to create client-config: %s");
+		return FALSE;
+	}
+
+	if (shared_socket_enabled) {
+		if (!priv->shared_socket) {
+			priv->shared_socket = shared_socket_acquire (error);
+			if (!priv->shared_socket)
+				return FALSE;
+		}
+		n_dhcp4_client_config_set_socket (config, priv->shared_socket->socket);
+	}
+
+	n_dhcp4_client_config_set_ifindex (config, ifindex);
+	n_dhcp4_client_config_set_transport (config, transport);
+	n_dhcp4_client_config_set_mac (config, hwaddr_arr, hwaddr_len);
+	n_dhcp4_client_config_set_broadcast_mac (config, broadcast_arr, broadcast_len);
+
+	/* Note that we always set a client-id. In particular for infiniband that is necessary,
+	 * see https://tools.ietf.org/html/rfc4390#section-2.1 . */
+	r = n_dhcp4_client_config_set_client_id (config, client_id_arr, client_id_len);
+	if (r) {
+		nm_utils_error_set_errno (error, r, "failed to set client-id: %s");
+		return FALSE;
+	}
+
+	r = n_dhcp4_client_new (&client, config);
+	if (r) {
+		if (r < 0)
+			nm_utils_error_set_errno (error, r, "failed to create client: %s");
+		else
+			nm_utils_error_set (error, NM_UTILS_ERROR_UNKNOWN, "failed to create client (%d)", r);
+		return FALSE;
+	}
+
+	priv->client = g_steal_pointer (&client);
+
+	if (priv->shared_socket)
+		g_hash_table_insert (priv->shared_socket->clients, priv->client, self);
+
+	n_dhcp4_client_get_fd (priv->client, &fd);
+	priv->channel = g_io_channel_unix_new (fd);
+	priv->event_id = g_io_add_watch (priv->channel, G_IO_IN, dhcp4_event_cb, self);
+
+	return TRUE;
+}
+
+static gboolean
+_append_hostname_option (NDhcp4ClientProbeConfig *config,
+                         const char *hostname,
+                         gboolean use_fqdn,
+                         GError **error)
+{
+	gsize len;
+	int r;
+
+	len = strlen (hostname);
+
+	if (use_fqdn) {
+		guint8 buffer[255];
+
+		/* RFC 4702, section 2: flags (S: the server should update the A
+		 * record), two deprecated RCODE fields and the name in ASCII encoding. */
+		if (len + 3 > sizeof (buffer)) {
+			nm_utils_error_set_literal (error, NM_UTILS_ERROR_UNKNOWN, "DHCP FQDN is too long");
+			return FALSE;
+		}
+		buffer[0] = 0x01;
+		buffer[1] = 0;
+		buffer[2] = 0;
+		memcpy (&buffer[3], hostname, len);
+		r = n_dhcp4_client_probe_config_append_option (config, DHCP_OPTION_FQDN, buffer, len + 3);
+	} else {
+		if (len > 255) {
+			nm_utils_error_set_literal (error, NM_UTILS_ERROR_UNKNOWN, "DHCP hostname is too long");
+			return FALSE;
+		}
+		r = n_dhcp4_client_probe_config_append_option (config, DHCP_OPTION_HOST_NAME, hostname, len);
+	}
+
+	if (r) {
+		nm_utils_error_set (error, NM_UTILS_ERROR_UNKNOWN, "failed to set DHCP hostname (%d)", r);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+ip4_start (NMDhcpClient *client,
+           const char *dhcp_anycast_addr,
+           const char *last_ip4_address,
+           GError **error)
+{
+	NMDhcpNettools *self = NM_DHCP_NETTOOLS (client);
+	NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE (self);
+	nm_auto (n_dhcp4_client_probe_config_freep) NDhcp4ClientProbeConfig *config = NULL;
+	GBytes *client_id;
+	gs_unref_bytes GBytes *client_id_new = NULL;
+	struct in_addr last_addr = { 0 };
+	const char *hostname;
+	int r, i;
+
+	g_return_val_if_fail (!priv->probe, FALSE);
+
+	client_id = nm_dhcp_client_get_client_id (client);
+	if (!client_id) {
+		GBytes *hwaddr = nm_dhcp_client_get_hw_addr (client);
+		const guint8 *hwaddr_arr;
+		gsize hwaddr_len;
+		int arp_type;
+
+		if (   !hwaddr
+		    || !(hwaddr_arr = g_bytes_get_data (hwaddr, &hwaddr_len))
+		    || (arp_type = nm_utils_arp_type_detect_from_hwaddrlen (hwaddr_len)) < 0) {
+			nm_utils_error_set_literal (error, NM_UTILS_ERROR_UNKNOWN, "invalid MAC address");
+			return FALSE;
+		}
+		client_id_new = nm_utils_dhcp_client_id_mac (arp_type, hwaddr_arr, hwaddr_len);
+		client_id = client_id_new;
+	}
+
+	if (!priv->client) {
+		if (!nettools_create (self, client_id, dhcp_anycast_addr, error))
+			return FALSE;
+	}
+
+	r = n_dhcp4_client_probe_config_new (&config);
+	if (r) {
+		nm_utils_error_set_errno (error, r, "failed to create dhcp-client-probe-config: %s");
+		return FALSE;
+	}
+
+	/* NetworkManager already delays activation as needed, don't add the
+	 * randomized delay of up to 9 seconds from RFC 2131, section 4.4.1. */
+	n_dhcp4_client_probe_config_set_start_delay (config, 1);
+
+	if (last_ip4_address)
+		inet_pton (AF_INET, last_ip4_address, &last_addr);
+	if (last_addr.s_addr) {
+		n_dhcp4_client_probe_config_set_requested_ip (config, last_addr);
+		n_dhcp4_client_probe_config_set_init_reboot (config, TRUE);
+	}
+
+	/* Add requested options */
+	for (i = 0; dhcp4_requests[i].name; i++) {
+		if (dhcp4_requests[i].include) {
+			nm_assert (dhcp4_requests[i].option_num <= 255);
+			n_dhcp4_client_probe_config_request_option (config, dhcp4_requests[i].option_num);
+		}
+	}
+
+	hostname = nm_dhcp_client_get_hostname (client);
+	if (hostname) {
+		if (!_append_hostname_option (config,
+		                              hostname,
+		                              nm_dhcp_client_get_use_fqdn (client),
+		                              error))
+			return FALSE;
+	}
+
+	r = n_dhcp4_client_probe (priv->client, &priv->probe, config);
+	if (r) {
+		if (r < 0)
+			nm_utils_error_set_errno (error, r, "failed to start DHCP client: %s");
+		else
+			nm_utils_error_set (error, NM_UTILS_ERROR_UNKNOWN, "failed to start DHCP client (%d)", r);
+		return FALSE;
+	}
+
+	_LOGT ("dhcp-client4: start %p", (gpointer) priv->client);
+
+	nm_dhcp_client_set_client_id (client, client_id);
+
+	nm_dhcp_client_start_timeout (client);
+	return TRUE;
+}
+
+static void
+stop (NMDhcpClient *client, gboolean release)
+{
+	NMDhcpNettools *self = NM_DHCP_NETTOOLS (client);
+	NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE (self);
+
+	NM_DHCP_CLIENT_CLASS (nm_dhcp_nettools_parent_class)->stop (client, release);
+
+	_LOGT ("dhcp-client4: stop %p", (gpointer) priv->client);
+
+	if (   release
+	    && priv->probe) {
+		int r;
+
+		/* the probe only sends the release when it has a lease. */
+		r = n_dhcp4_client_probe_release (priv->probe);
+		if (r)
+			_LOGW ("failed to send DHCPRELEASE (%d)", r);
+	}
+
+	nm_clear_pointer (&priv->lease, n_dhcp4_client_lease_unref);
+	priv->probe = n_dhcp4_client_probe_free (priv->probe);
+}
+
+/*****************************************************************************/
+
+static void
+nm_dhcp_nettools_init (NMDhcpNettools *self)
+{
+}
+
+static void
+dispose (GObject *object)
+{
+	NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE ((NMDhcpNettools *) object);
+
+	nm_clear_g_source (&priv->event_id);
+	nm_clear_pointer (&priv->channel, g_io_channel_unref);
+
+	nm_clear_pointer (&priv->lease, n_dhcp4_client_lease_unref);
+	priv->probe = n_dhcp4_client_probe_free (priv->probe);
+	shared_socket_remove_client ((NMDhcpNettools *) object);
+	nm_clear_pointer (&priv->client, n_dhcp4_client_unref);
+
+	G_OBJECT_CLASS (nm_dhcp_nettools_parent_class)->dispose (object);
+}
+
+static void
+nm_dhcp_nettools_class_init (NMDhcpNettoolsClass *class)
+{
+	NMDhcpClientClass *client_class = NM_DHCP_CLIENT_CLASS (class);
+	GObjectClass *object_class = G_OBJECT_CLASS (class);
+
+	object_class->dispose = dispose;
+
+	client_class->ip4_start = ip4_start;
+	client_class->stop = stop;
+}
+
+const NMDhcpClientFactory _nm_dhcp_client_factory_nettools = {
+	.name = "nettools",
+	.get_type = nm_dhcp_nettools_get_type,
+	.get_path = NULL,
+};
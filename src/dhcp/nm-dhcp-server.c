@@ -0,0 +1,908 @@
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2019 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-dhcp-server.h"
+
+#include <arpa/inet.h>
+
+#include "nm-utils.h"
+#include "nm-core-utils.h"
+#include "platform/nm-platform.h"
+#include "dnsmasq/nm-dnsmasq-utils.h"
+#include "n-dhcp4/src/n-dhcp4.h"
+
+#define DHCP_OPTION_SUBNET_MASK                     1
+#define DHCP_OPTION_ROUTER                          3
+#define DHCP_OPTION_DOMAIN_NAME_SERVER              6
+#define DHCP_OPTION_BROADCAST                      28
+#define DHCP_OPTION_VENDOR_SPECIFIC                43
+#define DHCP_OPTION_CLIENT_IDENTIFIER              61
+#define DHCP_OPTION_DOMAIN_SEARCH_LIST            119
+
+/* the same as dnsmasq gets passed via "--dhcp-range" and "--dhcp-lease-max". */
+#define LEASE_LIFETIME_SEC     3600
+#define LEASE_MAX              50
+
+/* how long an offered address is reserved for the client. */
+#define OFFER_TIMEOUT_MSEC     (60 * 1000)
+
+/* how long an address is not handed out after a client declined it. */
+#define DECLINE_TIMEOUT_MSEC   (10 * 60 * 1000)
+
+/*****************************************************************************/
+
+typedef enum {
+	LEASE_STATE_OFFERED,
+	LEASE_STATE_BOUND,
+	LEASE_STATE_DECLINED,
+} LeaseState;
+
+typedef struct {
+	/* %NULL for declined addresses. */
+	GBytes *client_id;
+	in_addr_t addr;
+	LeaseState state;
+	gint64 expiry_msec;
+} Lease;
+
+struct _NMDhcpServerLeases {
+	/* in_addr_t -> Lease. Owns the leases. */
+	GHashTable *by_addr;
+
+	/* GBytes -> Lease */
+	GHashTable *by_client_id;
+
+	/* the pool, in host byte order. */
+	guint32 first;
+	guint32 last;
+
+	in_addr_t server_addr;
+	guint max_leases;
+};
+
+/*****************************************************************************/
+
+enum {
+	FAILED,
+	LAST_SIGNAL,
+};
+
+static guint signals[LAST_SIGNAL] = { 0 };
+
+typedef struct {
+	char *iface;
+	int ifindex;
+
+	NDhcp4Server *server;
+	NDhcp4ServerIp *server_ip;
+	GIOChannel *channel;
+	guint event_id;
+
+	NMDhcpServerLeases *leases;
+
+	/* what the options are built from. */
+	NMIP4Config *ip4_config;
+	NMPlatformIP4Address address;
+	bool announce_android_metered:1;
+
+	/* the options for offers and acks, as code/length/data triples. */
+	GByteArray *options;
+} NMDhcpServerPrivate;
+
+struct _NMDhcpServer {
+	GObject parent;
+	NMDhcpServerPrivate _priv;
+};
+
+struct _NMDhcpServerClass {
+	GObjectClass parent;
+};
+
+G_DEFINE_TYPE (NMDhcpServer, nm_dhcp_server, G_TYPE_OBJECT)
+
+#define NM_DHCP_SERVER_GET_PRIVATE(self) _NM_GET_PRIVATE (self, NMDhcpServer, NM_IS_DHCP_SERVER)
+
+/*****************************************************************************/
+
+#define _NMLOG_PREFIX_NAME "dhcp-server"
+#define _NMLOG_DOMAIN      LOGD_SHARING
+#define _NMLOG(level, ...) \
+	G_STMT_START { \
+		const char *_iface = (self) ? NM_DHCP_SERVER_GET_PRIVATE (self)->iface : NULL; \
+		\
+		nm_log ((level), _NMLOG_DOMAIN, _iface, NULL, \
+		        "%s%s%s%s: " _NM_UTILS_MACRO_FIRST (__VA_ARGS__), \
+		        _NMLOG_PREFIX_NAME, \
+		        NM_PRINT_FMT_QUOTED (_iface, "[", _iface, "]", "") \
+		        _NM_UTILS_MACRO_REST (__VA_ARGS__)); \
+	} G_STMT_END
+
+/*****************************************************************************/
+
+static void
+lease_free (Lease *lease)
+{
+	if (lease->client_id)
+		g_bytes_unref (lease->client_id);
+	g_slice_free (Lease, lease);
+}
+
+static gboolean
+lease_is_expired (const Lease *lease, gint64 now_msec)
+{
+	return lease->expiry_msec <= now_msec;
+}
+
+NMDhcpServerLeases *
+nm_dhcp_server_leases_new (in_addr_t first,
+                           in_addr_t last,
+                           in_addr_t server_addr,
+                           guint max_leases)
+{
+	NMDhcpServerLeases *leases;
+
+	g_return_val_if_fail (ntohl (first) <= ntohl (last), NULL);
+	g_return_val_if_fail (max_leases > 0, NULL);
+
+	leases = g_slice_new (NMDhcpServerLeases);
+	*leases = (NMDhcpServerLeases) {
+		.by_addr      = g_hash_table_new_full (nm_direct_hash, NULL, NULL, (GDestroyNotify) lease_free),
+		.by_client_id = g_hash_table_new (g_bytes_hash, g_bytes_equal),
+		.first        = ntohl (first),
+		.last         = ntohl (last),
+		.server_addr  = server_addr,
+		.max_leases   = max_leases,
+	};
+	return leases;
+}
+
+void
+nm_dhcp_server_leases_free (NMDhcpServerLeases *leases)
+{
+	if (!leases)
+		return;
+
+	g_hash_table_unref (leases->by_client_id);
+	g_hash_table_unref (leases->by_addr);
+	g_slice_free (NMDhcpServerLeases, leases);
+}
+
+guint
+nm_dhcp_server_leases_get_num (NMDhcpServerLeases *leases)
+{
+	return g_hash_table_size (leases->by_addr);
+}
+
+static void
+leases_remove (NMDhcpServerLeases *leases, Lease *lease)
+{
+	if (   lease->client_id
+	    && g_hash_table_lookup (leases->by_client_id, lease->client_id) == lease)
+		g_hash_table_remove (leases->by_client_id, lease->client_id);
+	g_hash_table_remove (leases->by_addr, GUINT_TO_POINTER (lease->addr));
+}
+
+static void
+leases_purge_expired (NMDhcpServerLeases *leases, gint64 now_msec)
+{
+	GHashTableIter iter;
+	Lease *lease;
+
+	g_hash_table_iter_init (&iter, leases->by_addr);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &lease)) {
+		if (!lease_is_expired (lease, now_msec))
+			continue;
+		if (   lease->client_id
+		    && g_hash_table_lookup (leases->by_client_id, lease->client_id) == lease)
+			g_hash_table_remove (leases->by_client_id, lease->client_id);
+		g_hash_table_iter_remove (&iter);
+	}
+}
+
+static gboolean
+leases_addr_in_pool (NMDhcpServerLeases *leases, in_addr_t addr)
+{
+	guint32 a = ntohl (addr);
+
+	return    a >= leases->first
+	       && a <= leases->last
+	       && addr != leases->server_addr;
+}
+
+static gboolean
+leases_addr_available (NMDhcpServerLeases *leases, in_addr_t addr, gint64 now_msec)
+{
+	Lease *lease;
+
+	if (!leases_addr_in_pool (leases, addr))
+		return FALSE;
+
+	lease = g_hash_table_lookup (leases->by_addr, GUINT_TO_POINTER (addr));
+	return !lease || lease_is_expired (lease, now_msec);
+}
+
+static Lease *
+leases_add (NMDhcpServerLeases *leases,
+            GBytes *client_id,
+            in_addr_t addr,
+            LeaseState state,
+            gint64 expiry_msec,
+            gint64 now_msec)
+{
+	Lease *lease;
+
+	lease = g_hash_table_lookup (leases->by_addr, GUINT_TO_POINTER (addr));
+	if (lease)
+		leases_remove (leases, lease);
+
+	if (g_hash_table_size (leases->by_addr) >= leases->max_leases) {
+		leases_purge_expired (leases, now_msec);
+		if (g_hash_table_size (leases->by_addr) >= leases->max_leases)
+			return NULL;
+	}
+
+	lease = g_slice_new (Lease);
+	*lease = (Lease) {
+		.client_id   = client_id ? g_bytes_ref (client_id) : NULL,
+		.addr        = addr,
+		.state       = state,
+		.expiry_msec = expiry_msec,
+	};
+	g_hash_table_insert (leases->by_addr, GUINT_TO_POINTER (addr), lease);
+	if (client_id)
+		g_hash_table_insert (leases->by_client_id, lease->client_id, lease);
+	return lease;
+}
+
+/**
+ * nm_dhcp_server_leases_offer:
+ * @leases: the lease table
+ * @client_id: the client identifier, or the hardware address of the client
+ * @requested: the address the client asks for, or 0
+ * @now_msec: the current timestamp
+ *
+ * Picks an address for @client_id and reserves it for a while. A client
+ * that has an address on record gets it again. Otherwise the @requested
+ * address is preferred if it is free. Otherwise the address is chosen
+ * based on a hash of @client_id, so that clients tend to get the same
+ * address even after the table was lost.
+ *
+ * Returns: the address, or 0 if the pool is exhausted.
+ */
+in_addr_t
+nm_dhcp_server_leases_offer (NMDhcpServerLeases *leases,
+                             GBytes *client_id,
+                             in_addr_t requested,
+                             gint64 now_msec)
+{
+	Lease *lease;
+	guint32 n, start, i;
+	in_addr_t addr = 0;
+
+	g_return_val_if_fail (leases, 0);
+	g_return_val_if_fail (client_id, 0);
+
+	lease = g_hash_table_lookup (leases->by_client_id, client_id);
+	if (lease) {
+		if (   lease->state != LEASE_STATE_BOUND
+		    || lease_is_expired (lease, now_msec)) {
+			lease->state = LEASE_STATE_OFFERED;
+			lease->expiry_msec = now_msec + OFFER_TIMEOUT_MSEC;
+		}
+		return lease->addr;
+	}
+
+	if (   requested
+	    && leases_addr_available (leases, requested, now_msec))
+		addr = requested;
+	else {
+		n = leases->last - leases->first + 1;
+		start = g_bytes_hash (client_id) % n;
+		for (i = 0; i < n; i++) {
+			in_addr_t a = htonl (leases->first + ((start + i) % n));
+
+			if (leases_addr_available (leases, a, now_msec)) {
+				addr = a;
+				break;
+			}
+		}
+		if (!addr)
+			return 0;
+	}
+
+	if (!leases_add (leases,
+	                 client_id,
+	                 addr,
+	                 LEASE_STATE_OFFERED,
+	                 now_msec + OFFER_TIMEOUT_MSEC,
+	                 now_msec))
+		return 0;
+
+	return addr;
+}
+
+/**
+ * nm_dhcp_server_leases_bind:
+ * @leases: the lease table
+ * @client_id: the client identifier, or the hardware address of the client
+ * @addr: the requested address
+ * @lifetime: the lifetime of the lease in seconds
+ * @now_msec: the current timestamp
+ *
+ * Binds @addr to @client_id. This succeeds if the address is on record
+ * for the client, or if it is free. The latter allows clients to keep
+ * their address after the server restarted.
+ *
+ * Returns: %TRUE if the request can be acknowledged.
+ */
+gboolean
+nm_dhcp_server_leases_bind (NMDhcpServerLeases *leases,
+                            GBytes *client_id,
+                            in_addr_t addr,
+                            guint32 lifetime,
+                            gint64 now_msec)
+{
+	Lease *lease;
+
+	g_return_val_if_fail (leases, FALSE);
+	g_return_val_if_fail (client_id, FALSE);
+
+	lease = g_hash_table_lookup (leases->by_client_id, client_id);
+	if (   lease
+	    && lease->addr != addr) {
+		/* the client moved on to a different address. */
+		leases_remove (leases, lease);
+		lease = NULL;
+	}
+
+	if (!lease) {
+		if (!leases_addr_available (leases, addr, now_msec))
+			return FALSE;
+		lease = leases_add (leases, client_id, addr, LEASE_STATE_BOUND, 0, now_msec);
+		if (!lease)
+			return FALSE;
+	}
+
+	lease->state = LEASE_STATE_BOUND;
+	lease->expiry_msec = now_msec + ((gint64) lifetime) * 1000;
+	return TRUE;
+}
+
+gboolean
+nm_dhcp_server_leases_release (NMDhcpServerLeases *leases,
+                               GBytes *client_id,
+                               in_addr_t addr)
+{
+	Lease *lease;
+
+	g_return_val_if_fail (leases, FALSE);
+	g_return_val_if_fail (client_id, FALSE);
+
+	lease = g_hash_table_lookup (leases->by_client_id, client_id);
+	if (   !lease
+	    || lease->addr != addr)
+		return FALSE;
+
+	leases_remove (leases, lease);
+	return TRUE;
+}
+
+void
+nm_dhcp_server_leases_decline (NMDhcpServerLeases *leases,
+                               GBytes *client_id,
+                               in_addr_t addr,
+                               gint64 now_msec)
+{
+	Lease *lease;
+
+	g_return_if_fail (leases);
+
+	if (client_id) {
+		lease = g_hash_table_lookup (leases->by_client_id, client_id);
+		if (lease)
+			leases_remove (leases, lease);
+	}
+
+	if (!leases_addr_in_pool (leases, addr))
+		return;
+
+	/* the address is in use by somebody else. Don't hand it out for a while. */
+	leases_add (leases,
+	            NULL,
+	            addr,
+	            LEASE_STATE_DECLINED,
+	            now_msec + DECLINE_TIMEOUT_MSEC,
+	            now_msec);
+}
+
+/*****************************************************************************/
+
+static void
+_options_append (GByteArray *options, guint8 code, gconstpointer data, gsize len)
+{
+	const guint8 header[2] = { code, len };
+
+	nm_assert (len <= G_MAXUINT8);
+
+	g_byte_array_append (options, header, sizeof (header));
+	g_byte_array_append (options, data, len);
+}
+
+static void
+_options_append_domain_search (GByteArray *options, const NMIP4Config *ip4_config)
+{
+	nm_auto_unref_bytearray GByteArray *buf = g_byte_array_new ();
+	guint i, n;
+
+	/* RFC 3397, without compression. Domains that don't fit are dropped. */
+	n = nm_ip4_config_get_num_searches (ip4_config);
+	for (i = 0; i < n; i++) {
+		gs_strfreev char **labels = g_strsplit (nm_ip4_config_get_search (ip4_config, i), ".", -1);
+		guint old_len = buf->len;
+		char **label;
+
+		for (label = labels; *label; label++) {
+			gsize len = strlen (*label);
+			guint8 len8 = len;
+
+			if (len == 0)
+				continue;
+			if (len > 63)
+				goto next;
+			g_byte_array_append (buf, &len8, 1);
+			g_byte_array_append (buf, (const guint8 *) *label, len);
+		}
+		g_byte_array_append (buf, (const guint8 *) "", 1);
+
+		if (buf->len <= G_MAXUINT8)
+			continue;
+next:
+		g_byte_array_set_size (buf, old_len);
+	}
+
+	if (buf->len > 0)
+		_options_append (options, DHCP_OPTION_DOMAIN_SEARCH_LIST, buf->data, buf->len);
+}
+
+static GByteArray *
+_options_new (const NMIP4Config *ip4_config,
+              const GArray *upstream_nameservers,
+              const NMPlatformIP4Address *address,
+              gboolean announce_android_metered,
+              gboolean *out_has_nameservers)
+{
+	GByteArray *options = g_byte_array_new ();
+	in_addr_t netmask;
+	in_addr_t broadcast;
+	guint i, n;
+
+	*out_has_nameservers = FALSE;
+
+	netmask = _nm_utils_ip4_prefix_to_netmask (address->plen);
+	_options_append (options, DHCP_OPTION_SUBNET_MASK, &netmask, sizeof (netmask));
+
+	if (address->plen < 31) {
+		broadcast = address->address | ~netmask;
+		_options_append (options, DHCP_OPTION_BROADCAST, &broadcast, sizeof (broadcast));
+	}
+
+	if (nm_ip4_config_best_default_route_get (ip4_config))
+		_options_append (options, DHCP_OPTION_ROUTER, &address->address, sizeof (address->address));
+
+	/* unlike dnsmasq, we don't forward DNS queries. Announce the name servers
+	 * of the shared connection, or if it has none, the upstream name servers
+	 * directly. */
+	n = NM_MIN (nm_ip4_config_get_num_nameservers (ip4_config), G_MAXUINT8 / sizeof (in_addr_t));
+	if (n > 0) {
+		in_addr_t nameservers[G_MAXUINT8 / sizeof (in_addr_t)];
+
+		for (i = 0; i < n; i++)
+			nameservers[i] = nm_ip4_config_get_nameserver (ip4_config, i);
+		_options_append (options, DHCP_OPTION_DOMAIN_NAME_SERVER, nameservers, n * sizeof (in_addr_t));
+		*out_has_nameservers = TRUE;
+	} else if (upstream_nameservers) {
+		n = NM_MIN (upstream_nameservers->len, G_MAXUINT8 / sizeof (in_addr_t));
+		if (n > 0) {
+			_options_append (options, DHCP_OPTION_DOMAIN_NAME_SERVER, upstream_nameservers->data, n * sizeof (in_addr_t));
+			*out_has_nameservers = TRUE;
+		}
+	}
+
+	_options_append_domain_search (options, ip4_config);
+
+	if (announce_android_metered) {
+		/* announce ANDROID_METERED, even if the client did not ask for this option.
+		 * See https://www.lorier.net/docs/android-metered.html */
+		_options_append (options, DHCP_OPTION_VENDOR_SPECIFIC, "ANDROID_METERED", NM_STRLEN ("ANDROID_METERED"));
+	}
+
+	return options;
+}
+
+static void
+_options_update (NMDhcpServer *self, const GArray *upstream_nameservers)
+{
+	NMDhcpServerPrivate *priv = NM_DHCP_SERVER_GET_PRIVATE (self);
+	GByteArray *options;
+	gboolean has_nameservers;
+
+	options = _options_new (priv->ip4_config,
+	                        upstream_nameservers,
+	                        &priv->address,
+	                        priv->announce_android_metered,
+	                        &has_nameservers);
+
+	if (   priv->options
+	    && priv->options->len == options->len
+	    && memcmp (priv->options->data, options->data, options->len) == 0) {
+		g_byte_array_unref (options);
+		return;
+	}
+
+	if (!has_nameservers)
+		_LOGW ("no IPv4 name servers to announce, clients get no DNS server until there are upstream name servers");
+	else if (priv->options)
+		_LOGD ("announced options changed");
+
+	nm_clear_pointer (&priv->options, g_byte_array_unref);
+	priv->options = options;
+}
+
+/*****************************************************************************/
+
+static GBytes *
+_lease_get_client_id (NDhcp4ServerLease *lease)
+{
+	const uint8_t *data;
+	uint8_t *option;
+	size_t n_data;
+
+	if (   n_dhcp4_server_lease_query (lease, DHCP_OPTION_CLIENT_IDENTIFIER, &option, &n_data) == 0
+	    && n_data > 0)
+		return g_bytes_new (option, n_data);
+
+	/* fall back to the hardware address. */
+	n_dhcp4_server_lease_get_chaddr (lease, &data, &n_data);
+	if (n_data == 0)
+		return NULL;
+	return g_bytes_new (data, n_data);
+}
+
+static in_addr_t
+_lease_get_requested_ip (NDhcp4ServerLease *lease)
+{
+	struct in_addr addr;
+
+	if (n_dhcp4_server_lease_get_requested_ip (lease, &addr) != 0)
+		return 0;
+	return addr.s_addr;
+}
+
+static int
+_lease_reply (NMDhcpServer *self, NDhcp4ServerLease *lease, in_addr_t addr, gboolean offer)
+{
+	NMDhcpServerPrivate *priv = NM_DHCP_SERVER_GET_PRIVATE (self);
+	guint i;
+	int r;
+
+	n_dhcp4_server_lease_set_yiaddr (lease, (struct in_addr) { addr }, LEASE_LIFETIME_SEC);
+
+	for (i = 0; i < priv->options->len; i += 2 + priv->options->data[i + 1]) {
+		r = n_dhcp4_server_lease_append (lease,
+		                                 priv->options->data[i],
+		                                 &priv->options->data[i + 2],
+		                                 priv->options->data[i + 1]);
+		if (r)
+			return r;
+	}
+
+	return offer
+	       ? n_dhcp4_server_lease_offer (lease)
+	       : n_dhcp4_server_lease_ack (lease);
+}
+
+static void
+_event_handle (NMDhcpServer *self, NDhcp4ServerEvent *event)
+{
+	NMDhcpServerPrivate *priv = NM_DHCP_SERVER_GET_PRIVATE (self);
+	gs_unref_bytes GBytes *client_id = NULL;
+	gs_free char *client_id_str = NULL;
+	NDhcp4ServerLease *lease;
+	char addr_str[INET_ADDRSTRLEN];
+	gint64 now_msec;
+	in_addr_t addr;
+	int r;
+
+	switch (event->event) {
+	case N_DHCP4_SERVER_EVENT_DISCOVER:
+	case N_DHCP4_SERVER_EVENT_REQUEST:
+	case N_DHCP4_SERVER_EVENT_RENEW:
+	case N_DHCP4_SERVER_EVENT_DECLINE:
+	case N_DHCP4_SERVER_EVENT_RELEASE:
+		/* all lease events share the same layout. */
+		lease = event->discover.lease;
+		break;
+	default:
+		return;
+	}
+
+	client_id = _lease_get_client_id (lease);
+	if (!client_id)
+		return;
+
+	client_id_str = nm_utils_bin2hexstr_full (g_bytes_get_data (client_id, NULL),
+	                                          g_bytes_get_size (client_id),
+	                                          ':', FALSE, NULL);
+
+	now_msec = nm_utils_get_monotonic_timestamp_ms ();
+	addr = _lease_get_requested_ip (lease);
+
+	switch (event->event) {
+	case N_DHCP4_SERVER_EVENT_DISCOVER:
+		addr = nm_dhcp_server_leases_offer (priv->leases, client_id, addr, now_msec);
+		if (!addr) {
+			_LOGW ("no free address for client %s", client_id_str);
+			return;
+		}
+		_LOGD ("offer %s to client %s", nm_utils_inet4_ntop (addr, addr_str), client_id_str);
+		r = _lease_reply (self, lease, addr, TRUE);
+		break;
+	case N_DHCP4_SERVER_EVENT_REQUEST:
+	case N_DHCP4_SERVER_EVENT_RENEW:
+		if (   !addr
+		    || !nm_dhcp_server_leases_bind (priv->leases, client_id, addr, LEASE_LIFETIME_SEC, now_msec)) {
+			_LOGD ("reject request for %s from client %s", nm_utils_inet4_ntop (addr, addr_str), client_id_str);
+			r = n_dhcp4_server_lease_nack (lease);
+			break;
+		}
+		_LOGD ("lease %s to client %s", nm_utils_inet4_ntop (addr, addr_str), client_id_str);
+		r = _lease_reply (self, lease, addr, FALSE);
+		break;
+	case N_DHCP4_SERVER_EVENT_DECLINE:
+		_LOGD ("client %s declined %s", client_id_str, nm_utils_inet4_ntop (addr, addr_str));
+		nm_dhcp_server_leases_decline (priv->leases, client_id, addr, now_msec);
+		return;
+	case N_DHCP4_SERVER_EVENT_RELEASE:
+		if (nm_dhcp_server_leases_release (priv->leases, client_id, addr))
+			_LOGD ("client %s released %s", client_id_str, nm_utils_inet4_ntop (addr, addr_str));
+		return;
+	default:
+		nm_assert_not_reached ();
+		return;
+	}
+
+	if (r)
+		_LOGD ("failed to send reply (%d)", r);
+}
+
+static gboolean
+server_event_cb (GIOChannel *source, GIOCondition condition, gpointer user_data)
+{
+	NMDhcpServer *self = user_data;
+	NMDhcpServerPrivate *priv = NM_DHCP_SERVER_GET_PRIVATE (self);
+	NDhcp4ServerEvent *event;
+	int r;
+
+	r = n_dhcp4_server_dispatch (priv->server);
+	if (r < 0) {
+		/* N_DHCP4_E_PREEMPTED is positive. The watch is level-triggered,
+		 * so we will be called again. */
+		_LOGW ("error %d dispatching events", r);
+		priv->event_id = 0;
+		g_signal_emit (self, signals[FAILED], 0);
+		return G_SOURCE_REMOVE;
+	}
+
+	while (   !n_dhcp4_server_pop_event (priv->server, &event)
+	       && event)
+		_event_handle (self, event);
+
+	return G_SOURCE_CONTINUE;
+}
+
+/**
+ * nm_dhcp_server_start:
+ * @server: the #NMDhcpServer
+ * @ip4_config: the configuration of the shared interface
+ * @upstream_nameservers: (allow-none): an array of in_addr_t with the name
+ *   servers to announce if @ip4_config has none. See
+ *   nm_dhcp_server_set_upstream_nameservers().
+ * @announce_android_metered: whether to announce the ANDROID_METERED option
+ * @error: (allow-none): the error
+ *
+ * Returns: %TRUE if the server was started.
+ */
+gboolean
+nm_dhcp_server_start (NMDhcpServer *server,
+                      NMIP4Config *ip4_config,
+                      const GArray *upstream_nameservers,
+                      gboolean announce_android_metered,
+                      GError **error)
+{
+	NMDhcpServer *self = server;
+	NMDhcpServerPrivate *priv;
+	nm_auto (n_dhcp4_server_config_freep) NDhcp4ServerConfig *config = NULL;
+	const NMPlatformIP4Address *address;
+	char first_str[INET_ADDRSTRLEN];
+	char last_str[INET_ADDRSTRLEN];
+	gs_free char *error_desc = NULL;
+	in_addr_t first, last;
+	int r, fd;
+
+	g_return_val_if_fail (NM_IS_DHCP_SERVER (self), FALSE);
+	g_return_val_if_fail (!error || !*error, FALSE);
+	g_return_val_if_fail (nm_ip4_config_get_num_addresses (ip4_config) > 0, FALSE);
+
+	priv = NM_DHCP_SERVER_GET_PRIVATE (self);
+
+	nm_dhcp_server_stop (self);
+
+	address = nm_ip4_config_get_first_address (ip4_config);
+
+	if (!nm_dnsmasq_utils_get_range (address, first_str, last_str, &error_desc)) {
+		g_set_error_literal (error,
+		                     NM_MANAGER_ERROR,
+		                     NM_MANAGER_ERROR_FAILED,
+		                     error_desc);
+		_LOGW ("failed to find DHCP address ranges: %s", error_desc);
+		return FALSE;
+	}
+	inet_pton (AF_INET, first_str, &first);
+	inet_pton (AF_INET, last_str, &last);
+
+	r = n_dhcp4_server_config_new (&config);
+	if (r) {
+		nm_utils_error_set_errno (error, r, "failed to create server config: %s");
+		return FALSE;
+	}
+	n_dhcp4_server_config_set_ifindex (config, priv->ifindex);
+
+	r = n_dhcp4_server_new (&priv->server, config);
+	if (r) {
+		if (r < 0)
+			nm_utils_error_set_errno (error, r, "failed to create server: %s");
+		else
+			nm_utils_error_set (error, NM_UTILS_ERROR_UNKNOWN, "failed to create server (%d)", r);
+		return FALSE;
+	}
+
+	r = n_dhcp4_server_add_ip (priv->server,
+	                           &priv->server_ip,
+	                           (struct in_addr) { address->address });
+	if (r) {
+		nm_dhcp_server_stop (self);
+		nm_utils_error_set (error, NM_UTILS_ERROR_UNKNOWN, "failed to add server address (%d)", r);
+		return FALSE;
+	}
+
+	priv->leases = nm_dhcp_server_leases_new (first, last, address->address, LEASE_MAX);
+
+	priv->ip4_config = g_object_ref (ip4_config);
+	priv->address = *address;
+	priv->announce_android_metered = announce_android_metered;
+	_options_update (self, upstream_nameservers);
+
+	n_dhcp4_server_get_fd (priv->server, &fd);
+	priv->channel = g_io_channel_unix_new (fd);
+	priv->event_id = g_io_add_watch (priv->channel, G_IO_IN, server_event_cb, self);
+
+	_LOGI ("started, handing out %s - %s", first_str, last_str);
+	return TRUE;
+}
+
+/**
+ * nm_dhcp_server_set_upstream_nameservers:
+ * @server: the #NMDhcpServer
+ * @upstream_nameservers: (allow-none): an array of in_addr_t with the name
+ *   servers to announce if the shared configuration has none.
+ *
+ * The server does not forward DNS queries. Instead it announces the upstream
+ * name servers directly, so they must be updated whenever they change.
+ * Clients get the new ones when they renew their lease.
+ */
+void
+nm_dhcp_server_set_upstream_nameservers (NMDhcpServer *server,
+                                         const GArray *upstream_nameservers)
+{
+	NMDhcpServer *self = server;
+	NMDhcpServerPrivate *priv;
+
+	g_return_if_fail (NM_IS_DHCP_SERVER (self));
+
+	priv = NM_DHCP_SERVER_GET_PRIVATE (self);
+
+	if (!priv->server)
+		return;
+
+	_options_update (self, upstream_nameservers);
+}
+
+void
+nm_dhcp_server_stop (NMDhcpServer *server)
+{
+	NMDhcpServer *self = server;
+	NMDhcpServerPrivate *priv;
+
+	g_return_if_fail (NM_IS_DHCP_SERVER (self));
+
+	priv = NM_DHCP_SERVER_GET_PRIVATE (self);
+
+	if (priv->server)
+		_LOGD ("stopped");
+
+	nm_clear_g_source (&priv->event_id);
+	nm_clear_pointer (&priv->channel, g_io_channel_unref);
+	nm_clear_pointer (&priv->server_ip, n_dhcp4_server_ip_free);
+	nm_clear_pointer (&priv->server, n_dhcp4_server_unref);
+	nm_clear_pointer (&priv->leases, nm_dhcp_server_leases_free);
+	nm_clear_pointer (&priv->options, g_byte_array_unref);
+	g_clear_object (&priv->ip4_config);
+}
+
+/*****************************************************************************/
+
+static void
+nm_dhcp_server_init (NMDhcpServer *server)
+{
+}
+
+NMDhcpServer *
+nm_dhcp_server_new (const char *iface, int ifindex)
+{
+	NMDhcpServer *server;
+	NMDhcpServerPrivate *priv;
+
+	g_return_val_if_fail (ifindex > 0, NULL);
+
+	server = (NMDhcpServer *) g_object_new (NM_TYPE_DHCP_SERVER, NULL);
+
+	priv = NM_DHCP_SERVER_GET_PRIVATE (server);
+	priv->iface = g_strdup (iface);
+	priv->ifindex = ifindex;
+
+	return server;
+}
+
+static void
+finalize (GObject *object)
+{
+	NMDhcpServerPrivate *priv = NM_DHCP_SERVER_GET_PRIVATE ((NMDhcpServer *) object);
+
+	nm_dhcp_server_stop (NM_DHCP_SERVER (object));
+
+	g_free (priv->iface);
+
+	G_OBJECT_CLASS (nm_dhcp_server_parent_class)->finalize (object);
+}
+
+static void
+nm_dhcp_server_class_init (NMDhcpServerClass *server_class)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (server_class);
+
+	object_class->finalize = finalize;
+
+	signals[FAILED] =
+	     g_signal_new (NM_DHCP_SERVER_FAILED,
+	                   G_OBJECT_CLASS_TYPE (object_class),
+	                   G_SIGNAL_RUN_FIRST,
+	                   0, NULL, NULL,
+	                   g_cclosure_marshal_VOID__VOID,
+	                   G_TYPE_NONE, 0);
+}
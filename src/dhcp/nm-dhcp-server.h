@@ -0,0 +1,90 @@
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2019 Red Hat, Inc.
+ */
+
+#ifndef __NETWORKMANAGER_DHCP_SERVER_H__
+#define __NETWORKMANAGER_DHCP_SERVER_H__
+
+#include "nm-ip4-config.h"
+
+#define NM_TYPE_DHCP_SERVER            (nm_dhcp_server_get_type ())
+#define NM_DHCP_SERVER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), NM_TYPE_DHCP_SERVER, NMDhcpServer))
+#define NM_DHCP_SERVER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), NM_TYPE_DHCP_SERVER, NMDhcpServerClass))
+#define NM_IS_DHCP_SERVER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NM_TYPE_DHCP_SERVER))
+#define NM_IS_DHCP_SERVER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), NM_TYPE_DHCP_SERVER))
+#define NM_DHCP_SERVER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), NM_TYPE_DHCP_SERVER, NMDhcpServerClass))
+
+/* signals */
+#define NM_DHCP_SERVER_FAILED "failed"
+
+typedef struct _NMDhcpServer NMDhcpServer;
+typedef struct _NMDhcpServerClass NMDhcpServerClass;
+
+GType nm_dhcp_server_get_type (void);
+
+NMDhcpServer *nm_dhcp_server_new (const char *iface, int ifindex);
+
+gboolean nm_dhcp_server_start (NMDhcpServer *server,
+                               NMIP4Config *ip4_config,
+                               const GArray *upstream_nameservers,
+                               gboolean announce_android_metered,
+                               GError **error);
+
+void     nm_dhcp_server_set_upstream_nameservers (NMDhcpServer *server,
+                                                  const GArray *upstream_nameservers);
+
+void     nm_dhcp_server_stop  (NMDhcpServer *server);
+
+/*****************************************************************************/
+
+/* The lease table of the server. Addresses are in network byte order,
+ * timestamps are in milliseconds of nm_utils_get_monotonic_timestamp_ms(). */
+
+typedef struct _NMDhcpServerLeases NMDhcpServerLeases;
+
+NMDhcpServerLeases *nm_dhcp_server_leases_new (in_addr_t first,
+                                               in_addr_t last,
+                                               in_addr_t server_addr,
+                                               guint max_leases);
+
+void nm_dhcp_server_leases_free (NMDhcpServerLeases *leases);
+
+NM_AUTO_DEFINE_FCN0 (NMDhcpServerLeases *, _nm_auto_free_dhcp_server_leases, nm_dhcp_server_leases_free)
+#define nm_auto_free_dhcp_server_leases nm_auto (_nm_auto_free_dhcp_server_leases)
+
+guint nm_dhcp_server_leases_get_num (NMDhcpServerLeases *leases);
+
+in_addr_t nm_dhcp_server_leases_offer (NMDhcpServerLeases *leases,
+                                       GBytes *client_id,
+                                       in_addr_t requested,
+                                       gint64 now_msec);
+
+gboolean nm_dhcp_server_leases_bind (NMDhcpServerLeases *leases,
+                                     GBytes *client_id,
+                                     in_addr_t addr,
+                                     guint32 lifetime,
+                                     gint64 now_msec);
+
+gboolean nm_dhcp_server_leases_release (NMDhcpServerLeases *leases,
+                                        GBytes *client_id,
+                                        in_addr_t addr);
+
+void nm_dhcp_server_leases_decline (NMDhcpServerLeases *leases,
+                                    GBytes *client_id,
+                                    in_addr_t addr,
+                                    gint64 now_msec);
+
+#endif /* __NETWORKMANAGER_DHCP_SERVER_H__ */
@@ -589,6 +589,30 @@ get_leasefile_path (int addr_family, const char *iface, const char *uuid)
 	}
 }
 
+static void
+lease_save (NMDhcpSystemd *self, sd_dhcp_lease *lease)
+{
+	NMDhcpSystemdPrivate *priv = NM_DHCP_SYSTEMD_GET_PRIVATE (self);
+	NMDhcpClient *client = NM_DHCP_CLIENT (self);
+	NMDhcpLeaseDb *lease_db = nm_dhcp_client_get_lease_db (client);
+	struct in_addr addr;
+
+	if (!lease_db) {
+		dhcp_lease_save (lease, priv->lease_file);
+		return;
+	}
+
+	if (sd_dhcp_lease_get_address (lease, &addr) < 0)
+		return;
+
+	nm_dhcp_lease_db_set (lease_db,
+	                      AF_INET,
+	                      nm_dhcp_client_get_iface (client),
+	                      nm_dhcp_client_get_uuid (client),
+	                      &addr.s_addr,
+	                      time (NULL));
+}
+
 /*****************************************************************************/
 
 static void
@@ -627,7 +651,7 @@ bound4_handle (NMDhcpSystemd *self)
 	}
 
 	add_requests_to_options (options, dhcp4_requests);
-	dhcp_lease_save (lease, priv->lease_file);
+	lease_save (self, lease);
 
 	nm_dhcp_client_set_state (NM_DHCP_CLIENT (self),
 	                          NM_DHCP_STATE_BOUND,
@@ -735,7 +759,17 @@ ip4_start (NMDhcpClient *client,
 
 	if (last_ip4_address)
 		inet_pton (AF_INET, last_ip4_address, &last_addr);
-	else {
+	else if (nm_dhcp_client_get_lease_db (client)) {
+		NMIPAddr addr;
+
+		if (nm_dhcp_lease_db_get (nm_dhcp_client_get_lease_db (client),
+		                          AF_INET,
+		                          nm_dhcp_client_get_iface (client),
+		                          nm_dhcp_client_get_uuid (client),
+		                          &addr,
+		                          NULL))
+			last_addr.s_addr = addr.addr4;
+	} else {
 		nm_auto (sd_dhcp_lease_unrefp) sd_dhcp_lease *lease = NULL;
 
 		dhcp_lease_load (&lease, lease_file);
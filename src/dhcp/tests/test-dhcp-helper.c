@@ -0,0 +1,290 @@
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2019 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <sys/socket.h>
+
+#include "dhcp/nm-dhcp-helper-api.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+/* a typical set of variables, as dhclient passes them to the helper. */
+static const char *const event_env[][2] = {
+	{ "interface",                    "eth0" },
+	{ "pid",                          "4242" },
+	{ "reason",                       "BOUND" },
+	{ "new_ip_address",               "192.168.1.100" },
+	{ "new_subnet_mask",              "255.255.255.0" },
+	{ "new_network_number",           "192.168.1.0" },
+	{ "new_broadcast_address",        "192.168.1.255" },
+	{ "new_routers",                  "192.168.1.1" },
+	{ "new_domain_name_servers",      "192.168.1.1 192.168.1.2" },
+	{ "new_domain_name",              "example.com" },
+	{ "new_domain_search",            "example.com. corp.example.com." },
+	{ "new_dhcp_lease_time",          "3600" },
+	{ "new_dhcp_server_identifier",   "192.168.1.1" },
+	{ "new_dhcp_message_type",        "5" },
+	{ "new_expiry",                   "1559225280" },
+	{ "new_interface_mtu",            "1500" },
+	{ "new_rfc3442_classless_static_routes", "24 10 0 0 192 168 1 1" },
+	{ "requested_subnet_mask",        "1" },
+	{ "requested_routers",            "1" },
+	{ "requested_domain_name_servers", "1" },
+	{ "requested_domain_name",        "1" },
+	{ "requested_host_name",          "1" },
+	{ "requested_interface_mtu",      "1" },
+	{ "empty_value",                  "" },
+};
+
+static void
+_build_event (GByteArray *msg)
+{
+	guint i;
+
+	nm_dhcp_helper_msg_init (msg, NM_DHCP_HELPER_MSG_TYPE_EVENT);
+	for (i = 0; i < G_N_ELEMENTS (event_env); i++) {
+		g_assert (nm_dhcp_helper_msg_append (msg,
+		                                     event_env[i][0], strlen (event_env[i][0]),
+		                                     event_env[i][1], strlen (event_env[i][1])));
+	}
+}
+
+static GVariant *
+_build_event_variant (void)
+{
+	GVariantBuilder builder;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	for (i = 0; i < G_N_ELEMENTS (event_env); i++) {
+		g_variant_builder_add (&builder, "{sv}",
+		                       event_env[i][0],
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+		                                                  event_env[i][1],
+		                                                  strlen (event_env[i][1]),
+		                                                  1));
+	}
+	return g_variant_ref_sink (g_variant_new ("(a{sv})", &builder));
+}
+
+/*****************************************************************************/
+
+static void
+test_msg_roundtrip (void)
+{
+	nm_auto_unref_bytearray GByteArray *msg = g_byte_array_new ();
+	gs_unref_variant GVariant *options = NULL;
+	gs_unref_variant GVariant *expected = NULL;
+	gs_unref_variant GVariant *expected_options = NULL;
+	NMDhcpHelperMsgType type;
+
+	_build_event (msg);
+
+	g_assert (nm_dhcp_helper_msg_parse_header (msg->data, msg->len, &type));
+	g_assert_cmpint (type, ==, NM_DHCP_HELPER_MSG_TYPE_EVENT);
+
+	options = nm_dhcp_helper_msg_parse_event (msg->data, msg->len);
+	g_assert (options);
+	g_assert (g_variant_is_of_type (options, G_VARIANT_TYPE_VARDICT));
+	g_assert_cmpint (g_variant_n_children (options), ==, G_N_ELEMENTS (event_env));
+
+	/* the options must be identical to what the helper sends via D-Bus. */
+	expected = _build_event_variant ();
+	g_variant_get (expected, "(@a{sv})", &expected_options);
+	g_assert (g_variant_equal (options, expected_options));
+
+	nm_dhcp_helper_msg_init (msg, NM_DHCP_HELPER_MSG_TYPE_ACK);
+	g_assert_cmpint (msg->len, ==, sizeof (NMDhcpHelperMsgHeader));
+	g_assert (nm_dhcp_helper_msg_parse_header (msg->data, msg->len, &type));
+	g_assert_cmpint (type, ==, NM_DHCP_HELPER_MSG_TYPE_ACK);
+	g_assert (!nm_dhcp_helper_msg_parse_event (msg->data, msg->len));
+}
+
+static void
+test_msg_invalid (void)
+{
+	nm_auto_unref_bytearray GByteArray *msg = g_byte_array_new ();
+	NMDhcpHelperMsgHeader header;
+	gs_free char *large = NULL;
+	guint len;
+
+	_build_event (msg);
+	len = msg->len;
+
+	/* every truncation must be rejected. */
+	while (--len > 0)
+		g_assert (!nm_dhcp_helper_msg_parse_event (msg->data, len));
+
+	/* trailing garbage. */
+	g_byte_array_append (msg, (const guint8 *) "x", 1);
+	g_assert (!nm_dhcp_helper_msg_parse_event (msg->data, msg->len));
+	g_byte_array_set_size (msg, msg->len - 1);
+
+	memcpy (&header, msg->data, sizeof (header));
+	header.magic++;
+	g_assert (!nm_dhcp_helper_msg_parse_header (&header, sizeof (header), NULL));
+	header.magic--;
+	header.version++;
+	g_assert (!nm_dhcp_helper_msg_parse_header (&header, sizeof (header), NULL));
+
+	/* keys must not contain NUL or invalid UTF-8. */
+	nm_dhcp_helper_msg_init (msg, NM_DHCP_HELPER_MSG_TYPE_EVENT);
+	g_assert (nm_dhcp_helper_msg_append (msg, "a\0b", 3, "v", 1));
+	g_assert (!nm_dhcp_helper_msg_parse_event (msg->data, msg->len));
+	nm_dhcp_helper_msg_init (msg, NM_DHCP_HELPER_MSG_TYPE_EVENT);
+	g_assert (nm_dhcp_helper_msg_append (msg, "\xff", 1, "v", 1));
+	g_assert (!nm_dhcp_helper_msg_parse_event (msg->data, msg->len));
+
+	/* values are arbitrary bytes, but the message size is limited. */
+	nm_dhcp_helper_msg_init (msg, NM_DHCP_HELPER_MSG_TYPE_EVENT);
+	g_assert (nm_dhcp_helper_msg_append (msg, "k", 1, "\xff\0", 2));
+	g_assert (nm_dhcp_helper_msg_parse_event (msg->data, msg->len));
+	large = g_malloc0 (G_MAXUINT16);
+	g_assert (nm_dhcp_helper_msg_append (msg, "k", 1, large, G_MAXUINT16 - 100));
+	g_assert (!nm_dhcp_helper_msg_append (msg, "k", 1, large, 100));
+	g_assert_cmpint (msg->len, <=, NM_DHCP_HELPER_MSG_SIZE_MAX);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	int fds[2];
+	GByteArray *msg;
+	guint8 *buf;
+} SeqpacketData;
+
+static void
+_seqpacket_init (SeqpacketData *data)
+{
+	g_assert_cmpint (socketpair (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, data->fds), ==, 0);
+	data->msg = g_byte_array_new ();
+	data->buf = g_malloc (NM_DHCP_HELPER_MSG_SIZE_MAX);
+}
+
+static void
+_seqpacket_clear (SeqpacketData *data)
+{
+	nm_close (data->fds[0]);
+	nm_close (data->fds[1]);
+	g_byte_array_unref (data->msg);
+	g_free (data->buf);
+}
+
+/* encode, send, receive, parse and acknowledge one event, like the
+ * helper and the daemon do it. */
+static void
+_seqpacket_roundtrip (gpointer user_data)
+{
+	SeqpacketData *data = user_data;
+	gs_unref_variant GVariant *options = NULL;
+	const NMDhcpHelperMsgHeader ack = {
+		.magic   = NM_DHCP_HELPER_MSG_MAGIC,
+		.version = NM_DHCP_HELPER_MSG_VERSION,
+		.type    = NM_DHCP_HELPER_MSG_TYPE_ACK,
+	};
+	NMDhcpHelperMsgType type;
+	ssize_t n;
+
+	/* the event is received as one datagram, like the daemon reads it. */
+	g_byte_array_set_size (data->msg, 0);
+	_build_event (data->msg);
+	g_assert_cmpint (send (data->fds[0], data->msg->data, data->msg->len, 0), ==, data->msg->len);
+
+	n = recv (data->fds[1], data->buf, NM_DHCP_HELPER_MSG_SIZE_MAX, MSG_TRUNC);
+	g_assert_cmpint (n, ==, data->msg->len);
+	options = nm_dhcp_helper_msg_parse_event (data->buf, n);
+	g_assert (options);
+	g_assert_cmpint (g_variant_n_children (options), ==, G_N_ELEMENTS (event_env));
+
+	g_assert_cmpint (send (data->fds[1], &ack, sizeof (ack), 0), ==, sizeof (ack));
+	n = recv (data->fds[0], data->buf, NM_DHCP_HELPER_MSG_SIZE_MAX, 0);
+	g_assert_cmpint (n, ==, sizeof (ack));
+	g_assert (nm_dhcp_helper_msg_parse_header (data->buf, n, &type));
+	g_assert_cmpint (type, ==, NM_DHCP_HELPER_MSG_TYPE_ACK);
+}
+
+static void
+test_msg_seqpacket (void)
+{
+	SeqpacketData data;
+
+	_seqpacket_init (&data);
+	_seqpacket_roundtrip (&data);
+	_seqpacket_clear (&data);
+}
+
+/*****************************************************************************/
+
+/* the D-Bus path: marshal the GVariant into a D-Bus message and back. This
+ * does not even account for the connection setup and authentication. */
+static void
+_dbus_marshal (gpointer user_data)
+{
+	gs_unref_variant GVariant *parameters = NULL;
+	gs_unref_object GDBusMessage *message = NULL;
+	gs_unref_object GDBusMessage *message2 = NULL;
+	gs_free guchar *blob = NULL;
+	gsize blob_len;
+
+	parameters = _build_event_variant ();
+	message = g_dbus_message_new_method_call (NULL,
+	                                          NM_DHCP_HELPER_SERVER_OBJECT_PATH,
+	                                          NM_DHCP_HELPER_SERVER_INTERFACE_NAME,
+	                                          NM_DHCP_HELPER_SERVER_METHOD_NOTIFY);
+	g_dbus_message_set_body (message, parameters);
+	blob = g_dbus_message_to_blob (message, &blob_len, G_DBUS_CAPABILITY_FLAGS_NONE, NULL);
+	g_assert (blob);
+	message2 = g_dbus_message_new_from_blob (blob, blob_len, G_DBUS_CAPABILITY_FLAGS_NONE, NULL);
+	g_assert (message2);
+}
+
+static void
+test_benchmark (void)
+{
+	SeqpacketData data;
+
+	if (!nmtst_test_perf ()) {
+		g_test_skip ("benchmark only runs in perf mode (-m perf)");
+		return;
+	}
+
+	nmtst_benchmark ("events via D-Bus (marshalling only)", 100000, _dbus_marshal, NULL);
+
+	_seqpacket_init (&data);
+	nmtst_benchmark ("events via seqpacket (round-trip)", 100000, _seqpacket_roundtrip, &data);
+	_seqpacket_clear (&data);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	g_test_add_func ("/dhcp/helper/msg-roundtrip", test_msg_roundtrip);
+	g_test_add_func ("/dhcp/helper/msg-invalid", test_msg_invalid);
+	g_test_add_func ("/dhcp/helper/msg-seqpacket", test_msg_seqpacket);
+	g_test_add_func ("/dhcp/helper/benchmark", test_benchmark);
+
+	return g_test_run ();
+}
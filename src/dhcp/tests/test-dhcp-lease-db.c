@@ -0,0 +1,309 @@
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2019 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <fcntl.h>
+
+#include "dhcp/nm-dhcp-lease-db.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+#define ADDR(str) nmtst_inet4_from_string (str)
+
+#define UUID1 "3b8d0b8c-8a5c-4c8a-9d2f-1c7a4d1e8f01"
+#define UUID2 "3b8d0b8c-8a5c-4c8a-9d2f-1c7a4d1e8f02"
+
+static char *
+_db_path (const char *dirname)
+{
+	return g_build_filename (dirname, "dhcp-leases.db", NULL);
+}
+
+static void
+_assert_lease (NMDhcpLeaseDb *db,
+               const char *iface,
+               const char *uuid,
+               in_addr_t expected_addr,
+               gint64 expected_timestamp)
+{
+	NMIPAddr addr;
+	gint64 timestamp;
+
+	g_assert (nm_dhcp_lease_db_get (db, AF_INET, iface, uuid, &addr, &timestamp));
+	g_assert_cmpint (addr.addr4, ==, expected_addr);
+	g_assert_cmpint (timestamp, ==, expected_timestamp);
+}
+
+/*****************************************************************************/
+
+static void
+test_set_get (void)
+{
+	gs_free char *dirname = g_dir_make_tmp ("nm-test-lease-db-XXXXXX", NULL);
+	gs_free char *path = _db_path (dirname);
+	gs_free_error GError *error = NULL;
+
+	{
+		nm_auto_unref_dhcp_lease_db NMDhcpLeaseDb *db = NULL;
+		in_addr_t addr;
+
+		db = nm_dhcp_lease_db_open (path, &error);
+		nmtst_assert_success (db, error);
+		g_assert (nm_dhcp_lease_db_is_new (db));
+		g_assert_cmpint (nm_dhcp_lease_db_get_num (db), ==, 0);
+
+		addr = ADDR ("192.168.1.10");
+		g_assert (nm_dhcp_lease_db_set (db, AF_INET, "eth0", UUID1, &addr, 100));
+		addr = ADDR ("192.168.2.10");
+		g_assert (nm_dhcp_lease_db_set (db, AF_INET, "eth1", UUID1, &addr, 200));
+
+		/* an update replaces the lease. */
+		addr = ADDR ("192.168.1.11");
+		g_assert (nm_dhcp_lease_db_set (db, AF_INET, "eth0", UUID1, &addr, 300));
+		g_assert_cmpint (nm_dhcp_lease_db_get_num (db), ==, 2);
+
+		_assert_lease (db, "eth0", UUID1, ADDR ("192.168.1.11"), 300);
+		_assert_lease (db, "eth1", UUID1, ADDR ("192.168.2.10"), 200);
+		g_assert (!nm_dhcp_lease_db_get (db, AF_INET, "eth0", UUID2, NULL, NULL));
+		g_assert (!nm_dhcp_lease_db_get (db, AF_INET6, "eth0", UUID1, NULL, NULL));
+	}
+
+	/* the leases survive a restart. */
+	{
+		nm_auto_unref_dhcp_lease_db NMDhcpLeaseDb *db = NULL;
+
+		db = nm_dhcp_lease_db_open (path, &error);
+		nmtst_assert_success (db, error);
+		g_assert (!nm_dhcp_lease_db_is_new (db));
+		g_assert_cmpint (nm_dhcp_lease_db_get_num (db), ==, 2);
+		_assert_lease (db, "eth0", UUID1, ADDR ("192.168.1.11"), 300);
+		_assert_lease (db, "eth1", UUID1, ADDR ("192.168.2.10"), 200);
+	}
+
+	nmtst_file_unlink (path);
+	g_assert (rmdir (dirname) == 0);
+}
+
+static void
+test_corrupt (void)
+{
+	gs_free char *dirname = g_dir_make_tmp ("nm-test-lease-db-XXXXXX", NULL);
+	gs_free char *path = _db_path (dirname);
+	gs_free_error GError *error = NULL;
+	nm_auto_unref_dhcp_lease_db NMDhcpLeaseDb *db = NULL;
+	in_addr_t addr;
+	int fd;
+
+	db = nm_dhcp_lease_db_open (path, &error);
+	nmtst_assert_success (db, error);
+	addr = ADDR ("192.168.1.10");
+	g_assert (nm_dhcp_lease_db_set (db, AF_INET, "eth0", UUID1, &addr, 100));
+	addr = ADDR ("192.168.2.10");
+	g_assert (nm_dhcp_lease_db_set (db, AF_INET, "eth1", UUID1, &addr, 200));
+	nm_clear_pointer (&db, nm_dhcp_lease_db_unref);
+
+	/* damage the first record, which holds the lease of eth0. */
+	fd = open (path, O_RDWR | O_CLOEXEC);
+	g_assert (fd >= 0);
+	g_assert_cmpint (pwrite (fd, "XXXX", 4, 64 + 40), ==, 4);
+	nm_close (fd);
+
+	db = nm_dhcp_lease_db_open (path, &error);
+	nmtst_assert_success (db, error);
+	g_assert (!nm_dhcp_lease_db_is_new (db));
+	g_assert_cmpint (nm_dhcp_lease_db_get_num (db), ==, 1);
+	g_assert (!nm_dhcp_lease_db_get (db, AF_INET, "eth0", UUID1, NULL, NULL));
+	_assert_lease (db, "eth1", UUID1, ADDR ("192.168.2.10"), 200);
+	nm_clear_pointer (&db, nm_dhcp_lease_db_unref);
+
+	/* a damaged header keeps the valid records. */
+	fd = open (path, O_RDWR | O_CLOEXEC);
+	g_assert (fd >= 0);
+	g_assert_cmpint (pwrite (fd, "XXXX", 4, 8), ==, 4);
+	nm_close (fd);
+
+	NMTST_EXPECT_NM_WARN ("*has an invalid header, recovered 1 leases*");
+	db = nm_dhcp_lease_db_open (path, &error);
+	nmtst_assert_success (db, error);
+	g_test_assert_expected_messages ();
+	g_assert (!nm_dhcp_lease_db_is_new (db));
+	g_assert_cmpint (nm_dhcp_lease_db_get_num (db), ==, 1);
+	_assert_lease (db, "eth1", UUID1, ADDR ("192.168.2.10"), 200);
+	nm_clear_pointer (&db, nm_dhcp_lease_db_unref);
+
+	/* and the header was rewritten. */
+	db = nm_dhcp_lease_db_open (path, &error);
+	nmtst_assert_success (db, error);
+	g_assert_cmpint (nm_dhcp_lease_db_get_num (db), ==, 1);
+	nm_clear_pointer (&db, nm_dhcp_lease_db_unref);
+
+	/* a file without valid records starts a new database. */
+	fd = open (path, O_RDWR | O_CLOEXEC);
+	g_assert (fd >= 0);
+	g_assert_cmpint (pwrite (fd, "XXXX", 4, 8), ==, 4);
+	g_assert_cmpint (pwrite (fd, "XXXX", 4, 64 + 128 + 40), ==, 4);
+	nm_close (fd);
+
+	NMTST_EXPECT_NM_WARN ("*is not a valid lease database*");
+	db = nm_dhcp_lease_db_open (path, &error);
+	nmtst_assert_success (db, error);
+	g_test_assert_expected_messages ();
+	g_assert (nm_dhcp_lease_db_is_new (db));
+	g_assert_cmpint (nm_dhcp_lease_db_get_num (db), ==, 0);
+	nm_clear_pointer (&db, nm_dhcp_lease_db_unref);
+
+	nmtst_file_unlink (path);
+	g_assert (rmdir (dirname) == 0);
+}
+
+static void
+test_grow (void)
+{
+	gs_free char *dirname = g_dir_make_tmp ("nm-test-lease-db-XXXXXX", NULL);
+	gs_free char *path = _db_path (dirname);
+	gs_free_error GError *error = NULL;
+	nm_auto_unref_dhcp_lease_db NMDhcpLeaseDb *db = NULL;
+	const guint N = 300;
+	guint i;
+
+	db = nm_dhcp_lease_db_open (path, &error);
+	nmtst_assert_success (db, error);
+
+	for (i = 0; i < N; i++) {
+		char iface[IFNAMSIZ];
+		in_addr_t addr = htonl (0x0a000000 + i);
+
+		nm_sprintf_buf (iface, "veth%u", i);
+		g_assert (nm_dhcp_lease_db_set (db, AF_INET, iface, UUID1, &addr, i));
+	}
+	nm_clear_pointer (&db, nm_dhcp_lease_db_unref);
+
+	db = nm_dhcp_lease_db_open (path, &error);
+	nmtst_assert_success (db, error);
+	g_assert_cmpint (nm_dhcp_lease_db_get_num (db), ==, N);
+	for (i = 0; i < N; i++) {
+		char iface[IFNAMSIZ];
+
+		nm_sprintf_buf (iface, "veth%u", i);
+		_assert_lease (db, iface, UUID1, htonl (0x0a000000 + i), i);
+	}
+	nm_clear_pointer (&db, nm_dhcp_lease_db_unref);
+
+	nmtst_file_unlink (path);
+	g_assert (rmdir (dirname) == 0);
+}
+
+static void
+test_remove (void)
+{
+	gs_free char *dirname = g_dir_make_tmp ("nm-test-lease-db-XXXXXX", NULL);
+	gs_free char *path = _db_path (dirname);
+	gs_free_error GError *error = NULL;
+	nm_auto_unref_dhcp_lease_db NMDhcpLeaseDb *db = NULL;
+	in_addr_t addr;
+
+	db = nm_dhcp_lease_db_open (path, &error);
+	nmtst_assert_success (db, error);
+	addr = ADDR ("192.168.1.10");
+	g_assert (nm_dhcp_lease_db_set (db, AF_INET, "eth0", UUID1, &addr, 100));
+	addr = ADDR ("192.168.2.10");
+	g_assert (nm_dhcp_lease_db_set (db, AF_INET, "eth1", UUID1, &addr, 200));
+	addr = ADDR ("192.168.1.20");
+	g_assert (nm_dhcp_lease_db_set (db, AF_INET, "eth0", UUID2, &addr, 300));
+
+	/* all leases of the connection go, the others stay. */
+	g_assert_cmpint (nm_dhcp_lease_db_remove (db, UUID1), ==, 2);
+	g_assert_cmpint (nm_dhcp_lease_db_remove (db, UUID1), ==, 0);
+	g_assert_cmpint (nm_dhcp_lease_db_get_num (db), ==, 1);
+	g_assert (!nm_dhcp_lease_db_get (db, AF_INET, "eth0", UUID1, NULL, NULL));
+	g_assert (!nm_dhcp_lease_db_get (db, AF_INET, "eth1", UUID1, NULL, NULL));
+	_assert_lease (db, "eth0", UUID2, ADDR ("192.168.1.20"), 300);
+
+	/* the freed slots are reused. */
+	addr = ADDR ("192.168.1.11");
+	g_assert (nm_dhcp_lease_db_set (db, AF_INET, "eth0", UUID1, &addr, 400));
+	nm_clear_pointer (&db, nm_dhcp_lease_db_unref);
+
+	/* and the removal is on disk. */
+	db = nm_dhcp_lease_db_open (path, &error);
+	nmtst_assert_success (db, error);
+	g_assert_cmpint (nm_dhcp_lease_db_get_num (db), ==, 2);
+	g_assert (!nm_dhcp_lease_db_get (db, AF_INET, "eth1", UUID1, NULL, NULL));
+	_assert_lease (db, "eth0", UUID1, ADDR ("192.168.1.11"), 400);
+	_assert_lease (db, "eth0", UUID2, ADDR ("192.168.1.20"), 300);
+	nm_clear_pointer (&db, nm_dhcp_lease_db_unref);
+
+	nmtst_file_unlink (path);
+	g_assert (rmdir (dirname) == 0);
+}
+
+static void
+test_import (void)
+{
+	gs_free char *dirname = g_dir_make_tmp ("nm-test-lease-db-XXXXXX", NULL);
+	gs_free char *path = _db_path (dirname);
+	gs_free_error GError *error = NULL;
+	nm_auto_unref_dhcp_lease_db NMDhcpLeaseDb *db = NULL;
+	NMIPAddr addr;
+
+	db = nm_dhcp_lease_db_open (path, &error);
+	nmtst_assert_success (db, error);
+
+	{
+		nmtst_auto_unlinkfile char *file1 = g_build_filename (dirname, "internal-" UUID1 "-eth-0.lease", NULL);
+		nmtst_auto_unlinkfile char *file2 = g_build_filename (dirname, "internal-" UUID2 "-eth1.lease", NULL);
+		nmtst_auto_unlinkfile char *file3 = g_build_filename (dirname, "internal-not-a-uuid-eth2.lease", NULL);
+
+		nmtst_file_set_contents (file1, "# This is private data. Do not parse.\n"
+		                                "ADDRESS=192.168.1.10\n"
+		                                "NETMASK=255.255.255.0\n");
+		nmtst_file_set_contents (file2, "NETMASK=255.255.255.0\n");
+		nmtst_file_set_contents (file3, "ADDRESS=192.168.3.10\n");
+
+		/* only the lease with an address and a valid name is imported. */
+		g_assert_cmpint (nm_dhcp_lease_db_import_files (db, dirname), ==, 1);
+	}
+
+	g_assert_cmpint (nm_dhcp_lease_db_get_num (db), ==, 1);
+	g_assert (nm_dhcp_lease_db_get (db, AF_INET, "eth-0", UUID1, &addr, NULL));
+	g_assert_cmpint (addr.addr4, ==, ADDR ("192.168.1.10"));
+	nm_clear_pointer (&db, nm_dhcp_lease_db_unref);
+
+	nmtst_file_unlink (path);
+	g_assert (rmdir (dirname) == 0);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	g_test_add_func ("/dhcp/lease-db/set-get", test_set_get);
+	g_test_add_func ("/dhcp/lease-db/corrupt", test_corrupt);
+	g_test_add_func ("/dhcp/lease-db/grow", test_grow);
+	g_test_add_func ("/dhcp/lease-db/remove", test_remove);
+	g_test_add_func ("/dhcp/lease-db/import", test_import);
+
+	return g_test_run ();
+}
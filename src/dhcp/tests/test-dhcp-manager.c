@@ -0,0 +1,345 @@
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2019 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "dhcp/nm-dhcp-manager.h"
+#include "nm-core-utils.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+/* a DHCP client that only records when it was started. */
+
+typedef struct {
+	NMDhcpClient parent;
+	gint64 started_at;
+	bool fail_start:1;
+} TestDhcpClient;
+
+typedef NMDhcpClientClass TestDhcpClientClass;
+
+GType test_dhcp_client_get_type (void);
+G_DEFINE_TYPE (TestDhcpClient, test_dhcp_client, NM_TYPE_DHCP_CLIENT)
+
+#define TEST_DHCP_CLIENT(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), test_dhcp_client_get_type (), TestDhcpClient))
+
+static gboolean
+test_dhcp_client_ip4_start (NMDhcpClient *client,
+                            const char *anycast_addr,
+                            const char *last_ip4_address,
+                            GError **error)
+{
+	TestDhcpClient *self = TEST_DHCP_CLIENT (client);
+
+	g_assert_cmpint (self->started_at, ==, 0);
+	self->started_at = nm_utils_get_monotonic_timestamp_ms ();
+
+	if (self->fail_start) {
+		nm_utils_error_set_literal (error, NM_UTILS_ERROR_UNKNOWN, "test failure");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+test_dhcp_client_init (TestDhcpClient *self)
+{
+}
+
+static void
+test_dhcp_client_class_init (TestDhcpClientClass *klass)
+{
+	klass->ip4_start = test_dhcp_client_ip4_start;
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	NMDedupMultiIndex *multi_idx;
+	GMainLoop *loop;
+	NMDhcpStartSched *sched;
+} Fixture;
+
+static void
+_fixture_setup (Fixture *f,
+                guint limit,
+                guint rate,
+                guint slot_hold_msec)
+{
+	f->multi_idx = nm_dedup_multi_index_new ();
+	f->loop = g_main_loop_new (NULL, FALSE);
+	f->sched = nm_dhcp_start_sched_new (limit, rate, 0, slot_hold_msec);
+}
+
+static void
+_fixture_teardown (Fixture *f)
+{
+	nm_clear_pointer (&f->sched, nm_dhcp_start_sched_free);
+	nm_clear_pointer (&f->loop, g_main_loop_unref);
+	nm_clear_pointer (&f->multi_idx, nm_dedup_multi_index_unref);
+}
+
+static TestDhcpClient *
+_client_queue (Fixture *f, int ifindex)
+{
+	gs_free char *iface = g_strdup_printf ("eth%d", ifindex);
+	TestDhcpClient *client;
+
+	client = g_object_new (test_dhcp_client_get_type (),
+	                       NM_DHCP_CLIENT_MULTI_IDX, f->multi_idx,
+	                       NM_DHCP_CLIENT_ADDR_FAMILY, AF_INET,
+	                       NM_DHCP_CLIENT_INTERFACE, iface,
+	                       NM_DHCP_CLIENT_IFINDEX, ifindex,
+	                       NM_DHCP_CLIENT_UUID, "3b8d0b8c-8a5c-4c8a-9d2f-1c7a4d1e8f01",
+	                       NM_DHCP_CLIENT_TIMEOUT, (guint) NM_DHCP_TIMEOUT_INFINITY,
+	                       NULL);
+	nm_dhcp_start_sched_queue (f->sched, NM_DHCP_CLIENT (client),
+	                           NULL, FALSE, NULL, NULL, NULL,
+	                           NM_SETTING_IP6_CONFIG_PRIVACY_UNKNOWN, 0);
+	return client;
+}
+
+static guint
+_count_started (TestDhcpClient *const*clients, guint n_clients)
+{
+	guint i;
+	guint n = 0;
+
+	for (i = 0; i < n_clients; i++) {
+		if (clients[i] && clients[i]->started_at != 0)
+			n++;
+	}
+	return n;
+}
+
+static void
+_assert_counts (Fixture *f, guint expected_queued, guint expected_running)
+{
+	guint n_queued;
+	guint n_running;
+
+	nm_dhcp_start_sched_get_counts (f->sched, &n_queued, &n_running);
+	g_assert_cmpint (n_queued, ==, expected_queued);
+	g_assert_cmpint (n_running, ==, expected_running);
+}
+
+static void
+_bind (Fixture *f, TestDhcpClient *client)
+{
+	gs_unref_object NMIP4Config *ip4_config = NULL;
+	gs_unref_hashtable GHashTable *options = NULL;
+
+	ip4_config = nm_ip4_config_new (f->multi_idx, nm_dhcp_client_get_ifindex (NM_DHCP_CLIENT (client)));
+	options = g_hash_table_new (nm_str_hash, g_str_equal);
+	nm_dhcp_client_set_state (NM_DHCP_CLIENT (client), NM_DHCP_STATE_BOUND, NM_IP_CONFIG_CAST (ip4_config), options);
+}
+
+/*****************************************************************************/
+
+static void
+test_limit (void)
+{
+	Fixture f = { };
+	TestDhcpClient *clients[6];
+	guint i;
+
+	_fixture_setup (&f, 2, 0, 100000);
+
+	for (i = 0; i < G_N_ELEMENTS (clients); i++)
+		clients[i] = _client_queue (&f, i + 1);
+	clients[5]->fail_start = TRUE;
+
+	/* nothing starts synchronously. */
+	_assert_counts (&f, 6, 0);
+	g_assert_cmpint (_count_started (clients, G_N_ELEMENTS (clients)), ==, 0);
+
+	nmtst_main_loop_run (f.loop, 50);
+	_assert_counts (&f, 4, 2);
+	g_assert (clients[0]->started_at);
+	g_assert (clients[1]->started_at);
+	g_assert_cmpint (_count_started (clients, G_N_ELEMENTS (clients)), ==, 2);
+
+	/* a lease frees the slot. */
+	_bind (&f, clients[0]);
+	_assert_counts (&f, 4, 1);
+	nmtst_main_loop_run (f.loop, 50);
+	_assert_counts (&f, 3, 2);
+	g_assert (clients[2]->started_at);
+
+	/* so does a failure... */
+	nm_dhcp_client_set_state (NM_DHCP_CLIENT (clients[1]), NM_DHCP_STATE_FAIL, NULL, NULL);
+	nmtst_main_loop_run (f.loop, 50);
+	_assert_counts (&f, 2, 2);
+	g_assert (clients[3]->started_at);
+
+	/* ... and stopping the client. */
+	nm_dhcp_client_stop (NM_DHCP_CLIENT (clients[2]), FALSE);
+	nmtst_main_loop_run (f.loop, 50);
+	_assert_counts (&f, 1, 2);
+	g_assert (clients[4]->started_at);
+
+	/* a client that fails to start frees its slot right away. */
+	nm_dhcp_client_stop (NM_DHCP_CLIENT (clients[3]), FALSE);
+	nmtst_main_loop_run (f.loop, 50);
+	g_assert (clients[5]->started_at);
+	_assert_counts (&f, 0, 1);
+
+	/* the caller can drop the request itself. */
+	nm_dhcp_start_sched_finish (f.sched, NM_DHCP_CLIENT (clients[4]));
+	_assert_counts (&f, 0, 0);
+
+	for (i = 0; i < G_N_ELEMENTS (clients); i++)
+		g_object_unref (clients[i]);
+	_fixture_teardown (&f);
+}
+
+/*****************************************************************************/
+
+static void
+test_rate (void)
+{
+	Fixture f = { };
+	TestDhcpClient *clients[25];
+	gint64 first = G_MAXINT64;
+	gint64 last = 0;
+	guint i;
+
+	/* 20 per second, thus the bucket holds a burst of 20 and every
+	 * further client waits 50 msec. */
+	_fixture_setup (&f, 0, 20, 100000);
+
+	for (i = 0; i < G_N_ELEMENTS (clients); i++)
+		clients[i] = _client_queue (&f, i + 1);
+
+	nmtst_main_loop_run (f.loop, 20);
+	g_assert_cmpint (_count_started (clients, G_N_ELEMENTS (clients)), ==, 20);
+	_assert_counts (&f, 5, 20);
+
+	nmtst_main_loop_run (f.loop, 1000);
+	g_assert_cmpint (_count_started (clients, G_N_ELEMENTS (clients)), ==, 25);
+	_assert_counts (&f, 0, 25);
+
+	for (i = 0; i < G_N_ELEMENTS (clients); i++) {
+		first = NM_MIN (first, clients[i]->started_at);
+		last = NM_MAX (last, clients[i]->started_at);
+	}
+	g_assert_cmpint (last - first, >=, 5 * 50 - 10);
+
+	/* the clients are started in order. */
+	for (i = 1; i < G_N_ELEMENTS (clients); i++)
+		g_assert_cmpint (clients[i - 1]->started_at, <=, clients[i]->started_at);
+
+	for (i = 0; i < G_N_ELEMENTS (clients); i++)
+		g_object_unref (clients[i]);
+	_fixture_teardown (&f);
+}
+
+/*****************************************************************************/
+
+static void
+test_slot_hold (void)
+{
+	Fixture f = { };
+	TestDhcpClient *clients[2];
+	guint i;
+
+	_fixture_setup (&f, 1, 0, 100);
+
+	for (i = 0; i < G_N_ELEMENTS (clients); i++)
+		clients[i] = _client_queue (&f, i + 1);
+
+	nmtst_main_loop_run (f.loop, 50);
+	g_assert (clients[0]->started_at);
+	g_assert (!clients[1]->started_at);
+	_assert_counts (&f, 1, 1);
+
+	/* the first client never gets a lease, but it releases its slot
+	 * after the hold time. */
+	nmtst_main_loop_run (f.loop, 300);
+	g_assert (clients[1]->started_at);
+	g_assert_cmpint (clients[1]->started_at - clients[0]->started_at, >=, 100);
+
+	/* and the slot of the second client expired too. */
+	_assert_counts (&f, 0, 0);
+
+	for (i = 0; i < G_N_ELEMENTS (clients); i++)
+		g_object_unref (clients[i]);
+	_fixture_teardown (&f);
+}
+
+/*****************************************************************************/
+
+static void
+test_client_destroyed (void)
+{
+	Fixture f = { };
+	TestDhcpClient *clients[3];
+	gpointer weak;
+	guint i;
+
+	_fixture_setup (&f, 1, 0, 100000);
+
+	for (i = 0; i < 2; i++)
+		clients[i] = _client_queue (&f, i + 1);
+
+	nmtst_main_loop_run (f.loop, 50);
+	g_assert (clients[0]->started_at);
+	_assert_counts (&f, 1, 1);
+
+	/* the scheduler holds no reference on the clients. A queued client
+	 * that goes away is never started. */
+	weak = clients[1];
+	g_object_add_weak_pointer (G_OBJECT (clients[1]), &weak);
+	g_clear_object (&clients[1]);
+	g_assert (!weak);
+	_assert_counts (&f, 0, 1);
+
+	/* a running one frees its slot. */
+	g_clear_object (&clients[0]);
+	_assert_counts (&f, 0, 0);
+
+	clients[2] = _client_queue (&f, 3);
+	nmtst_main_loop_run (f.loop, 50);
+	g_assert (clients[2]->started_at);
+	_assert_counts (&f, 0, 1);
+
+	/* freeing the scheduler with pending requests detaches from the clients. */
+	nm_clear_pointer (&f.sched, nm_dhcp_start_sched_free);
+	_bind (&f, clients[2]);
+
+	g_object_unref (clients[2]);
+	_fixture_teardown (&f);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "ALL");
+
+	g_test_add_func ("/dhcp/start-sched/limit", test_limit);
+	g_test_add_func ("/dhcp/start-sched/rate", test_rate);
+	g_test_add_func ("/dhcp/start-sched/slot-hold", test_slot_hold);
+	g_test_add_func ("/dhcp/start-sched/client-destroyed", test_client_destroyed);
+
+	return g_test_run ();
+}
@@ -0,0 +1,430 @@
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2019 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "n-dhcp4/src/n-dhcp4-private.h"
+
+#include "dhcp/nm-dhcp-client.h"
+#include "nm-ip4-config.h"
+#include "platform/tests/test-common.h"
+
+#define IFACE_VETH0 "nm-test-veth0"
+#define IFACE_VETH1 "nm-test-veth1"
+
+#define ADDR_SERVER  "192.168.123.1"
+#define ADDR_CLIENT  "192.168.123.50"
+#define ADDR_DNS     "192.168.123.2"
+
+/*****************************************************************************/
+
+typedef struct {
+	int ifindex0;
+	int ifindex1;
+	const guint8 *hwaddr1;
+	size_t hwaddr1_len;
+} test_fixture;
+
+static void
+fixture_setup (test_fixture *fixture, gconstpointer user_data)
+{
+	/* create veth pair. */
+	fixture->ifindex0 = nmtstp_link_veth_add (NM_PLATFORM_GET, -1, IFACE_VETH0, IFACE_VETH1)->ifindex;
+	fixture->ifindex1 = nmtstp_link_get_typed (NM_PLATFORM_GET, -1, IFACE_VETH1, NM_LINK_TYPE_VETH)->ifindex;
+
+	g_assert (nm_platform_link_set_up (NM_PLATFORM_GET, fixture->ifindex0, NULL));
+	g_assert (nm_platform_link_set_up (NM_PLATFORM_GET, fixture->ifindex1, NULL));
+
+	fixture->hwaddr1 = nm_platform_link_get_address (NM_PLATFORM_GET, fixture->ifindex1, &fixture->hwaddr1_len);
+
+	nmtstp_ip4_address_add (NULL, FALSE, fixture->ifindex0, nmtst_inet4_from_string (ADDR_SERVER),
+	                        24, 0, 3600, 1800, 0, NULL);
+}
+
+static void
+fixture_teardown (test_fixture *fixture, gconstpointer user_data)
+{
+	nm_platform_link_delete (NM_PLATFORM_GET, fixture->ifindex0);
+	nm_platform_link_delete (NM_PLATFORM_GET, fixture->ifindex1);
+}
+
+/*****************************************************************************/
+
+/* A minimal DHCP server on top of the server connection of n-dhcp4. It
+ * offers and acknowledges ADDR_CLIENT to whoever asks. */
+typedef struct {
+	NDhcp4SConnection connection;
+	NDhcp4SConnectionIp connection_ip;
+	struct in_addr addr_server;
+	GIOChannel *channel;
+	guint event_id;
+	guint n_discover;
+	guint n_request;
+} TestServer;
+
+static int
+test_server_append_options (NDhcp4Outgoing *reply)
+{
+	const in_addr_t netmask = nmtst_inet4_from_string ("255.255.255.0");
+	const in_addr_t router = nmtst_inet4_from_string (ADDR_SERVER);
+	const in_addr_t dns = nmtst_inet4_from_string (ADDR_DNS);
+	const guint8 mtu[2] = { 1400 >> 8, 1400 & 0xFF };
+	const guint8 classless[] = { 24, 10, 0, 0,   192, 168, 123, 3 };
+	int r;
+
+	r = n_dhcp4_outgoing_append (reply, N_DHCP4_OPTION_SUBNET_MASK, &netmask, sizeof (netmask));
+	if (r)
+		return r;
+	r = n_dhcp4_outgoing_append (reply, N_DHCP4_OPTION_ROUTER, &router, sizeof (router));
+	if (r)
+		return r;
+	r = n_dhcp4_outgoing_append (reply, N_DHCP4_OPTION_DOMAIN_NAME_SERVER, &dns, sizeof (dns));
+	if (r)
+		return r;
+	r = n_dhcp4_outgoing_append (reply, N_DHCP4_OPTION_DOMAIN_NAME, "example.com", NM_STRLEN ("example.com"));
+	if (r)
+		return r;
+	r = n_dhcp4_outgoing_append (reply, N_DHCP4_OPTION_INTERFACE_MTU, mtu, sizeof (mtu));
+	if (r)
+		return r;
+	return n_dhcp4_outgoing_append (reply, N_DHCP4_OPTION_CLASSLESS_STATIC_ROUTE, classless, sizeof (classless));
+}
+
+static gboolean
+test_server_event (GIOChannel *source, GIOCondition condition, gpointer user_data)
+{
+	TestServer *server = user_data;
+	_c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *message = NULL;
+	_c_cleanup_(n_dhcp4_outgoing_freep) NDhcp4Outgoing *reply = NULL;
+	const struct in_addr addr_client = { nmtst_inet4_from_string (ADDR_CLIENT) };
+	guint8 type;
+	int r;
+
+	r = n_dhcp4_s_connection_dispatch_io (&server->connection, &message);
+	g_assert_cmpint (r, ==, 0);
+	if (!message)
+		return G_SOURCE_CONTINUE;
+
+	r = n_dhcp4_incoming_query_message_type (message, &type);
+	g_assert_cmpint (r, ==, 0);
+
+	switch (type) {
+	case N_DHCP4_MESSAGE_DISCOVER:
+		server->n_discover++;
+		r = n_dhcp4_s_connection_offer_new (&server->connection, &reply, message,
+		                                    &server->addr_server, &addr_client, 3600);
+		break;
+	case N_DHCP4_MESSAGE_REQUEST:
+		server->n_request++;
+		r = n_dhcp4_s_connection_ack_new (&server->connection, &reply, message,
+		                                  &server->addr_server, &addr_client, 3600);
+		break;
+	default:
+		return G_SOURCE_CONTINUE;
+	}
+	g_assert_cmpint (r, ==, 0);
+
+	r = test_server_append_options (reply);
+	g_assert_cmpint (r, ==, 0);
+
+	r = n_dhcp4_s_connection_send_reply (&server->connection, &server->addr_server, reply);
+	g_assert_cmpint (r, ==, 0);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+test_server_start (TestServer *server, int ifindex)
+{
+	int r, fd;
+
+	*server = (TestServer) {
+		.connection    = N_DHCP4_S_CONNECTION_NULL (server->connection),
+		.connection_ip = N_DHCP4_S_CONNECTION_IP_NULL (server->connection_ip),
+		.addr_server   = { nmtst_inet4_from_string (ADDR_SERVER) },
+	};
+
+	r = n_dhcp4_s_connection_init (&server->connection, ifindex);
+	g_assert_cmpint (r, ==, 0);
+
+	n_dhcp4_s_connection_ip_init (&server->connection_ip, server->addr_server);
+	n_dhcp4_s_connection_ip_link (&server->connection_ip, &server->connection);
+
+	n_dhcp4_s_connection_get_fd (&server->connection, &fd);
+	server->channel = g_io_channel_unix_new (fd);
+	server->event_id = g_io_add_watch (server->channel, G_IO_IN, test_server_event, server);
+}
+
+static void
+test_server_stop (TestServer *server)
+{
+	nm_clear_g_source (&server->event_id);
+	nm_clear_pointer (&server->channel, g_io_channel_unref);
+	n_dhcp4_s_connection_ip_unlink (&server->connection_ip);
+	n_dhcp4_s_connection_ip_deinit (&server->connection_ip);
+	n_dhcp4_s_connection_deinit (&server->connection);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GMainLoop *loop;
+	NMDhcpState state;
+	NMIP4Config *ip4_config;
+	GHashTable *options;
+} TestClientData;
+
+static void
+client_state_changed (NMDhcpClient *client,
+                      NMDhcpState state,
+                      NMIP4Config *ip4_config,
+                      GHashTable *options,
+                      const char *event_id,
+                      TestClientData *data)
+{
+	data->state = state;
+	if (state == NM_DHCP_STATE_BOUND) {
+		g_assert (NM_IS_IP4_CONFIG (ip4_config));
+		g_set_object (&data->ip4_config, ip4_config);
+		nm_clear_pointer (&data->options, g_hash_table_unref);
+		data->options = g_hash_table_ref (options);
+	}
+	g_main_loop_quit (data->loop);
+}
+
+static void
+test_nettools_bound (test_fixture *fixture, gconstpointer user_data)
+{
+	nm_auto_unref_dedup_multi_index NMDedupMultiIndex *multi_idx = nm_dedup_multi_index_new ();
+	gs_unref_bytes GBytes *hwaddr = g_bytes_new (fixture->hwaddr1, fixture->hwaddr1_len);
+	gs_unref_object NMDhcpClient *client = NULL;
+	gs_free_error GError *error = NULL;
+	TestClientData data = { };
+	TestServer server;
+	const NMPlatformIP4Address *a;
+	const NMPlatformIP4Route *r;
+	NMDedupMultiIter iter;
+	gboolean has_default = FALSE;
+	gboolean has_classless = FALSE;
+
+	test_server_start (&server, fixture->ifindex0);
+
+	client = g_object_new (_nm_dhcp_client_factory_nettools.get_type (),
+	                       NM_DHCP_CLIENT_MULTI_IDX, multi_idx,
+	                       NM_DHCP_CLIENT_INTERFACE, IFACE_VETH1,
+	                       NM_DHCP_CLIENT_IFINDEX, fixture->ifindex1,
+	                       NM_DHCP_CLIENT_HWADDR, hwaddr,
+	                       NM_DHCP_CLIENT_ADDR_FAMILY, AF_INET,
+	                       NM_DHCP_CLIENT_UUID, "1d6d4ad0-c0a4-4e8f-8ce2-4f5fc1e46b01",
+	                       NM_DHCP_CLIENT_ROUTE_TABLE, (guint) RT_TABLE_MAIN,
+	                       NM_DHCP_CLIENT_ROUTE_METRIC, (guint) 100,
+	                       NM_DHCP_CLIENT_TIMEOUT, (guint) 10,
+	                       NULL);
+	g_assert (NM_IS_DHCP_CLIENT (client));
+
+	data.loop = g_main_loop_new (NULL, FALSE);
+	g_signal_connect (client,
+	                  NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED,
+	                  G_CALLBACK (client_state_changed),
+	                  &data);
+
+	if (!nm_dhcp_client_start_ip4 (client, NULL, NULL, NULL, &error))
+		g_error ("failed to start client: %s", error->message);
+
+	g_assert (nmtst_main_loop_run (data.loop, 5000));
+	g_assert_cmpint (data.state, ==, NM_DHCP_STATE_BOUND);
+	g_assert_cmpint (server.n_discover, >=, 1);
+	g_assert_cmpint (server.n_request, >=, 1);
+
+	g_assert_cmpint (nm_ip4_config_get_num_addresses (data.ip4_config), ==, 1);
+	a = nm_ip4_config_get_first_address (data.ip4_config);
+	nmtst_assert_ip4_address (a->address, ADDR_CLIENT);
+	g_assert_cmpint (a->plen, ==, 24);
+	g_assert_cmpint (a->lifetime, >, 3500);
+	g_assert_cmpint (a->lifetime, <=, 3600);
+
+	g_assert_cmpint (nm_ip4_config_get_num_nameservers (data.ip4_config), ==, 1);
+	nmtst_assert_ip4_address (nm_ip4_config_get_nameserver (data.ip4_config, 0), ADDR_DNS);
+	g_assert_cmpint (nm_ip4_config_get_num_domains (data.ip4_config), ==, 1);
+	g_assert_cmpstr (nm_ip4_config_get_domain (data.ip4_config, 0), ==, "example.com");
+	g_assert_cmpint (nm_ip4_config_get_mtu (data.ip4_config), ==, 1400);
+
+	/* the classless route has no default route, so the router option is honored. */
+	nm_ip_config_iter_ip4_route_for_each (&iter, data.ip4_config, &r) {
+		if (r->plen == 0) {
+			nmtst_assert_ip4_address (r->gateway, ADDR_SERVER);
+			g_assert_cmpint (r->metric, ==, 100);
+			has_default = TRUE;
+		} else if (r->plen == 24 && r->network == nmtst_inet4_from_string ("10.0.0.0")) {
+			nmtst_assert_ip4_address (r->gateway, "192.168.123.3");
+			has_classless = TRUE;
+		}
+	}
+	g_assert (has_default);
+	g_assert (has_classless);
+
+	g_assert_cmpstr (g_hash_table_lookup (data.options, "ip_address"), ==, ADDR_CLIENT);
+	g_assert_cmpstr (g_hash_table_lookup (data.options, "routers"), ==, ADDR_SERVER);
+	g_assert_cmpstr (g_hash_table_lookup (data.options, "requested_domain_name_servers"), ==, "1");
+
+	nm_dhcp_client_stop (client, FALSE);
+	g_signal_handlers_disconnect_by_data (client, &data);
+
+	g_clear_object (&data.ip4_config);
+	nm_clear_pointer (&data.options, g_hash_table_unref);
+	nm_clear_pointer (&data.loop, g_main_loop_unref);
+	test_server_stop (&server);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GMainLoop *loop;
+	guint n_clients;
+	guint n_bound;
+} TestScaleData;
+
+static void
+scale_client_state_changed (NMDhcpClient *client,
+                            NMDhcpState state,
+                            NMIP4Config *ip4_config,
+                            GHashTable *options,
+                            const char *event_id,
+                            TestScaleData *data)
+{
+	g_assert_cmpint (state, ==, NM_DHCP_STATE_BOUND);
+	nmtst_assert_ip4_address (nm_ip4_config_get_first_address (ip4_config)->address, ADDR_CLIENT);
+
+	if (++data->n_bound == data->n_clients)
+		g_main_loop_quit (data->loop);
+}
+
+static void
+test_nettools_shared_socket_scale (void)
+{
+	nm_auto_unref_dedup_multi_index NMDedupMultiIndex *multi_idx = nm_dedup_multi_index_new ();
+	const guint n_clients = nmtst_test_quick () ? 8 : 64;
+	gs_free int *ifindexes0 = g_new0 (int, n_clients);
+	gs_free TestServer *servers = g_new0 (TestServer, n_clients);
+	gs_unref_ptrarray GPtrArray *clients = g_ptr_array_new_with_free_func (g_object_unref);
+	TestScaleData data = {
+		.n_clients = n_clients,
+	};
+	GTimer *timer;
+	guint i;
+
+	/* all clients on all interfaces share one packet socket, the replies are
+	 * demultiplexed by ifindex and xid. */
+	nm_dhcp_nettools_set_shared_socket (TRUE);
+
+	for (i = 0; i < n_clients; i++) {
+		char ifname0[IFNAMSIZ];
+		char ifname1[IFNAMSIZ];
+		gs_unref_bytes GBytes *hwaddr = NULL;
+		gs_free char *uuid = NULL;
+		const guint8 *hwaddr1;
+		size_t hwaddr1_len;
+		NMDhcpClient *client;
+		int ifindex1;
+
+		nm_sprintf_buf (ifname0, "nm-scale%u-0", i);
+		nm_sprintf_buf (ifname1, "nm-scale%u-1", i);
+
+		ifindexes0[i] = nmtstp_link_veth_add (NM_PLATFORM_GET, -1, ifname0, ifname1)->ifindex;
+		ifindex1 = nmtstp_link_get_typed (NM_PLATFORM_GET, -1, ifname1, NM_LINK_TYPE_VETH)->ifindex;
+		g_assert (nm_platform_link_set_up (NM_PLATFORM_GET, ifindexes0[i], NULL));
+		g_assert (nm_platform_link_set_up (NM_PLATFORM_GET, ifindex1, NULL));
+		nmtstp_ip4_address_add (NULL, FALSE, ifindexes0[i], nmtst_inet4_from_string (ADDR_SERVER),
+		                        24, 0, 3600, 1800, 0, NULL);
+
+		test_server_start (&servers[i], ifindexes0[i]);
+
+		hwaddr1 = nm_platform_link_get_address (NM_PLATFORM_GET, ifindex1, &hwaddr1_len);
+		hwaddr = g_bytes_new (hwaddr1, hwaddr1_len);
+		uuid = g_strdup_printf ("1d6d4ad0-c0a4-4e8f-8ce2-%012x", i);
+
+		client = g_object_new (_nm_dhcp_client_factory_nettools.get_type (),
+		                       NM_DHCP_CLIENT_MULTI_IDX, multi_idx,
+		                       NM_DHCP_CLIENT_INTERFACE, ifname1,
+		                       NM_DHCP_CLIENT_IFINDEX, ifindex1,
+		                       NM_DHCP_CLIENT_HWADDR, hwaddr,
+		                       NM_DHCP_CLIENT_ADDR_FAMILY, AF_INET,
+		                       NM_DHCP_CLIENT_UUID, uuid,
+		                       NM_DHCP_CLIENT_ROUTE_TABLE, (guint) RT_TABLE_MAIN,
+		                       NM_DHCP_CLIENT_ROUTE_METRIC, (guint) 100,
+		                       NM_DHCP_CLIENT_TIMEOUT, (guint) 30,
+		                       NULL);
+		g_signal_connect (client,
+		                  NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED,
+		                  G_CALLBACK (scale_client_state_changed),
+		                  &data);
+		g_ptr_array_add (clients, client);
+	}
+
+	data.loop = g_main_loop_new (NULL, FALSE);
+
+	timer = g_timer_new ();
+	for (i = 0; i < n_clients; i++) {
+		gs_free_error GError *error = NULL;
+
+		if (!nm_dhcp_client_start_ip4 (clients->pdata[i], NULL, NULL, NULL, &error))
+			g_error ("failed to start client: %s", error->message);
+	}
+
+	g_assert (nmtst_main_loop_run (data.loop, 20000));
+	g_assert_cmpint (data.n_bound, ==, n_clients);
+	g_test_message ("shared socket: %u clients bound in %.3f sec",
+	                n_clients, g_timer_elapsed (timer, NULL));
+	g_timer_destroy (timer);
+
+	/* each server answered the client on its link. */
+	for (i = 0; i < n_clients; i++) {
+		g_assert_cmpint (servers[i].n_discover, >=, 1);
+		g_assert_cmpint (servers[i].n_request, >=, 1);
+	}
+
+	for (i = 0; i < n_clients; i++) {
+		nm_dhcp_client_stop (clients->pdata[i], FALSE);
+		g_signal_handlers_disconnect_by_data (clients->pdata[i], &data);
+	}
+	g_ptr_array_set_size (clients, 0);
+
+	for (i = 0; i < n_clients; i++) {
+		test_server_stop (&servers[i]);
+		nm_platform_link_delete (NM_PLATFORM_GET, ifindexes0[i]);
+	}
+
+	nm_clear_pointer (&data.loop, g_main_loop_unref);
+	nm_dhcp_nettools_set_shared_socket (FALSE);
+}
+
+/*****************************************************************************/
+
+NMTstpSetupFunc const _nmtstp_setup_platform_func = nm_linux_platform_setup;
+
+void
+_nmtstp_init_tests (int *argc, char ***argv)
+{
+	nmtst_init_with_logging (argc, argv, NULL, "ALL");
+}
+
+void
+_nmtstp_setup_tests (void)
+{
+	g_test_add ("/dhcp/nettools/bound", test_fixture, NULL, fixture_setup, test_nettools_bound, fixture_teardown);
+	g_test_add_func ("/dhcp/nettools/shared-socket-scale", test_nettools_shared_socket_scale);
+}
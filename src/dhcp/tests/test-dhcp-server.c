@@ -0,0 +1,428 @@
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2019 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "dhcp/nm-dhcp-server.h"
+#include "dhcp/nm-dhcp-client.h"
+#include "nm-ip4-config.h"
+#include "platform/tests/test-common.h"
+
+#define IFACE_VETH0 "nm-test-veth0"
+#define IFACE_VETH1 "nm-test-veth1"
+
+#define ADDR_SERVER  "192.168.123.1"
+#define ADDR_DNS     "192.168.123.2"
+
+/*****************************************************************************/
+
+#define ADDR(str) nmtst_inet4_from_string (str)
+
+static GBytes *
+_client_id (guint8 n)
+{
+	const guint8 id[] = { 0x01, 0x52, 0x54, 0x00, 0x12, 0x34, n };
+
+	return g_bytes_new (id, sizeof (id));
+}
+
+static gboolean
+_in_pool (in_addr_t addr)
+{
+	return NM_IN_SET (addr, ADDR ("192.168.1.10"),
+	                        ADDR ("192.168.1.11"),
+	                        ADDR ("192.168.1.12"));
+}
+
+/*****************************************************************************/
+
+static void
+test_leases_offer (void)
+{
+	nm_auto_free_dhcp_server_leases NMDhcpServerLeases *leases = NULL;
+	gs_unref_bytes GBytes *id1 = _client_id (1);
+	gs_unref_bytes GBytes *id2 = _client_id (2);
+	in_addr_t addr1, addr2;
+	gint64 now = 1000;
+
+	leases = nm_dhcp_server_leases_new (ADDR ("192.168.1.10"),
+	                                    ADDR ("192.168.1.12"),
+	                                    ADDR ("192.168.1.11"),
+	                                    10);
+
+	/* the requested address is honored, unless it is the server's. */
+	addr1 = nm_dhcp_server_leases_offer (leases, id1, ADDR ("192.168.1.11"), now);
+	g_assert (_in_pool (addr1));
+	g_assert_cmpint (addr1, !=, ADDR ("192.168.1.11"));
+	g_assert_cmpint (nm_dhcp_server_leases_offer (leases, id1, 0, now), ==, addr1);
+
+	addr2 = nm_dhcp_server_leases_offer (leases, id2, addr1, now);
+	g_assert (_in_pool (addr2));
+	g_assert_cmpint (addr2, !=, addr1);
+	g_assert_cmpint (addr2, !=, ADDR ("192.168.1.11"));
+
+	/* the pool is exhausted. */
+	{
+		gs_unref_bytes GBytes *id3 = _client_id (3);
+
+		g_assert_cmpint (nm_dhcp_server_leases_offer (leases, id3, 0, now), ==, 0);
+
+		/* ... until the offer expires. */
+		now += 120 * 1000;
+		g_assert_cmpint (nm_dhcp_server_leases_offer (leases, id3, addr2, now), ==, addr2);
+	}
+
+	/* the original client can still get its address, since nobody took it. */
+	g_assert_cmpint (nm_dhcp_server_leases_offer (leases, id1, 0, now), ==, addr1);
+}
+
+static void
+test_leases_bind (void)
+{
+	nm_auto_free_dhcp_server_leases NMDhcpServerLeases *leases = NULL;
+	gs_unref_bytes GBytes *id1 = _client_id (1);
+	gs_unref_bytes GBytes *id2 = _client_id (2);
+	in_addr_t addr1;
+	gint64 now = 1000;
+
+	leases = nm_dhcp_server_leases_new (ADDR ("192.168.1.10"),
+	                                    ADDR ("192.168.1.12"),
+	                                    ADDR ("192.168.1.1"),
+	                                    10);
+
+	addr1 = nm_dhcp_server_leases_offer (leases, id1, 0, now);
+	g_assert (_in_pool (addr1));
+	g_assert (nm_dhcp_server_leases_bind (leases, id1, addr1, 3600, now));
+
+	/* a bound lease is not handed out to others, not even after the offer timeout. */
+	now += 120 * 1000;
+	g_assert (!nm_dhcp_server_leases_bind (leases, id2, addr1, 3600, now));
+	g_assert_cmpint (nm_dhcp_server_leases_offer (leases, id2, addr1, now), !=, addr1);
+
+	/* addresses outside the pool are rejected. */
+	g_assert (!nm_dhcp_server_leases_bind (leases, id2, ADDR ("192.168.1.13"), 3600, now));
+	g_assert (!nm_dhcp_server_leases_bind (leases, id2, ADDR ("192.168.1.1"), 3600, now));
+
+	g_assert (!nm_dhcp_server_leases_release (leases, id1, ADDR ("192.168.1.13")));
+	g_assert (nm_dhcp_server_leases_release (leases, id1, addr1));
+
+	/* a client can bind a free address without offer, e.g. after a restart. */
+	g_assert (nm_dhcp_server_leases_bind (leases, id2, addr1, 3600, now));
+
+	/* the lease expires after its lifetime. */
+	now += 3601 * 1000;
+	g_assert_cmpint (nm_dhcp_server_leases_offer (leases, id1, addr1, now), ==, addr1);
+}
+
+static void
+test_leases_decline (void)
+{
+	nm_auto_free_dhcp_server_leases NMDhcpServerLeases *leases = NULL;
+	gs_unref_bytes GBytes *id1 = _client_id (1);
+	in_addr_t addr1, addr2;
+	gint64 now = 1000;
+
+	leases = nm_dhcp_server_leases_new (ADDR ("192.168.1.10"),
+	                                    ADDR ("192.168.1.12"),
+	                                    ADDR ("192.168.1.1"),
+	                                    10);
+
+	addr1 = nm_dhcp_server_leases_offer (leases, id1, 0, now);
+	g_assert (nm_dhcp_server_leases_bind (leases, id1, addr1, 3600, now));
+
+	nm_dhcp_server_leases_decline (leases, id1, addr1, now);
+	g_assert_cmpint (nm_dhcp_server_leases_get_num (leases), ==, 1);
+
+	addr2 = nm_dhcp_server_leases_offer (leases, id1, addr1, now);
+	g_assert (_in_pool (addr2));
+	g_assert_cmpint (addr2, !=, addr1);
+	g_assert_cmpint (nm_dhcp_server_leases_get_num (leases), ==, 2);
+}
+
+static void
+test_leases_max (void)
+{
+	nm_auto_free_dhcp_server_leases NMDhcpServerLeases *leases = NULL;
+	gs_unref_bytes GBytes *id1 = _client_id (1);
+	gs_unref_bytes GBytes *id2 = _client_id (2);
+
+	leases = nm_dhcp_server_leases_new (ADDR ("192.168.1.10"),
+	                                    ADDR ("192.168.1.12"),
+	                                    ADDR ("192.168.1.1"),
+	                                    1);
+
+	g_assert (_in_pool (nm_dhcp_server_leases_offer (leases, id1, 0, 1000)));
+	g_assert_cmpint (nm_dhcp_server_leases_offer (leases, id2, 0, 1000), ==, 0);
+	g_assert_cmpint (nm_dhcp_server_leases_get_num (leases), ==, 1);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	int ifindex0;
+	int ifindex1;
+	NMDedupMultiIndex *multi_idx;
+	NMDhcpServer *server;
+} test_fixture;
+
+static void
+fixture_setup (test_fixture *fixture, gconstpointer user_data)
+{
+	/* create veth pair, the server runs on the first interface. */
+	fixture->ifindex0 = nmtstp_link_veth_add (NM_PLATFORM_GET, -1, IFACE_VETH0, IFACE_VETH1)->ifindex;
+	fixture->ifindex1 = nmtstp_link_get_typed (NM_PLATFORM_GET, -1, IFACE_VETH1, NM_LINK_TYPE_VETH)->ifindex;
+
+	g_assert (nm_platform_link_set_up (NM_PLATFORM_GET, fixture->ifindex0, NULL));
+	g_assert (nm_platform_link_set_up (NM_PLATFORM_GET, fixture->ifindex1, NULL));
+
+	nmtstp_ip4_address_add (NULL, FALSE, fixture->ifindex0, ADDR (ADDR_SERVER),
+	                        24, 0, 3600, 1800, 0, NULL);
+
+	fixture->multi_idx = nm_dedup_multi_index_new ();
+	fixture->server = nm_dhcp_server_new (IFACE_VETH0, fixture->ifindex0);
+}
+
+static void
+fixture_teardown (test_fixture *fixture, gconstpointer user_data)
+{
+	nm_dhcp_server_stop (fixture->server);
+	g_clear_object (&fixture->server);
+	nm_clear_pointer (&fixture->multi_idx, nm_dedup_multi_index_unref);
+
+	nm_platform_link_delete (NM_PLATFORM_GET, fixture->ifindex0);
+	nm_platform_link_delete (NM_PLATFORM_GET, fixture->ifindex1);
+}
+
+static void
+_server_start (test_fixture *fixture, const char *nameserver, const char *upstream_nameserver)
+{
+	gs_unref_object NMIP4Config *config = NULL;
+	gs_unref_array GArray *upstream_nameservers = NULL;
+	gs_free_error GError *error = NULL;
+	const NMPlatformIP4Address address = {
+		.address      = ADDR (ADDR_SERVER),
+		.peer_address = ADDR (ADDR_SERVER),
+		.plen         = 24,
+	};
+
+	config = nm_ip4_config_new (fixture->multi_idx, fixture->ifindex0);
+	nm_ip4_config_add_address (config, &address);
+	if (nameserver)
+		nm_ip4_config_add_nameserver (config, ADDR (nameserver));
+
+	if (upstream_nameserver) {
+		in_addr_t a = ADDR (upstream_nameserver);
+
+		upstream_nameservers = g_array_new (FALSE, FALSE, sizeof (in_addr_t));
+		g_array_append_val (upstream_nameservers, a);
+	}
+
+	if (!nm_dhcp_server_start (fixture->server, config, upstream_nameservers, FALSE, &error))
+		g_error ("failed to start server: %s", error->message);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GMainLoop *loop;
+	NMDhcpState state;
+	NMIP4Config *ip4_config;
+} TestClientData;
+
+static void
+client_state_changed (NMDhcpClient *client,
+                      NMDhcpState state,
+                      NMIP4Config *ip4_config,
+                      GHashTable *options,
+                      const char *event_id,
+                      TestClientData *data)
+{
+	data->state = state;
+	if (state == NM_DHCP_STATE_BOUND) {
+		g_assert (NM_IS_IP4_CONFIG (ip4_config));
+		g_set_object (&data->ip4_config, ip4_config);
+	}
+	g_main_loop_quit (data->loop);
+}
+
+/* runs a nettools client on the second interface until its state changes. */
+static NMDhcpState
+_client_run (test_fixture *fixture,
+             const char *last_address,
+             NMIP4Config **out_ip4_config)
+{
+	gs_unref_bytes GBytes *hwaddr = NULL;
+	gs_unref_object NMDhcpClient *client = NULL;
+	gs_free_error GError *error = NULL;
+	TestClientData data = { };
+	const guint8 *hwaddr1;
+	size_t hwaddr1_len;
+
+	hwaddr1 = nm_platform_link_get_address (NM_PLATFORM_GET, fixture->ifindex1, &hwaddr1_len);
+	hwaddr = g_bytes_new (hwaddr1, hwaddr1_len);
+
+	client = g_object_new (_nm_dhcp_client_factory_nettools.get_type (),
+	                       NM_DHCP_CLIENT_MULTI_IDX, fixture->multi_idx,
+	                       NM_DHCP_CLIENT_INTERFACE, IFACE_VETH1,
+	                       NM_DHCP_CLIENT_IFINDEX, fixture->ifindex1,
+	                       NM_DHCP_CLIENT_HWADDR, hwaddr,
+	                       NM_DHCP_CLIENT_ADDR_FAMILY, AF_INET,
+	                       NM_DHCP_CLIENT_UUID, "8b9d6a2c-2bd4-4e61-9a0f-5d1c4e0d7c11",
+	                       NM_DHCP_CLIENT_ROUTE_TABLE, (guint) RT_TABLE_MAIN,
+	                       NM_DHCP_CLIENT_ROUTE_METRIC, (guint) 100,
+	                       NM_DHCP_CLIENT_TIMEOUT, (guint) 10,
+	                       NULL);
+	g_assert (NM_IS_DHCP_CLIENT (client));
+
+	data.loop = g_main_loop_new (NULL, FALSE);
+	g_signal_connect (client,
+	                  NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED,
+	                  G_CALLBACK (client_state_changed),
+	                  &data);
+
+	if (!nm_dhcp_client_start_ip4 (client, NULL, NULL, last_address, &error))
+		g_error ("failed to start client: %s", error->message);
+
+	g_assert (nmtst_main_loop_run (data.loop, 5000));
+
+	nm_dhcp_client_stop (client, FALSE);
+	g_signal_handlers_disconnect_by_data (client, &data);
+	nm_clear_pointer (&data.loop, g_main_loop_unref);
+
+	if (out_ip4_config)
+		*out_ip4_config = g_steal_pointer (&data.ip4_config);
+	else
+		g_clear_object (&data.ip4_config);
+	return data.state;
+}
+
+static void
+_assert_bound (NMIP4Config *ip4_config, const char *nameserver)
+{
+	const NMPlatformIP4Address *a;
+	in_addr_t netmask = _nm_utils_ip4_prefix_to_netmask (24);
+
+	g_assert_cmpint (nm_ip4_config_get_num_addresses (ip4_config), ==, 1);
+	a = nm_ip4_config_get_first_address (ip4_config);
+	g_assert_cmpint (a->plen, ==, 24);
+	g_assert_cmpint (a->address & netmask, ==, ADDR (ADDR_SERVER) & netmask);
+	g_assert_cmpint (a->address, !=, ADDR (ADDR_SERVER));
+	g_assert_cmpint (a->lifetime, >, 3500);
+	g_assert_cmpint (a->lifetime, <=, 3600);
+
+	g_assert_cmpint (nm_ip4_config_get_num_nameservers (ip4_config), ==, 1);
+	nmtst_assert_ip4_address (nm_ip4_config_get_nameserver (ip4_config, 0), nameserver);
+}
+
+static void
+test_server_bound (test_fixture *fixture, gconstpointer user_data)
+{
+	gs_unref_object NMIP4Config *ip4_config1 = NULL;
+	gs_unref_object NMIP4Config *ip4_config2 = NULL;
+
+	_server_start (fixture, NULL, ADDR_DNS);
+
+	/* DISCOVER, OFFER, REQUEST and ACK. Without own name servers, the
+	 * upstream one is announced. */
+	g_assert_cmpint (_client_run (fixture, NULL, &ip4_config1), ==, NM_DHCP_STATE_BOUND);
+	_assert_bound (ip4_config1, ADDR_DNS);
+
+	/* the client gets the same address again. */
+	g_assert_cmpint (_client_run (fixture, NULL, &ip4_config2), ==, NM_DHCP_STATE_BOUND);
+	_assert_bound (ip4_config2, ADDR_DNS);
+	g_assert_cmpint (nm_ip4_config_get_first_address (ip4_config1)->address,
+	                 ==,
+	                 nm_ip4_config_get_first_address (ip4_config2)->address);
+}
+
+static void
+test_server_nameservers (test_fixture *fixture, gconstpointer user_data)
+{
+	gs_unref_object NMIP4Config *ip4_config = NULL;
+
+	/* the name servers of the shared connection take precedence. */
+	_server_start (fixture, "192.168.123.3", ADDR_DNS);
+
+	g_assert_cmpint (_client_run (fixture, NULL, &ip4_config), ==, NM_DHCP_STATE_BOUND);
+	_assert_bound (ip4_config, "192.168.123.3");
+}
+
+static void
+test_server_upstream_nameservers (test_fixture *fixture, gconstpointer user_data)
+{
+	gs_unref_object NMIP4Config *ip4_config1 = NULL;
+	gs_unref_object NMIP4Config *ip4_config2 = NULL;
+	gs_unref_object NMIP4Config *ip4_config3 = NULL;
+	gs_unref_array GArray *upstream_nameservers = NULL;
+	in_addr_t a = ADDR (ADDR_DNS);
+
+	/* without upstream name servers, e.g. while the WAN is not up yet, the
+	 * clients get no name server... */
+	_server_start (fixture, NULL, NULL);
+	g_assert_cmpint (_client_run (fixture, NULL, &ip4_config1), ==, NM_DHCP_STATE_BOUND);
+	g_assert_cmpint (nm_ip4_config_get_num_nameservers (ip4_config1), ==, 0);
+
+	/* ... until the DNS configuration changes. */
+	upstream_nameservers = g_array_new (FALSE, FALSE, sizeof (in_addr_t));
+	g_array_append_val (upstream_nameservers, a);
+	nm_dhcp_server_set_upstream_nameservers (fixture->server, upstream_nameservers);
+
+	g_assert_cmpint (_client_run (fixture, NULL, &ip4_config2), ==, NM_DHCP_STATE_BOUND);
+	_assert_bound (ip4_config2, ADDR_DNS);
+
+	/* the lease table is kept, the client still gets the same address. */
+	g_assert_cmpint (nm_ip4_config_get_first_address (ip4_config2)->address,
+	                 ==,
+	                 nm_ip4_config_get_first_address (ip4_config1)->address);
+
+	nm_dhcp_server_set_upstream_nameservers (fixture->server, NULL);
+	g_assert_cmpint (_client_run (fixture, NULL, &ip4_config3), ==, NM_DHCP_STATE_BOUND);
+	g_assert_cmpint (nm_ip4_config_get_num_nameservers (ip4_config3), ==, 0);
+}
+
+static void
+test_server_nak (test_fixture *fixture, gconstpointer user_data)
+{
+	_server_start (fixture, NULL, ADDR_DNS);
+
+	/* INIT-REBOOT with an address outside of the pool gets a NAK. */
+	g_assert_cmpint (_client_run (fixture, "10.0.0.5", NULL), ==, NM_DHCP_STATE_EXPIRE);
+}
+
+/*****************************************************************************/
+
+NMTstpSetupFunc const _nmtstp_setup_platform_func = nm_linux_platform_setup;
+
+void
+_nmtstp_init_tests (int *argc, char ***argv)
+{
+	nmtst_init_with_logging (argc, argv, NULL, "ALL");
+}
+
+void
+_nmtstp_setup_tests (void)
+{
+	g_test_add_func ("/dhcp/server/leases/offer", test_leases_offer);
+	g_test_add_func ("/dhcp/server/leases/bind", test_leases_bind);
+	g_test_add_func ("/dhcp/server/leases/decline", test_leases_decline);
+	g_test_add_func ("/dhcp/server/leases/max", test_leases_max);
+
+	g_test_add ("/dhcp/server/bound", test_fixture, NULL, fixture_setup, test_server_bound, fixture_teardown);
+	g_test_add ("/dhcp/server/nameservers", test_fixture, NULL, fixture_setup, test_server_nameservers, fixture_teardown);
+	g_test_add ("/dhcp/server/upstream-nameservers", test_fixture, NULL, fixture_setup, test_server_upstream_nameservers, fixture_teardown);
+	g_test_add ("/dhcp/server/nak", test_fixture, NULL, fixture_setup, test_server_nak, fixture_teardown);
+}
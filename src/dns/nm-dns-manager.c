@@ -1818,6 +1818,52 @@ nm_dns_manager_end_updates (NMDnsManager *self, const char *func)
 	memset (priv->prev_hash, 0, sizeof (priv->prev_hash));
 }
 
+/**
+ * nm_dns_manager_get_ip4_nameservers:
+ * @self: the #NMDnsManager
+ *
+ * Returns: (transfer full): an array of in_addr_t with the upstream IPv4
+ *   name servers of the current configuration, in order of preference.
+ *   These are the name servers of the connections (or the global DNS
+ *   configuration), also when a DNS plugin like dnsmasq or
+ *   systemd-resolved is in use and resolv.conf only points to a local
+ *   resolver. Name servers on the loopback network are omitted, as they
+ *   are of no use to other hosts.
+ */
+GArray *
+nm_dns_manager_get_ip4_nameservers (NMDnsManager *self)
+{
+	NMDnsManagerPrivate *priv;
+	gs_strfreev char **searches = NULL;
+	gs_strfreev char **options = NULL;
+	gs_strfreev char **nameservers = NULL;
+	gs_strfreev char **nis_servers = NULL;
+	const char *nis_domain = NULL;
+	GArray *result;
+	guint i;
+
+	g_return_val_if_fail (NM_IS_DNS_MANAGER (self), NULL);
+
+	priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+
+	_collect_resolv_conf_data (self,
+	                           nm_config_data_get_global_dns_config (nm_config_get_data (priv->config)),
+	                           &searches, &options, &nameservers,
+	                           &nis_servers, &nis_domain);
+
+	result = g_array_new (FALSE, FALSE, sizeof (in_addr_t));
+	for (i = 0; nameservers && nameservers[i]; i++) {
+		in_addr_t addr;
+
+		if (!nm_utils_parse_inaddr_bin (AF_INET, nameservers[i], NULL, &addr))
+			continue;
+		if (nm_ip4_addr_is_localhost (addr))
+			continue;
+		g_array_append_val (result, addr);
+	}
+	return result;
+}
+
 void
 nm_dns_manager_stop (NMDnsManager *self)
 {
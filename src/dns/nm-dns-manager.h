@@ -91,6 +91,8 @@ gboolean nm_dns_manager_set_ip_config (NMDnsManager *self,
                                        NMIPConfig *ip_config,
                                        NMDnsIPConfigType ip_config_type);
 
+GArray *nm_dns_manager_get_ip4_nameservers (NMDnsManager *self);
+
 void nm_dns_manager_set_initial_hostname (NMDnsManager *self,
                                           const char *hostname);
 void nm_dns_manager_set_hostname         (NMDnsManager *self,
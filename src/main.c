@@ -37,6 +37,7 @@
 #include "platform/nm-linux-platform.h"
 #include "nm-dbus-manager.h"
 #include "devices/nm-device.h"
+#include "devices/nm-lldp-listener.h"
 #include "dhcp/nm-dhcp-manager.h"
 #include "nm-config.h"
 #include "nm-session-monitor.h"
@@ -429,8 +430,24 @@ main (int argc, char *argv[])
 	                                                         NM_CONFIG_KEYFILE_KEY_MAIN_AUTH_POLKIT,
 	                                                         NM_CONFIG_DEFAULT_MAIN_AUTH_POLKIT_BOOL));
 
+	nm_lldp_listener_set_shared_socket (nm_config_data_get_value_boolean (nm_config_get_data_orig (config),
+	                                                                      NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                                                      NM_CONFIG_KEYFILE_KEY_MAIN_LLDP_SHARED_SOCKET,
+	                                                                      FALSE));
+
 	manager = nm_manager_setup ();
 
+	nm_dbus_manager_set_notify_coalesce (nm_dbus_manager_get (),
+	                                     nm_config_data_get_value_int64 (nm_config_get_data_orig (config),
+	                                                                     NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                                                     NM_CONFIG_KEYFILE_KEY_MAIN_DBUS_COALESCE_PROPERTIES_CHANGED,
+	                                                                     10, -1, G_MAXINT32, -1));
+	nm_dbus_manager_set_legacy_properties_changed (nm_dbus_manager_get (),
+	                                               nm_config_data_get_value_boolean (nm_config_get_data_orig (config),
+	                                                                                 NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                                                                 NM_CONFIG_KEYFILE_KEY_MAIN_DBUS_LEGACY_PROPERTIES_CHANGED,
+	                                                                                 TRUE));
+
 	nm_dbus_manager_start (nm_dbus_manager_get(),
 	                       nm_manager_dbus_set_property_handle,
 	                       manager);
@@ -33,8 +33,34 @@
 
 #define _NMLOG_PREFIX_NAME                "ndisc"
 
+/* misbehaving routers or flapping links may send RAs at high rate.
+ * Emit at most one config change per this interval. */
+#define CONFIG_CHANGE_COALESCE_MSEC 500
+
 /*****************************************************************************/
 
+typedef enum {
+	TABLE_GATEWAYS,
+	TABLE_ADDRESSES,
+	TABLE_ROUTES,
+	TABLE_DNS_SERVERS,
+	TABLE_DNS_DOMAINS,
+	_TABLE_NUM,
+} Table;
+
+/* An entry of the hash index of a table. It maps the key of an item
+ * to its position in the GArray of the table. The items are stored in
+ * arbitrary order, their order is given by priority and seq. */
+typedef struct {
+	struct in6_addr address;
+	guint8 plen;
+	guint idx;
+	int priority;
+	guint64 seq;
+} IndexEntry;
+
+typedef void (*IndexGetKeyFunc) (gconstpointer item, IndexEntry *entry);
+
 struct _NMNDiscPrivate {
 	/* this *must* be the first field. */
 	NMNDiscDataInternal rdata;
@@ -53,6 +79,47 @@ struct _NMNDiscPrivate {
 	};
 	guint ra_timeout_id;  /* first RA timeout */
 	guint timeout_id;   /* prefix/dns/etc lifetime timeout */
+
+	/* routers may announce hundreds of routes. These index the items of
+	 * rdata by their key, so that refreshing them on every RA doesn't
+	 * scan the arrays. The indexed arrays of rdata are unordered, so that
+	 * adding and removing items doesn't move the others. */
+	GHashTable *gateways_idx;
+	GHashTable *routes_idx;
+	GHashTable *dns_servers_idx;
+	guint64 idx_seq;
+
+	/* the indexed tables sorted by preference. They are only built when
+	 * emitting a config change, and are what the NMNDiscData exposes. */
+	struct {
+		GArray *gateways;
+		GArray *routes;
+		GArray *dns_servers;
+	} ordered;
+
+	/* for each table, a lower bound for the earliest expiry (or refresh)
+	 * of its items. check_timestamps() only scans the tables that have
+	 * items due. The bounds are lowered whenever an item is added or
+	 * updated, and recomputed when the table is scanned. */
+	gint64 next_expiry[_TABLE_NUM];
+
+	/* the data of the last emitted config change. Changes without
+	 * semantic difference to it (like refreshed lifetimes) are not
+	 * emitted. */
+	struct {
+		GArray *gateways;
+		GArray *addresses;
+		GArray *routes;
+		GArray *dns_servers;
+		GArray *dns_domains;
+	} applied;
+
+	/* changes are emitted at most once per CONFIG_CHANGE_COALESCE_MSEC,
+	 * the ones in between are accumulated. */
+	NMNDiscConfigMap changed_pending;
+	gint64 changed_last_ms;
+	guint changed_timeout_id;
+
 	char *last_error;
 	NMUtilsIPv6IfaceId iid;
 
@@ -193,6 +260,189 @@ _get_exp (char *buf, gsize buf_size, gint64 now_ns, gint64 expiry_time)
 #define get_exp(buf, now_ns, item) \
 	_get_exp ((buf), G_N_ELEMENTS (buf), (now_ns), (get_expiry (item)))
 
+static void
+_next_expiry_lower (NMNDiscPrivate *priv, Table table, gint64 expiry)
+{
+	if (priv->next_expiry[table] > expiry)
+		priv->next_expiry[table] = expiry;
+}
+
+/*****************************************************************************/
+
+static guint
+_index_entry_hash (gconstpointer ptr)
+{
+	const IndexEntry *entry = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 1543418291u);
+	nm_hash_update_in6addr (&h, &entry->address);
+	nm_hash_update_val (&h, entry->plen);
+	return nm_hash_complete (&h);
+}
+
+static gboolean
+_index_entry_equal (gconstpointer a, gconstpointer b)
+{
+	const IndexEntry *entry_a = a;
+	const IndexEntry *entry_b = b;
+
+	return    entry_a->plen == entry_b->plen
+	       && IN6_ARE_ADDR_EQUAL (&entry_a->address, &entry_b->address);
+}
+
+static void
+_index_entry_free (gpointer ptr)
+{
+	g_slice_free (IndexEntry, ptr);
+}
+
+static GHashTable *
+_index_new (void)
+{
+	return g_hash_table_new_full (_index_entry_hash, _index_entry_equal,
+	                              _index_entry_free, NULL);
+}
+
+static void
+_gateway_get_key (gconstpointer item, IndexEntry *entry)
+{
+	const NMNDiscGateway *gateway = item;
+
+	entry->address = gateway->address;
+	entry->plen = 128;
+}
+
+static void
+_route_get_key (gconstpointer item, IndexEntry *entry)
+{
+	const NMNDiscRoute *route = item;
+
+	entry->address = route->network;
+	entry->plen = route->plen;
+}
+
+static void
+_dns_server_get_key (gconstpointer item, IndexEntry *entry)
+{
+	const NMNDiscDNSServer *dns_server = item;
+
+	entry->address = dns_server->address;
+	entry->plen = 128;
+}
+
+#define _table_item(array, i) \
+	((gpointer) &(array)->data[((gsize) (i)) * g_array_get_element_size (array)])
+
+static guint
+_table_lookup (GArray *array, GHashTable *index, IndexGetKeyFunc get_key, gconstpointer item)
+{
+	IndexEntry needle;
+	const IndexEntry *entry;
+
+	get_key (item, &needle);
+	entry = g_hash_table_lookup (index, &needle);
+	if (!entry)
+		return G_MAXUINT;
+
+	nm_assert (entry->idx < array->len);
+	return entry->idx;
+}
+
+static void
+_table_insert (NMNDiscPrivate *priv, GArray *array, GHashTable *index, IndexGetKeyFunc get_key, int priority, gconstpointer item)
+{
+	IndexEntry *entry;
+
+	nm_assert (_table_lookup (array, index, get_key, item) == G_MAXUINT);
+
+	entry = g_slice_new (IndexEntry);
+	get_key (item, entry);
+	entry->idx = array->len;
+	entry->priority = priority;
+	entry->seq = ++priv->idx_seq;
+	g_hash_table_add (index, entry);
+
+	g_array_append_vals (array, item, 1);
+}
+
+static void
+_table_remove (GArray *array, GHashTable *index, IndexGetKeyFunc get_key, guint idx)
+{
+	IndexEntry needle;
+	guint last = array->len - 1;
+
+	get_key (_table_item (array, idx), &needle);
+	if (!g_hash_table_remove (index, &needle))
+		nm_assert_not_reached ();
+
+	/* move the last item into the gap. */
+	if (idx != last) {
+		IndexEntry *entry;
+
+		get_key (_table_item (array, last), &needle);
+		entry = g_hash_table_lookup (index, &needle);
+		nm_assert (entry && entry->idx == last);
+		entry->idx = idx;
+	}
+	g_array_remove_index_fast (array, idx);
+}
+
+static int
+_index_entry_cmp (gconstpointer pa, gconstpointer pb, gpointer user_data)
+{
+	const IndexEntry *a = *((const IndexEntry *const*) pa);
+	const IndexEntry *b = *((const IndexEntry *const*) pb);
+	gboolean newest_first = GPOINTER_TO_INT (user_data);
+
+	NM_CMP_DIRECT (b->priority, a->priority);
+	if (newest_first)
+		NM_CMP_DIRECT (b->seq, a->seq);
+	else
+		NM_CMP_DIRECT (a->seq, b->seq);
+	return 0;
+}
+
+/* copies the items of a table to @dst, with more preferable items first. Items
+ * with the same preference are in the order they were added, or in reverse. */
+static void
+_table_order (GArray *dst, GArray *array, GHashTable *index, gboolean newest_first)
+{
+	gs_free const IndexEntry **entries = NULL;
+	GHashTableIter iter;
+	const IndexEntry *entry;
+	guint i;
+
+	nm_assert (g_hash_table_size (index) == array->len);
+
+	g_array_set_size (dst, 0);
+	if (!array->len)
+		return;
+
+	entries = g_new (const IndexEntry *, array->len);
+	i = 0;
+	g_hash_table_iter_init (&iter, index);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &entry, NULL))
+		entries[i++] = entry;
+
+	g_qsort_with_data (entries, array->len, sizeof (entries[0]), _index_entry_cmp, GINT_TO_POINTER (newest_first));
+
+	for (i = 0; i < array->len; i++)
+		g_array_append_vals (dst, _table_item (array, entries[i]->idx), 1);
+}
+
+static void
+_ASSERT_table_index (GArray *array, GHashTable *index, IndexGetKeyFunc get_key)
+{
+#if NM_MORE_ASSERTS > 10
+	guint i;
+
+	nm_assert (g_hash_table_size (index) == array->len);
+	for (i = 0; i < array->len; i++)
+		nm_assert (_table_lookup (array, index, get_key, _table_item (array, i)) == i);
+#endif
+}
+
 /*****************************************************************************/
 
 NMPNetns *
@@ -249,12 +499,172 @@ nm_ndisc_get_node_type (NMNDisc *self)
 
 /*****************************************************************************/
 
+static gboolean
+_gateway_equal (gconstpointer a, gconstpointer b)
+{
+	const NMNDiscGateway *gateway_a = a;
+	const NMNDiscGateway *gateway_b = b;
+
+	return    gateway_a->preference == gateway_b->preference
+	       && IN6_ARE_ADDR_EQUAL (&gateway_a->address, &gateway_b->address);
+}
+
+static gboolean
+_route_equal (gconstpointer a, gconstpointer b)
+{
+	const NMNDiscRoute *route_a = a;
+	const NMNDiscRoute *route_b = b;
+
+	return    route_a->plen == route_b->plen
+	       && route_a->preference == route_b->preference
+	       && IN6_ARE_ADDR_EQUAL (&route_a->network, &route_b->network)
+	       && IN6_ARE_ADDR_EQUAL (&route_a->gateway, &route_b->gateway);
+}
+
+static gboolean
+_dns_server_equal (gconstpointer a, gconstpointer b)
+{
+	const NMNDiscDNSServer *dns_server_a = a;
+	const NMNDiscDNSServer *dns_server_b = b;
+
+	return IN6_ARE_ADDR_EQUAL (&dns_server_a->address, &dns_server_b->address);
+}
+
+static gboolean
+_dns_domain_equal (gconstpointer a, gconstpointer b)
+{
+	const NMNDiscDNSDomain *dns_domain_a = a;
+	const NMNDiscDNSDomain *dns_domain_b = b;
+
+	return nm_streq0 (dns_domain_a->domain, dns_domain_b->domain);
+}
+
+/* compares the items of a table with the applied ones, ignoring
+ * their timestamps and lifetimes. */
+static gboolean
+_applied_differs (GArray *applied, GArray *array, GEqualFunc equal)
+{
+	guint i;
+
+	if (applied->len != array->len)
+		return TRUE;
+
+	for (i = 0; i < array->len; i++) {
+		if (!equal (_table_item (applied, i), _table_item (array, i)))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static gboolean
+_expiry_need_sync (gint32 now, gint64 expiry, gint64 expiry_applied, gint32 *nextevent)
+{
+	if (expiry == expiry_applied)
+		return FALSE;
+
+	/* shortened lifetimes (like a deprecated prefix) are applied right away. */
+	if (   expiry < expiry_applied
+	    || expiry == _EXPIRY_INFINITY)
+		return TRUE;
+
+	/* an extended lifetime only needs to be applied before the applied one
+	 * runs out. Do it when the applied lifetime has less than half of the
+	 * new lifetime left. */
+	return !expiry_next (now, 2 * expiry_applied - expiry, nextevent);
+}
+
+/* Addresses are the only items whose lifetimes are configured in the
+ * kernel, so unlike for the other tables, refreshing their lifetimes
+ * eventually requires a config change. */
+static gboolean
+_addresses_need_sync (NMNDiscPrivate *priv, gint32 now, gint32 *nextevent)
+{
+	GArray *addresses = priv->rdata.addresses;
+	GArray *applied = priv->applied.addresses;
+	guint i;
+
+	if (addresses->len != applied->len)
+		return TRUE;
+
+	for (i = 0; i < addresses->len; i++) {
+		const NMNDiscAddress *item = &g_array_index (addresses, NMNDiscAddress, i);
+		const NMNDiscAddress *item_applied = &g_array_index (applied, NMNDiscAddress, i);
+
+		if (!IN6_ARE_ADDR_EQUAL (&item->address, &item_applied->address))
+			return TRUE;
+		if (_expiry_need_sync (now, get_expiry (item), get_expiry (item_applied), nextevent))
+			return TRUE;
+		if (_expiry_need_sync (now, get_expiry_preferred (item), get_expiry_preferred (item_applied), nextevent))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static NMNDiscConfigMap
+_applied_filter_changed (NMNDiscPrivate *priv, NMNDiscConfigMap changed)
+{
+	NMNDiscDataInternal *rdata = &priv->rdata;
+
+	if (   NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_GATEWAYS)
+	    && !_applied_differs (priv->applied.gateways, priv->ordered.gateways, _gateway_equal))
+		changed &= ~NM_NDISC_CONFIG_GATEWAYS;
+	if (   NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_ADDRESSES)
+	    && !_addresses_need_sync (priv, nm_utils_get_monotonic_timestamp_s (), NULL))
+		changed &= ~NM_NDISC_CONFIG_ADDRESSES;
+	if (   NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_ROUTES)
+	    && !_applied_differs (priv->applied.routes, priv->ordered.routes, _route_equal))
+		changed &= ~NM_NDISC_CONFIG_ROUTES;
+	if (   NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_DNS_SERVERS)
+	    && !_applied_differs (priv->applied.dns_servers, priv->ordered.dns_servers, _dns_server_equal))
+		changed &= ~NM_NDISC_CONFIG_DNS_SERVERS;
+	if (   NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_DNS_DOMAINS)
+	    && !_applied_differs (priv->applied.dns_domains, rdata->dns_domains, _dns_domain_equal))
+		changed &= ~NM_NDISC_CONFIG_DNS_DOMAINS;
+	return changed;
+}
+
+static void
+_applied_set (GArray *applied, GArray *array)
+{
+	g_array_set_size (applied, 0);
+	g_array_append_vals (applied, array->data, array->len);
+}
+
+static void
+_applied_update (NMNDiscPrivate *priv, NMNDiscConfigMap changed)
+{
+	NMNDiscDataInternal *rdata = &priv->rdata;
+
+	if (NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_GATEWAYS))
+		_applied_set (priv->applied.gateways, priv->ordered.gateways);
+	if (NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_ADDRESSES))
+		_applied_set (priv->applied.addresses, rdata->addresses);
+	if (NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_ROUTES))
+		_applied_set (priv->applied.routes, priv->ordered.routes);
+	if (NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_DNS_SERVERS))
+		_applied_set (priv->applied.dns_servers, priv->ordered.dns_servers);
+	if (NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_DNS_DOMAINS)) {
+		guint i;
+
+		_applied_set (priv->applied.dns_domains, rdata->dns_domains);
+		for (i = 0; i < priv->applied.dns_domains->len; i++) {
+			NMNDiscDNSDomain *item = &g_array_index (priv->applied.dns_domains, NMNDiscDNSDomain, i);
+
+			item->domain = g_strdup (item->domain);
+		}
+	}
+}
+
+/*****************************************************************************/
+
 static void
-_ASSERT_data_gateways (const NMNDiscDataInternal *data)
+_ASSERT_data_gateways (NMNDiscPrivate *priv)
 {
 #if NM_MORE_ASSERTS > 10
+	const NMNDiscDataInternal *data = &priv->rdata;
 	guint i, j;
-	const NMNDiscGateway *item_prev = NULL;
+
+	_ASSERT_table_index (data->gateways, priv->gateways_idx, _gateway_get_key);
 
 	if (!data->gateways->len)
 		return;
@@ -271,33 +681,45 @@ _ASSERT_data_gateways (const NMNDiscDataInternal *data)
 		}
 
 		nm_assert (item->lifetime > 0);
-		if (i > 0)
-			nm_assert (_preference_to_priority (item_prev->preference) >= _preference_to_priority (item->preference));
-
-		item_prev = item;
 	}
 #endif
 }
 
 /*****************************************************************************/
 
+static void
+_ordered_update (NMNDiscPrivate *priv)
+{
+	NMNDiscDataInternal *data = &priv->rdata;
+
+	_ASSERT_data_gateways (priv);
+	_ASSERT_table_index (data->routes, priv->routes_idx, _route_get_key);
+	_ASSERT_table_index (data->dns_servers, priv->dns_servers_idx, _dns_server_get_key);
+
+	/* gateways and routes are sorted by preference. Among routes with the same
+	 * preference, the most recent one comes first. */
+	_table_order (priv->ordered.gateways, data->gateways, priv->gateways_idx, FALSE);
+	_table_order (priv->ordered.routes, data->routes, priv->routes_idx, TRUE);
+	_table_order (priv->ordered.dns_servers, data->dns_servers, priv->dns_servers_idx, FALSE);
+}
+
 static const NMNDiscData *
-_data_complete (NMNDiscDataInternal *data)
+_data_complete (NMNDiscPrivate *priv)
 {
-	_ASSERT_data_gateways (data);
+	NMNDiscDataInternal *data = &priv->rdata;
 
-#define _SET(data, field) \
+#define _SET(data, field, array) \
 	G_STMT_START { \
-		if ((data->public.field##_n = data->field->len) > 0) \
-			data->public.field = (gpointer) data->field->data; \
+		if ((data->public.field##_n = (array)->len) > 0) \
+			data->public.field = (gpointer) (array)->data; \
 		else \
 			data->public.field = NULL; \
 	} G_STMT_END
-	_SET (data, gateways);
-	_SET (data, addresses);
-	_SET (data, routes);
-	_SET (data, dns_servers);
-	_SET (data, dns_domains);
+	_SET (data, gateways, priv->ordered.gateways);
+	_SET (data, addresses, data->addresses);
+	_SET (data, routes, priv->ordered.routes);
+	_SET (data, dns_servers, priv->ordered.dns_servers);
+	_SET (data, dns_domains, data->dns_domains);
 #undef _SET
 	return &data->public;
 }
@@ -305,60 +727,98 @@ _data_complete (NMNDiscDataInternal *data)
 void
 nm_ndisc_emit_config_change (NMNDisc *self, NMNDiscConfigMap changed)
 {
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (self);
+
+	changed |= priv->changed_pending;
+	priv->changed_pending = NM_NDISC_CONFIG_NONE;
+	nm_clear_g_source (&priv->changed_timeout_id);
+
+	_ordered_update (priv);
+
+	changed = _applied_filter_changed (priv, changed);
+	if (!changed)
+		return;
+
+	priv->changed_last_ms = nm_utils_get_monotonic_timestamp_ms ();
+	_applied_update (priv, changed);
+
 	_config_changed_log (self, changed);
 	g_signal_emit (self, signals[CONFIG_RECEIVED], 0,
-	               _data_complete (&NM_NDISC_GET_PRIVATE (self)->rdata),
+	               _data_complete (priv),
 	               (guint) changed);
 }
 
+static gboolean
+config_change_timeout_cb (gpointer user_data)
+{
+	NMNDisc *ndisc = user_data;
+
+	NM_NDISC_GET_PRIVATE (ndisc)->changed_timeout_id = 0;
+	nm_ndisc_emit_config_change (ndisc, NM_NDISC_CONFIG_NONE);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+config_change_schedule (NMNDisc *ndisc, NMNDiscConfigMap changed)
+{
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	gint64 now_ms;
+
+	priv->changed_pending |= changed;
+	if (priv->changed_timeout_id)
+		return;
+
+	now_ms = nm_utils_get_monotonic_timestamp_ms ();
+	if (   !priv->changed_last_ms
+	    || now_ms >= priv->changed_last_ms + CONFIG_CHANGE_COALESCE_MSEC) {
+		nm_ndisc_emit_config_change (ndisc, NM_NDISC_CONFIG_NONE);
+		return;
+	}
+
+	priv->changed_timeout_id = g_timeout_add (priv->changed_last_ms + CONFIG_CHANGE_COALESCE_MSEC - now_ms,
+	                                          config_change_timeout_cb,
+	                                          ndisc);
+}
+
 /*****************************************************************************/
 
 gboolean
 nm_ndisc_add_gateway (NMNDisc *ndisc, const NMNDiscGateway *new)
 {
-	NMNDiscDataInternal *rdata = &NM_NDISC_GET_PRIVATE(ndisc)->rdata;
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	NMNDiscDataInternal *rdata = &priv->rdata;
 	guint i;
-	guint insert_idx = G_MAXUINT;
 
-	for (i = 0; i < rdata->gateways->len; ) {
+	i = _table_lookup (rdata->gateways, priv->gateways_idx, _gateway_get_key, new);
+	if (i != G_MAXUINT) {
 		NMNDiscGateway *item = &g_array_index (rdata->gateways, NMNDiscGateway, i);
 
-		if (IN6_ARE_ADDR_EQUAL (&item->address, &new->address)) {
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdata->gateways, i);
-				_ASSERT_data_gateways (rdata);
-				return TRUE;
-			}
-
-			if (item->preference != new->preference) {
-				g_array_remove_index (rdata->gateways, i);
-				continue;
-			}
+		if (new->lifetime == 0) {
+			_table_remove (rdata->gateways, priv->gateways_idx, _gateway_get_key, i);
+			_ASSERT_data_gateways (priv);
+			return TRUE;
+		}
 
+		if (item->preference == new->preference) {
 			if (get_expiry (item) == get_expiry (new))
 				return FALSE;
 
 			*item = *new;
-			_ASSERT_data_gateways (rdata);
+			_next_expiry_lower (priv, TABLE_GATEWAYS, get_expiry (new));
+			_ASSERT_data_gateways (priv);
 			return TRUE;
 		}
 
-		/* Put before less preferable gateways. */
-		if (   _preference_to_priority (item->preference) < _preference_to_priority (new->preference)
-		    && insert_idx == G_MAXUINT)
-			insert_idx = i;
-
-		i++;
+		/* the preference changed. Re-add it. */
+		_table_remove (rdata->gateways, priv->gateways_idx, _gateway_get_key, i);
 	}
 
 	if (new->lifetime) {
-		g_array_insert_val (rdata->gateways,
-		                    insert_idx == G_MAXUINT
-		                      ? rdata->gateways->len
-		                      : insert_idx,
-		                    *new);
+		_table_insert (priv, rdata->gateways, priv->gateways_idx, _gateway_get_key,
+		               _preference_to_priority (new->preference), new);
+		_next_expiry_lower (priv, TABLE_GATEWAYS, get_expiry (new));
 	}
-	_ASSERT_data_gateways (rdata);
+	_ASSERT_data_gateways (priv);
 	return !!new->lifetime;
 }
 
@@ -495,8 +955,12 @@ nm_ndisc_add_address (NMNDisc *ndisc,
 					existing->preferred = MIN (existing->preferred, existing->lifetime);
 			}
 
-			return    old_expiry_lifetime != get_expiry (existing)
-			       || old_expiry_preferred != get_expiry_preferred (existing);
+			if (   old_expiry_lifetime == get_expiry (existing)
+			    && old_expiry_preferred == get_expiry_preferred (existing))
+				return FALSE;
+
+			_next_expiry_lower (priv, TABLE_ADDRESSES, get_expiry (existing));
+			return TRUE;
 		}
 
 		if (new->lifetime == 0) {
@@ -511,6 +975,7 @@ nm_ndisc_add_address (NMNDisc *ndisc,
 		existing->timestamp = new->timestamp;
 		existing->lifetime = new->lifetime;
 		existing->preferred = new->preferred;
+		_next_expiry_lower (priv, TABLE_ADDRESSES, get_expiry (existing));
 		return TRUE;
 	}
 
@@ -534,6 +999,7 @@ nm_ndisc_add_address (NMNDisc *ndisc,
 	}
 
 	g_array_append_val (rdata->addresses, *new);
+	_next_expiry_lower (priv, TABLE_ADDRESSES, get_expiry (new));
 	return TRUE;
 }
 
@@ -551,7 +1017,6 @@ nm_ndisc_add_route (NMNDisc *ndisc, const NMNDiscRoute *new)
 	NMNDiscPrivate *priv;
 	NMNDiscDataInternal *rdata;
 	guint i;
-	guint insert_idx = G_MAXUINT;
 
 	if (new->plen == 0 || new->plen > 128) {
 		/* Only expect non-default routes.  The router has no idea what the
@@ -567,45 +1032,36 @@ nm_ndisc_add_route (NMNDisc *ndisc, const NMNDiscRoute *new)
 	priv = NM_NDISC_GET_PRIVATE (ndisc);
 	rdata = &priv->rdata;
 
-	for (i = 0; i < rdata->routes->len; ) {
+	i = _table_lookup (rdata->routes, priv->routes_idx, _route_get_key, new);
+	if (i != G_MAXUINT) {
 		NMNDiscRoute *item = &g_array_index (rdata->routes, NMNDiscRoute, i);
 
-		if (   IN6_ARE_ADDR_EQUAL (&item->network, &new->network)
-		    && item->plen == new->plen) {
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdata->routes, i);
-				return TRUE;
-			}
-
-			if (item->preference != new->preference) {
-				g_array_remove_index (rdata->routes, i);
-				continue;
-			}
+		if (new->lifetime == 0) {
+			_table_remove (rdata->routes, priv->routes_idx, _route_get_key, i);
+			return TRUE;
+		}
 
+		if (item->preference == new->preference) {
 			if (   get_expiry (item) == get_expiry (new)
 			    && IN6_ARE_ADDR_EQUAL (&item->gateway, &new->gateway))
 				return FALSE;
 
 			*item = *new;
+			_next_expiry_lower (priv, TABLE_ROUTES, get_expiry (new));
 			return TRUE;
 		}
 
-		/* Put before less preferable routes. */
-		if (   _preference_to_priority (item->preference) < _preference_to_priority (new->preference)
-		    && insert_idx == G_MAXUINT)
-			insert_idx = i;
-
-		i++;
+		/* the preference changed. Re-add it. */
+		_table_remove (rdata->routes, priv->routes_idx, _route_get_key, i);
 	}
 
-	if (new->lifetime) {
-		g_array_insert_val (rdata->routes,
-		                    insert_idx == G_MAXUINT
-		                      ? 0u
-		                      : insert_idx,
-		                    *new);
-	}
-	return !!new->lifetime;
+	if (!new->lifetime)
+		return FALSE;
+
+	_table_insert (priv, rdata->routes, priv->routes_idx, _route_get_key,
+	               _preference_to_priority (new->preference), new);
+	_next_expiry_lower (priv, TABLE_ROUTES, get_expiry (new));
+	return TRUE;
 }
 
 gboolean
@@ -618,26 +1074,29 @@ nm_ndisc_add_dns_server (NMNDisc *ndisc, const NMNDiscDNSServer *new)
 	priv = NM_NDISC_GET_PRIVATE (ndisc);
 	rdata = &priv->rdata;
 
-	for (i = 0; i < rdata->dns_servers->len; i++) {
+	i = _table_lookup (rdata->dns_servers, priv->dns_servers_idx, _dns_server_get_key, new);
+	if (i != G_MAXUINT) {
 		NMNDiscDNSServer *item = &g_array_index (rdata->dns_servers, NMNDiscDNSServer, i);
 
-		if (IN6_ARE_ADDR_EQUAL (&item->address, &new->address)) {
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdata->dns_servers, i);
-				return TRUE;
-			}
-
-			if (get_expiry (item) == get_expiry (new))
-				return FALSE;
-
-			*item = *new;
+		if (new->lifetime == 0) {
+			_table_remove (rdata->dns_servers, priv->dns_servers_idx, _dns_server_get_key, i);
 			return TRUE;
 		}
+
+		if (get_expiry (item) == get_expiry (new))
+			return FALSE;
+
+		*item = *new;
+		_next_expiry_lower (priv, TABLE_DNS_SERVERS, get_expiry_half (new));
+		return TRUE;
 	}
 
-	if (new->lifetime)
-		g_array_append_val (rdata->dns_servers, *new);
-	return !!new->lifetime;
+	if (!new->lifetime)
+		return FALSE;
+
+	_table_insert (priv, rdata->dns_servers, priv->dns_servers_idx, _dns_server_get_key, 0, new);
+	_next_expiry_lower (priv, TABLE_DNS_SERVERS, get_expiry_half (new));
+	return TRUE;
 }
 
 /* Copies new->domain if 'new' is added to the dns_domains list */
@@ -666,6 +1125,7 @@ nm_ndisc_add_dns_domain (NMNDisc *ndisc, const NMNDiscDNSDomain *new)
 
 			item->timestamp = new->timestamp;
 			item->lifetime = new->lifetime;
+			_next_expiry_lower (priv, TABLE_DNS_DOMAINS, get_expiry_half (new));
 			return TRUE;
 		}
 	}
@@ -676,6 +1136,7 @@ nm_ndisc_add_dns_domain (NMNDisc *ndisc, const NMNDiscDNSDomain *new)
 		                       NMNDiscDNSDomain,
 		                       rdata->dns_domains->len - 1);
 		item->domain = g_strdup (new->domain);
+		_next_expiry_lower (priv, TABLE_DNS_DOMAINS, get_expiry_half (new));
 	}
 	return !!new->lifetime;
 }
@@ -1039,77 +1500,89 @@ _config_changed_log (NMNDisc *ndisc, NMNDiscConfigMap changed)
 	config_map_to_string (changed, changedstr);
 	_LOGD ("neighbor discovery configuration changed [%s]:", changedstr);
 	_LOGD ("  dhcp-level %s", dhcp_level_to_string (priv->rdata.public.dhcp_level));
-	for (i = 0; i < rdata->gateways->len; i++) {
-		NMNDiscGateway *gateway = &g_array_index (rdata->gateways, NMNDiscGateway, i);
-
-		inet_ntop (AF_INET6, &gateway->address, addrstr, sizeof (addrstr));
-		_LOGD ("  gateway %s pref %s exp %s", addrstr,
-		       nm_icmpv6_router_pref_to_string (gateway->preference, str_pref, sizeof (str_pref)),
-		       get_exp (str_exp, now_ns, gateway));
+	if (NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_GATEWAYS)) {
+		for (i = 0; i < priv->ordered.gateways->len; i++) {
+			NMNDiscGateway *gateway = &g_array_index (priv->ordered.gateways, NMNDiscGateway, i);
+
+			inet_ntop (AF_INET6, &gateway->address, addrstr, sizeof (addrstr));
+			_LOGD ("  gateway %s pref %s exp %s", addrstr,
+			       nm_icmpv6_router_pref_to_string (gateway->preference, str_pref, sizeof (str_pref)),
+			       get_exp (str_exp, now_ns, gateway));
+		}
 	}
-	for (i = 0; i < rdata->addresses->len; i++) {
-		const NMNDiscAddress *address = &g_array_index (rdata->addresses, NMNDiscAddress, i);
+	if (NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_ADDRESSES)) {
+		for (i = 0; i < rdata->addresses->len; i++) {
+			const NMNDiscAddress *address = &g_array_index (rdata->addresses, NMNDiscAddress, i);
 
-		inet_ntop (AF_INET6, &address->address, addrstr, sizeof (addrstr));
-		_LOGD ("  address %s exp %s", addrstr,
-		       get_exp (str_exp, now_ns, address));
+			inet_ntop (AF_INET6, &address->address, addrstr, sizeof (addrstr));
+			_LOGD ("  address %s exp %s", addrstr,
+			       get_exp (str_exp, now_ns, address));
+		}
 	}
-	for (i = 0; i < rdata->routes->len; i++) {
-		NMNDiscRoute *route = &g_array_index (rdata->routes, NMNDiscRoute, i);
-		char sbuf[NM_UTILS_INET_ADDRSTRLEN];
-
-		inet_ntop (AF_INET6, &route->network, addrstr, sizeof (addrstr));
-		_LOGD ("  route %s/%u via %s pref %s exp %s", addrstr, (guint) route->plen,
-		       nm_utils_inet6_ntop (&route->gateway, sbuf),
-		       nm_icmpv6_router_pref_to_string (route->preference, str_pref, sizeof (str_pref)),
-		       get_exp (str_exp, now_ns, route));
+	if (NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_ROUTES)) {
+		for (i = 0; i < priv->ordered.routes->len; i++) {
+			NMNDiscRoute *route = &g_array_index (priv->ordered.routes, NMNDiscRoute, i);
+			char sbuf[NM_UTILS_INET_ADDRSTRLEN];
+
+			inet_ntop (AF_INET6, &route->network, addrstr, sizeof (addrstr));
+			_LOGD ("  route %s/%u via %s pref %s exp %s", addrstr, (guint) route->plen,
+			       nm_utils_inet6_ntop (&route->gateway, sbuf),
+			       nm_icmpv6_router_pref_to_string (route->preference, str_pref, sizeof (str_pref)),
+			       get_exp (str_exp, now_ns, route));
+		}
 	}
-	for (i = 0; i < rdata->dns_servers->len; i++) {
-		NMNDiscDNSServer *dns_server = &g_array_index (rdata->dns_servers, NMNDiscDNSServer, i);
+	if (NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_DNS_SERVERS)) {
+		for (i = 0; i < priv->ordered.dns_servers->len; i++) {
+			NMNDiscDNSServer *dns_server = &g_array_index (priv->ordered.dns_servers, NMNDiscDNSServer, i);
 
-		inet_ntop (AF_INET6, &dns_server->address, addrstr, sizeof (addrstr));
-		_LOGD ("  dns_server %s exp %s", addrstr,
-		       get_exp (str_exp, now_ns, dns_server));
+			inet_ntop (AF_INET6, &dns_server->address, addrstr, sizeof (addrstr));
+			_LOGD ("  dns_server %s exp %s", addrstr,
+			       get_exp (str_exp, now_ns, dns_server));
+		}
 	}
-	for (i = 0; i < rdata->dns_domains->len; i++) {
-		NMNDiscDNSDomain *dns_domain = &g_array_index (rdata->dns_domains, NMNDiscDNSDomain, i);
+	if (NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_DNS_DOMAINS)) {
+		for (i = 0; i < rdata->dns_domains->len; i++) {
+			NMNDiscDNSDomain *dns_domain = &g_array_index (rdata->dns_domains, NMNDiscDNSDomain, i);
 
-		_LOGD ("  dns_domain %s exp %s", dns_domain->domain,
-		       get_exp (str_exp, now_ns, dns_domain));
+			_LOGD ("  dns_domain %s exp %s", dns_domain->domain,
+			       get_exp (str_exp, now_ns, dns_domain));
+		}
 	}
 }
 
 static void
 clean_gateways (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
 {
-	NMNDiscDataInternal *rdata;
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	NMNDiscDataInternal *rdata = &priv->rdata;
+	gint64 next_expiry = _EXPIRY_INFINITY;
 	guint i;
 
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
-
 	for (i = 0; i < rdata->gateways->len; ) {
 		NMNDiscGateway *item = &g_array_index (rdata->gateways, NMNDiscGateway, i);
 
 		if (!expiry_next (now, get_expiry (item), nextevent)) {
-			g_array_remove_index (rdata->gateways, i);
+			_table_remove (rdata->gateways, priv->gateways_idx, _gateway_get_key, i);
 			*changed |= NM_NDISC_CONFIG_GATEWAYS;
 			continue;
 		}
 
+		next_expiry = MIN (next_expiry, get_expiry (item));
 		i++;
 	}
 
-	_ASSERT_data_gateways (rdata);
+	priv->next_expiry[TABLE_GATEWAYS] = next_expiry;
+	_ASSERT_data_gateways (priv);
 }
 
 static void
 clean_addresses (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
 {
-	NMNDiscDataInternal *rdata;
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	NMNDiscDataInternal *rdata = &priv->rdata;
+	gint64 next_expiry = _EXPIRY_INFINITY;
 	guint i;
 
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
-
 	for (i = 0; i < rdata->addresses->len; ) {
 		const NMNDiscAddress *item = &g_array_index (rdata->addresses, NMNDiscAddress, i);
 
@@ -1119,39 +1592,45 @@ clean_addresses (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *
 			continue;
 		}
 
+		next_expiry = MIN (next_expiry, get_expiry (item));
 		i++;
 	}
+
+	priv->next_expiry[TABLE_ADDRESSES] = next_expiry;
 }
 
 static void
 clean_routes (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
 {
-	NMNDiscDataInternal *rdata;
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	NMNDiscDataInternal *rdata = &priv->rdata;
+	gint64 next_expiry = _EXPIRY_INFINITY;
 	guint i;
 
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
-
 	for (i = 0; i < rdata->routes->len; ) {
 		NMNDiscRoute *item = &g_array_index (rdata->routes, NMNDiscRoute, i);
 
 		if (!expiry_next (now, get_expiry (item), nextevent)) {
-			g_array_remove_index (rdata->routes, i);
+			_table_remove (rdata->routes, priv->routes_idx, _route_get_key, i);
 			*changed |= NM_NDISC_CONFIG_ROUTES;
 			continue;
 		}
 
+		next_expiry = MIN (next_expiry, get_expiry (item));
 		i++;
 	}
+
+	priv->next_expiry[TABLE_ROUTES] = next_expiry;
 }
 
 static void
 clean_dns_servers (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
 {
-	NMNDiscDataInternal *rdata;
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	NMNDiscDataInternal *rdata = &priv->rdata;
+	gint64 next_expiry = _EXPIRY_INFINITY;
 	guint i;
 
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
-
 	for (i = 0; i < rdata->dns_servers->len; ) {
 		NMNDiscDNSServer *item = &g_array_index (rdata->dns_servers, NMNDiscDNSServer, i);
 		gint64 refresh;
@@ -1159,7 +1638,7 @@ clean_dns_servers (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32
 		refresh = get_expiry_half (item);
 		if (refresh != _EXPIRY_INFINITY) {
 			if (!expiry_next (now, get_expiry (item), NULL)) {
-				g_array_remove_index (rdata->dns_servers, i);
+				_table_remove (rdata->dns_servers, priv->dns_servers_idx, _dns_server_get_key, i);
 				*changed |= NM_NDISC_CONFIG_DNS_SERVERS;
 				continue;
 			}
@@ -1168,19 +1647,22 @@ clean_dns_servers (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32
 				solicit_routers (ndisc);
 			else if (*nextevent > refresh)
 				*nextevent = refresh;
+			next_expiry = MIN (next_expiry, refresh);
 		}
 		i++;
 	}
+
+	priv->next_expiry[TABLE_DNS_SERVERS] = next_expiry;
 }
 
 static void
 clean_dns_domains (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
 {
-	NMNDiscDataInternal *rdata;
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	NMNDiscDataInternal *rdata = &priv->rdata;
+	gint64 next_expiry = _EXPIRY_INFINITY;
 	guint i;
 
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
-
 	for (i = 0; i < rdata->dns_domains->len; ) {
 		NMNDiscDNSDomain *item = &g_array_index (rdata->dns_domains, NMNDiscDNSDomain, i);
 		gint64 refresh;
@@ -1197,9 +1679,12 @@ clean_dns_domains (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32
 				solicit_routers (ndisc);
 			else if (*nextevent > refresh)
 				*nextevent = refresh;
+			next_expiry = MIN (next_expiry, refresh);
 		}
 		i++;
 	}
+
+	priv->next_expiry[TABLE_DNS_DOMAINS] = next_expiry;
 }
 
 static gboolean timeout_cb (gpointer user_data);
@@ -1213,11 +1698,25 @@ check_timestamps (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap changed)
 
 	nm_clear_g_source (&priv->timeout_id);
 
-	clean_gateways (ndisc, now, &changed, &nextevent);
-	clean_addresses (ndisc, now, &changed, &nextevent);
-	clean_routes (ndisc, now, &changed, &nextevent);
-	clean_dns_servers (ndisc, now, &changed, &nextevent);
-	clean_dns_domains (ndisc, now, &changed, &nextevent);
+	/* Only scan the tables that have items which expire (or need refresh).
+	 * For the others, the lower bound of their expiry is good enough to
+	 * schedule the next check. */
+#define _CLEAN(table, clean_fcn) \
+	G_STMT_START { \
+		if (priv->next_expiry[table] <= now) \
+			clean_fcn (ndisc, now, &changed, &nextevent); \
+		else \
+			expiry_next (now, priv->next_expiry[table], &nextevent); \
+	} G_STMT_END
+	_CLEAN (TABLE_GATEWAYS, clean_gateways);
+	_CLEAN (TABLE_ADDRESSES, clean_addresses);
+	_CLEAN (TABLE_ROUTES, clean_routes);
+	_CLEAN (TABLE_DNS_SERVERS, clean_dns_servers);
+	_CLEAN (TABLE_DNS_DOMAINS, clean_dns_domains);
+#undef _CLEAN
+
+	if (_addresses_need_sync (priv, now, &nextevent))
+		changed |= NM_NDISC_CONFIG_ADDRESSES;
 
 	if (nextevent != G_MAXINT32) {
 		if (nextevent <= now)
@@ -1228,7 +1727,7 @@ check_timestamps (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap changed)
 	}
 
 	if (changed)
-		nm_ndisc_emit_config_change (ndisc, changed);
+		config_change_schedule (ndisc, changed);
 }
 
 static gboolean
@@ -1341,6 +1840,7 @@ nm_ndisc_init (NMNDisc *ndisc)
 {
 	NMNDiscPrivate *priv;
 	NMNDiscDataInternal *rdata;
+	guint i;
 
 	priv = G_TYPE_INSTANCE_GET_PRIVATE (ndisc, NM_TYPE_NDISC, NMNDiscPrivate);
 	ndisc->_priv = priv;
@@ -1355,6 +1855,22 @@ nm_ndisc_init (NMNDisc *ndisc)
 	g_array_set_clear_func (rdata->dns_domains, dns_domain_free);
 	priv->rdata.public.hop_limit = 64;
 
+	priv->gateways_idx = _index_new ();
+	priv->routes_idx = _index_new ();
+	priv->dns_servers_idx = _index_new ();
+	priv->ordered.gateways = g_array_new (FALSE, FALSE, sizeof (NMNDiscGateway));
+	priv->ordered.routes = g_array_new (FALSE, FALSE, sizeof (NMNDiscRoute));
+	priv->ordered.dns_servers = g_array_new (FALSE, FALSE, sizeof (NMNDiscDNSServer));
+	for (i = 0; i < _TABLE_NUM; i++)
+		priv->next_expiry[i] = _EXPIRY_INFINITY;
+
+	priv->applied.gateways = g_array_new (FALSE, FALSE, sizeof (NMNDiscGateway));
+	priv->applied.addresses = g_array_new (FALSE, FALSE, sizeof (NMNDiscAddress));
+	priv->applied.routes = g_array_new (FALSE, FALSE, sizeof (NMNDiscRoute));
+	priv->applied.dns_servers = g_array_new (FALSE, FALSE, sizeof (NMNDiscDNSServer));
+	priv->applied.dns_domains = g_array_new (FALSE, FALSE, sizeof (NMNDiscDNSDomain));
+	g_array_set_clear_func (priv->applied.dns_domains, dns_domain_free);
+
 	/* Start at very low number so that last_rs - router_solicitation_interval
 	 * is much lower than nm_utils_get_monotonic_timestamp_s() at startup.
 	 */
@@ -1373,6 +1889,7 @@ dispose (GObject *object)
 	g_clear_pointer (&priv->last_error, g_free);
 
 	nm_clear_g_source (&priv->timeout_id);
+	nm_clear_g_source (&priv->changed_timeout_id);
 
 	G_OBJECT_CLASS (nm_ndisc_parent_class)->dispose (object);
 }
@@ -1393,6 +1910,19 @@ finalize (GObject *object)
 	g_array_unref (rdata->dns_servers);
 	g_array_unref (rdata->dns_domains);
 
+	g_hash_table_unref (priv->gateways_idx);
+	g_hash_table_unref (priv->routes_idx);
+	g_hash_table_unref (priv->dns_servers_idx);
+	g_array_unref (priv->ordered.gateways);
+	g_array_unref (priv->ordered.routes);
+	g_array_unref (priv->ordered.dns_servers);
+
+	g_array_unref (priv->applied.gateways);
+	g_array_unref (priv->applied.addresses);
+	g_array_unref (priv->applied.routes);
+	g_array_unref (priv->applied.dns_servers);
+	g_array_unref (priv->applied.dns_domains);
+
 	g_clear_object (&priv->netns);
 	g_clear_object (&priv->platform);
 
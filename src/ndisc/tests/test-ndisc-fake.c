@@ -375,8 +375,8 @@ test_preference_changed_cb (NMNDisc *ndisc, const NMNDiscData *rdata, guint chan
 		match_route (rdata, 0, "2001:db8:a:b::", 64, "fe80::2", data->timestamp1 + 1, 10, 10);
 		match_route (rdata, 1, "2001:db8:a:a::", 64, "fe80::1", data->timestamp1, 10, 5);
 	} else if (data->counter == 2) {
+		/* the address is only refreshed, which is not applied yet. */
 		g_assert_cmpint (changed, ==, NM_NDISC_CONFIG_GATEWAYS |
-		                              NM_NDISC_CONFIG_ADDRESSES |
 		                              NM_NDISC_CONFIG_ROUTES);
 
 		g_assert_cmpint (rdata->gateways_n, ==, 2);
@@ -513,7 +513,147 @@ test_dns_solicit_loop (void)
 
 	nm_ndisc_start (NM_NDISC (ndisc));
 	g_main_loop_run (data.loop);
-	g_assert_cmpint (data.counter, ==, 3);
+	g_assert_cmpint (data.counter, ==, 2);
+
+	g_object_unref (ndisc);
+	g_main_loop_unref (data.loop);
+}
+
+static void
+test_many_routes_cb (NMNDisc *ndisc, const NMNDiscData *rdata, guint changed_int, TestData *data)
+{
+	NMNDiscConfigMap changed = changed_int;
+
+	if (data->counter == 0) {
+		g_assert (NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_ROUTES));
+		g_assert_cmpint (rdata->routes_n, ==, 65);
+
+		/* with the same preference, the most recent route comes first. */
+		g_assert_cmpint (rdata->routes[0].network.s6_addr[5], ==, 63);
+		g_assert_cmpint (rdata->routes[32].network.s6_addr[4], ==, 0xff);
+		g_assert_cmpint (rdata->routes[64].network.s6_addr[5], ==, 0);
+	} else if (data->counter == 1) {
+		guint i;
+
+		/* the second RA refreshes the routes without changes. The next
+		 * notification is only about the route that expired. */
+		g_assert_cmpint (changed, ==, NM_NDISC_CONFIG_ROUTES);
+		g_assert_cmpint (rdata->routes_n, ==, 64);
+		for (i = 0; i < rdata->routes_n; i++) {
+			g_assert_cmpint (rdata->routes[i].lifetime, ==, 30);
+			g_assert_cmpint (rdata->routes[i].network.s6_addr[4], ==, 0);
+			g_assert_cmpint (rdata->routes[i].network.s6_addr[5], ==, 63 - i);
+		}
+
+		g_assert (nm_fake_ndisc_done (NM_FAKE_NDISC (ndisc)));
+		g_main_loop_quit (data->loop);
+	} else
+		g_assert_not_reached ();
+
+	data->counter++;
+}
+
+static void
+test_many_routes (void)
+{
+	NMFakeNDisc *ndisc = ndisc_new ();
+	guint32 now = nm_utils_get_monotonic_timestamp_s ();
+	TestData data = { g_main_loop_new (NULL, FALSE), 0, 0, now };
+	guint id;
+	guint i, j;
+
+	/* Test that routes announced again are refreshed in place, and that an
+	 * expiring route among many others is removed without reordering the
+	 * others. */
+
+	for (j = 0; j < 2; j++) {
+		id = nm_fake_ndisc_add_ra (ndisc, 1, NM_NDISC_DHCP_LEVEL_NONE, 4, 1500);
+		g_assert (id);
+		for (i = 0; i < 64; i++) {
+			char network[INET6_ADDRSTRLEN];
+
+			if (i == 32)
+				nm_fake_ndisc_add_prefix (ndisc, id, "2001:db8:ffff:ff00::", 56, "fe80::1", now, 4, 4, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+			nm_sprintf_buf (network, "2001:db8:%x::", i);
+			nm_fake_ndisc_add_prefix (ndisc, id, network, 48, "fe80::1", now, 30, 30, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+		}
+	}
+
+	g_signal_connect (ndisc,
+	                  NM_NDISC_CONFIG_RECEIVED,
+	                  G_CALLBACK (test_many_routes_cb),
+	                  &data);
+
+	nm_ndisc_start (NM_NDISC (ndisc));
+	g_main_loop_run (data.loop);
+	g_assert_cmpint (data.counter, ==, 2);
+
+	g_object_unref (ndisc);
+	g_main_loop_unref (data.loop);
+}
+
+static void
+test_refresh_cb (NMNDisc *ndisc, const NMNDiscData *rdata, guint changed_int, TestData *data)
+{
+	NMNDiscConfigMap changed = changed_int;
+
+	if (data->counter == 0) {
+		g_assert_cmpint (changed, ==, NM_NDISC_CONFIG_DHCP_LEVEL |
+		                              NM_NDISC_CONFIG_GATEWAYS |
+		                              NM_NDISC_CONFIG_ADDRESSES |
+		                              NM_NDISC_CONFIG_ROUTES |
+		                              NM_NDISC_CONFIG_DNS_SERVERS |
+		                              NM_NDISC_CONFIG_DNS_DOMAINS |
+		                              NM_NDISC_CONFIG_HOP_LIMIT |
+		                              NM_NDISC_CONFIG_MTU);
+	} else if (data->counter == 1) {
+		/* the second RA only refreshes the lifetimes and is not emitted. */
+		g_assert_cmpint (changed, ==, NM_NDISC_CONFIG_DNS_SERVERS);
+
+		match_gateway (rdata, 0, "fe80::1", data->timestamp1 + 1, 60, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+		match_route (rdata, 0, "2001:db8:a:a::", 64, "fe80::1", data->timestamp1 + 1, 60, 10);
+		g_assert_cmpint (rdata->dns_servers_n, ==, 2);
+		match_dns_server (rdata, 0, "2001:db8:c:c::1", data->timestamp1 + 1, 60);
+		match_dns_server (rdata, 1, "2001:db8:c:c::2", data->timestamp1 + 2, 60);
+
+		g_assert (nm_fake_ndisc_done (NM_FAKE_NDISC (ndisc)));
+		g_main_loop_quit (data->loop);
+	} else
+		g_assert_not_reached ();
+
+	data->counter++;
+}
+
+static void
+test_refresh (void)
+{
+	NMFakeNDisc *ndisc = ndisc_new ();
+	guint32 now = nm_utils_get_monotonic_timestamp_s ();
+	TestData data = { g_main_loop_new (NULL, FALSE), 0, 0, now };
+	guint id;
+	guint i;
+
+	for (i = 0; i < 2; i++) {
+		id = nm_fake_ndisc_add_ra (ndisc, 1, NM_NDISC_DHCP_LEVEL_NONE, 4, 1500);
+		g_assert (id);
+		nm_fake_ndisc_add_gateway (ndisc, id, "fe80::1", now + i, 60, NM_ICMPV6_ROUTER_PREF_MEDIUM);
+		nm_fake_ndisc_add_prefix (ndisc, id, "2001:db8:a:a::", 64, "fe80::1", now + i, 60, 60, 10);
+		nm_fake_ndisc_add_dns_server (ndisc, id, "2001:db8:c:c::1", now + i, 60);
+		nm_fake_ndisc_add_dns_domain (ndisc, id, "foobar.com", now + i, 60);
+	}
+
+	id = nm_fake_ndisc_add_ra (ndisc, 1, NM_NDISC_DHCP_LEVEL_NONE, 4, 1500);
+	g_assert (id);
+	nm_fake_ndisc_add_dns_server (ndisc, id, "2001:db8:c:c::2", now + 2, 60);
+
+	g_signal_connect (ndisc,
+	                  NM_NDISC_CONFIG_RECEIVED,
+	                  G_CALLBACK (test_refresh_cb),
+	                  &data);
+
+	nm_ndisc_start (NM_NDISC (ndisc));
+	g_main_loop_run (data.loop);
+	g_assert_cmpint (data.counter, ==, 2);
 
 	g_object_unref (ndisc);
 	g_main_loop_unref (data.loop);
@@ -538,6 +678,8 @@ main (int argc, char **argv)
 	g_test_add_func ("/ndisc/preference-order", test_preference_order);
 	g_test_add_func ("/ndisc/preference-changed", test_preference_changed);
 	g_test_add_func ("/ndisc/dns-solicit-loop", test_dns_solicit_loop);
+	g_test_add_func ("/ndisc/many-routes", test_many_routes);
+	g_test_add_func ("/ndisc/refresh", test_refresh);
 
 	return g_test_run ();
 }
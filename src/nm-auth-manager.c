@@ -35,6 +35,12 @@
 #define CANCELLATION_ID_PREFIX "cancellation-id-"
 #define CANCELLATION_TIMEOUT_MS 5000
 
+/* how long a cached polkit decision is considered valid. polkit notifies
+ * us via "Changed" about changes to its policy, so this is only a safety
+ * net for changes that don't trigger that signal. */
+#define AUTH_CACHE_TIMEOUT_MS   10000
+#define AUTH_CACHE_MAX_ENTRIES  1000
+
 /*****************************************************************************/
 
 NM_GOBJECT_PROPERTIES_DEFINE_BASE (
@@ -52,7 +58,11 @@ typedef struct {
 	CList calls_lst_head;
 	GDBusConnection *dbus_connection;
 	GCancellable *shutdown_cancellable;
+	GHashTable *cache;
 	guint64 call_numid_counter;
+	guint64 cache_generation;
+	guint64 cache_hits;
+	guint64 cache_misses;
 	guint changed_signal_id;
 	bool disposing:1;
 	bool shutting_down:1;
@@ -117,6 +127,21 @@ nm_auth_manager_get_polkit_enabled (NMAuthManager *self)
 	return NM_AUTH_MANAGER_GET_PRIVATE (self)->dbus_connection != NULL;
 }
 
+void
+nm_auth_manager_get_cache_stats (NMAuthManager *self,
+                                 guint64 *out_hits,
+                                 guint64 *out_misses)
+{
+	NMAuthManagerPrivate *priv;
+
+	g_return_if_fail (NM_IS_AUTH_MANAGER (self));
+
+	priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+
+	NM_SET_OUT (out_hits, priv->cache_hits);
+	NM_SET_OUT (out_misses, priv->cache_misses);
+}
+
 /*****************************************************************************/
 
 typedef enum {
@@ -127,19 +152,147 @@ typedef enum {
 typedef enum {
 	IDLE_REASON_AUTHORIZED,
 	IDLE_REASON_NO_DBUS,
+	IDLE_REASON_CACHED,
 } IdleReason;
 
+/* A cached polkit decision. The key are all fields except
+ * @expiry_msec and @is_authorized. */
+typedef struct {
+	char *action_id;
+	char *dbus_sender;
+	guint64 start_time;
+	gint64 expiry_msec;
+	gulong pid;
+	gulong uid;
+	bool is_authorized:1;
+} AuthCacheEntry;
+
 struct _NMAuthManagerCallId {
 	CList calls_lst;
 	NMAuthManager *self;
 	GCancellable *dbus_cancellable;
 	NMAuthManagerCheckAuthorizationCallback callback;
 	gpointer user_data;
+	AuthCacheEntry *cache_entry;
 	guint64 call_numid;
+	guint64 cache_generation;
 	guint idle_id;
 	IdleReason idle_reason:8;
+	bool cached_is_authorized:1;
 };
 
+/*****************************************************************************/
+
+static guint
+_auth_cache_entry_hash (gconstpointer ptr)
+{
+	const AuthCacheEntry *entry = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 1470376583u);
+	nm_hash_update_vals (&h,
+	                     entry->start_time,
+	                     entry->pid,
+	                     entry->uid);
+	nm_hash_update_str0 (&h, entry->dbus_sender);
+	nm_hash_update_str0 (&h, entry->action_id);
+	return nm_hash_complete (&h);
+}
+
+static gboolean
+_auth_cache_entry_equal (gconstpointer a, gconstpointer b)
+{
+	const AuthCacheEntry *entry_a = a;
+	const AuthCacheEntry *entry_b = b;
+
+	return    entry_a->start_time == entry_b->start_time
+	       && entry_a->pid == entry_b->pid
+	       && entry_a->uid == entry_b->uid
+	       && nm_streq0 (entry_a->dbus_sender, entry_b->dbus_sender)
+	       && nm_streq (entry_a->action_id, entry_b->action_id);
+}
+
+static void
+_auth_cache_entry_free (AuthCacheEntry *entry)
+{
+	g_free (entry->action_id);
+	g_free (entry->dbus_sender);
+	g_slice_free (AuthCacheEntry, entry);
+}
+
+static gboolean
+_auth_cache_entry_init (AuthCacheEntry *entry,
+                        NMAuthSubject *subject,
+                        const char *action_id)
+{
+	nm_assert (nm_auth_subject_is_unix_process (subject));
+
+	*entry = (AuthCacheEntry) {
+		.action_id   = (char *) action_id,
+		.dbus_sender = (char *) nm_auth_subject_get_unix_process_dbus_sender (subject),
+		.start_time  = nm_auth_subject_get_unix_process_start_time (subject),
+		.pid         = nm_auth_subject_get_unix_process_pid (subject),
+		.uid         = nm_auth_subject_get_unix_process_uid (subject),
+	};
+
+	/* without a start-time, we cannot tell a recycled PID apart.
+	 * Don't cache such subjects. */
+	return entry->start_time != 0;
+}
+
+static const AuthCacheEntry *
+_auth_cache_lookup (NMAuthManager *self,
+                    NMAuthSubject *subject,
+                    const char *action_id)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	AuthCacheEntry needle;
+	AuthCacheEntry *entry;
+
+	if (!_auth_cache_entry_init (&needle, subject, action_id))
+		return NULL;
+
+	entry = g_hash_table_lookup (priv->cache, &needle);
+	if (   entry
+	    && entry->expiry_msec <= nm_utils_get_monotonic_timestamp_ms ()) {
+		g_hash_table_remove (priv->cache, entry);
+		entry = NULL;
+	}
+
+	if (!entry) {
+		priv->cache_misses++;
+		return NULL;
+	}
+
+	priv->cache_hits++;
+	return entry;
+}
+
+static void
+_auth_cache_add (NMAuthManagerCallId *call_id,
+                 gboolean is_authorized)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (call_id->self);
+	AuthCacheEntry *entry;
+
+	entry = g_steal_pointer (&call_id->cache_entry);
+
+	if (   !priv->cache
+	    || call_id->cache_generation != priv->cache_generation) {
+		/* polkit signalled a change while the request was pending. The
+		 * result might already be outdated. */
+		_auth_cache_entry_free (entry);
+		return;
+	}
+
+	if (g_hash_table_size (priv->cache) >= AUTH_CACHE_MAX_ENTRIES)
+		g_hash_table_remove_all (priv->cache);
+
+	entry->expiry_msec = nm_utils_get_monotonic_timestamp_ms () + AUTH_CACHE_TIMEOUT_MS;
+	entry->is_authorized = is_authorized;
+	g_hash_table_add (priv->cache, entry);
+}
+
 #define cancellation_id_to_str_a(call_numid) \
 	nm_sprintf_bufa (NM_STRLEN (CANCELLATION_ID_PREFIX) + 60, \
 	                 CANCELLATION_ID_PREFIX"%"G_GUINT64_FORMAT, \
@@ -158,6 +311,8 @@ _call_id_free (NMAuthManagerCallId *call_id)
 		return;
 	}
 
+	if (call_id->cache_entry)
+		_auth_cache_entry_free (call_id->cache_entry);
 	g_object_unref (call_id->self);
 	g_slice_free (NMAuthManagerCallId, call_id);
 }
@@ -259,13 +414,23 @@ _call_check_authorize_cb (GObject *proxy,
 	}
 
 	if (!error) {
+		gs_unref_variant GVariant *details = NULL;
+
 		g_variant_get (value,
 		               "((bb@a{ss}))",
 		               &is_authorized,
 		               &is_challenge,
-		               NULL);
+		               &details);
 		_LOG2T (call_id, "completed: authorized=%d, challenge=%d",
 		        is_authorized, is_challenge);
+
+		/* only definite answers are cached. An authorization that was
+		 * granted due to a temporary authorization can expire or be
+		 * revoked at any time, without polkit emitting "Changed". */
+		if (   call_id->cache_entry
+		    && !is_challenge
+		    && !g_variant_lookup (details, "polkit.temporary_authorization_id", "&s", NULL))
+			_auth_cache_add (call_id, is_authorized);
 	} else
 		_LOG2T (call_id, "completed: failed: %s", error->message);
 
@@ -286,6 +451,10 @@ _call_on_idle (gpointer user_data)
 		is_authorized = TRUE;
 		_LOG2T (call_id, "completed: authorized=%d, challenge=%d (simulated)",
 		        is_authorized, is_challenge);
+	} else if (call_id->idle_reason == IDLE_REASON_CACHED) {
+		is_authorized = call_id->cached_is_authorized;
+		_LOG2T (call_id, "completed: authorized=%d, challenge=%d (cached)",
+		        is_authorized, is_challenge);
 	} else {
 		nm_assert (call_id->idle_reason == IDLE_REASON_NO_DBUS);
 		error_msg = "failure creating GDBusProxy for authorization request";
@@ -323,6 +492,7 @@ nm_auth_manager_check_authorization (NMAuthManager *self,
 	PolkitCheckAuthorizationFlags flags;
 	char subject_buf[64];
 	NMAuthManagerCallId *call_id;
+	const AuthCacheEntry *cache_entry;
 
 	g_return_val_if_fail (NM_IS_AUTH_MANAGER (self), NULL);
 	g_return_val_if_fail (NM_IN_SET (nm_auth_subject_get_subject_type (subject),
@@ -361,11 +531,31 @@ nm_auth_manager_check_authorization (NMAuthManager *self,
 		_LOG2T (call_id, "CheckAuthorization(%s), subject=%s (succeeding for root)", action_id, nm_auth_subject_to_string (subject, subject_buf, sizeof (subject_buf)));
 		call_id->idle_reason = IDLE_REASON_AUTHORIZED;
 		call_id->idle_id = g_idle_add (_call_on_idle, call_id);
+	} else if ((cache_entry = _auth_cache_lookup (self, subject, action_id))) {
+		/* a cached result is either an authorization or a denial without
+		 * challenge. In both cases, user interaction would not change the
+		 * outcome. */
+		_LOG2T (call_id, "CheckAuthorization(%s), subject=%s (cached result)", action_id, nm_auth_subject_to_string (subject, subject_buf, sizeof (subject_buf)));
+		call_id->idle_reason = IDLE_REASON_CACHED;
+		call_id->cached_is_authorized = cache_entry->is_authorized;
+		call_id->idle_id = g_idle_add (_call_on_idle, call_id);
 	} else {
 		GVariant *parameters;
 		GVariantBuilder builder;
 		GVariant *subject_value;
 		GVariant *details_value;
+		AuthCacheEntry needle;
+
+		/* only cache results of non-interactive requests. An interactive request
+		 * may be granted once by the user, which must not be remembered. */
+		if (   !allow_user_interaction
+		    && _auth_cache_entry_init (&needle, subject, action_id)) {
+			call_id->cache_entry = g_slice_new (AuthCacheEntry);
+			*call_id->cache_entry = needle;
+			call_id->cache_entry->action_id = g_strdup (action_id);
+			call_id->cache_entry->dbus_sender = g_strdup (needle.dbus_sender);
+			call_id->cache_generation = priv->cache_generation;
+		}
 
 		subject_value = nm_auth_subject_unix_process_to_polkit_gvariant (subject);
 		nm_assert (g_variant_is_floating (subject_value));
@@ -439,8 +629,16 @@ changed_signal_cb (GDBusConnection *connection,
                    gpointer user_data)
 {
 	NMAuthManager *self = user_data;
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+
+	_LOGD ("dbus signal: \"Changed\" (drop %u cached results; cache hits %"G_GUINT64_FORMAT", misses %"G_GUINT64_FORMAT")",
+	       g_hash_table_size (priv->cache),
+	       priv->cache_hits,
+	       priv->cache_misses);
+
+	priv->cache_generation++;
+	g_hash_table_remove_all (priv->cache);
 
-	_LOGD ("dbus signal: \"Changed\"");
 	g_signal_emit (self, signals[CHANGED_SIGNAL], 0);
 }
 
@@ -514,6 +712,10 @@ nm_auth_manager_init (NMAuthManager *self)
 	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
 
 	c_list_init (&priv->calls_lst_head);
+	priv->cache = g_hash_table_new_full (_auth_cache_entry_hash,
+	                                     _auth_cache_entry_equal,
+	                                     (GDestroyNotify) _auth_cache_entry_free,
+	                                     NULL);
 }
 
 static void
@@ -597,6 +799,8 @@ dispose (GObject *object)
 	nm_clear_g_dbus_connection_signal (priv->dbus_connection,
 	                                   &priv->changed_signal_id);
 
+	nm_clear_pointer (&priv->cache, g_hash_table_unref);
+
 	G_OBJECT_CLASS (nm_auth_manager_parent_class)->dispose (object);
 
 	g_clear_object (&priv->dbus_connection);
@@ -742,15 +742,24 @@ static const ConfigGroup config_groups[] = {
 			NM_CONFIG_KEYFILE_KEY_MAIN_AUTH_POLKIT,
 			NM_CONFIG_KEYFILE_KEY_MAIN_AUTOCONNECT_RETRIES_DEFAULT,
 			NM_CONFIG_KEYFILE_KEY_MAIN_CONFIGURE_AND_QUIT,
+			NM_CONFIG_KEYFILE_KEY_MAIN_DBUS_COALESCE_PROPERTIES_CHANGED,
+			NM_CONFIG_KEYFILE_KEY_MAIN_DBUS_LEGACY_PROPERTIES_CHANGED,
 			NM_CONFIG_KEYFILE_KEY_MAIN_DEBUG,
 			NM_CONFIG_KEYFILE_KEY_MAIN_DHCP,
+			NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_LEASE_DB,
+			NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_SHARED_SOCKET,
+			NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_START_JITTER,
+			NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_START_LIMIT,
+			NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_START_RATE,
 			NM_CONFIG_KEYFILE_KEY_MAIN_DNS,
 			NM_CONFIG_KEYFILE_KEY_MAIN_HOSTNAME_MODE,
 			NM_CONFIG_KEYFILE_KEY_MAIN_IGNORE_CARRIER,
+			NM_CONFIG_KEYFILE_KEY_MAIN_LLDP_SHARED_SOCKET,
 			NM_CONFIG_KEYFILE_KEY_MAIN_MONITOR_CONNECTION_FILES,
 			NM_CONFIG_KEYFILE_KEY_MAIN_NO_AUTO_DEFAULT,
 			NM_CONFIG_KEYFILE_KEY_MAIN_PLUGINS,
 			NM_CONFIG_KEYFILE_KEY_MAIN_RC_MANAGER,
+			NM_CONFIG_KEYFILE_KEY_MAIN_SHARED_DHCP,
 			NM_CONFIG_KEYFILE_KEY_MAIN_SLAVES_ORDER,
 			NM_CONFIG_KEYFILE_KEY_MAIN_SYSTEMD_RESOLVED,
 		),
@@ -796,6 +805,7 @@ static const ConfigGroup config_groups[] = {
 			NM_CONFIG_KEYFILE_KEY_DEVICE_MANAGED,
 			NM_CONFIG_KEYFILE_KEY_DEVICE_SRIOV_NUM_VFS,
 			NM_CONFIG_KEYFILE_KEY_DEVICE_WIFI_BACKEND,
+			NM_CONFIG_KEYFILE_KEY_DEVICE_WIFI_SCAN_NL80211_RESULTS,
 			NM_CONFIG_KEYFILE_KEY_DEVICE_WIFI_SCAN_RAND_MAC_ADDRESS,
 			NM_CONFIG_KEYFILE_KEY_MATCH_DEVICE,
 			NM_CONFIG_KEYFILE_KEY_STOP_MATCH,
@@ -60,15 +60,24 @@
 #define NM_CONFIG_KEYFILE_KEY_MAIN_AUTH_POLKIT              "auth-polkit"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_AUTOCONNECT_RETRIES_DEFAULT "autoconnect-retries-default"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_CONFIGURE_AND_QUIT       "configure-and-quit"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DBUS_COALESCE_PROPERTIES_CHANGED "dbus-coalesce-properties-changed"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DBUS_LEGACY_PROPERTIES_CHANGED "dbus-legacy-properties-changed"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_DEBUG                    "debug"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_DHCP                     "dhcp"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_LEASE_DB            "dhcp-lease-db"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_SHARED_SOCKET       "dhcp-shared-socket"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_START_JITTER        "dhcp-start-jitter"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_START_LIMIT         "dhcp-start-limit"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_START_RATE          "dhcp-start-rate"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_DNS                      "dns"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_HOSTNAME_MODE            "hostname-mode"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_IGNORE_CARRIER           "ignore-carrier"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_LLDP_SHARED_SOCKET       "lldp-shared-socket"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_MONITOR_CONNECTION_FILES "monitor-connection-files"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_NO_AUTO_DEFAULT          "no-auto-default"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_PLUGINS                  "plugins"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_RC_MANAGER               "rc-manager"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_SHARED_DHCP              "shared-dhcp"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_SLAVES_ORDER             "slaves-order"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_SYSTEMD_RESOLVED         "systemd-resolved"
 
@@ -99,6 +108,7 @@
 #define NM_CONFIG_KEYFILE_KEY_DEVICE_SRIOV_NUM_VFS          "sriov-num-vfs"
 #define NM_CONFIG_KEYFILE_KEY_DEVICE_WIFI_BACKEND           "wifi.backend"
 #define NM_CONFIG_KEYFILE_KEY_DEVICE_WIFI_SCAN_RAND_MAC_ADDRESS "wifi.scan-rand-mac-address"
+#define NM_CONFIG_KEYFILE_KEY_DEVICE_WIFI_SCAN_NL80211_RESULTS "wifi.scan-nl80211-results"
 #define NM_CONFIG_KEYFILE_KEY_DEVICE_CARRIER_WAIT_TIMEOUT   "carrier-wait-timeout"
 
 #define NM_CONFIG_KEYFILE_KEY_MATCH_DEVICE           "match-device"
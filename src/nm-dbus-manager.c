@@ -41,6 +41,14 @@
  */
 #define OBJECT_MANAGER_SERVER_BASE_PATH "/org/freedesktop"
 
+/* An extension of the ObjectManager interface, on the same path. It allows
+ * clients to fetch the managed objects filtered and in chunks, and to subscribe
+ * to InterfacesAdded/InterfacesRemoved signals for certain interfaces only. */
+#define OBJECT_MANAGER_FILTERED_INTERFACE NM_DBUS_INTERFACE ".ObjectManager"
+
+/* the maximum number of objects returned by one GetManagedObjectsFiltered() call. */
+#define OBJECT_MANAGER_FILTERED_MAX_LIMIT 1000
+
 /*****************************************************************************/
 
 typedef struct {
@@ -54,8 +62,27 @@ typedef struct {
 	char sender[0];
 } CallerInfo;
 
+typedef struct {
+	const char *path_prefix;
+
+	/* a %NULL terminated list of interface names, or %NULL to match
+	 * all interfaces. */
+	const char *const*interfaces;
+} ObjFilter;
+
+typedef struct {
+	CList objmgr_subscription_lst;
+	char *sender;
+	char *path_prefix;
+	char **interfaces;
+	guint name_watch_id;
+} ObjmgrSubscription;
+
 typedef struct {
 	GVariant *value;
+
+	/* whether the property changed and a PropertiesChanged signal is pending. */
+	bool notify_pending;
 } PropertyCacheData;
 
 typedef struct {
@@ -64,9 +91,23 @@ typedef struct {
 	NMDBusObjectClass *klass;
 	guint info_idx;
 	guint registration_id;
+	guint64 notify_batch_id;
+	bool notify_pending:1;
 	PropertyCacheData property_cache[];
 } RegistrationData;
 
+typedef struct {
+	/* the property index created by nm_dbus_utils_property_index_new(), to
+	 * find the D-Bus properties for a GObject property notification. */
+	GHashTable *property_index;
+	guint n_interface_infos;
+	const NMDBusInterfaceInfoExtended *interface_infos[];
+} TypeInfo;
+
+/* Upper bound for the coalescing window of PropertiesChanged signals. Changes
+ * are never delayed longer than this, regardless of the configuration. */
+#define NOTIFY_COALESCE_MAX_MSEC 1000
+
 /* we require that @path is the first member of NMDBusManagerData
  * because _objects_by_path_hash() requires that. */
 G_STATIC_ASSERT (G_STRUCT_OFFSET (struct _NMDBusObjectInternal, path) == 0);
@@ -84,6 +125,10 @@ typedef struct {
 	GHashTable *objects_by_path;
 	CList objects_lst_head;
 
+	/* the exported objects by their export-version-id, to resume
+	 * GetManagedObjectsFiltered() at the cursor. */
+	GHashTable *objects_by_export_version_id;
+
 	CList private_servers_lst_head;
 
 	NMDBusManagerSetPropertyHandler set_property_handler;
@@ -93,9 +138,34 @@ typedef struct {
 
 	CList caller_info_lst_head;
 
+	/* the TypeInfo for each object type, see _type_info_get(). */
+	GHashTable *type_info_by_gtype;
+
+	/* objects that have PropertiesChanged signals pending. */
+	CList notify_pending_lst_head;
+	guint notify_pending_id;
+	guint64 notify_batch_id;
+
+	/* how long to coalesce PropertiesChanged signals. -1 means disabled, and
+	 * 0 means to flush them once per main-loop iteration. */
+	int notify_coalesce_msec;
+
+	struct {
+		guint64 emitted;
+		guint64 saved;
+		guint64 legacy_suppressed;
+	} notify_stats;
+
 	guint objmgr_registration_id;
+	guint objmgr_filtered_registration_id;
+
+	CList objmgr_subscription_lst_head;
+
 	bool started:1;
 	bool shutting_down:1;
+
+	/* whether to emit the legacy, interface specific PropertiesChanged signals. */
+	bool legacy_properties_changed:1;
 } NMDBusManagerPrivate;
 
 struct _NMDBusManager {
@@ -123,8 +193,17 @@ NM_DEFINE_SINGLETON_GETTER (NMDBusManager, nm_dbus_manager_get, NM_TYPE_DBUS_MAN
 static const GDBusInterfaceInfo interface_info_objmgr;
 static const GDBusSignalInfo signal_info_objmgr_interfaces_added;
 static const GDBusSignalInfo signal_info_objmgr_interfaces_removed;
+static const GDBusInterfaceInfo interface_info_objmgr_filtered;
 static GVariantBuilder *_obj_collect_properties_all (NMDBusObject *obj,
                                                      GVariantBuilder *builder);
+static void _objmgr_subscriptions_emit_added (NMDBusManager *self,
+                                              NMDBusObject *obj);
+static void _objmgr_subscriptions_emit_removed (NMDBusManager *self,
+                                                NMDBusObject *obj,
+                                                const char *const*interfaces);
+static void _obj_notify_flush (NMDBusManager *self,
+                               NMDBusObject *obj);
+static void _obj_notify_flush_all (NMDBusManager *self);
 
 /*****************************************************************************/
 
@@ -862,6 +941,76 @@ _reg_data_get_interface_info (RegistrationData *reg_data)
 
 /*****************************************************************************/
 
+static void
+_type_info_free (TypeInfo *type_info)
+{
+	g_hash_table_unref (type_info->property_index);
+	g_free (type_info);
+}
+
+static TypeInfo *
+_type_info_get (NMDBusManager *self,
+                NMDBusObject *obj)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	GType gtype = G_OBJECT_TYPE (obj);
+	gs_unref_ptrarray GPtrArray *interface_infos = NULL;
+	const NMDBusInterfaceInfoExtended *const*prev_interface_infos;
+	TypeInfo *type_info;
+	GType t;
+	guint i;
+
+	if (G_UNLIKELY (!priv->type_info_by_gtype)) {
+		priv->type_info_by_gtype = g_hash_table_new_full (nm_direct_hash,
+		                                                  NULL,
+		                                                  NULL,
+		                                                  (GDestroyNotify) _type_info_free);
+	}
+
+	type_info = g_hash_table_lookup (priv->type_info_by_gtype, GSIZE_TO_POINTER (gtype));
+	if (G_LIKELY (type_info))
+		return type_info;
+
+	/* the D-Bus interfaces of an object strictly depend on its type. Collect
+	 * them once per type, the same way as _obj_register() does. */
+	interface_infos = g_ptr_array_new ();
+	prev_interface_infos = NULL;
+	for (t = gtype; t != NM_TYPE_DBUS_OBJECT; t = g_type_parent (t)) {
+		NMDBusObjectClass *klass = g_type_class_peek (t);
+
+		if (   !klass->interface_infos
+		    || klass->interface_infos == prev_interface_infos)
+			continue;
+		prev_interface_infos = klass->interface_infos;
+
+		for (i = 0; klass->interface_infos[i]; i++)
+			g_ptr_array_add (interface_infos, (gpointer) klass->interface_infos[i]);
+	}
+
+	type_info = g_malloc (G_STRUCT_OFFSET (TypeInfo, interface_infos) + (sizeof (gpointer) * interface_infos->len));
+	type_info->n_interface_infos = interface_infos->len;
+	memcpy (type_info->interface_infos, interface_infos->pdata, sizeof (gpointer) * interface_infos->len);
+	type_info->property_index = nm_dbus_utils_property_index_new (type_info->interface_infos,
+	                                                              type_info->n_interface_infos);
+	g_hash_table_insert (priv->type_info_by_gtype, GSIZE_TO_POINTER (gtype), type_info);
+	return type_info;
+}
+
+static guint
+_type_info_get_interface_idx (const TypeInfo *type_info,
+                              const NMDBusInterfaceInfoExtended *interface_info)
+{
+	guint i;
+
+	for (i = 0; i < type_info->n_interface_infos; i++) {
+		if (type_info->interface_infos[i] == interface_info)
+			return i;
+	}
+	g_return_val_if_reached (G_MAXUINT);
+}
+
+/*****************************************************************************/
+
 static void
 dbus_vtable_method_call (GDBusConnection *connection,
                          const char *sender,
@@ -1026,12 +1175,17 @@ _obj_register (NMDBusManager *self,
 	NMDBusObjectClass *klasses[10];
 	const NMDBusInterfaceInfoExtended *const*prev_interface_infos = NULL;
 	GVariantBuilder builder;
+	TypeInfo *type_info;
 
 	nm_assert (c_list_is_empty (&obj->internal.registration_lst_head));
+	nm_assert (!obj->internal.registrations);
 	nm_assert (priv->main_dbus_connection);
 	nm_assert (priv->objmgr_registration_id != 0);
 	nm_assert (priv->started);
 
+	type_info = _type_info_get (self, obj);
+	obj->internal.registrations = g_new0 (gpointer, NM_MAX (type_info->n_interface_infos, 1u));
+
 	n_klasses = 0;
 	gtype = G_OBJECT_TYPE (obj);
 	while (gtype != NM_TYPE_DBUS_OBJECT) {
@@ -1062,6 +1216,7 @@ _obj_register (NMDBusManager *self,
 			RegistrationData *reg_data;
 			gs_free_error GError *error = NULL;
 			guint registration_id;
+			guint interface_idx;
 			guint prop_len = NM_PTRARRAY_LEN (interface_info->parent.properties);
 
 			reg_data = g_malloc0 (sizeof (RegistrationData) + (sizeof (PropertyCacheData) * prop_len));
@@ -1084,6 +1239,10 @@ _obj_register (NMDBusManager *self,
 			reg_data->info_idx = i;
 			reg_data->registration_id = registration_id;
 			c_list_link_tail (&obj->internal.registration_lst_head, &reg_data->registration_lst);
+
+			interface_idx = _type_info_get_interface_idx (type_info, interface_info);
+			if (interface_idx < type_info->n_interface_infos)
+				obj->internal.registrations[interface_idx] = reg_data;
 		}
 	}
 
@@ -1104,7 +1263,11 @@ _obj_register (NMDBusManager *self,
 	 * notifications out. Which is a bit odd, as we just export the object.
 	 *
 	 * In general, it's ok to export an object with frozen signals. But you better make sure
-	 * that all properties are in a self-consistent state when exporting the object. */
+	 * that all properties are in a self-consistent state when exporting the object.
+	 *
+	 * Pending PropertiesChanged signals of other objects might refer to the new object
+	 * (or not). Send them first, to preserve the order of events. */
+	_obj_notify_flush_all (self);
 	g_dbus_connection_emit_signal (priv->main_dbus_connection,
 	                               NULL,
 	                               OBJECT_MANAGER_SERVER_BASE_PATH,
@@ -1114,6 +1277,8 @@ _obj_register (NMDBusManager *self,
 	                                              obj->internal.path,
 	                                              _obj_collect_properties_all (obj, &builder)),
 	                               NULL);
+
+	_objmgr_subscriptions_emit_added (self, obj);
 }
 
 static void
@@ -1123,6 +1288,8 @@ _obj_unregister (NMDBusManager *self,
 	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
 	RegistrationData *reg_data;
 	GVariantBuilder builder;
+	gs_free const char **interfaces = NULL;
+	guint n_interfaces = 0;
 
 	nm_assert (NM_IS_DBUS_OBJECT (obj));
 	nm_assert (priv->main_dbus_connection);
@@ -1130,8 +1297,16 @@ _obj_unregister (NMDBusManager *self,
 	nm_assert (priv->started);
 	nm_assert (!c_list_is_empty (&obj->internal.registration_lst_head));
 
+	/* emit pending PropertiesChanged signals (of this and the other objects)
+	 * before the object goes away. */
+	_obj_notify_flush_all (self);
+	nm_assert (c_list_is_empty (&obj->internal.notify_pending_lst));
+
 	g_variant_builder_init (&builder, G_VARIANT_TYPE ("as"));
 
+	/* the interface names for the subscribers of the filtered object manager. */
+	interfaces = g_new (const char *, c_list_length (&obj->internal.registration_lst_head) + 1);
+
 	while ((reg_data = c_list_last_entry (&obj->internal.registration_lst_head, RegistrationData, registration_lst))) {
 		const NMDBusInterfaceInfoExtended *interface_info = _reg_data_get_interface_info (reg_data);
 		guint i;
@@ -1139,6 +1314,7 @@ _obj_unregister (NMDBusManager *self,
 		g_variant_builder_add (&builder,
 		                       "s",
 		                       interface_info->parent.name);
+		interfaces[n_interfaces++] = interface_info->parent.name;
 		c_list_unlink_stale (&reg_data->registration_lst);
 		if (!g_dbus_connection_unregister_object (priv->main_dbus_connection, reg_data->registration_id))
 			nm_assert_not_reached ();
@@ -1151,6 +1327,7 @@ _obj_unregister (NMDBusManager *self,
 		g_type_class_unref (reg_data->klass);
 		g_free (reg_data);
 	}
+	nm_clear_g_free (&obj->internal.registrations);
 
 	g_dbus_connection_emit_signal (priv->main_dbus_connection,
 	                               NULL,
@@ -1161,6 +1338,9 @@ _obj_unregister (NMDBusManager *self,
 	                                              obj->internal.path,
 	                                              &builder),
 	                               NULL);
+
+	interfaces[n_interfaces] = NULL;
+	_objmgr_subscriptions_emit_removed (self, obj, interfaces);
 }
 
 gpointer
@@ -1202,6 +1382,7 @@ _nm_dbus_manager_obj_export (NMDBusObject *obj)
 	if (!g_hash_table_add (priv->objects_by_path, &obj->internal))
 		nm_assert_not_reached ();
 	c_list_link_tail (&priv->objects_lst_head, &obj->internal.objects_lst);
+	g_hash_table_insert (priv->objects_by_export_version_id, &obj->internal.export_version_id, obj);
 
 	if (priv->started)
 		_obj_register (self, obj);
@@ -1232,75 +1413,63 @@ _nm_dbus_manager_obj_unexport (NMDBusObject *obj)
 	if (!g_hash_table_remove (priv->objects_by_path, &obj->internal))
 		nm_assert_not_reached ();
 	c_list_unlink (&obj->internal.objects_lst);
+	if (!g_hash_table_remove (priv->objects_by_export_version_id, &obj->internal.export_version_id))
+		nm_assert_not_reached ();
 }
 
-void
-_nm_dbus_manager_obj_notify (NMDBusObject *obj,
-                             guint n_pspecs,
-                             const GParamSpec *const*pspecs)
+static void
+_obj_notify_flush (NMDBusManager *self,
+                   NMDBusObject *obj)
 {
-	NMDBusManager *self;
-	NMDBusManagerPrivate *priv;
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
 	RegistrationData *reg_data;
-	guint i, p;
-	gboolean any_legacy_signals = FALSE;
+	guint i;
+	guint n_legacy_interfaces = 0;
 	gboolean any_legacy_properties = FALSE;
+	gboolean any_legacy_suppressed = FALSE;
 	GVariantBuilder legacy_builder;
 	GVariant *device_statistics_args = NULL;
 
-	nm_assert (NM_IS_DBUS_OBJECT (obj));
-	nm_assert (obj->internal.path);
-	nm_assert (NM_IS_DBUS_MANAGER (obj->internal.bus_manager));
-	nm_assert (!c_list_is_empty (&obj->internal.objects_lst));
-
-	self = obj->internal.bus_manager;
-	priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	nm_assert (priv->started);
 
-	nm_assert (!priv->started || priv->objmgr_registration_id != 0);
-	nm_assert (priv->objmgr_registration_id == 0 || priv->main_dbus_connection);
-	nm_assert (c_list_is_empty (&obj->internal.registration_lst_head) != priv->started);
-
-	if (G_UNLIKELY (!priv->started))
-		return;
+	c_list_unlink (&obj->internal.notify_pending_lst);
 
 	c_list_for_each_entry (reg_data, &obj->internal.registration_lst_head, registration_lst) {
-		if (_reg_data_get_interface_info (reg_data)->legacy_property_changed) {
-			any_legacy_signals = TRUE;
-			break;
-		}
+		if (_reg_data_get_interface_info (reg_data)->legacy_property_changed)
+			n_legacy_interfaces++;
 	}
 
-	/* do a naive search for the matching NMDBusPropertyInfoExtended infos. Since the number of
-	 * (interfaces x properties) is static and possibly small, this naive search is effectively
-	 * O(1). We might wanna introduce some index to lookup the properties in question faster.
-	 *
-	 * The nice part of this implementation is however, that the order in which properties
-	 * are added to the GVariant is strictly defined to be the order in which the D-Bus property-info
-	 * is declared. Getting a defined ordering with some smart lookup would be hard. */
+	/* The order in which properties are added to the GVariant is strictly defined to be
+	 * the order in which the D-Bus property-info is declared. */
 	c_list_for_each_entry (reg_data, &obj->internal.registration_lst_head, registration_lst) {
 		const NMDBusInterfaceInfoExtended *interface_info = _reg_data_get_interface_info (reg_data);
-		gboolean has_properties = FALSE;
 		GVariantBuilder builder;
 		GVariantBuilder invalidated_builder;
 		GVariant *args;
 
-		if (!interface_info->parent.properties)
+		if (!reg_data->notify_pending)
 			continue;
+		reg_data->notify_pending = FALSE;
+
+		nm_assert (interface_info->parent.properties);
+
+		g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
 
 		for (i = 0; interface_info->parent.properties[i]; i++) {
 			const NMDBusPropertyInfoExtended *property_info = (const NMDBusPropertyInfoExtended *) interface_info->parent.properties[i];
+			gs_unref_variant GVariant *value = NULL;
 
-			for (p = 0; p < n_pspecs; p++) {
-				const GParamSpec *pspec = pspecs[p];
-				gs_unref_variant GVariant *value = NULL;
-
-				if (!nm_streq (property_info->property_name, pspec->name))
-					continue;
+			if (!reg_data->property_cache[i].notify_pending)
+				continue;
+			reg_data->property_cache[i].notify_pending = FALSE;
 
-				value = _obj_get_property (reg_data, i, TRUE);
+			value = _obj_get_property (reg_data, i, FALSE);
 
-				if (   property_info->include_in_legacy_property_changed
-				    && any_legacy_signals) {
+			if (   property_info->include_in_legacy_property_changed
+			    && n_legacy_interfaces > 0) {
+				if (!priv->legacy_properties_changed)
+					any_legacy_suppressed = TRUE;
+				else {
 					/* also track the value in the legacy_builder to emit legacy signals below. */
 					if (!any_legacy_properties) {
 						any_legacy_properties = TRUE;
@@ -1308,17 +1477,10 @@ _nm_dbus_manager_obj_notify (NMDBusObject *obj,
 					}
 					g_variant_builder_add (&legacy_builder, "{sv}", property_info->parent.name, value);
 				}
-
-				if (!has_properties) {
-					has_properties = TRUE;
-					g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
-				}
-				g_variant_builder_add (&builder, "{sv}", property_info->parent.name, value);
 			}
-		}
 
-		if (!has_properties)
-			continue;
+			g_variant_builder_add (&builder, "{sv}", property_info->parent.name, value);
+		}
 
 		args = g_variant_builder_end (&builder);
 
@@ -1326,9 +1488,14 @@ _nm_dbus_manager_obj_notify (NMDBusObject *obj,
 			/* we treat the Device.Statistics signal special, because we need to
 			 * emit a signal also for it (below). */
 			nm_assert (!device_statistics_args);
-			device_statistics_args = g_variant_ref_sink (args);
+			if (priv->legacy_properties_changed)
+				device_statistics_args = g_variant_ref_sink (args);
+			else
+				priv->notify_stats.legacy_suppressed++;
 		}
 
+		priv->notify_stats.emitted++;
+
 		g_variant_builder_init (&invalidated_builder, G_VARIANT_TYPE ("as"));
 		g_dbus_connection_emit_signal (priv->main_dbus_connection,
 		                               NULL,
@@ -1357,6 +1524,11 @@ _nm_dbus_manager_obj_notify (NMDBusObject *obj,
 		g_variant_unref (device_statistics_args);
 	}
 
+	if (any_legacy_suppressed) {
+		/* we would have emitted the legacy signal on every interface that has one. */
+		priv->notify_stats.legacy_suppressed += n_legacy_interfaces;
+	}
+
 	if (any_legacy_properties) {
 		gs_unref_variant GVariant *args = NULL;
 
@@ -1395,6 +1567,220 @@ _nm_dbus_manager_obj_notify (NMDBusObject *obj,
 	}
 }
 
+static gboolean
+_obj_notify_pending_cb (gpointer user_data)
+{
+	NMDBusManager *self = user_data;
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+
+	priv->notify_pending_id = 0;
+	_obj_notify_flush_all (self);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_obj_notify_flush_all (NMDBusManager *self)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	NMDBusObject *obj;
+
+	nm_clear_g_source (&priv->notify_pending_id);
+
+	if (c_list_is_empty (&priv->notify_pending_lst_head))
+		return;
+
+	while ((obj = c_list_first_entry (&priv->notify_pending_lst_head, NMDBusObject, internal.notify_pending_lst)))
+		_obj_notify_flush (self, obj);
+
+	_LOGT ("properties-changed: %"G_GUINT64_FORMAT" signals emitted, %"G_GUINT64_FORMAT" saved by coalescing, %"G_GUINT64_FORMAT" legacy signals suppressed",
+	       priv->notify_stats.emitted,
+	       priv->notify_stats.saved,
+	       priv->notify_stats.legacy_suppressed);
+}
+
+void
+_nm_dbus_manager_obj_notify (NMDBusObject *obj,
+                             guint n_pspecs,
+                             const GParamSpec *const*pspecs)
+{
+	NMDBusManager *self;
+	NMDBusManagerPrivate *priv;
+	TypeInfo *type_info;
+	guint64 batch_id;
+	guint i, p;
+	gboolean any_pending = FALSE;
+
+	nm_assert (NM_IS_DBUS_OBJECT (obj));
+	nm_assert (obj->internal.path);
+	nm_assert (NM_IS_DBUS_MANAGER (obj->internal.bus_manager));
+	nm_assert (!c_list_is_empty (&obj->internal.objects_lst));
+
+	self = obj->internal.bus_manager;
+	priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+
+	nm_assert (!priv->started || priv->objmgr_registration_id != 0);
+	nm_assert (priv->objmgr_registration_id == 0 || priv->main_dbus_connection);
+	nm_assert (c_list_is_empty (&obj->internal.registration_lst_head) != priv->started);
+
+	if (G_UNLIKELY (!priv->started))
+		return;
+
+	/* Only mark the properties as pending. The values are fetched when emitting the signal,
+	 * so that several changes of the same property result in only one notification. */
+	type_info = _type_info_get (self, obj);
+	batch_id = ++priv->notify_batch_id;
+	for (p = 0; p < n_pspecs; p++) {
+		const NMDBusPropertyIndexEntry *entries;
+		guint n_entries;
+
+		entries = nm_dbus_utils_property_index_lookup (type_info->property_index, pspecs[p]->name, &n_entries);
+		for (i = 0; i < n_entries; i++) {
+			RegistrationData *reg_data;
+
+			nm_assert (entries[i].interface_idx < type_info->n_interface_infos);
+			reg_data = obj->internal.registrations[entries[i].interface_idx];
+			if (!reg_data) {
+				/* the registration of the interface failed. */
+				continue;
+			}
+
+			/* drop the cached value, so that a Get() call returns the new
+			 * value, even while the signal is still pending. */
+			nm_clear_g_variant (&reg_data->property_cache[entries[i].property_idx].value);
+			reg_data->property_cache[entries[i].property_idx].notify_pending = TRUE;
+
+			if (reg_data->notify_batch_id == batch_id)
+				continue;
+			reg_data->notify_batch_id = batch_id;
+
+			if (reg_data->notify_pending) {
+				/* the change gets merged into the pending signal. */
+				priv->notify_stats.saved++;
+			} else
+				reg_data->notify_pending = TRUE;
+			any_pending = TRUE;
+		}
+	}
+
+	if (!any_pending)
+		return;
+
+	if (priv->notify_coalesce_msec < 0) {
+		nm_assert (c_list_is_empty (&priv->notify_pending_lst_head));
+		c_list_link_tail (&priv->notify_pending_lst_head, &obj->internal.notify_pending_lst);
+		_obj_notify_flush (self, obj);
+		return;
+	}
+
+	if (c_list_is_empty (&obj->internal.notify_pending_lst))
+		c_list_link_tail (&priv->notify_pending_lst_head, &obj->internal.notify_pending_lst);
+
+	/* the timer is started by the first pending change and not extended by
+	 * further changes. That bounds the latency of any change. */
+	if (priv->notify_pending_id == 0) {
+		if (priv->notify_coalesce_msec == 0) {
+			priv->notify_pending_id = g_idle_add_full (G_PRIORITY_DEFAULT,
+			                                           _obj_notify_pending_cb,
+			                                           self,
+			                                           NULL);
+		} else {
+			priv->notify_pending_id = g_timeout_add (priv->notify_coalesce_msec,
+			                                         _obj_notify_pending_cb,
+			                                         self);
+		}
+	}
+}
+
+/**
+ * nm_dbus_manager_set_notify_coalesce:
+ * @self: the #NMDBusManager
+ * @msec: the time in milliseconds to coalesce PropertiesChanged signals.
+ *   A negative value disables coalescing and signals are emitted right
+ *   away. With zero, pending signals are emitted once per main-loop
+ *   iteration. The value is limited to %NOTIFY_COALESCE_MAX_MSEC.
+ *
+ * While coalescing, property changes of an object get merged and emitted
+ * as one PropertiesChanged signal per interface.
+ */
+void
+nm_dbus_manager_set_notify_coalesce (NMDBusManager *self,
+                                     int msec)
+{
+	NMDBusManagerPrivate *priv;
+
+	g_return_if_fail (NM_IS_DBUS_MANAGER (self));
+
+	priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+
+	msec = NM_CLAMP (msec, -1, NOTIFY_COALESCE_MAX_MSEC);
+	if (priv->notify_coalesce_msec == msec)
+		return;
+
+	_LOGD ("properties-changed: %s%d%s",
+	       msec < 0 ? "coalescing disabled" : "coalesce for ",
+	       msec < 0 ? 0 : msec,
+	       msec < 0 ? "" : " msec");
+
+	/* emit pending signals now, any new signals use the new setting. */
+	_obj_notify_flush_all (self);
+	priv->notify_coalesce_msec = msec;
+}
+
+/**
+ * nm_dbus_manager_set_legacy_properties_changed:
+ * @self: the #NMDBusManager
+ * @enabled: whether to emit legacy signals
+ *
+ * Some interfaces have a legacy, interface specific PropertiesChanged signal
+ * in addition to the standard org.freedesktop.DBus.Properties.PropertiesChanged
+ * signal. Disabling them halves the number of signals for property changes
+ * on these objects.
+ */
+void
+nm_dbus_manager_set_legacy_properties_changed (NMDBusManager *self,
+                                               gboolean enabled)
+{
+	NMDBusManagerPrivate *priv;
+
+	g_return_if_fail (NM_IS_DBUS_MANAGER (self));
+
+	priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+
+	enabled = !!enabled;
+	if (priv->legacy_properties_changed == enabled)
+		return;
+
+	_LOGD ("properties-changed: %s legacy signals", enabled ? "enable" : "disable");
+
+	_obj_notify_flush_all (self);
+	priv->legacy_properties_changed = enabled;
+}
+
+/**
+ * nm_dbus_manager_get_notify_stats:
+ * @self: the #NMDBusManager
+ * @out_emitted: (allow-none): the number of emitted standard PropertiesChanged signals
+ * @out_saved: (allow-none): the number of signals saved by coalescing
+ * @out_legacy_suppressed: (allow-none): the number of legacy PropertiesChanged
+ *   signals that were not emitted because they are disabled
+ */
+void
+nm_dbus_manager_get_notify_stats (NMDBusManager *self,
+                                  guint64 *out_emitted,
+                                  guint64 *out_saved,
+                                  guint64 *out_legacy_suppressed)
+{
+	NMDBusManagerPrivate *priv;
+
+	g_return_if_fail (NM_IS_DBUS_MANAGER (self));
+
+	priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+
+	NM_SET_OUT (out_emitted, priv->notify_stats.emitted);
+	NM_SET_OUT (out_saved, priv->notify_stats.saved);
+	NM_SET_OUT (out_legacy_suppressed, priv->notify_stats.legacy_suppressed);
+}
+
 void
 _nm_dbus_manager_obj_emit_signal (NMDBusObject *obj,
                                   const NMDBusInterfaceInfoExtended *interface_info,
@@ -1417,6 +1803,10 @@ _nm_dbus_manager_obj_emit_signal (NMDBusObject *obj,
 		return;
 	}
 
+	/* pending property changes of the object happened before the signal. */
+	if (!c_list_is_empty (&obj->internal.notify_pending_lst))
+		_obj_notify_flush (self, obj);
+
 	g_dbus_connection_emit_signal (priv->main_dbus_connection,
 	                               NULL,
 	                               obj->internal.path,
@@ -1525,6 +1915,425 @@ static const GDBusInterfaceVTable dbus_vtable_objmgr = {
 	.method_call = dbus_vtable_objmgr_method_call
 };
 
+/*****************************************************************************/
+
+static gboolean
+_obj_filter_match_path (const ObjFilter *filter,
+                        const char *path)
+{
+	gsize l;
+
+	if (!filter->path_prefix)
+		return TRUE;
+
+	if (!g_str_has_prefix (path, filter->path_prefix))
+		return FALSE;
+
+	/* only match whole path elements. */
+	l = strlen (filter->path_prefix);
+	return    l == 0
+	       || filter->path_prefix[l - 1] == '/'
+	       || NM_IN_SET (path[l], '\0', '/');
+}
+
+static gboolean
+_obj_filter_match_interface (const ObjFilter *filter,
+                             const char *interface_name)
+{
+	return    !filter->interfaces
+	       || nm_utils_strv_find_first ((char **) filter->interfaces, -1, interface_name) >= 0;
+}
+
+static gboolean
+_obj_filter_match_any_interface (NMDBusObject *obj,
+                                 const ObjFilter *filter)
+{
+	RegistrationData *reg_data;
+
+	if (!filter->interfaces)
+		return !c_list_is_empty (&obj->internal.registration_lst_head);
+
+	c_list_for_each_entry (reg_data, &obj->internal.registration_lst_head, registration_lst) {
+		if (_obj_filter_match_interface (filter, _reg_data_get_interface_info (reg_data)->parent.name))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* like _obj_collect_properties_all(), but only for the interfaces that match
+ * @filter. Returns the number of matching interfaces, or zero, in which case
+ * @builder is not initialized. */
+static guint
+_obj_collect_properties_filtered (NMDBusObject *obj,
+                                  const ObjFilter *filter,
+                                  GVariantBuilder *builder)
+{
+	RegistrationData *reg_data;
+	guint n = 0;
+
+	c_list_for_each_entry (reg_data, &obj->internal.registration_lst_head, registration_lst) {
+		const NMDBusInterfaceInfoExtended *interface_info = _reg_data_get_interface_info (reg_data);
+		GVariantBuilder properties_builder;
+
+		if (!_obj_filter_match_interface (filter, interface_info->parent.name))
+			continue;
+
+		if (n++ == 0)
+			g_variant_builder_init (builder, G_VARIANT_TYPE ("a{sa{sv}}"));
+		g_variant_builder_add (builder,
+		                       "{sa{sv}}",
+		                       interface_info->parent.name,
+		                       _obj_collect_properties_per_interface (obj,
+		                                                              reg_data,
+		                                                              &properties_builder));
+	}
+
+	return n;
+}
+
+static gboolean
+_obj_filter_parse (GVariant *options,
+                   gboolean with_paging,
+                   ObjFilter *out_filter,
+                   const char ***out_interfaces_free,
+                   guint64 *out_cursor,
+                   guint32 *out_limit,
+                   GError **error)
+{
+	GVariantIter iter;
+	const char *key;
+	GVariant *value;
+
+	*out_filter = (ObjFilter) { };
+	*out_interfaces_free = NULL;
+	NM_SET_OUT (out_cursor, 0);
+	NM_SET_OUT (out_limit, OBJECT_MANAGER_FILTERED_MAX_LIMIT);
+
+	g_variant_iter_init (&iter, options);
+	while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+		gs_unref_variant GVariant *value_free = value;
+
+		if (   nm_streq (key, "interfaces")
+		    && g_variant_is_of_type (value, G_VARIANT_TYPE ("as"))) {
+			g_free (*out_interfaces_free);
+			*out_interfaces_free = g_variant_get_strv (value, NULL);
+			out_filter->interfaces = *out_interfaces_free;
+		} else if (   nm_streq (key, "path-prefix")
+		           && (   g_variant_is_of_type (value, G_VARIANT_TYPE_OBJECT_PATH)
+		               || g_variant_is_of_type (value, G_VARIANT_TYPE_STRING))) {
+			/* the string is owned by @options, which outlives the filter. */
+			out_filter->path_prefix = g_variant_get_string (value, NULL);
+		} else if (   with_paging
+		           && nm_streq (key, "cursor")
+		           && g_variant_is_of_type (value, G_VARIANT_TYPE_UINT64))
+			*out_cursor = g_variant_get_uint64 (value);
+		else if (   with_paging
+		         && nm_streq (key, "limit")
+		         && g_variant_is_of_type (value, G_VARIANT_TYPE_UINT32)) {
+			guint32 limit = g_variant_get_uint32 (value);
+
+			*out_limit = NM_CLAMP (limit, 1u, (guint32) OBJECT_MANAGER_FILTERED_MAX_LIMIT);
+		} else {
+			nm_clear_g_free (out_interfaces_free);
+			g_set_error (error,
+			             G_DBUS_ERROR,
+			             G_DBUS_ERROR_INVALID_ARGS,
+			             "Invalid option \"%s\" of type \"%s\"",
+			             key,
+			             g_variant_get_type_string (value));
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static void
+_objmgr_filtered_get_managed_objects (NMDBusManager *self,
+                                      GDBusMethodInvocation *invocation,
+                                      GVariant *parameters)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	gs_unref_variant GVariant *options = NULL;
+	gs_free const char **interfaces_free = NULL;
+	GError *error = NULL;
+	GVariantBuilder array_builder;
+	ObjFilter filter;
+	NMDBusObject *obj;
+	CList *iter;
+	guint64 cursor;
+	guint64 next_cursor = 0;
+	guint32 limit;
+	guint32 n = 0;
+	gboolean has_more = FALSE;
+
+	g_variant_get (parameters, "(@a{sv})", &options);
+	if (!_obj_filter_parse (options, TRUE, &filter, &interfaces_free, &cursor, &limit, &error)) {
+		g_dbus_method_invocation_take_error (invocation, error);
+		return;
+	}
+
+	/* the cursor is the export-version-id of the last returned object. Objects are
+	 * sorted by it, because they are appended to objects_lst_head when being exported,
+	 * and every export gets a new, increasing id. Objects that get exported between
+	 * two calls thus show up on later pages.
+	 *
+	 * Usually the object of the cursor is still exported, and we continue right
+	 * after it. Otherwise, search for the first object after the cursor. */
+	iter = &priv->objects_lst_head;
+	if (cursor > 0) {
+		obj = g_hash_table_lookup (priv->objects_by_export_version_id, &cursor);
+		if (obj)
+			iter = &obj->internal.objects_lst;
+		else {
+			c_list_for_each_entry (obj, &priv->objects_lst_head, internal.objects_lst) {
+				if (obj->internal.export_version_id > cursor)
+					break;
+				iter = &obj->internal.objects_lst;
+			}
+		}
+	}
+
+	g_variant_builder_init (&array_builder, G_VARIANT_TYPE ("a{oa{sa{sv}}}"));
+	for (iter = iter->next; iter != &priv->objects_lst_head; iter = iter->next) {
+		GVariantBuilder interfaces_builder;
+
+		obj = c_list_entry (iter, NMDBusObject, internal.objects_lst);
+
+		nm_assert (obj->internal.export_version_id > cursor);
+
+		if (!_obj_filter_match_path (&filter, obj->internal.path))
+			continue;
+
+		if (n >= limit) {
+			/* only announce another page if it won't be empty. */
+			if (_obj_filter_match_any_interface (obj, &filter)) {
+				has_more = TRUE;
+				break;
+			}
+			continue;
+		}
+
+		if (!_obj_collect_properties_filtered (obj, &filter, &interfaces_builder))
+			continue;
+
+		g_variant_builder_add (&array_builder,
+		                       "{oa{sa{sv}}}",
+		                       obj->internal.path,
+		                       &interfaces_builder);
+		next_cursor = obj->internal.export_version_id;
+		n++;
+	}
+
+	if (!has_more)
+		next_cursor = 0;
+
+	g_dbus_method_invocation_return_value (invocation,
+	                                       g_variant_new ("(a{oa{sa{sv}}}t)",
+	                                                      &array_builder,
+	                                                      next_cursor));
+}
+
+/*****************************************************************************/
+
+static void
+_objmgr_subscription_free (ObjmgrSubscription *sub)
+{
+	c_list_unlink_stale (&sub->objmgr_subscription_lst);
+	if (sub->name_watch_id)
+		g_bus_unwatch_name (nm_steal_int (&sub->name_watch_id));
+	g_free (sub->sender);
+	g_free (sub->path_prefix);
+	g_strfreev (sub->interfaces);
+	g_slice_free (ObjmgrSubscription, sub);
+}
+
+static ObjmgrSubscription *
+_objmgr_subscription_find (NMDBusManager *self,
+                           const char *sender)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	ObjmgrSubscription *sub;
+
+	c_list_for_each_entry (sub, &priv->objmgr_subscription_lst_head, objmgr_subscription_lst) {
+		if (nm_streq (sub->sender, sender))
+			return sub;
+	}
+	return NULL;
+}
+
+static void
+_objmgr_subscription_vanished_cb (GDBusConnection *connection,
+                                  const char *name,
+                                  gpointer user_data)
+{
+	ObjmgrSubscription *sub = user_data;
+
+	_LOGT ("object-manager: drop subscription of %s", sub->sender);
+	_objmgr_subscription_free (sub);
+}
+
+static void
+_objmgr_filtered_subscribe (NMDBusManager *self,
+                            GDBusMethodInvocation *invocation,
+                            const char *sender,
+                            GVariant *parameters)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	gs_unref_variant GVariant *options = NULL;
+	gs_free const char **interfaces_free = NULL;
+	GError *error = NULL;
+	ObjmgrSubscription *sub;
+	ObjFilter filter;
+
+	g_variant_get (parameters, "(@a{sv})", &options);
+	if (!_obj_filter_parse (options, FALSE, &filter, &interfaces_free, NULL, NULL, &error)) {
+		g_dbus_method_invocation_take_error (invocation, error);
+		return;
+	}
+
+	sub = _objmgr_subscription_find (self, sender);
+	if (!sub) {
+		sub = g_slice_new0 (ObjmgrSubscription);
+		sub->sender = g_strdup (sender);
+		c_list_link_tail (&priv->objmgr_subscription_lst_head, &sub->objmgr_subscription_lst);
+		sub->name_watch_id = g_bus_watch_name_on_connection (priv->main_dbus_connection,
+		                                                     sender,
+		                                                     G_BUS_NAME_WATCHER_FLAGS_NONE,
+		                                                     NULL,
+		                                                     _objmgr_subscription_vanished_cb,
+		                                                     sub,
+		                                                     NULL);
+	}
+
+	g_free (sub->path_prefix);
+	sub->path_prefix = g_strdup (filter.path_prefix);
+	g_strfreev (sub->interfaces);
+	sub->interfaces = g_strdupv ((char **) filter.interfaces);
+
+	_LOGT ("object-manager: subscription of %s", sender);
+
+	g_dbus_method_invocation_return_value (invocation, NULL);
+}
+
+static void
+_objmgr_subscriptions_emit_added (NMDBusManager *self,
+                                  NMDBusObject *obj)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	ObjmgrSubscription *sub;
+
+	c_list_for_each_entry (sub, &priv->objmgr_subscription_lst_head, objmgr_subscription_lst) {
+		const ObjFilter filter = {
+			.path_prefix = sub->path_prefix,
+			.interfaces  = (const char *const*) sub->interfaces,
+		};
+		GVariantBuilder builder;
+
+		if (!_obj_filter_match_path (&filter, obj->internal.path))
+			continue;
+		if (!_obj_collect_properties_filtered (obj, &filter, &builder))
+			continue;
+
+		g_dbus_connection_emit_signal (priv->main_dbus_connection,
+		                               sub->sender,
+		                               OBJECT_MANAGER_SERVER_BASE_PATH,
+		                               OBJECT_MANAGER_FILTERED_INTERFACE,
+		                               signal_info_objmgr_interfaces_added.name,
+		                               g_variant_new ("(oa{sa{sv}})",
+		                                              obj->internal.path,
+		                                              &builder),
+		                               NULL);
+	}
+}
+
+static void
+_objmgr_subscriptions_emit_removed (NMDBusManager *self,
+                                    NMDBusObject *obj,
+                                    const char *const*interfaces)
+{
+	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
+	ObjmgrSubscription *sub;
+	guint i;
+
+	c_list_for_each_entry (sub, &priv->objmgr_subscription_lst_head, objmgr_subscription_lst) {
+		const ObjFilter filter = {
+			.path_prefix = sub->path_prefix,
+			.interfaces  = (const char *const*) sub->interfaces,
+		};
+		GVariantBuilder builder;
+		gboolean any = FALSE;
+
+		if (!_obj_filter_match_path (&filter, obj->internal.path))
+			continue;
+
+		for (i = 0; interfaces[i]; i++) {
+			if (!_obj_filter_match_interface (&filter, interfaces[i]))
+				continue;
+			if (!any) {
+				any = TRUE;
+				g_variant_builder_init (&builder, G_VARIANT_TYPE ("as"));
+			}
+			g_variant_builder_add (&builder, "s", interfaces[i]);
+		}
+		if (!any)
+			continue;
+
+		g_dbus_connection_emit_signal (priv->main_dbus_connection,
+		                               sub->sender,
+		                               OBJECT_MANAGER_SERVER_BASE_PATH,
+		                               OBJECT_MANAGER_FILTERED_INTERFACE,
+		                               signal_info_objmgr_interfaces_removed.name,
+		                               g_variant_new ("(oas)",
+		                                              obj->internal.path,
+		                                              &builder),
+		                               NULL);
+	}
+}
+
+static void
+dbus_vtable_objmgr_filtered_method_call (GDBusConnection *connection,
+                                         const char *sender,
+                                         const char *object_path,
+                                         const char *interface_name,
+                                         const char *method_name,
+                                         GVariant *parameters,
+                                         GDBusMethodInvocation *invocation,
+                                         gpointer user_data)
+{
+	NMDBusManager *self = user_data;
+	ObjmgrSubscription *sub;
+
+	nm_assert (nm_streq0 (object_path, OBJECT_MANAGER_SERVER_BASE_PATH));
+	nm_assert (nm_streq0 (interface_name, OBJECT_MANAGER_FILTERED_INTERFACE));
+
+	if (nm_streq (method_name, "GetManagedObjectsFiltered")) {
+		_objmgr_filtered_get_managed_objects (self, invocation, parameters);
+		return;
+	}
+	if (nm_streq (method_name, "Subscribe")) {
+		_objmgr_filtered_subscribe (self, invocation, sender, parameters);
+		return;
+	}
+	if (nm_streq (method_name, "Unsubscribe")) {
+		sub = _objmgr_subscription_find (self, sender);
+		if (sub)
+			_objmgr_subscription_free (sub);
+		g_dbus_method_invocation_return_value (invocation, NULL);
+		return;
+	}
+
+	g_dbus_method_invocation_return_error (invocation,
+	                                       G_DBUS_ERROR,
+	                                       G_DBUS_ERROR_UNKNOWN_METHOD,
+	                                       "Unknown method %s",
+	                                       method_name);
+}
+
+static const GDBusInterfaceVTable dbus_vtable_objmgr_filtered = {
+	.method_call = dbus_vtable_objmgr_filtered_method_call
+};
+
 static const GDBusSignalInfo signal_info_objmgr_interfaces_added = NM_DEFINE_GDBUS_SIGNAL_INFO_INIT (
 	"InterfacesAdded",
 	.args = NM_DEFINE_GDBUS_ARG_INFOS (
@@ -1557,6 +2366,42 @@ static const GDBusInterfaceInfo interface_info_objmgr = NM_DEFINE_GDBUS_INTERFAC
 	),
 );
 
+/* GetManagedObjectsFiltered() and Subscribe() accept the options "interfaces" (as)
+ * and "path-prefix" (o). GetManagedObjectsFiltered() additionally accepts "cursor" (t),
+ * which is the cursor returned by the previous call, and "limit" (u). A returned
+ * cursor of zero means that there are no more objects.
+ *
+ * After Subscribe(), the InterfacesAdded/InterfacesRemoved signals of this interface
+ * are sent to the subscriber only, and only for the matching objects and interfaces. */
+static const GDBusInterfaceInfo interface_info_objmgr_filtered = NM_DEFINE_GDBUS_INTERFACE_INFO_INIT (
+	OBJECT_MANAGER_FILTERED_INTERFACE,
+	.methods = NM_DEFINE_GDBUS_METHOD_INFOS (
+		NM_DEFINE_GDBUS_METHOD_INFO (
+			"GetManagedObjectsFiltered",
+			.in_args = NM_DEFINE_GDBUS_ARG_INFOS (
+				NM_DEFINE_GDBUS_ARG_INFO ("options", "a{sv}"),
+			),
+			.out_args = NM_DEFINE_GDBUS_ARG_INFOS (
+				NM_DEFINE_GDBUS_ARG_INFO ("object_paths_interfaces_and_properties", "a{oa{sa{sv}}}"),
+				NM_DEFINE_GDBUS_ARG_INFO ("cursor", "t"),
+			),
+		),
+		NM_DEFINE_GDBUS_METHOD_INFO (
+			"Subscribe",
+			.in_args = NM_DEFINE_GDBUS_ARG_INFOS (
+				NM_DEFINE_GDBUS_ARG_INFO ("options", "a{sv}"),
+			),
+		),
+		NM_DEFINE_GDBUS_METHOD_INFO (
+			"Unsubscribe",
+		),
+	),
+	.signals = NM_DEFINE_GDBUS_SIGNAL_INFOS (
+		&signal_info_objmgr_interfaces_added,
+		&signal_info_objmgr_interfaces_removed,
+	),
+);
+
 /*****************************************************************************/
 
 GDBusConnection *
@@ -1670,6 +2515,18 @@ nm_dbus_manager_acquire_bus (NMDBusManager *self,
 
 	priv->objmgr_registration_id = registration_id;
 
+	priv->objmgr_filtered_registration_id = g_dbus_connection_register_object (priv->main_dbus_connection,
+	                                                                           OBJECT_MANAGER_SERVER_BASE_PATH,
+	                                                                           NM_UNCONST_PTR (GDBusInterfaceInfo, &interface_info_objmgr_filtered),
+	                                                                           &dbus_vtable_objmgr_filtered,
+	                                                                           self,
+	                                                                           NULL,
+	                                                                           &error);
+	if (!priv->objmgr_filtered_registration_id) {
+		_LOGW ("failure to register filtered object manager: %s", error->message);
+		g_clear_error (&error);
+	}
+
 	_LOGI ("acquired D-Bus service \"%s\"", NM_DBUS_SERVICE);
 
 	return TRUE;
@@ -1688,6 +2545,9 @@ nm_dbus_manager_stop (NMDBusManager *self)
 	 * setting from now on. */
 	priv->set_property_handler = NULL;
 	priv->set_property_handler_data = NULL;
+
+	/* don't delay signals anymore. We are about to quit. */
+	nm_dbus_manager_set_notify_coalesce (self, -1);
 }
 
 gboolean
@@ -1707,8 +2567,15 @@ nm_dbus_manager_init (NMDBusManager *self)
 	c_list_init (&priv->objects_lst_head);
 
 	priv->objects_by_path = g_hash_table_new ((GHashFunc) _objects_by_path_hash, (GEqualFunc) _objects_by_path_equal);
+	priv->objects_by_export_version_id = g_hash_table_new (g_int64_hash, g_int64_equal);
 
 	c_list_init (&priv->caller_info_lst_head);
+
+	c_list_init (&priv->objmgr_subscription_lst_head);
+
+	c_list_init (&priv->notify_pending_lst_head);
+	priv->notify_coalesce_msec = -1;
+	priv->legacy_properties_changed = TRUE;
 }
 
 static void
@@ -1718,17 +2585,31 @@ dispose (GObject *object)
 	NMDBusManagerPrivate *priv = NM_DBUS_MANAGER_GET_PRIVATE (self);
 	PrivateServer *s, *s_safe;
 	CallerInfo *caller_info;
+	ObjmgrSubscription *sub;
 
 	/* All exported NMDBusObject instances keep the manager alive, so we don't
 	 * expect any remaining objects. */
 	nm_assert (!priv->objects_by_path || g_hash_table_size (priv->objects_by_path) == 0);
 	nm_assert (c_list_is_empty (&priv->objects_lst_head));
+	nm_assert (c_list_is_empty (&priv->notify_pending_lst_head));
+
+	nm_clear_g_source (&priv->notify_pending_id);
 
 	g_clear_pointer (&priv->objects_by_path, g_hash_table_destroy);
+	g_clear_pointer (&priv->objects_by_export_version_id, g_hash_table_destroy);
+	g_clear_pointer (&priv->type_info_by_gtype, g_hash_table_destroy);
 
 	c_list_for_each_entry_safe (s, s_safe, &priv->private_servers_lst_head, private_servers_lst)
 		private_server_free (s);
 
+	while ((sub = c_list_first_entry (&priv->objmgr_subscription_lst_head, ObjmgrSubscription, objmgr_subscription_lst)))
+		_objmgr_subscription_free (sub);
+
+	if (priv->objmgr_filtered_registration_id) {
+		g_dbus_connection_unregister_object (priv->main_dbus_connection,
+		                                     nm_steal_int (&priv->objmgr_filtered_registration_id));
+	}
+
 	if (priv->objmgr_registration_id) {
 		g_dbus_connection_unregister_object (priv->main_dbus_connection,
 		                                     nm_steal_int (&priv->objmgr_registration_id));
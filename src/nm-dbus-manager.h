@@ -61,6 +61,17 @@ void nm_dbus_manager_start (NMDBusManager *self,
 
 void nm_dbus_manager_stop (NMDBusManager *self);
 
+void nm_dbus_manager_set_notify_coalesce (NMDBusManager *self,
+                                          int msec);
+
+void nm_dbus_manager_set_legacy_properties_changed (NMDBusManager *self,
+                                                    gboolean enabled);
+
+void nm_dbus_manager_get_notify_stats (NMDBusManager *self,
+                                       guint64 *out_emitted,
+                                       guint64 *out_saved,
+                                       guint64 *out_legacy_suppressed);
+
 gboolean nm_dbus_manager_is_stopping (NMDBusManager *self);
 
 gpointer nm_dbus_manager_lookup_object (NMDBusManager *self, const char *path);
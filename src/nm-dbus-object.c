@@ -239,6 +239,7 @@ nm_dbus_object_init (NMDBusObject *self)
 {
 	c_list_init (&self->internal.objects_lst);
 	c_list_init (&self->internal.registration_lst_head);
+	c_list_init (&self->internal.notify_pending_lst);
 	self->internal.bus_manager = nm_g_object_ref (nm_dbus_manager_get ());
 }
 
@@ -284,6 +285,8 @@ dispose (GObject *object)
 		nm_dbus_object_unexport (self);
 	}
 
+	nm_assert (c_list_is_empty (&self->internal.notify_pending_lst));
+
 	G_OBJECT_CLASS (nm_dbus_object_parent_class)->dispose (object);
 
 	g_clear_object (&self->internal.bus_manager);
@@ -87,6 +87,15 @@ struct _NMDBusObjectInternal {
 	CList objects_lst;
 	CList registration_lst_head;
 
+	/* the entries of registration_lst_head, indexed by the position of their
+	 * interface in the property index of the object type. NULL for interfaces
+	 * that failed to register. */
+	gpointer *registrations;
+
+	/* linked in the list of NMDBusManager, while PropertiesChanged
+	 * signals for the object are pending. */
+	CList notify_pending_lst;
+
 	/* we perform asynchronous operation on exported objects. For example, we receive
 	 * a Set property call, and asynchronously validate the operation. We must make
 	 * sure that when the authentication is complete, that we are still looking at
@@ -81,6 +81,74 @@ nm_dbus_utils_interface_info_lookup_method (const GDBusInterfaceInfo *interface_
 	return NULL;
 }
 
+/**
+ * nm_dbus_utils_property_index_new:
+ * @interface_infos: the D-Bus interfaces of an object.
+ * @n_interface_infos: the number of @interface_infos.
+ *
+ * Returns: (transfer full): a hash table that maps the names of
+ *   GObject properties to the D-Bus properties that are backed by them.
+ *   Use nm_dbus_utils_property_index_lookup() to look them up.
+ */
+GHashTable *
+nm_dbus_utils_property_index_new (const NMDBusInterfaceInfoExtended *const*interface_infos,
+                                  guint n_interface_infos)
+{
+	GHashTable *property_index;
+	guint i, j;
+
+	property_index = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, (GDestroyNotify) g_array_unref);
+
+	for (i = 0; i < n_interface_infos; i++) {
+		const NMDBusInterfaceInfoExtended *interface_info = interface_infos[i];
+
+		if (!interface_info->parent.properties)
+			continue;
+
+		for (j = 0; interface_info->parent.properties[j]; j++) {
+			const NMDBusPropertyInfoExtended *property_info = (const NMDBusPropertyInfoExtended *) interface_info->parent.properties[j];
+			NMDBusPropertyIndexEntry entry = {
+				.interface_info = interface_info,
+				.interface_idx  = i,
+				.property_idx   = j,
+			};
+			GArray *entries;
+
+			entries = g_hash_table_lookup (property_index, property_info->property_name);
+			if (!entries) {
+				entries = g_array_new (FALSE, FALSE, sizeof (NMDBusPropertyIndexEntry));
+				g_hash_table_insert (property_index, (gpointer) property_info->property_name, entries);
+			}
+			g_array_append_val (entries, entry);
+		}
+	}
+
+	return property_index;
+}
+
+const NMDBusPropertyIndexEntry *
+nm_dbus_utils_property_index_lookup (GHashTable *property_index,
+                                     const char *property_name,
+                                     guint *out_len)
+{
+	GArray *entries;
+
+	nm_assert (property_index);
+	nm_assert (property_name);
+	nm_assert (out_len);
+
+	entries = g_hash_table_lookup (property_index, property_name);
+	if (!entries) {
+		*out_len = 0;
+		return NULL;
+	}
+
+	*out_len = entries->len;
+	return &g_array_index (entries, NMDBusPropertyIndexEntry, 0);
+}
+
+/*****************************************************************************/
+
 GVariant *
 nm_dbus_utils_get_property (GObject *obj,
                             const char *signature,
@@ -164,6 +164,24 @@ GVariant *nm_dbus_utils_get_property (GObject *obj,
 
 /*****************************************************************************/
 
+typedef struct {
+	const NMDBusInterfaceInfoExtended *interface_info;
+
+	/* the position of @interface_info in the interfaces that were
+	 * passed to nm_dbus_utils_property_index_new(). */
+	guint interface_idx;
+	guint property_idx;
+} NMDBusPropertyIndexEntry;
+
+GHashTable *nm_dbus_utils_property_index_new (const NMDBusInterfaceInfoExtended *const*interface_infos,
+                                              guint n_interface_infos);
+
+const NMDBusPropertyIndexEntry *nm_dbus_utils_property_index_lookup (GHashTable *property_index,
+                                                                     const char *property_name,
+                                                                     guint *out_len);
+
+/*****************************************************************************/
+
 struct CList;
 
 const char **nm_dbus_utils_get_paths_for_clist (const struct CList *lst_head,
@@ -8045,6 +8045,16 @@ wifi_set_wake_on_wlan (NMPlatform *platform, int ifindex,
 	return nm_wifi_utils_set_wake_on_wlan (wifi_data, wowl);
 }
 
+static gboolean
+wifi_watch_scan_results (NMPlatform *platform,
+                         int ifindex,
+                         NMPlatformWifiScanResultsCallback callback,
+                         gpointer user_data)
+{
+	WIFI_GET_WIFI_DATA_NETNS (wifi_data, platform, ifindex, FALSE);
+	return nm_wifi_utils_watch_scan_results (wifi_data, callback, user_data);
+}
+
 /*****************************************************************************/
 
 static gboolean
@@ -9323,6 +9333,7 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	platform_class->wifi_indicate_addressing_running = wifi_indicate_addressing_running;
 	platform_class->wifi_get_wake_on_wlan = wifi_get_wake_on_wlan;
 	platform_class->wifi_set_wake_on_wlan = wifi_set_wake_on_wlan;
+	platform_class->wifi_watch_scan_results = wifi_watch_scan_results;
 
 	platform_class->mesh_get_channel = mesh_get_channel;
 	platform_class->mesh_set_channel = mesh_set_channel;
@@ -792,16 +792,61 @@ _genl_parse_getfamily (struct nl_msg *msg, void *arg)
 	return NL_STOP;
 }
 
-int
-genl_ctrl_resolve (struct nl_sock *sk, const char *name)
+typedef struct {
+	const char *grp_name;
+	gint32 grp_id;
+} GenlParseGetfamilyGrpData;
+
+static int
+_genl_parse_getfamily_grp (struct nl_msg *msg, void *arg)
+{
+	static const struct nla_policy ctrl_policy[] = {
+		[CTRL_ATTR_FAMILY_ID]    = { .type = NLA_U16 },
+		[CTRL_ATTR_FAMILY_NAME]  = { .type = NLA_STRING,
+		                             .maxlen = GENL_NAMSIZ },
+		[CTRL_ATTR_VERSION]      = { .type = NLA_U32 },
+		[CTRL_ATTR_HDRSIZE]      = { .type = NLA_U32 },
+		[CTRL_ATTR_MAXATTR]      = { .type = NLA_U32 },
+		[CTRL_ATTR_OPS]          = { .type = NLA_NESTED },
+		[CTRL_ATTR_MCAST_GROUPS] = { .type = NLA_NESTED },
+	};
+	static const struct nla_policy grp_policy[] = {
+		[CTRL_ATTR_MCAST_GRP_NAME] = { .type = NLA_STRING },
+		[CTRL_ATTR_MCAST_GRP_ID]   = { .type = NLA_U32 },
+	};
+	struct nlattr *tb[G_N_ELEMENTS (ctrl_policy)];
+	struct nlattr *tb_grp[G_N_ELEMENTS (grp_policy)];
+	struct nlmsghdr *nlh = nlmsg_hdr (msg);
+	GenlParseGetfamilyGrpData *data = arg;
+	struct nlattr *nl_grp;
+	int rem;
+
+	if (genlmsg_parse_arr (nlh, 0, tb, ctrl_policy) < 0)
+		return NL_SKIP;
+
+	if (!tb[CTRL_ATTR_MCAST_GROUPS])
+		return NL_STOP;
+
+	nla_for_each_nested (nl_grp, tb[CTRL_ATTR_MCAST_GROUPS], rem) {
+		if (nla_parse_nested_arr (tb_grp, nl_grp, grp_policy) < 0)
+			continue;
+		if (   !tb_grp[CTRL_ATTR_MCAST_GRP_NAME]
+		    || !tb_grp[CTRL_ATTR_MCAST_GRP_ID])
+			continue;
+		if (!nm_streq (nla_get_string (tb_grp[CTRL_ATTR_MCAST_GRP_NAME]), data->grp_name))
+			continue;
+		data->grp_id = nla_get_u32 (tb_grp[CTRL_ATTR_MCAST_GRP_ID]);
+		break;
+	}
+
+	return NL_STOP;
+}
+
+static int
+_genl_ctrl_getfamily (struct nl_sock *sk, const char *name, const struct nl_cb *cb)
 {
 	nm_auto_nlmsg struct nl_msg *msg = NULL;
 	int nmerr;
-	gint32 response_data = -1;
-	const struct nl_cb cb = {
-		.valid_cb = _genl_parse_getfamily,
-		.valid_arg = &response_data,
-	};
 
 	msg = nlmsg_alloc ();
 
@@ -817,12 +862,25 @@ genl_ctrl_resolve (struct nl_sock *sk, const char *name)
 	if (nmerr < 0)
 		return nmerr;
 
-	nmerr = nl_recvmsgs (sk, &cb);
+	nmerr = nl_recvmsgs (sk, cb);
 	if (nmerr < 0)
 		return nmerr;
 
 	/* If search was successful, request may be ACKed after data */
-	nmerr = nl_wait_for_ack (sk, NULL);
+	return nl_wait_for_ack (sk, NULL);
+}
+
+int
+genl_ctrl_resolve (struct nl_sock *sk, const char *name)
+{
+	int nmerr;
+	gint32 response_data = -1;
+	const struct nl_cb cb = {
+		.valid_cb = _genl_parse_getfamily,
+		.valid_arg = &response_data,
+	};
+
+	nmerr = _genl_ctrl_getfamily (sk, name, &cb);
 	if (nmerr < 0)
 		return nmerr;
 
@@ -832,6 +890,29 @@ genl_ctrl_resolve (struct nl_sock *sk, const char *name)
 	return response_data;
 }
 
+int
+genl_ctrl_resolve_grp (struct nl_sock *sk, const char *family_name, const char *grp_name)
+{
+	int nmerr;
+	GenlParseGetfamilyGrpData data = {
+		.grp_name = grp_name,
+		.grp_id   = -1,
+	};
+	const struct nl_cb cb = {
+		.valid_cb = _genl_parse_getfamily_grp,
+		.valid_arg = &data,
+	};
+
+	nmerr = _genl_ctrl_getfamily (sk, family_name, &cb);
+	if (nmerr < 0)
+		return nmerr;
+
+	if (data.grp_id < 0)
+		return -NME_UNSPEC;
+
+	return data.grp_id;
+}
+
 /*****************************************************************************/
 
 struct nl_sock *
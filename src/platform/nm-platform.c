@@ -3335,6 +3335,34 @@ nm_platform_wifi_set_wake_on_wlan (NMPlatform *self, int ifindex, NMSettingWirel
 	return klass->wifi_set_wake_on_wlan (self, ifindex, wowl);
 }
 
+/**
+ * nm_platform_wifi_watch_scan_results:
+ * @self: platform instance
+ * @ifindex: the ifindex of the Wi-Fi device
+ * @callback: (allow-none): invoked with the scan results of the driver
+ *   each time the kernel reports that a scan finished. Pass %NULL and
+ *   the @user_data of the watch to stop watching.
+ * @user_data: user data for @callback
+ *
+ * Returns: %TRUE if the scan results can be watched. This is only
+ *   supported for nl80211 drivers.
+ */
+gboolean
+nm_platform_wifi_watch_scan_results (NMPlatform *self,
+                                     int ifindex,
+                                     NMPlatformWifiScanResultsCallback callback,
+                                     gpointer user_data)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+
+	if (!klass->wifi_watch_scan_results)
+		return FALSE;
+
+	return klass->wifi_watch_scan_results (self, ifindex, callback, user_data);
+}
+
 guint32
 nm_platform_mesh_get_channel (NMPlatform *self, int ifindex)
 {
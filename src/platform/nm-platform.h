@@ -903,6 +903,8 @@ typedef enum {
 
 typedef void (*NMPlatformAsyncCallback) (GError *error, gpointer user_data);
 
+typedef void (*NMPlatformWifiScanResultsCallback) (int ifindex, GPtrArray *bss_props, gpointer user_data);
+
 /*****************************************************************************/
 
 typedef enum {
@@ -1109,6 +1111,10 @@ typedef struct {
 	void        (*wifi_indicate_addressing_running) (NMPlatform *self, int ifindex, gboolean running);
 	NMSettingWirelessWakeOnWLan (*wifi_get_wake_on_wlan) (NMPlatform *self, int ifindex);
 	gboolean    (*wifi_set_wake_on_wlan) (NMPlatform *self, int ifindex, NMSettingWirelessWakeOnWLan wowl);
+	gboolean    (*wifi_watch_scan_results) (NMPlatform *self,
+	                                        int ifindex,
+	                                        NMPlatformWifiScanResultsCallback callback,
+	                                        gpointer user_data);
 
 	guint32     (*mesh_get_channel)      (NMPlatform *self, int ifindex);
 	gboolean    (*mesh_set_channel)      (NMPlatform *self, int ifindex, guint32 channel);
@@ -1551,6 +1557,10 @@ guint32     nm_platform_wifi_find_frequency   (NMPlatform *self, int ifindex, co
 void        nm_platform_wifi_indicate_addressing_running (NMPlatform *self, int ifindex, gboolean running);
 NMSettingWirelessWakeOnWLan nm_platform_wifi_get_wake_on_wlan (NMPlatform *self, int ifindex);
 gboolean    nm_platform_wifi_set_wake_on_wlan (NMPlatform *self, int ifindex, NMSettingWirelessWakeOnWLan wowl);
+gboolean    nm_platform_wifi_watch_scan_results (NMPlatform *self,
+                                                 int ifindex,
+                                                 NMPlatformWifiScanResultsCallback callback,
+                                                 gpointer user_data);
 
 guint32     nm_platform_mesh_get_channel      (NMPlatform *self, int ifindex);
 gboolean    nm_platform_mesh_set_channel      (NMPlatform *self, int ifindex, guint32 channel);
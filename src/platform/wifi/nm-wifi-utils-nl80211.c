@@ -57,6 +57,14 @@ typedef struct {
 	int num_freqs;
 	int phy;
 	bool can_wowlan:1;
+
+	/* separate socket for the "scan" multicast group, only created
+	 * when somebody watches the scan results. */
+	struct nl_sock *nl_event_sock;
+	GIOChannel *event_channel;
+	guint event_id;
+	NMWifiUtilsScanResultsCallback scan_results_cb;
+	gpointer scan_results_user_data;
 } NMWifiUtilsNl80211;
 
 typedef struct {
@@ -161,11 +169,22 @@ nl80211_send_and_recv (NMWifiUtilsNl80211 *self,
 	return err;
 }
 
+static void
+nl80211_event_sock_clear (NMWifiUtilsNl80211 *self)
+{
+	nm_clear_g_source (&self->event_id);
+	g_clear_pointer (&self->event_channel, g_io_channel_unref);
+	g_clear_pointer (&self->nl_event_sock, nl_socket_free);
+	self->scan_results_cb = NULL;
+	self->scan_results_user_data = NULL;
+}
+
 static void
 dispose (GObject *object)
 {
 	NMWifiUtilsNl80211 *self = NM_WIFI_UTILS_NL80211 (object);
 
+	nl80211_event_sock_clear (self);
 	g_clear_pointer (&self->freqs, g_free);
 }
 
@@ -697,6 +716,258 @@ nla_put_failure:
 	g_return_val_if_reached (FALSE);
 }
 
+/*****************************************************************************/
+
+#define WLAN_CAPABILITY_ESS     (1 << 0)
+#define WLAN_CAPABILITY_IBSS    (1 << 1)
+#define WLAN_CAPABILITY_PRIVACY (1 << 4)
+
+/**
+ * nm_wifi_utils_nl80211_parse_scan_result:
+ * @msg: a message of a NL80211_CMD_GET_SCAN dump
+ *
+ * Returns: (transfer full): the properties of the BSS in @msg, using the
+ *   names of wpa_supplicant's BSS properties on D-Bus, or %NULL if @msg
+ *   contains no BSS.
+ */
+GVariant *
+nm_wifi_utils_nl80211_parse_scan_result (struct nl_msg *msg)
+{
+	static const struct nla_policy bss_policy[] = {
+		[NL80211_BSS_FREQUENCY]            = { .type = NLA_U32 },
+		[NL80211_BSS_BSSID]                = { .minlen = ETH_ALEN },
+		[NL80211_BSS_CAPABILITY]           = { .type = NLA_U16 },
+		[NL80211_BSS_INFORMATION_ELEMENTS] = { },
+		[NL80211_BSS_SIGNAL_MBM]           = { .type = NLA_U32 },
+		[NL80211_BSS_SEEN_MS_AGO]          = { .type = NLA_U32 },
+	};
+	struct genlmsghdr *gnlh = nlmsg_data (nlmsg_hdr (msg));
+	struct nlattr *tb[NL80211_ATTR_MAX + 1];
+	struct nlattr *bss[G_N_ELEMENTS (bss_policy)];
+	GVariantBuilder builder;
+
+	if (nla_parse_arr (tb,
+	                   genlmsg_attrdata (gnlh, 0),
+	                   genlmsg_attrlen (gnlh, 0),
+	                   NULL) < 0)
+		return NULL;
+
+	if (tb[NL80211_ATTR_BSS] == NULL)
+		return NULL;
+
+	if (nla_parse_nested_arr (bss,
+	                          tb[NL80211_ATTR_BSS],
+	                          bss_policy))
+		return NULL;
+
+	if (bss[NL80211_BSS_BSSID] == NULL)
+		return NULL;
+
+	/* build the properties like wpa_supplicant would expose them on D-Bus,
+	 * so that they can be passed to nm_wifi_ap_update_from_properties(). */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+	g_variant_builder_add (&builder, "{sv}", "BSSID",
+	                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+	                                                  nla_data (bss[NL80211_BSS_BSSID]),
+	                                                  ETH_ALEN,
+	                                                  1));
+
+	if (bss[NL80211_BSS_FREQUENCY]) {
+		g_variant_builder_add (&builder, "{sv}", "Frequency",
+		                       g_variant_new_uint16 (nla_get_u32 (bss[NL80211_BSS_FREQUENCY])));
+	}
+
+	if (bss[NL80211_BSS_SIGNAL_MBM]) {
+		/* mBm to dBm */
+		g_variant_builder_add (&builder, "{sv}", "Signal",
+		                       g_variant_new_int16 (((gint32) nla_get_u32 (bss[NL80211_BSS_SIGNAL_MBM])) / 100));
+	}
+
+	if (bss[NL80211_BSS_CAPABILITY]) {
+		guint16 caps = nla_get_u16 (bss[NL80211_BSS_CAPABILITY]);
+
+		g_variant_builder_add (&builder, "{sv}", "Privacy",
+		                       g_variant_new_boolean (NM_FLAGS_HAS (caps, WLAN_CAPABILITY_PRIVACY)));
+		if (NM_FLAGS_HAS (caps, WLAN_CAPABILITY_ESS))
+			g_variant_builder_add (&builder, "{sv}", "Mode", g_variant_new_string ("infrastructure"));
+		else if (NM_FLAGS_HAS (caps, WLAN_CAPABILITY_IBSS))
+			g_variant_builder_add (&builder, "{sv}", "Mode", g_variant_new_string ("ad-hoc"));
+	}
+
+	if (bss[NL80211_BSS_SEEN_MS_AGO]) {
+		g_variant_builder_add (&builder, "{sv}", "Age",
+		                       g_variant_new_uint32 (nla_get_u32 (bss[NL80211_BSS_SEEN_MS_AGO]) / 1000));
+	}
+
+	if (bss[NL80211_BSS_INFORMATION_ELEMENTS]) {
+		guint8 *ies = nla_data (bss[NL80211_BSS_INFORMATION_ELEMENTS]);
+		guint32 ies_len = nla_len (bss[NL80211_BSS_INFORMATION_ELEMENTS]);
+		guint8 *ssid;
+		guint32 ssid_len;
+
+		/* hidden networks don't have an SSID in the scan result. Don't
+		 * report it, otherwise an SSID we learned elsewhere gets cleared. */
+		find_ssid (ies, ies_len, &ssid, &ssid_len);
+		if (   ssid
+		    && ssid_len > 0) {
+			g_variant_builder_add (&builder, "{sv}", "SSID",
+			                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, ssid, ssid_len, 1));
+		}
+		g_variant_builder_add (&builder, "{sv}", "IEs",
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, ies, ies_len, 1));
+	}
+
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+static int
+nl80211_scan_dump_handler (struct nl_msg *msg, void *arg)
+{
+	GPtrArray *results = arg;
+	GVariant *props;
+
+	props = nm_wifi_utils_nl80211_parse_scan_result (msg);
+	if (props)
+		g_ptr_array_add (results, props);
+	return NL_SKIP;
+}
+
+static void
+nl80211_scan_results_dump (NMWifiUtilsNl80211 *self)
+{
+	nm_auto_nlmsg struct nl_msg *msg = NULL;
+	gs_unref_ptrarray GPtrArray *results = NULL;
+	int err;
+
+	results = g_ptr_array_new_with_free_func ((GDestroyNotify) g_variant_unref);
+
+	msg = nl80211_alloc_msg (self, NL80211_CMD_GET_SCAN, NLM_F_DUMP);
+	err = nl80211_send_and_recv (self, msg, nl80211_scan_dump_handler, results);
+	if (   err < 0
+	    && err != -NME_NL_DUMP_INTR) {
+		_LOGD ("failed to dump scan results: %s", nm_strerror (err));
+		return;
+	}
+
+	_LOGT ("scan results: %u BSS", results->len);
+	self->scan_results_cb (self->parent.ifindex, results, self->scan_results_user_data);
+}
+
+static gboolean
+nl80211_event_handler (GIOChannel *channel,
+                       GIOCondition io_condition,
+                       gpointer user_data)
+{
+	NMWifiUtilsNl80211 *self = user_data;
+	gboolean scan_done = FALSE;
+
+	for (;;) {
+		gs_free unsigned char *buf = NULL;
+		struct sockaddr_nl nla = { };
+		struct nlmsghdr *hdr;
+		int n;
+
+		n = nl_recv (self->nl_event_sock, &nla, &buf, NULL, NULL);
+		if (n == -ENOBUFS) {
+			/* we lost events. Better dump the results once too often. */
+			scan_done = TRUE;
+			continue;
+		}
+		if (n <= 0)
+			break;
+
+		for (hdr = (struct nlmsghdr *) buf; nlmsg_ok (hdr, n); hdr = nlmsg_next (hdr, &n)) {
+			struct nlattr *tb[NL80211_ATTR_MAX + 1];
+			struct genlmsghdr *gnlh;
+
+			if (hdr->nlmsg_type != self->id)
+				continue;
+
+			gnlh = nlmsg_data (hdr);
+			if (gnlh->cmd != NL80211_CMD_NEW_SCAN_RESULTS)
+				continue;
+
+			if (nla_parse_arr (tb,
+			                   genlmsg_attrdata (gnlh, 0),
+			                   genlmsg_attrlen (gnlh, 0),
+			                   NULL) < 0)
+				continue;
+
+			if (   !tb[NL80211_ATTR_IFINDEX]
+			    || nla_get_u32 (tb[NL80211_ATTR_IFINDEX]) != self->parent.ifindex)
+				continue;
+
+			scan_done = TRUE;
+		}
+	}
+
+	if (   scan_done
+	    && self->scan_results_cb)
+		nl80211_scan_results_dump (self);
+
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+wifi_nl80211_watch_scan_results (NMWifiUtils *data,
+                                 NMWifiUtilsScanResultsCallback callback,
+                                 gpointer user_data)
+{
+	NMWifiUtilsNl80211 *self = (NMWifiUtilsNl80211 *) data;
+	struct nl_sock *sk;
+	int grp;
+	int nle;
+
+	if (!callback) {
+		/* the ifindex might already belong to a new device, don't
+		 * stop watching on behalf of somebody else. */
+		if (self->scan_results_user_data == user_data)
+			nl80211_event_sock_clear (self);
+		return TRUE;
+	}
+
+	self->scan_results_cb = callback;
+	self->scan_results_user_data = user_data;
+
+	if (self->nl_event_sock)
+		return TRUE;
+
+	grp = genl_ctrl_resolve_grp (self->nl_sock, "nl80211", "scan");
+	if (grp < 0) {
+		_LOGD ("failed to resolve nl80211 \"scan\" multicast group: %s", nm_strerror (grp));
+		goto fail;
+	}
+
+	sk = nl_socket_alloc ();
+	nle = nl_connect (sk, NETLINK_GENERIC);
+	if (nle >= 0)
+		nle = nl_socket_set_nonblocking (sk);
+	if (nle >= 0)
+		nle = nl_socket_add_memberships (sk, grp, 0);
+	if (nle < 0) {
+		_LOGD ("failed to create socket for nl80211 scan events: %s", nm_strerror (nle));
+		nl_socket_free (sk);
+		goto fail;
+	}
+
+	self->nl_event_sock = sk;
+	self->event_channel = g_io_channel_unix_new (nl_socket_get_fd (sk));
+	g_io_channel_set_encoding (self->event_channel, NULL, NULL);
+	self->event_id = g_io_add_watch (self->event_channel,
+	                                 G_IO_IN,
+	                                 nl80211_event_handler,
+	                                 self);
+
+	_LOGD ("watching nl80211 scan results");
+	return TRUE;
+
+fail:
+	self->scan_results_cb = NULL;
+	self->scan_results_user_data = NULL;
+	return FALSE;
+}
+
 struct nl80211_device_info {
 	NMWifiUtilsNl80211 *self;
 	int phy;
@@ -931,6 +1202,7 @@ nm_wifi_utils_nl80211_class_init (NMWifiUtilsNl80211Class *klass)
 	wifi_utils_class->get_rate = wifi_nl80211_get_rate;
 	wifi_utils_class->get_qual = wifi_nl80211_get_qual;
 	wifi_utils_class->indicate_addressing_running = wifi_nl80211_indicate_addressing_running;
+	wifi_utils_class->watch_scan_results = wifi_nl80211_watch_scan_results;
 }
 
 NMWifiUtils *
@@ -35,4 +35,6 @@ GType nm_wifi_utils_nl80211_get_type (void);
 
 NMWifiUtils *nm_wifi_utils_nl80211_new (int ifindex, struct nl_sock *genl);
 
+GVariant *nm_wifi_utils_nl80211_parse_scan_result (struct nl_msg *msg);
+
 #endif  /* __WIFI_UTILS_NL80211_H__ */
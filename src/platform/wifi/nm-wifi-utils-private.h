@@ -66,6 +66,11 @@ typedef struct {
 	gboolean (*set_mesh_ssid) (NMWifiUtils *data, const guint8 *ssid, gsize len);
 
 	gboolean (*indicate_addressing_running) (NMWifiUtils *data, gboolean running);
+
+	/* Report the scan results of the driver each time a scan finished */
+	gboolean (*watch_scan_results) (NMWifiUtils *data,
+	                                NMWifiUtilsScanResultsCallback callback,
+	                                gpointer user_data);
 } NMWifiUtilsClass;
 
 struct NMWifiUtils {
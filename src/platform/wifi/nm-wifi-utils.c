@@ -170,6 +170,19 @@ nm_wifi_utils_get_qual (NMWifiUtils *data)
 	return NM_WIFI_UTILS_GET_CLASS (data)->get_qual (data);
 }
 
+gboolean
+nm_wifi_utils_watch_scan_results (NMWifiUtils *data,
+                                  NMWifiUtilsScanResultsCallback callback,
+                                  gpointer user_data)
+{
+	NMWifiUtilsClass *klass;
+
+	g_return_val_if_fail (data != NULL, FALSE);
+
+	klass = NM_WIFI_UTILS_GET_CLASS (data);
+	return klass->watch_scan_results ? klass->watch_scan_results (data, callback, user_data) : FALSE;
+}
+
 gboolean
 nm_wifi_utils_is_wifi (int dirfd, const char *ifname)
 {
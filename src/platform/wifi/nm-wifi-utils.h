@@ -73,6 +73,15 @@ NMSettingWirelessWakeOnWLan nm_wifi_utils_get_wake_on_wlan (NMWifiUtils *data);
 
 gboolean nm_wifi_utils_set_wake_on_wlan (NMWifiUtils *data, NMSettingWirelessWakeOnWLan wowl);
 
+/* @bss_props contains one a{sv} #GVariant per BSS, using the property names
+ * of wpa_supplicant's BSS D-Bus interface. */
+typedef void (*NMWifiUtilsScanResultsCallback) (int ifindex, GPtrArray *bss_props, gpointer user_data);
+
+/* Pass a %NULL @callback with the same @user_data to stop watching. */
+gboolean nm_wifi_utils_watch_scan_results (NMWifiUtils *data,
+                                           NMWifiUtilsScanResultsCallback callback,
+                                           gpointer user_data);
+
 /* OLPC Mesh-only functions */
 guint32 nm_wifi_utils_get_mesh_channel (NMWifiUtils *data);
 
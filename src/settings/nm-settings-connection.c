@@ -37,6 +37,7 @@
 #include "NetworkManagerUtils.h"
 #include "nm-core-internal.h"
 #include "nm-audit-manager.h"
+#include "dhcp/nm-dhcp-manager.h"
 
 #define AUTOCONNECT_RETRIES_UNSET        -2
 #define AUTOCONNECT_RETRIES_FOREVER      -1
@@ -125,6 +126,13 @@ typedef struct _NMSettingsConnectionPrivate {
 
 	GHashTable *seen_bssids; /* Up-to-date BSSIDs that's been seen for the connection */
 
+	/* The settings as returned by GetSettings(), indexed by the
+	 * NMConnectionSerializationFlags. Clients tend to fetch all profiles
+	 * on startup, so we avoid serializing the same connection over and over
+	 * again. The cache is dropped whenever the connection, its timestamp
+	 * or seen-bssids change. See nm_settings_connection_get_dbus_settings(). */
+	GVariant *dbus_settings_cache[8];
+
 	guint64 timestamp;   /* Up-to-date timestamp of connection use */
 
 	guint64 last_secret_agent_version_id;
@@ -342,11 +350,29 @@ update_agent_secrets_cache (NMSettingsConnection *self, NMConnection *new)
 	                                              | NM_SETTING_SECRET_FLAG_AGENT_OWNED);
 }
 
+static void
+_dbus_settings_cache_clear (NMSettingsConnection *self)
+{
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (priv->dbus_settings_cache); i++)
+		nm_clear_pointer (&priv->dbus_settings_cache[i], g_variant_unref);
+}
+
+static void
+secrets_updated_cb (NMConnection *connection, const char *setting_name, NMSettingsConnection *self)
+{
+	_dbus_settings_cache_clear (self);
+}
+
 static void
 secrets_cleared_cb (NMConnection *connection, NMSettingsConnection *self)
 {
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
 
+	_dbus_settings_cache_clear (self);
+
 	/* Clear agent secrets when connection's secrets are cleared since agent
 	 * secrets are transient.
 	 */
@@ -406,6 +432,7 @@ _emit_updated (NMSettingsConnection *self, gboolean by_user)
 static void
 connection_changed_cb (NMConnection *connection, NMSettingsConnection *self)
 {
+	_dbus_settings_cache_clear (self);
 	set_persist_mode (self, NM_SETTINGS_CONNECTION_PERSIST_MODE_UNSAVED);
 	_emit_updated (self, FALSE);
 }
@@ -610,6 +637,7 @@ nm_settings_connection_update (NMSettingsConnection *self,
 
 	g_signal_handlers_unblock_by_func (priv->connection, G_CALLBACK (connection_changed_cb), self);
 
+	_dbus_settings_cache_clear (self);
 	_emit_updated (self, TRUE);
 
 out:
@@ -664,6 +692,8 @@ nm_settings_connection_delete (NMSettingsConnection *self,
 	if (priv->kf_db_seen_bssids)
 		nm_key_file_db_remove_key (priv->kf_db_seen_bssids, connection_uuid);
 
+	nm_dhcp_manager_remove_leases (nm_dhcp_manager_get (), connection_uuid);
+
 	nm_settings_connection_signal_remove (self);
 	return TRUE;
 }
@@ -1383,6 +1413,64 @@ check_writable (NMConnection *self, GError **error)
 	return TRUE;
 }
 
+/**
+ * nm_settings_connection_get_dbus_settings:
+ * @self: the #NMSettingsConnection
+ * @flags: the serialization flags
+ *
+ * Returns the settings as returned by GetSettings(), including the timestamp
+ * and the seen-bssids. The result is cached until the connection changes.
+ *
+ * Returns: (transfer none): the serialized settings.
+ **/
+GVariant *
+nm_settings_connection_get_dbus_settings (NMSettingsConnection *self,
+                                          NMConnectionSerializationFlags flags)
+{
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+	gs_unref_object NMConnection *dupl_con = NULL;
+	GVariant *settings;
+	NMSettingConnection *s_con;
+	NMSettingWireless *s_wifi;
+	guint64 timestamp = 0;
+	gs_free char **bssids = NULL;
+
+	nm_assert ((guint) flags < G_N_ELEMENTS (priv->dbus_settings_cache));
+
+	settings = priv->dbus_settings_cache[flags];
+	if (settings)
+		return settings;
+
+	dupl_con = nm_simple_connection_new_clone (nm_settings_connection_get_connection (self));
+
+	/* Timestamp is not updated in connection's 'timestamp' property,
+	 * because it would force updating the connection and in turn
+	 * writing to /etc periodically, which we want to avoid. Rather real
+	 * timestamps are kept track of in a private variable. So, substitute
+	 * timestamp property with the real one here before returning the settings.
+	 */
+	nm_settings_connection_get_timestamp (self, &timestamp);
+	if (timestamp) {
+		s_con = nm_connection_get_setting_connection (dupl_con);
+		g_object_set (s_con, NM_SETTING_CONNECTION_TIMESTAMP, timestamp, NULL);
+	}
+	/* Seen BSSIDs are not updated in 802-11-wireless 'seen-bssids' property
+	 * from the same reason as timestamp. Thus we put it here to GetSettings()
+	 * return settings too.
+	 */
+	bssids = nm_settings_connection_get_seen_bssids (self);
+	s_wifi = nm_connection_get_setting_wireless (dupl_con);
+	if (bssids && bssids[0] && s_wifi)
+		g_object_set (s_wifi, NM_SETTING_WIRELESS_SEEN_BSSIDS, bssids, NULL);
+
+	settings = nm_connection_to_dbus (dupl_con, flags);
+	if (!settings)
+		settings = g_variant_new_array (G_VARIANT_TYPE ("{sa{sv}}"), NULL, 0);
+
+	priv->dbus_settings_cache[flags] = g_variant_ref_sink (settings);
+	return settings;
+}
+
 static void
 get_settings_auth_cb (NMSettingsConnection *self,
                       GDBusMethodInvocation *context,
@@ -1393,42 +1481,13 @@ get_settings_auth_cb (NMSettingsConnection *self,
 	if (error)
 		g_dbus_method_invocation_return_gerror (context, error);
 	else {
-		gs_unref_object NMConnection *dupl_con = NULL;
-		GVariant *settings;
-		NMSettingConnection *s_con;
-		NMSettingWireless *s_wifi;
-		guint64 timestamp = 0;
-		gs_free char **bssids = NULL;
-
-		dupl_con = nm_simple_connection_new_clone (nm_settings_connection_get_connection (self));
-
-		/* Timestamp is not updated in connection's 'timestamp' property,
-		 * because it would force updating the connection and in turn
-		 * writing to /etc periodically, which we want to avoid. Rather real
-		 * timestamps are kept track of in a private variable. So, substitute
-		 * timestamp property with the real one here before returning the settings.
-		 */
-		nm_settings_connection_get_timestamp (self, &timestamp);
-		if (timestamp) {
-			s_con = nm_connection_get_setting_connection (dupl_con);
-			g_object_set (s_con, NM_SETTING_CONNECTION_TIMESTAMP, timestamp, NULL);
-		}
-		/* Seen BSSIDs are not updated in 802-11-wireless 'seen-bssids' property
-		 * from the same reason as timestamp. Thus we put it here to GetSettings()
-		 * return settings too.
-		 */
-		bssids = nm_settings_connection_get_seen_bssids (self);
-		s_wifi = nm_connection_get_setting_wireless (dupl_con);
-		if (bssids && bssids[0] && s_wifi)
-			g_object_set (s_wifi, NM_SETTING_WIRELESS_SEEN_BSSIDS, bssids, NULL);
-
 		/* Secrets should *never* be returned by the GetSettings method, they
 		 * get returned by the GetSecrets method which can be better
 		 * protected against leakage of secrets to unprivileged callers.
 		 */
-		settings = nm_connection_to_dbus (dupl_con, NM_CONNECTION_SERIALIZE_NO_SECRETS);
 		g_dbus_method_invocation_return_value (context,
-		                                       g_variant_new ("(@a{sa{sv}})", settings));
+		                                       g_variant_new ("(@a{sa{sv}})",
+		                                                      nm_settings_connection_get_dbus_settings (self, NM_CONNECTION_SERIALIZE_NO_SECRETS)));
 	}
 }
 
@@ -2296,6 +2355,10 @@ nm_settings_connection_update_timestamp (NMSettingsConnection *self,
 
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (self));
 
+	if (   !priv->timestamp_set
+	    || priv->timestamp != timestamp)
+		_dbus_settings_cache_clear (self);
+
 	priv->timestamp = timestamp;
 	priv->timestamp_set = TRUE;
 
@@ -2333,6 +2396,8 @@ nm_settings_connection_register_kf_dbs (NMSettingsConnection *self,
 
 	connection_uuid = nm_settings_connection_get_uuid (self);
 
+	_dbus_settings_cache_clear (self);
+
 	if (priv->kf_db_timestamps != kf_db_timestamps) {
 		gs_free char *tmp_str = NULL;
 		guint64 timestamp;
@@ -2458,7 +2523,10 @@ nm_settings_connection_add_seen_bssid (NMSettingsConnection *self,
 
 	g_return_if_fail (seen_bssid != NULL);
 
-	g_hash_table_add (priv->seen_bssids, g_strdup (seen_bssid));
+	if (!g_hash_table_add (priv->seen_bssids, g_strdup (seen_bssid)))
+		return;
+
+	_dbus_settings_cache_clear (self);
 
 	if (!priv->kf_db_seen_bssids)
 		return;
@@ -2740,6 +2808,7 @@ nm_settings_connection_init (NMSettingsConnection *self)
 	priv->connection = nm_simple_connection_new ();
 
 	g_signal_connect (priv->connection, NM_CONNECTION_SECRETS_CLEARED, G_CALLBACK (secrets_cleared_cb), self);
+	g_signal_connect (priv->connection, NM_CONNECTION_SECRETS_UPDATED, G_CALLBACK (secrets_updated_cb), self);
 	g_signal_connect (priv->connection, NM_CONNECTION_CHANGED, G_CALLBACK (connection_changed_cb), self);
 }
 
@@ -2779,6 +2848,7 @@ dispose (GObject *object)
 		 * because nm_connection_clear_secrets() emits NM_CONNECTION_CHANGED signal.
 		 */
 		g_signal_handlers_disconnect_by_func (priv->connection, G_CALLBACK (secrets_cleared_cb), self);
+		g_signal_handlers_disconnect_by_func (priv->connection, G_CALLBACK (secrets_updated_cb), self);
 		g_signal_handlers_disconnect_by_func (priv->connection, G_CALLBACK (connection_changed_cb), self);
 
 		/* FIXME(copy-on-write-connection): avoid modifying NMConnection instances and share them via copy-on-write. */
@@ -2790,6 +2860,8 @@ dispose (GObject *object)
 
 	g_clear_pointer (&priv->seen_bssids, g_hash_table_destroy);
 
+	_dbus_settings_cache_clear (self);
+
 	nm_clear_g_signal_handler (priv->session_monitor, &priv->session_changed_id);
 	g_clear_object (&priv->session_monitor);
 
@@ -230,6 +230,9 @@ void nm_settings_connection_update_timestamp (NMSettingsConnection *self,
 
 char **nm_settings_connection_get_seen_bssids (NMSettingsConnection *self);
 
+GVariant *nm_settings_connection_get_dbus_settings (NMSettingsConnection *self,
+                                                    NMConnectionSerializationFlags flags);
+
 gboolean nm_settings_connection_has_seen_bssid (NMSettingsConnection *self,
                                                 const char *bssid);
 
@@ -43,8 +43,13 @@
 /*****************************************************************************/
 
 typedef struct {
-	GDBusProxy *proxy;
-	gulong change_id;
+	char *path;
+
+	/* the merged a{sv} of all BSS properties we know so far. */
+	GVariant *props;
+
+	bool get_all_pending:1;
+	bool initialized:1;
 } BssData;
 
 typedef struct {
@@ -155,7 +160,18 @@ typedef struct {
 	AssocData *    assoc_data;
 
 	char *         net_path;
-	GHashTable *   bss_proxies;
+	GHashTable *   bss_hash;
+
+	GDBusConnection *bss_connection;
+	GCancellable * bss_cancellable;
+	char *         bss_match_rule;
+	guint          bss_signal_id;
+	guint          bss_fetch_id;
+
+	/* the BSS properties are refreshed elsewhere, see
+	 * nm_supplicant_interface_set_watch_bss_properties(). */
+	bool           bss_props_unwatched:1;
+
 	char *         current_bss;
 
 	GHashTable *   peer_proxies;
@@ -225,121 +241,441 @@ bss_data_destroy (gpointer user_data)
 {
 	BssData *bss_data = user_data;
 
-	nm_clear_g_signal_handler (bss_data->proxy, &bss_data->change_id);
-	g_object_unref (bss_data->proxy);
+	nm_clear_pointer (&bss_data->props, g_variant_unref);
+	g_free (bss_data->path);
 	g_slice_free (BssData, bss_data);
 }
 
+/**
+ * nm_supplicant_interface_bss_props_merge:
+ * @props: (allow-none): the known properties of a BSS
+ * @changed: the changed properties
+ *
+ * Returns: (transfer full): a vardict with all properties of @props and
+ *   @changed, where @changed takes precedence.
+ */
+GVariant *
+nm_supplicant_interface_bss_props_merge (GVariant *props, GVariant *changed)
+{
+	GVariantBuilder builder;
+	GVariantIter iter;
+	const char *key;
+	GVariant *value;
+
+	if (!props)
+		return g_variant_ref (changed);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+	g_variant_iter_init (&iter, changed);
+	while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+		g_variant_builder_add (&builder, "{sv}", key, value);
+		g_variant_unref (value);
+	}
+
+	g_variant_iter_init (&iter, props);
+	while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+		gs_unref_variant GVariant *v = NULL;
+
+		v = g_variant_lookup_value (changed, key, NULL);
+		if (!v)
+			g_variant_builder_add (&builder, "{sv}", key, value);
+		g_variant_unref (value);
+	}
+
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
 static void
-bss_proxy_properties_changed_cb (GDBusProxy *proxy,
-                                 GVariant *changed_properties,
-                                 char **invalidated_properties,
-                                 gpointer user_data)
+bss_properties_changed_cb (GDBusConnection *connection,
+                           const char *sender_name,
+                           const char *object_path,
+                           const char *interface_name,
+                           const char *signal_name,
+                           GVariant *parameters,
+                           gpointer user_data)
 {
 	NMSupplicantInterface *self = NM_SUPPLICANT_INTERFACE (user_data);
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+	gs_unref_variant GVariant *changed_properties = NULL;
+	GVariant *props;
+	BssData *bss_data;
 
-	if (priv->scanning)
-		priv->last_scan = nm_utils_get_monotonic_timestamp_ms ();
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(sa{sv}as)")))
+		return;
 
-	g_signal_emit (self, signals[BSS_UPDATED], 0,
-	               g_dbus_proxy_get_object_path (proxy),
-	               changed_properties);
-}
+	bss_data = g_hash_table_lookup (priv->bss_hash, object_path);
+	if (!bss_data)
+		return;
 
-static GVariant *
-bss_proxy_get_properties (NMSupplicantInterface *self, GDBusProxy *proxy)
-{
-	gs_strfreev char **properties = NULL;
-	GVariantBuilder builder;
-	char **iter;
+	/* until the initial properties are fetched, changes are ignored.
+	 * The GetAll reply is newer than any signal we saw before it. */
+	if (!bss_data->initialized)
+		return;
 
-	iter = properties = g_dbus_proxy_get_cached_property_names (proxy);
+	if (priv->scanning)
+		priv->last_scan = nm_utils_get_monotonic_timestamp_ms ();
 
-	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
-	if (iter) {
-		while (*iter) {
-			GVariant *copy = g_dbus_proxy_get_cached_property (proxy, *iter);
+	changed_properties = g_variant_get_child_value (parameters, 1);
 
-			g_variant_builder_add (&builder, "{sv}", *iter++, copy);
-			g_variant_unref (copy);
-		}
-	}
-	return g_variant_builder_end (&builder);
+	props = nm_supplicant_interface_bss_props_merge (bss_data->props, changed_properties);
+	nm_clear_pointer (&bss_data->props, g_variant_unref);
+	bss_data->props = props;
+
+	g_signal_emit (self, signals[BSS_UPDATED], 0,
+	               bss_data->path,
+	               changed_properties);
 }
 
 static void
-bss_proxy_acquired_cb (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
+bss_get_all_cb (GObject *source, GAsyncResult *result, gpointer user_data)
 {
 	NMSupplicantInterface *self;
 	NMSupplicantInterfacePrivate *priv;
+	gs_free char *object_path = NULL;
 	gs_free_error GError *error = NULL;
-	GVariant *props = NULL;
-	const char *object_path;
+	gs_unref_variant GVariant *res = NULL;
 	BssData *bss_data;
-	gboolean success;
 
-	success = g_async_initable_init_finish (G_ASYNC_INITABLE (proxy), result, &error);
-	if (   !success
+	nm_utils_user_data_unpack (user_data, &self, &object_path);
+
+	res = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), result, &error);
+	if (   !res
 	    && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
 		return;
 
-	self = NM_SUPPLICANT_INTERFACE (user_data);
 	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
-	if (!success) {
-		_LOGD ("failed to acquire BSS proxy: (%s)", error->message);
-		g_hash_table_remove (priv->bss_proxies,
-		                     g_dbus_proxy_get_object_path (proxy));
+	bss_data = g_hash_table_lookup (priv->bss_hash, object_path);
+	if (   !bss_data
+	    || !bss_data->get_all_pending)
 		return;
-	}
 
-	object_path = g_dbus_proxy_get_object_path (proxy);
-	bss_data = g_hash_table_lookup (priv->bss_proxies, object_path);
-	if (!bss_data)
+	bss_data->get_all_pending = FALSE;
+
+	if (!res) {
+		_LOGD ("failed to get properties of BSS %s: (%s)", object_path, error->message);
+		if (!bss_data->initialized)
+			g_hash_table_remove (priv->bss_hash, object_path);
 		return;
+	}
 
-	bss_data->change_id = g_signal_connect (proxy, "g-properties-changed", G_CALLBACK (bss_proxy_properties_changed_cb), self);
+	nm_clear_pointer (&bss_data->props, g_variant_unref);
+	g_variant_get (res, "(@a{sv})", &bss_data->props);
+	bss_data->initialized = TRUE;
 
-	props = bss_proxy_get_properties (self, proxy);
 	g_signal_emit (self, signals[BSS_UPDATED], 0,
-	               g_dbus_proxy_get_object_path (proxy),
-	               g_variant_ref_sink (props));
-	g_variant_unref (props);
+	               bss_data->path,
+	               bss_data->props);
 
 	if (priv->scan_done_pending)
 		scan_done_emit_signal (self);
 }
 
+static gboolean
+bss_fetch_cb (gpointer user_data)
+{
+	NMSupplicantInterface *self = user_data;
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+	GHashTableIter iter;
+	BssData *bss_data;
+	guint n = 0;
+
+	priv->bss_fetch_id = 0;
+
+	/* issue the GetAll calls for all BSS that showed up during the last
+	 * batch of signals together. The replies get pipelined on the bus
+	 * and there is no per-BSS proxy or match rule. */
+	g_hash_table_iter_init (&iter, priv->bss_hash);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &bss_data)) {
+		if (   bss_data->initialized
+		    || bss_data->get_all_pending)
+			continue;
+
+		bss_data->get_all_pending = TRUE;
+		g_dbus_connection_call (priv->bss_connection,
+		                        WPAS_DBUS_SERVICE,
+		                        bss_data->path,
+		                        DBUS_INTERFACE_PROPERTIES,
+		                        "GetAll",
+		                        g_variant_new ("(s)", WPAS_DBUS_IFACE_BSS),
+		                        G_VARIANT_TYPE ("(a{sv})"),
+		                        G_DBUS_CALL_FLAGS_NONE,
+		                        -1,
+		                        priv->bss_cancellable,
+		                        bss_get_all_cb,
+		                        nm_utils_user_data_pack (self, g_strdup (bss_data->path)));
+		n++;
+	}
+
+	if (n > 0)
+		_LOGT ("fetching properties of %u BSS", n);
+
+	return G_SOURCE_REMOVE;
+}
+
+static BssData *
+bss_add_new (NMSupplicantInterface *self, const char *object_path, GVariant *props)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+	BssData *bss_data;
+
+	g_return_val_if_fail (object_path != NULL, NULL);
+
+	bss_data = g_hash_table_lookup (priv->bss_hash, object_path);
+	if (!bss_data) {
+		bss_data = g_slice_new0 (BssData);
+		bss_data->path = g_strdup (object_path);
+		g_hash_table_insert (priv->bss_hash, bss_data->path, bss_data);
+	}
+
+	if (props) {
+		/* BSSAdded carries all properties of the BSS. No need to ask for them. */
+		nm_clear_pointer (&bss_data->props, g_variant_unref);
+		bss_data->props = g_variant_ref (props);
+		bss_data->initialized = TRUE;
+		return bss_data;
+	}
+
+	if (   !bss_data->initialized
+	    && !bss_data->get_all_pending
+	    && priv->bss_connection
+	    && !priv->bss_fetch_id)
+		priv->bss_fetch_id = g_idle_add (bss_fetch_cb, self);
+
+	return NULL;
+}
+
+/**
+ * nm_supplicant_interface_bss_watch:
+ * @connection: the bus connection
+ * @sender: the unique name of the supplicant
+ * @iface_path: the D-Bus path of the supplicant interface
+ * @callback: called for each PropertiesChanged signal of a BSS
+ * @user_data: the data for @callback
+ * @out_match_rule: (out) (transfer full): the match rule that was added
+ *   to the bus
+ *
+ * Subscribes to the PropertiesChanged signals of all BSS objects below
+ * @iface_path with a single match rule. Undo with
+ * nm_supplicant_interface_bss_unwatch().
+ *
+ * Returns: the subscription id.
+ */
+guint
+nm_supplicant_interface_bss_watch (GDBusConnection *connection,
+                                   const char *sender,
+                                   const char *iface_path,
+                                   GDBusSignalCallback callback,
+                                   gpointer user_data,
+                                   char **out_match_rule)
+{
+	char *match_rule;
+
+	g_return_val_if_fail (G_IS_DBUS_CONNECTION (connection), 0);
+	g_return_val_if_fail (iface_path, 0);
+	g_return_val_if_fail (out_match_rule && !*out_match_rule, 0);
+
+	/* GDBus only supports exact object paths for subscriptions. Instead,
+	 * install our own match rule for the whole namespace below our interface,
+	 * and subscribe without a match rule. */
+	match_rule = g_strdup_printf ("type='signal',"
+	                              "sender='" WPAS_DBUS_SERVICE "',"
+	                              "interface='" DBUS_INTERFACE_PROPERTIES "',"
+	                              "member='PropertiesChanged',"
+	                              "path_namespace='%s',"
+	                              "arg0='" WPAS_DBUS_IFACE_BSS "'",
+	                              iface_path);
+	g_dbus_connection_call (connection,
+	                        DBUS_SERVICE_DBUS,
+	                        DBUS_PATH_DBUS,
+	                        DBUS_INTERFACE_DBUS,
+	                        "AddMatch",
+	                        g_variant_new ("(s)", match_rule),
+	                        NULL,
+	                        G_DBUS_CALL_FLAGS_NONE,
+	                        -1,
+	                        NULL,
+	                        NULL,
+	                        NULL);
+	*out_match_rule = match_rule;
+
+	/* without a match rule, GDBus does not filter on a well-known sender
+	 * name. Use the unique name of the supplicant instead. */
+	return g_dbus_connection_signal_subscribe (connection,
+	                                           sender ?: WPAS_DBUS_SERVICE,
+	                                           DBUS_INTERFACE_PROPERTIES,
+	                                           "PropertiesChanged",
+	                                           NULL,
+	                                           WPAS_DBUS_IFACE_BSS,
+	                                           G_DBUS_SIGNAL_FLAGS_NO_MATCH_RULE,
+	                                           callback,
+	                                           user_data,
+	                                           NULL);
+}
+
+void
+nm_supplicant_interface_bss_unwatch (GDBusConnection *connection,
+                                     guint *p_signal_id,
+                                     char **p_match_rule)
+{
+	g_return_if_fail (G_IS_DBUS_CONNECTION (connection));
+	g_return_if_fail (p_signal_id);
+	g_return_if_fail (p_match_rule);
+
+	if (*p_signal_id) {
+		g_dbus_connection_signal_unsubscribe (connection, *p_signal_id);
+		*p_signal_id = 0;
+	}
+
+	if (*p_match_rule) {
+		g_dbus_connection_call (connection,
+		                        DBUS_SERVICE_DBUS,
+		                        DBUS_PATH_DBUS,
+		                        DBUS_INTERFACE_DBUS,
+		                        "RemoveMatch",
+		                        g_variant_new ("(s)", *p_match_rule),
+		                        NULL,
+		                        G_DBUS_CALL_FLAGS_NONE,
+		                        -1,
+		                        NULL,
+		                        NULL,
+		                        NULL);
+		nm_clear_g_free (p_match_rule);
+	}
+}
+
+static void
+bss_props_watch (NMSupplicantInterface *self)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	nm_assert (priv->bss_connection);
+	nm_assert (!priv->bss_signal_id);
+
+	priv->bss_signal_id = nm_supplicant_interface_bss_watch (priv->bss_connection,
+	                                                         g_dbus_proxy_get_name_owner (priv->iface_proxy),
+	                                                         priv->object_path,
+	                                                         bss_properties_changed_cb,
+	                                                         self,
+	                                                         &priv->bss_match_rule);
+}
+
+static void
+bss_props_unwatch (NMSupplicantInterface *self)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	nm_supplicant_interface_bss_unwatch (priv->bss_connection,
+	                                     &priv->bss_signal_id,
+	                                     &priv->bss_match_rule);
+}
+
 static void
-bss_add_new (NMSupplicantInterface *self, const char *object_path)
+bss_subscribe (NMSupplicantInterface *self)
 {
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
-	GDBusProxy *bss_proxy;
+
+	nm_assert (!priv->bss_connection);
+
+	if (!priv->object_path)
+		return;
+
+	priv->bss_connection = g_object_ref (g_dbus_proxy_get_connection (priv->iface_proxy));
+	priv->bss_cancellable = g_cancellable_new ();
+
+	if (!priv->bss_props_unwatched)
+		bss_props_watch (self);
+
+	if (g_hash_table_size (priv->bss_hash) > 0)
+		priv->bss_fetch_id = g_idle_add (bss_fetch_cb, self);
+}
+
+static void
+bss_unsubscribe (NMSupplicantInterface *self)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	nm_clear_g_source (&priv->bss_fetch_id);
+	nm_clear_g_cancellable (&priv->bss_cancellable);
+
+	if (!priv->bss_connection)
+		return;
+
+	bss_props_unwatch (self);
+	g_clear_object (&priv->bss_connection);
+}
+
+/**
+ * nm_supplicant_interface_set_watch_bss_properties:
+ * @self: the supplicant interface
+ * @watch: whether to receive property changes of the BSS objects
+ *
+ * The supplicant emits a PropertiesChanged signal for every BSS whose
+ * signal strength or age changed after a scan. A user that refreshes the
+ * BSS properties by other means can disable the match rule for them, so
+ * that the bus no longer routes these signals to us. New BSS are still
+ * reported with their initial properties.
+ */
+void
+nm_supplicant_interface_set_watch_bss_properties (NMSupplicantInterface *self,
+                                                  gboolean watch)
+{
+	NMSupplicantInterfacePrivate *priv;
+
+	g_return_if_fail (NM_IS_SUPPLICANT_INTERFACE (self));
+
+	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	if (priv->bss_props_unwatched == !watch)
+		return;
+
+	priv->bss_props_unwatched = !watch;
+
+	if (!priv->bss_connection)
+		return;
+
+	if (watch)
+		bss_props_watch (self);
+	else
+		bss_props_unwatch (self);
+}
+
+/**
+ * nm_supplicant_interface_merge_bss_properties:
+ * @self: the supplicant interface
+ * @object_path: the D-Bus path of the BSS
+ * @properties: BSS properties that were obtained by other means
+ *
+ * Updates the known properties of the BSS at @object_path with
+ * @properties. Use this while the BSS properties are not watched (see
+ * nm_supplicant_interface_set_watch_bss_properties()), so that the
+ * properties re-announced after a scan are not older than the ones the
+ * user already has. No signal is emitted.
+ */
+void
+nm_supplicant_interface_merge_bss_properties (NMSupplicantInterface *self,
+                                              const char *object_path,
+                                              GVariant *properties)
+{
+	NMSupplicantInterfacePrivate *priv;
 	BssData *bss_data;
+	GVariant *props;
 
-	g_return_if_fail (object_path != NULL);
+	g_return_if_fail (NM_IS_SUPPLICANT_INTERFACE (self));
+	g_return_if_fail (object_path);
+	g_return_if_fail (g_variant_is_of_type (properties, G_VARIANT_TYPE_VARDICT));
+
+	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
-	if (g_hash_table_lookup (priv->bss_proxies, object_path))
+	bss_data = g_hash_table_lookup (priv->bss_hash, object_path);
+	if (   !bss_data
+	    || !bss_data->initialized)
 		return;
 
-	bss_proxy = g_object_new (G_TYPE_DBUS_PROXY,
-	                          "g-bus-type", G_BUS_TYPE_SYSTEM,
-	                          "g-flags", G_DBUS_PROXY_FLAGS_NONE,
-	                          "g-name", WPAS_DBUS_SERVICE,
-	                          "g-object-path", object_path,
-	                          "g-interface-name", WPAS_DBUS_IFACE_BSS,
-	                          NULL);
-	bss_data = g_slice_new0 (BssData);
-	bss_data->proxy = bss_proxy;
-	g_hash_table_insert (priv->bss_proxies,
-	                     (char *) g_dbus_proxy_get_object_path (bss_proxy),
-	                     bss_data);
-	g_async_initable_init_async (G_ASYNC_INITABLE (bss_proxy),
-	                             G_PRIORITY_DEFAULT,
-	                             priv->other_cancellable,
-	                             (GAsyncReadyCallback) bss_proxy_acquired_cb,
-	                             self);
+	props = nm_supplicant_interface_bss_props_merge (bss_data->props, properties);
+	nm_clear_pointer (&bss_data->props, g_variant_unref);
+	bss_data->props = props;
 }
 
 static void
@@ -485,6 +821,7 @@ set_state (NMSupplicantInterface *self, NMSupplicantInterfaceState new_state)
 
 		if (priv->iface_proxy)
 			g_signal_handlers_disconnect_by_data (priv->iface_proxy, self);
+		bss_unsubscribe (self);
 	}
 
 	priv->state = new_state;
@@ -1177,30 +1514,26 @@ static void
 scan_done_emit_signal (NMSupplicantInterface *self)
 {
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
-	const char *object_path;
 	BssData *bss_data;
 	gboolean success;
 	GHashTableIter iter;
 
-	g_hash_table_iter_init (&iter, priv->bss_proxies);
+	g_hash_table_iter_init (&iter, priv->bss_hash);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &bss_data)) {
 		/* we have some BSS' that need to be initialized first. Delay
 		 * emitting signal. */
-		if (!bss_data->change_id) {
+		if (!bss_data->initialized) {
 			priv->scan_done_pending = TRUE;
 			return;
 		}
 	}
 
 	/* Emit BSS_UPDATED so that wifi device has the APs (in case it removed them) */
-	g_hash_table_iter_init (&iter, priv->bss_proxies);
-	while (g_hash_table_iter_next (&iter, (gpointer *) &object_path, (gpointer *) &bss_data)) {
-		gs_unref_variant GVariant *props = NULL;
-
-		props = bss_proxy_get_properties (self, bss_data->proxy);
+	g_hash_table_iter_init (&iter, priv->bss_hash);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &bss_data)) {
 		g_signal_emit (self, signals[BSS_UPDATED], 0,
-		               object_path,
-		               g_variant_ref_sink (props));
+		               bss_data->path,
+		               bss_data->props);
 	}
 
 	success = priv->scan_done_success;
@@ -1231,11 +1564,19 @@ wpas_iface_bss_added (GDBusProxy *proxy,
 {
 	NMSupplicantInterface *self = NM_SUPPLICANT_INTERFACE (user_data);
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+	BssData *bss_data;
 
 	if (priv->scanning)
 		priv->last_scan = nm_utils_get_monotonic_timestamp_ms ();
 
-	bss_add_new (self, path);
+	bss_data = bss_add_new (self, path, props);
+	if (bss_data) {
+		g_signal_emit (self, signals[BSS_UPDATED], 0,
+		               bss_data->path,
+		               bss_data->props);
+		if (priv->scan_done_pending)
+			scan_done_emit_signal (self);
+	}
 }
 
 static void
@@ -1247,12 +1588,15 @@ wpas_iface_bss_removed (GDBusProxy *proxy,
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 	BssData *bss_data;
 
-	bss_data = g_hash_table_lookup (priv->bss_proxies, path);
+	bss_data = g_hash_table_lookup (priv->bss_hash, path);
 	if (!bss_data)
 		return;
-	g_hash_table_steal (priv->bss_proxies, path);
+	g_hash_table_steal (priv->bss_hash, path);
 	g_signal_emit (self, signals[BSS_REMOVED], 0, path);
 	bss_data_destroy (bss_data);
+
+	if (priv->scan_done_pending)
+		scan_done_emit_signal (self);
 }
 
 static void
@@ -1300,7 +1644,7 @@ props_changed_cb (GDBusProxy *proxy,
 	if (g_variant_lookup (changed_properties, "BSSs", "^a&o", &array)) {
 		iter = array;
 		while (*iter)
-			bss_add_new (self, *iter++);
+			bss_add_new (self, *iter++, NULL);
 		g_free (array);
 	}
 
@@ -1603,6 +1947,8 @@ on_iface_proxy_acquired (GDBusProxy *proxy, GAsyncResult *result, gpointer user_
 	self = NM_SUPPLICANT_INTERFACE (user_data);
 	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
+	bss_subscribe (self);
+
 	_nm_dbus_signal_connect (priv->iface_proxy, "ScanDone", G_VARIANT_TYPE ("(b)"),
 	                         G_CALLBACK (wpas_iface_scan_done), self);
 	_nm_dbus_signal_connect (priv->iface_proxy, "BSSAdded", G_VARIANT_TYPE ("(oa{sv})"),
@@ -2696,7 +3042,7 @@ nm_supplicant_interface_init (NMSupplicantInterface * self)
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
 	priv->state = NM_SUPPLICANT_INTERFACE_STATE_INIT;
-	priv->bss_proxies = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, bss_data_destroy);
+	priv->bss_hash = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, bss_data_destroy);
 	priv->peer_proxies = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, peer_data_destroy);
 }
 
@@ -2767,7 +3113,8 @@ dispose (GObject *object)
 	if (priv->wpas_proxy)
 		g_signal_handlers_disconnect_by_data (priv->wpas_proxy, object);
 	g_clear_object (&priv->wpas_proxy);
-	g_clear_pointer (&priv->bss_proxies, g_hash_table_destroy);
+	bss_unsubscribe (self);
+	g_clear_pointer (&priv->bss_hash, g_hash_table_destroy);
 	g_clear_pointer (&priv->peer_proxies, g_hash_table_destroy);
 
 	g_clear_pointer (&priv->net_path, g_free);
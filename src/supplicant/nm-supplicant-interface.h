@@ -128,6 +128,13 @@ const char *nm_supplicant_interface_get_current_bss (NMSupplicantInterface *self
 
 gint64 nm_supplicant_interface_get_last_scan (NMSupplicantInterface *self);
 
+void nm_supplicant_interface_set_watch_bss_properties (NMSupplicantInterface *self,
+                                                       gboolean watch);
+
+void nm_supplicant_interface_merge_bss_properties (NMSupplicantInterface *self,
+                                                   const char *object_path,
+                                                   GVariant *properties);
+
 const char *nm_supplicant_interface_get_ifname (NMSupplicantInterface *self);
 
 guint nm_supplicant_interface_get_max_scan_ssids (NMSupplicantInterface *self);
@@ -187,4 +194,18 @@ void nm_supplicant_interface_enroll_wps (NMSupplicantInterface *self,
 
 void nm_supplicant_interface_cancel_wps (NMSupplicantInterface *self);
 
+/* exposed for testing */
+GVariant *nm_supplicant_interface_bss_props_merge (GVariant *props, GVariant *changed);
+
+guint nm_supplicant_interface_bss_watch (GDBusConnection *connection,
+                                         const char *sender,
+                                         const char *iface_path,
+                                         GDBusSignalCallback callback,
+                                         gpointer user_data,
+                                         char **out_match_rule);
+
+void nm_supplicant_interface_bss_unwatch (GDBusConnection *connection,
+                                          guint *p_signal_id,
+                                          char **p_match_rule);
+
 #endif /* __NM_SUPPLICANT_INTERFACE_H__ */
@@ -0,0 +1,270 @@
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2019 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "supplicant/nm-supplicant-interface.h"
+
+#include "nm-test-utils-core.h"
+
+#define IFACE_BSS        WPAS_DBUS_SERVICE ".BSS"
+#define IFACE_INTERFACE  WPAS_DBUS_SERVICE ".Interface"
+#define IFACE_PATH       WPAS_DBUS_PATH "/Interfaces/1"
+
+/*****************************************************************************/
+
+static GVariant *
+_vardict_new (const char *const*keys, const guint32 *values)
+{
+	GVariantBuilder builder;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	for (i = 0; keys[i]; i++)
+		g_variant_builder_add (&builder, "{sv}", keys[i], g_variant_new_uint32 (values[i]));
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+static void
+_assert_prop (GVariant *props, const char *key, guint32 expected)
+{
+	guint32 value;
+
+	g_assert (g_variant_lookup (props, key, "u", &value));
+	g_assert_cmpint (value, ==, expected);
+}
+
+static void
+test_bss_props_merge (void)
+{
+	gs_unref_variant GVariant *props = NULL;
+	gs_unref_variant GVariant *changed = NULL;
+	gs_unref_variant GVariant *merged = NULL;
+	gs_unref_variant GVariant *merged2 = NULL;
+
+	props = _vardict_new (NM_MAKE_STRV ("Signal", "Frequency", "Age"),
+	                      (const guint32 []) { 10, 2412, 3 });
+	changed = _vardict_new (NM_MAKE_STRV ("Signal", "Age", "Mode"),
+	                        (const guint32 []) { 20, 0, 1 });
+
+	/* the first properties are taken as they are. */
+	merged = nm_supplicant_interface_bss_props_merge (NULL, props);
+	g_assert (merged == props);
+	g_clear_pointer (&merged, g_variant_unref);
+
+	/* the changed values win, the others are kept and every key appears once. */
+	merged = nm_supplicant_interface_bss_props_merge (props, changed);
+	g_assert (g_variant_is_of_type (merged, G_VARIANT_TYPE_VARDICT));
+	g_assert_cmpint (g_variant_n_children (merged), ==, 4);
+	_assert_prop (merged, "Signal", 20);
+	_assert_prop (merged, "Frequency", 2412);
+	_assert_prop (merged, "Age", 0);
+	_assert_prop (merged, "Mode", 1);
+
+	/* the inputs are not modified. */
+	_assert_prop (props, "Signal", 10);
+	g_assert_cmpint (g_variant_n_children (props), ==, 3);
+
+	/* merging the same change again is idempotent. */
+	merged2 = nm_supplicant_interface_bss_props_merge (merged, changed);
+	g_assert (g_variant_equal (merged, merged2));
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GTestDBus *test_bus;
+	GDBusConnection *supplicant;
+	GDBusConnection *other;
+	GDBusConnection *nm;
+	GPtrArray *received;
+} SignalFixture;
+
+static GDBusConnection *
+_bus_connect (SignalFixture *f)
+{
+	gs_free_error GError *error = NULL;
+	GDBusConnection *connection;
+
+	connection = g_dbus_connection_new_for_address_sync (g_test_dbus_get_bus_address (f->test_bus),
+	                                                     G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT
+	                                                     | G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+	                                                     NULL,
+	                                                     NULL,
+	                                                     &error);
+	g_assert_no_error (error);
+	return connection;
+}
+
+static void
+_bus_call (GDBusConnection *connection,
+           const char *method,
+           GVariant *parameters)
+{
+	gs_unref_variant GVariant *ret = NULL;
+	gs_free_error GError *error = NULL;
+
+	ret = g_dbus_connection_call_sync (connection,
+	                                   DBUS_SERVICE_DBUS,
+	                                   DBUS_PATH_DBUS,
+	                                   DBUS_INTERFACE_DBUS,
+	                                   method,
+	                                   parameters,
+	                                   NULL,
+	                                   G_DBUS_CALL_FLAGS_NONE,
+	                                   -1,
+	                                   NULL,
+	                                   &error);
+	g_assert_no_error (error);
+}
+
+static void
+_emit (GDBusConnection *connection, const char *path, const char *interface_name)
+{
+	gs_free_error GError *error = NULL;
+
+	g_dbus_connection_emit_signal (connection,
+	                               NULL,
+	                               path,
+	                               DBUS_INTERFACE_PROPERTIES,
+	                               "PropertiesChanged",
+	                               g_variant_new ("(s@a{sv}@as)",
+	                                              interface_name,
+	                                              g_variant_new_array (G_VARIANT_TYPE ("{sv}"), NULL, 0),
+	                                              g_variant_new_strv (NULL, 0)),
+	                               &error);
+	g_assert_no_error (error);
+}
+
+static void
+_signal_cb (GDBusConnection *connection,
+            const char *sender_name,
+            const char *object_path,
+            const char *interface_name,
+            const char *signal_name,
+            GVariant *parameters,
+            gpointer user_data)
+{
+	SignalFixture *f = user_data;
+
+	g_assert_cmpstr (interface_name, ==, DBUS_INTERFACE_PROPERTIES);
+	g_assert_cmpstr (signal_name, ==, "PropertiesChanged");
+	g_ptr_array_add (f->received, g_strdup (object_path));
+}
+
+static void
+_sync (SignalFixture *f)
+{
+	/* messages from one connection are ordered. Once the bus answered
+	 * the sender and then us, everything the sender emitted before was
+	 * routed to us. */
+	g_dbus_connection_flush_sync (f->supplicant, NULL, NULL);
+	g_dbus_connection_flush_sync (f->other, NULL, NULL);
+	_bus_call (f->supplicant, "GetId", NULL);
+	_bus_call (f->other, "GetId", NULL);
+	_bus_call (f->nm, "GetId", NULL);
+
+	while (g_main_context_iteration (NULL, FALSE)) {
+	}
+}
+
+static void
+test_bss_signal_filter (void)
+{
+	gs_free char *dbus_daemon = NULL;
+	gs_free char *match_rule = NULL;
+	SignalFixture f = { };
+	guint signal_id;
+
+	dbus_daemon = g_find_program_in_path ("dbus-daemon");
+	if (!dbus_daemon) {
+		g_test_skip ("dbus-daemon is not available");
+		return;
+	}
+
+	f.test_bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+	g_test_dbus_up (f.test_bus);
+	f.supplicant = _bus_connect (&f);
+	f.other = _bus_connect (&f);
+	f.nm = _bus_connect (&f);
+	f.received = g_ptr_array_new_with_free_func (g_free);
+
+	/* the match rule names the well-known name of the supplicant. */
+	_bus_call (f.supplicant, "RequestName", g_variant_new ("(su)", WPAS_DBUS_SERVICE, 0));
+
+	signal_id = nm_supplicant_interface_bss_watch (f.nm,
+	                                               g_dbus_connection_get_unique_name (f.supplicant),
+	                                               IFACE_PATH,
+	                                               _signal_cb,
+	                                               &f,
+	                                               &match_rule);
+	g_assert (signal_id);
+	g_assert (match_rule);
+
+	/* AddMatch was sent before, thus it is in effect now. */
+	_bus_call (f.nm, "GetId", NULL);
+
+	_emit (f.supplicant, IFACE_PATH "/BSSs/1", IFACE_BSS);
+	_emit (f.supplicant, IFACE_PATH "/BSSs/2", IFACE_INTERFACE);
+	_emit (f.supplicant, IFACE_PATH, IFACE_INTERFACE);
+	_emit (f.supplicant, WPAS_DBUS_PATH "/Interfaces/2/BSSs/1", IFACE_BSS);
+	_emit (f.supplicant, WPAS_DBUS_PATH "/Interfaces/10/BSSs/1", IFACE_BSS);
+	_emit (f.other, IFACE_PATH "/BSSs/3", IFACE_BSS);
+	_emit (f.supplicant, IFACE_PATH "/BSSs/4", IFACE_BSS);
+	_sync (&f);
+
+	/* only the BSS signals of our interface's namespace arrive. Not for
+	 * other interfaces (path_namespace matches whole path elements), not
+	 * for other D-Bus interfaces (arg0) and not from other senders. */
+	g_assert_cmpint (f.received->len, ==, 2);
+	g_assert_cmpstr (f.received->pdata[0], ==, IFACE_PATH "/BSSs/1");
+	g_assert_cmpstr (f.received->pdata[1], ==, IFACE_PATH "/BSSs/4");
+
+	nm_supplicant_interface_bss_unwatch (f.nm, &signal_id, &match_rule);
+	g_assert (!signal_id);
+	g_assert (!match_rule);
+	_bus_call (f.nm, "GetId", NULL);
+
+	_emit (f.supplicant, IFACE_PATH "/BSSs/1", IFACE_BSS);
+	_sync (&f);
+	g_assert_cmpint (f.received->len, ==, 2);
+
+	g_ptr_array_unref (f.received);
+	g_dbus_connection_close_sync (f.nm, NULL, NULL);
+	g_dbus_connection_close_sync (f.other, NULL, NULL);
+	g_dbus_connection_close_sync (f.supplicant, NULL, NULL);
+	g_object_unref (f.nm);
+	g_object_unref (f.other);
+	g_object_unref (f.supplicant);
+	g_test_dbus_down (f.test_bus);
+	g_object_unref (f.test_bus);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "ALL");
+
+	g_test_add_func ("/supplicant/interface/bss-props-merge", test_bss_props_merge);
+	g_test_add_func ("/supplicant/interface/bss-signal-filter", test_bss_signal_filter);
+
+	return g_test_run ();
+}
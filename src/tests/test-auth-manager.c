@@ -0,0 +1,459 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2019 Red Hat, Inc.
+ *
+ */
+
+#include "nm-default.h"
+
+#include "nm-auth-manager.h"
+#include "nm-dbus-manager.h"
+
+#include "nm-test-utils-core.h"
+
+#define POLKIT_SERVICE     "org.freedesktop.PolicyKit1"
+#define POLKIT_OBJECT_PATH "/org/freedesktop/PolicyKit1/Authority"
+#define POLKIT_INTERFACE   "org.freedesktop.PolicyKit1.Authority"
+
+#define ACTION_A "org.freedesktop.NetworkManager.network-control"
+#define ACTION_B "org.freedesktop.NetworkManager.settings.modify.system"
+
+/*****************************************************************************/
+
+/* a fake polkit authority. It answers CheckAuthorization with the
+ * scripted result and counts the requests. */
+
+static const char polkit_introspection_xml[] =
+	"<node>"
+	"  <interface name='" POLKIT_INTERFACE "'>"
+	"    <method name='CheckAuthorization'>"
+	"      <arg type='(sa{sv})' name='subject' direction='in'/>"
+	"      <arg type='s' name='action_id' direction='in'/>"
+	"      <arg type='a{ss}' name='details' direction='in'/>"
+	"      <arg type='u' name='flags' direction='in'/>"
+	"      <arg type='s' name='cancellation_id' direction='in'/>"
+	"      <arg type='(bba{ss})' name='result' direction='out'/>"
+	"    </method>"
+	"    <method name='CancelCheckAuthorization'>"
+	"      <arg type='s' name='cancellation_id' direction='in'/>"
+	"    </method>"
+	"    <signal name='Changed'/>"
+	"  </interface>"
+	"</node>";
+
+static struct {
+	GTestDBus *test_bus;
+	GDBusConnection *polkit;
+	guint registration_id;
+	guint n_calls;
+	bool is_authorized:1;
+	bool is_challenge:1;
+	bool is_temporary:1;
+} gl;
+
+static void
+_polkit_method_call (GDBusConnection *connection,
+                     const char *sender,
+                     const char *object_path,
+                     const char *interface_name,
+                     const char *method_name,
+                     GVariant *parameters,
+                     GDBusMethodInvocation *invocation,
+                     gpointer user_data)
+{
+	GVariantBuilder details;
+
+	if (nm_streq (method_name, "CancelCheckAuthorization")) {
+		g_dbus_method_invocation_return_value (invocation, NULL);
+		return;
+	}
+
+	g_assert_cmpstr (method_name, ==, "CheckAuthorization");
+
+	gl.n_calls++;
+
+	g_variant_builder_init (&details, G_VARIANT_TYPE ("a{ss}"));
+	if (gl.is_temporary)
+		g_variant_builder_add (&details, "{ss}", "polkit.temporary_authorization_id", "tmpauthz1");
+	g_dbus_method_invocation_return_value (invocation,
+	                                       g_variant_new ("((bba{ss}))",
+	                                                      (gboolean) gl.is_authorized,
+	                                                      (gboolean) gl.is_challenge,
+	                                                      &details));
+}
+
+static void
+_polkit_set_result (gboolean is_authorized,
+                    gboolean is_challenge,
+                    gboolean is_temporary)
+{
+	gl.is_authorized = is_authorized;
+	gl.is_challenge = is_challenge;
+	gl.is_temporary = is_temporary;
+}
+
+static void
+_polkit_emit_changed (void)
+{
+	gs_free_error GError *error = NULL;
+
+	g_dbus_connection_emit_signal (gl.polkit,
+	                               NULL,
+	                               POLKIT_OBJECT_PATH,
+	                               POLKIT_INTERFACE,
+	                               "Changed",
+	                               NULL,
+	                               &error);
+	g_assert_no_error (error);
+}
+
+/*****************************************************************************/
+
+static gboolean
+_bus_skip (void)
+{
+	if (gl.polkit)
+		return FALSE;
+	g_test_skip ("dbus-daemon is not available");
+	return TRUE;
+}
+
+static void
+_bus_setup (void)
+{
+	static const GDBusInterfaceVTable vtable = {
+		.method_call = _polkit_method_call,
+	};
+	GDBusNodeInfo *node_info;
+	gs_unref_variant GVariant *ret = NULL;
+	gs_free char *dbus_daemon = NULL;
+	gs_free_error GError *error = NULL;
+	guint32 reply;
+
+	dbus_daemon = g_find_program_in_path ("dbus-daemon");
+	if (!dbus_daemon)
+		return;
+
+	/* run our own bus and let NMDBusManager connect to it as system bus. */
+	gl.test_bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+	g_test_dbus_up (gl.test_bus);
+	g_setenv ("DBUS_SYSTEM_BUS_ADDRESS", g_test_dbus_get_bus_address (gl.test_bus), TRUE);
+
+	g_assert (nm_dbus_manager_acquire_bus (nm_dbus_manager_get (), TRUE));
+
+	gl.polkit = g_dbus_connection_new_for_address_sync (g_test_dbus_get_bus_address (gl.test_bus),
+	                                                    G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT
+	                                                    | G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+	                                                    NULL,
+	                                                    NULL,
+	                                                    &error);
+	g_assert_no_error (error);
+
+	node_info = g_dbus_node_info_new_for_xml (polkit_introspection_xml, &error);
+	g_assert_no_error (error);
+	gl.registration_id = g_dbus_connection_register_object (gl.polkit,
+	                                                        POLKIT_OBJECT_PATH,
+	                                                        node_info->interfaces[0],
+	                                                        &vtable,
+	                                                        NULL,
+	                                                        NULL,
+	                                                        &error);
+	g_assert_no_error (error);
+	g_dbus_node_info_unref (node_info);
+
+	ret = g_dbus_connection_call_sync (gl.polkit,
+	                                   DBUS_SERVICE_DBUS,
+	                                   DBUS_PATH_DBUS,
+	                                   DBUS_INTERFACE_DBUS,
+	                                   "RequestName",
+	                                   g_variant_new ("(su)", POLKIT_SERVICE, 0),
+	                                   G_VARIANT_TYPE ("(u)"),
+	                                   G_DBUS_CALL_FLAGS_NONE,
+	                                   -1,
+	                                   NULL,
+	                                   &error);
+	g_assert_no_error (error);
+	g_variant_get (ret, "(u)", &reply);
+	g_assert_cmpint (reply, ==, 1 /* DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER */);
+}
+
+static void
+_bus_teardown (void)
+{
+	if (!gl.test_bus)
+		return;
+	if (gl.polkit) {
+		g_dbus_connection_unregister_object (gl.polkit, gl.registration_id);
+		g_dbus_connection_close_sync (gl.polkit, NULL, NULL);
+		g_clear_object (&gl.polkit);
+	}
+	g_test_dbus_down (gl.test_bus);
+	g_clear_object (&gl.test_bus);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GMainLoop *loop;
+	NMAuthManager *auth_mgr;
+	NMAuthSubject *subject;
+	gulong changed_id;
+	guint n_changed;
+} Fixture;
+
+typedef struct {
+	GMainLoop *loop;
+	NMAuthCallResult result;
+	bool completed:1;
+} CheckData;
+
+static void
+_changed_cb (NMAuthManager *auth_mgr, gpointer user_data)
+{
+	Fixture *f = user_data;
+
+	f->n_changed++;
+	g_main_loop_quit (f->loop);
+}
+
+static NMAuthSubject *
+_subject_new (gulong uid)
+{
+	NMAuthSubject *subject;
+
+	/* our own process has a start-time, which is required for caching. */
+	subject = g_object_new (NM_TYPE_AUTH_SUBJECT,
+	                        NM_AUTH_SUBJECT_SUBJECT_TYPE, (int) NM_AUTH_SUBJECT_TYPE_UNIX_PROCESS,
+	                        NM_AUTH_SUBJECT_UNIX_PROCESS_DBUS_SENDER, ":1.4242",
+	                        NM_AUTH_SUBJECT_UNIX_PROCESS_PID, (gulong) getpid (),
+	                        NM_AUTH_SUBJECT_UNIX_PROCESS_UID, uid,
+	                        NULL);
+	g_assert (nm_auth_subject_is_unix_process (subject));
+	g_assert (nm_auth_subject_get_unix_process_start_time (subject) != 0);
+	return subject;
+}
+
+static void
+_fixture_setup (Fixture *f)
+{
+	f->loop = g_main_loop_new (NULL, FALSE);
+	f->auth_mgr = g_object_new (NM_TYPE_AUTH_MANAGER,
+	                            NM_AUTH_MANAGER_POLKIT_ENABLED, TRUE,
+	                            NULL);
+	g_assert (nm_auth_manager_get_polkit_enabled (f->auth_mgr));
+	f->changed_id = g_signal_connect (f->auth_mgr,
+	                                  NM_AUTH_MANAGER_SIGNAL_CHANGED,
+	                                  G_CALLBACK (_changed_cb),
+	                                  f);
+	f->subject = _subject_new (1000);
+	gl.n_calls = 0;
+	_polkit_set_result (TRUE, FALSE, FALSE);
+}
+
+static void
+_fixture_teardown (Fixture *f)
+{
+	nm_clear_g_signal_handler (f->auth_mgr, &f->changed_id);
+	g_clear_object (&f->subject);
+	g_clear_object (&f->auth_mgr);
+	nm_clear_pointer (&f->loop, g_main_loop_unref);
+}
+
+static void
+_check_cb (NMAuthManager *auth_mgr,
+           NMAuthManagerCallId *call_id,
+           gboolean is_authorized,
+           gboolean is_challenge,
+           GError *error,
+           gpointer user_data)
+{
+	CheckData *data = user_data;
+
+	g_assert_no_error (error);
+	data->result = nm_auth_call_result_eval (is_authorized, is_challenge, error);
+	data->completed = TRUE;
+	g_main_loop_quit (data->loop);
+}
+
+static NMAuthCallResult
+_check (Fixture *f,
+        NMAuthSubject *subject,
+        const char *action_id,
+        gboolean allow_user_interaction)
+{
+	CheckData data = {
+		.loop = f->loop,
+	};
+
+	nm_auth_manager_check_authorization (f->auth_mgr,
+	                                     subject ?: f->subject,
+	                                     action_id,
+	                                     allow_user_interaction,
+	                                     _check_cb,
+	                                     &data);
+	g_assert (!data.completed);
+	if (!nmtst_main_loop_run (f->loop, 5000))
+		g_assert_not_reached ();
+	g_assert (data.completed);
+	return data.result;
+}
+
+static void
+_assert_stats (Fixture *f,
+               guint64 expected_hits,
+               guint64 expected_misses,
+               guint expected_calls)
+{
+	guint64 hits;
+	guint64 misses;
+
+	nm_auth_manager_get_cache_stats (f->auth_mgr, &hits, &misses);
+	g_assert_cmpint (hits, ==, expected_hits);
+	g_assert_cmpint (misses, ==, expected_misses);
+	g_assert_cmpint (gl.n_calls, ==, expected_calls);
+}
+
+/*****************************************************************************/
+
+static void
+test_cache_hit_miss (void)
+{
+	gs_unref_object NMAuthSubject *subject2 = NULL;
+	gs_unref_object NMAuthSubject *subject_root = NULL;
+	Fixture f = { };
+
+	if (_bus_skip ())
+		return;
+
+	_fixture_setup (&f);
+	_assert_stats (&f, 0, 0, 0);
+
+	/* the first request asks polkit, the second one is answered from the cache. */
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_YES);
+	_assert_stats (&f, 0, 1, 1);
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_YES);
+	_assert_stats (&f, 1, 1, 1);
+
+	/* a definite denial is cached too. */
+	_polkit_set_result (FALSE, FALSE, FALSE);
+	g_assert_cmpint (_check (&f, NULL, ACTION_B, FALSE), ==, NM_AUTH_CALL_RESULT_NO);
+	_assert_stats (&f, 1, 2, 2);
+	g_assert_cmpint (_check (&f, NULL, ACTION_B, FALSE), ==, NM_AUTH_CALL_RESULT_NO);
+	_assert_stats (&f, 2, 2, 2);
+
+	/* the cached results don't change with polkit's answer. */
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_YES);
+	_assert_stats (&f, 3, 2, 2);
+
+	/* another user is a different key. */
+	subject2 = _subject_new (1001);
+	g_assert_cmpint (_check (&f, subject2, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_NO);
+	_assert_stats (&f, 3, 3, 3);
+
+	/* root doesn't ask polkit and doesn't touch the cache. */
+	subject_root = _subject_new (0);
+	g_assert_cmpint (_check (&f, subject_root, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_YES);
+	_assert_stats (&f, 3, 3, 3);
+
+	_fixture_teardown (&f);
+}
+
+static void
+test_cache_changed (void)
+{
+	Fixture f = { };
+
+	if (_bus_skip ())
+		return;
+
+	_fixture_setup (&f);
+
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_YES);
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_YES);
+	_assert_stats (&f, 1, 1, 1);
+
+	/* polkit's policy changes. The cached decision is dropped and
+	 * the new one is fetched. */
+	_polkit_set_result (FALSE, FALSE, FALSE);
+	_polkit_emit_changed ();
+	if (!nmtst_main_loop_run (f.loop, 5000))
+		g_assert_not_reached ();
+	g_assert_cmpint (f.n_changed, ==, 1);
+
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_NO);
+	_assert_stats (&f, 1, 2, 2);
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_NO);
+	_assert_stats (&f, 2, 2, 2);
+
+	_fixture_teardown (&f);
+}
+
+static void
+test_cache_not_cached (void)
+{
+	Fixture f = { };
+
+	if (_bus_skip ())
+		return;
+
+	_fixture_setup (&f);
+
+	/* a challenge is not a definite answer... */
+	_polkit_set_result (FALSE, TRUE, FALSE);
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_AUTH);
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_AUTH);
+	_assert_stats (&f, 0, 2, 2);
+
+	/* ... and a temporary authorization can expire at any time. */
+	_polkit_set_result (TRUE, FALSE, TRUE);
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_YES);
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_YES);
+	_assert_stats (&f, 0, 4, 4);
+
+	/* the result of an interactive request is not remembered. */
+	_polkit_set_result (TRUE, FALSE, FALSE);
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, TRUE), ==, NM_AUTH_CALL_RESULT_YES);
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, TRUE), ==, NM_AUTH_CALL_RESULT_YES);
+	_assert_stats (&f, 0, 6, 6);
+
+	/* while a non-interactive one is. */
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_YES);
+	g_assert_cmpint (_check (&f, NULL, ACTION_A, FALSE), ==, NM_AUTH_CALL_RESULT_YES);
+	_assert_stats (&f, 1, 7, 7);
+
+	_fixture_teardown (&f);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	int r;
+
+	nmtst_init_with_logging (&argc, &argv, NULL, "ALL");
+
+	g_test_add_func ("/auth-manager/cache/hit-miss", test_cache_hit_miss);
+	g_test_add_func ("/auth-manager/cache/changed", test_cache_changed);
+	g_test_add_func ("/auth-manager/cache/not-cached", test_cache_not_cached);
+
+	_bus_setup ();
+	r = g_test_run ();
+	_bus_teardown ();
+	return r;
+}
@@ -0,0 +1,669 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2019 Red Hat, Inc.
+ *
+ */
+
+#include "nm-default.h"
+
+#include "nm-dbus-manager.h"
+#include "nm-dbus-object.h"
+#include "nm-dhcp4-config.h"
+#include "nm-dhcp6-config.h"
+
+#include "nm-test-utils-core.h"
+
+#define N_OBJECTS 1000
+
+#define OBJECT_MANAGER_PATH               "/org/freedesktop"
+#define OBJECT_MANAGER_FILTERED_INTERFACE NM_DBUS_INTERFACE ".ObjectManager"
+
+/*****************************************************************************/
+
+static struct {
+	GTestDBus *test_bus;
+	GDBusConnection *client;
+	const char *nm_name;
+} gl;
+
+static gboolean
+_bus_skip (void)
+{
+	if (gl.client)
+		return FALSE;
+	g_test_skip ("dbus-daemon is not available");
+	return TRUE;
+}
+
+static void
+_bus_setup (void)
+{
+	gs_free char *dbus_daemon = NULL;
+	gs_free_error GError *error = NULL;
+	NMDBusManager *dbus_mgr;
+
+	dbus_daemon = g_find_program_in_path ("dbus-daemon");
+	if (!dbus_daemon)
+		return;
+
+	/* run our own bus and let NMDBusManager connect to it as system bus. */
+	gl.test_bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+	g_test_dbus_up (gl.test_bus);
+	g_setenv ("DBUS_SYSTEM_BUS_ADDRESS", g_test_dbus_get_bus_address (gl.test_bus), TRUE);
+
+	dbus_mgr = nm_dbus_manager_get ();
+	g_assert (nm_dbus_manager_acquire_bus (dbus_mgr, TRUE));
+	nm_dbus_manager_start (dbus_mgr, NULL, NULL);
+	nm_dbus_manager_set_notify_coalesce (dbus_mgr, -1);
+
+	gl.nm_name = g_dbus_connection_get_unique_name (nm_dbus_manager_get_dbus_connection (dbus_mgr));
+
+	gl.client = g_dbus_connection_new_for_address_sync (g_test_dbus_get_bus_address (gl.test_bus),
+	                                                    G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT
+	                                                    | G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+	                                                    NULL,
+	                                                    NULL,
+	                                                    &error);
+	g_assert_no_error (error);
+}
+
+static void
+_bus_teardown (void)
+{
+	if (!gl.test_bus)
+		return;
+	if (gl.client) {
+		g_dbus_connection_close_sync (gl.client, NULL, NULL);
+		g_clear_object (&gl.client);
+	}
+	g_test_dbus_down (gl.test_bus);
+	g_clear_object (&gl.test_bus);
+}
+
+static void
+_bus_sync (void)
+{
+	gs_unref_variant GVariant *ret = NULL;
+	gs_free_error GError *error = NULL;
+
+	/* a round trip to NetworkManager's connection. Messages are ordered,
+	 * so all signals that were emitted before are received once the reply
+	 * arrives. */
+	ret = g_dbus_connection_call_sync (gl.client,
+	                                   gl.nm_name,
+	                                   NM_DBUS_PATH,
+	                                   DBUS_INTERFACE_PEER,
+	                                   "Ping",
+	                                   NULL,
+	                                   NULL,
+	                                   G_DBUS_CALL_FLAGS_NONE,
+	                                   -1,
+	                                   NULL,
+	                                   &error);
+	g_assert_no_error (error);
+
+	while (g_main_context_iteration (NULL, FALSE)) {
+	}
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	guint standard;
+	guint legacy;
+} PropertiesChangedCounts;
+
+static void
+_properties_changed_cb (GDBusConnection *connection,
+                        const char *sender_name,
+                        const char *object_path,
+                        const char *interface_name,
+                        const char *signal_name,
+                        GVariant *parameters,
+                        gpointer user_data)
+{
+	PropertiesChangedCounts *counts = user_data;
+
+	if (nm_streq (interface_name, DBUS_INTERFACE_PROPERTIES))
+		counts->standard++;
+	else {
+		g_assert_cmpstr (interface_name, ==, NM_DBUS_INTERFACE_DHCP4_CONFIG);
+		counts->legacy++;
+	}
+}
+
+static void
+_do_test_legacy_properties_changed (NMDhcp4Config **objs,
+                                    gboolean legacy_enabled,
+                                    const char *value)
+{
+	NMDBusManager *dbus_mgr = nm_dbus_manager_get ();
+	PropertiesChangedCounts counts = { 0 };
+	guint64 emitted_before, emitted_after;
+	guint64 suppressed_before, suppressed_after;
+	gs_unref_hashtable GHashTable *options = NULL;
+	guint subscription_id;
+	guint i;
+
+	nm_dbus_manager_set_legacy_properties_changed (dbus_mgr, legacy_enabled);
+
+	subscription_id = g_dbus_connection_signal_subscribe (gl.client,
+	                                                      gl.nm_name,
+	                                                      NULL,
+	                                                      "PropertiesChanged",
+	                                                      NULL,
+	                                                      NULL,
+	                                                      G_DBUS_SIGNAL_FLAGS_NONE,
+	                                                      _properties_changed_cb,
+	                                                      &counts,
+	                                                      NULL);
+	/* make sure the match rule is in place. */
+	_bus_sync ();
+
+	options = g_hash_table_new (nm_str_hash, g_str_equal);
+	g_hash_table_insert (options, "ip_address", (char *) value);
+
+	nm_dbus_manager_get_notify_stats (dbus_mgr, &emitted_before, NULL, &suppressed_before);
+	for (i = 0; i < N_OBJECTS; i++)
+		nm_dhcp4_config_set_options (objs[i], options);
+	nm_dbus_manager_get_notify_stats (dbus_mgr, &emitted_after, NULL, &suppressed_after);
+
+	_bus_sync ();
+	g_dbus_connection_signal_unsubscribe (gl.client, subscription_id);
+
+	g_test_message ("legacy signals %s: %u objects changed, %u standard and %u legacy PropertiesChanged signals received",
+	                legacy_enabled ? "enabled" : "disabled",
+	                (guint) N_OBJECTS,
+	                counts.standard,
+	                counts.legacy);
+
+	/* one standard and one legacy signal per object (DHCP4Config has one
+	 * interface with a legacy signal). */
+	g_assert_cmpuint (emitted_after - emitted_before, ==, N_OBJECTS);
+	g_assert_cmpuint (counts.standard, ==, N_OBJECTS);
+	if (legacy_enabled) {
+		g_assert_cmpuint (counts.legacy, ==, N_OBJECTS);
+		g_assert_cmpuint (suppressed_after, ==, suppressed_before);
+	} else {
+		g_assert_cmpuint (counts.legacy, ==, 0);
+		g_assert_cmpuint (suppressed_after - suppressed_before, ==, N_OBJECTS);
+	}
+}
+
+static void
+test_legacy_properties_changed (void)
+{
+	NMDhcp4Config *objs[N_OBJECTS];
+	guint i;
+
+	if (_bus_skip ())
+		return;
+
+	for (i = 0; i < N_OBJECTS; i++)
+		objs[i] = nm_dhcp4_config_new ();
+	_bus_sync ();
+
+	_do_test_legacy_properties_changed (objs, TRUE, "192.168.1.1");
+	_do_test_legacy_properties_changed (objs, FALSE, "192.168.1.2");
+	_do_test_legacy_properties_changed (objs, TRUE, "192.168.1.3");
+
+	for (i = 0; i < N_OBJECTS; i++)
+		g_object_unref (objs[i]);
+	_bus_sync ();
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GMainLoop *loop;
+	guint n_signals;
+	gint64 received_at;
+	char *ip_address;
+} CoalesceInfo;
+
+static void
+_coalesce_properties_changed_cb (GDBusConnection *connection,
+                                 const char *sender_name,
+                                 const char *object_path,
+                                 const char *interface_name,
+                                 const char *signal_name,
+                                 GVariant *parameters,
+                                 gpointer user_data)
+{
+	CoalesceInfo *info = user_data;
+	gs_unref_variant GVariant *changed = NULL;
+	gs_unref_variant GVariant *options = NULL;
+
+	g_variant_get (parameters, "(&s@a{sv}@as)", NULL, &changed, NULL);
+	g_assert (g_variant_lookup (changed, "Options", "@a{sv}", &options));
+
+	info->n_signals++;
+	info->received_at = nm_utils_get_monotonic_timestamp_ms ();
+	nm_clear_g_free (&info->ip_address);
+	g_assert (g_variant_lookup (options, "ip_address", "s", &info->ip_address));
+	g_main_loop_quit (info->loop);
+}
+
+static void
+_set_ip_address (NMDhcp4Config *obj, const char *value)
+{
+	gs_unref_hashtable GHashTable *options = NULL;
+
+	options = g_hash_table_new (nm_str_hash, g_str_equal);
+	g_hash_table_insert (options, "ip_address", (char *) value);
+	nm_dhcp4_config_set_options (obj, options);
+}
+
+static void
+test_properties_changed_coalesce (void)
+{
+	NMDBusManager *dbus_mgr = nm_dbus_manager_get ();
+	gs_unref_object NMDhcp4Config *obj = NULL;
+	CoalesceInfo info = { };
+	guint64 emitted_before, emitted_after;
+	guint64 saved_before, saved_after;
+	guint subscription_id;
+	gint64 changed_at;
+
+	if (_bus_skip ())
+		return;
+
+	info.loop = g_main_loop_new (NULL, FALSE);
+	obj = nm_dhcp4_config_new ();
+	_bus_sync ();
+
+	subscription_id = g_dbus_connection_signal_subscribe (gl.client,
+	                                                      gl.nm_name,
+	                                                      DBUS_INTERFACE_PROPERTIES,
+	                                                      "PropertiesChanged",
+	                                                      nm_dbus_object_get_path (NM_DBUS_OBJECT (obj)),
+	                                                      NULL,
+	                                                      G_DBUS_SIGNAL_FLAGS_NONE,
+	                                                      _coalesce_properties_changed_cb,
+	                                                      &info,
+	                                                      NULL);
+	_bus_sync ();
+
+	/* several changes within the window result in one signal with the
+	 * last value. */
+	nm_dbus_manager_set_notify_coalesce (dbus_mgr, 200);
+	nm_dbus_manager_get_notify_stats (dbus_mgr, &emitted_before, &saved_before, NULL);
+
+	changed_at = nm_utils_get_monotonic_timestamp_ms ();
+	_set_ip_address (obj, "192.168.1.1");
+	_set_ip_address (obj, "192.168.1.2");
+	_set_ip_address (obj, "192.168.1.3");
+
+	nm_dbus_manager_get_notify_stats (dbus_mgr, &emitted_after, &saved_after, NULL);
+	g_assert_cmpuint (emitted_after, ==, emitted_before);
+	g_assert_cmpuint (saved_after - saved_before, ==, 2);
+
+	if (!nmtst_main_loop_run (info.loop, 5000))
+		g_assert_not_reached ();
+	_bus_sync ();
+
+	g_assert_cmpuint (info.n_signals, ==, 1);
+	g_assert_cmpstr (info.ip_address, ==, "192.168.1.3");
+	g_assert_cmpint (info.received_at - changed_at, >=, 200);
+
+	nm_dbus_manager_get_notify_stats (dbus_mgr, &emitted_after, &saved_after, NULL);
+	g_assert_cmpuint (emitted_after - emitted_before, ==, 1);
+
+	/* the window is capped at NOTIFY_COALESCE_MAX_MSEC (1000 msec). */
+	nm_dbus_manager_set_notify_coalesce (dbus_mgr, 60000);
+	info.n_signals = 0;
+
+	changed_at = nm_utils_get_monotonic_timestamp_ms ();
+	_set_ip_address (obj, "192.168.1.4");
+
+	if (!nmtst_main_loop_run (info.loop, 5000))
+		g_assert_not_reached ();
+
+	g_assert_cmpuint (info.n_signals, ==, 1);
+	g_assert_cmpstr (info.ip_address, ==, "192.168.1.4");
+	g_assert_cmpint (info.received_at - changed_at, >=, 1000);
+	g_assert_cmpint (info.received_at - changed_at, <, 5000);
+
+	nm_dbus_manager_set_notify_coalesce (dbus_mgr, -1);
+	g_dbus_connection_signal_unsubscribe (gl.client, subscription_id);
+	nm_clear_g_free (&info.ip_address);
+	g_main_loop_unref (info.loop);
+	g_clear_object (&obj);
+	_bus_sync ();
+}
+
+/*****************************************************************************/
+
+static GVariant *
+_objmgr_call (const char *method_name,
+              GVariant *parameters,
+              const GVariantType *reply_type,
+              GError **error)
+{
+	return g_dbus_connection_call_sync (gl.client,
+	                                    gl.nm_name,
+	                                    OBJECT_MANAGER_PATH,
+	                                    OBJECT_MANAGER_FILTERED_INTERFACE,
+	                                    method_name,
+	                                    parameters,
+	                                    reply_type,
+	                                    G_DBUS_CALL_FLAGS_NONE,
+	                                    -1,
+	                                    NULL,
+	                                    error);
+}
+
+static GVariant *
+_objmgr_options (const char *interface,
+                 const char *path_prefix,
+                 guint64 cursor,
+                 guint32 limit)
+{
+	GVariantBuilder builder;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+	if (interface) {
+		const char *const interfaces[] = { interface, NULL };
+
+		g_variant_builder_add (&builder, "{sv}", "interfaces", g_variant_new_strv (interfaces, -1));
+	}
+	if (path_prefix)
+		g_variant_builder_add (&builder, "{sv}", "path-prefix", g_variant_new_object_path (path_prefix));
+	if (cursor)
+		g_variant_builder_add (&builder, "{sv}", "cursor", g_variant_new_uint64 (cursor));
+	if (limit)
+		g_variant_builder_add (&builder, "{sv}", "limit", g_variant_new_uint32 (limit));
+	return g_variant_new ("(a{sv})", &builder);
+}
+
+/* returns the object paths of all objects returned by GetManagedObjectsFiltered(),
+ * fetched in chunks of @limit. Asserts that each object has exactly the
+ * interface @interface. */
+static GHashTable *
+_objmgr_get_managed_objects (const char *interface,
+                             const char *path_prefix,
+                             guint32 limit,
+                             guint *out_n_calls)
+{
+	GHashTable *paths;
+	guint64 cursor = 0;
+	guint n_calls = 0;
+
+	paths = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, NULL);
+
+	do {
+		gs_unref_variant GVariant *ret = NULL;
+		gs_unref_variant GVariant *objects = NULL;
+		gs_free_error GError *error = NULL;
+		GVariantIter iter;
+		const char *path;
+		GVariant *interfaces;
+
+		ret = _objmgr_call ("GetManagedObjectsFiltered",
+		                    _objmgr_options (interface, path_prefix, cursor, limit),
+		                    G_VARIANT_TYPE ("(a{oa{sa{sv}}}t)"),
+		                    &error);
+		g_assert_no_error (error);
+		n_calls++;
+
+		g_variant_get (ret, "(@a{oa{sa{sv}}}t)", &objects, &cursor);
+		if (limit)
+			g_assert_cmpuint (g_variant_n_children (objects), <=, limit);
+
+		g_variant_iter_init (&iter, objects);
+		while (g_variant_iter_next (&iter, "{&o@a{sa{sv}}}", &path, &interfaces)) {
+			gs_unref_variant GVariant *interfaces_free = interfaces;
+
+			if (interface) {
+				g_assert_cmpuint (g_variant_n_children (interfaces), ==, 1);
+				g_assert (g_variant_lookup (interfaces, interface, "@a{sv}", NULL));
+			}
+			if (!g_hash_table_add (paths, g_strdup (path)))
+				g_assert_not_reached ();
+		}
+	} while (cursor != 0);
+
+	NM_SET_OUT (out_n_calls, n_calls);
+	return paths;
+}
+
+static void
+test_objmgr_get_managed_objects_filtered (void)
+{
+	NMDhcp4Config *objs4[5];
+	NMDhcp6Config *objs6[3];
+	gs_unref_hashtable GHashTable *paths = NULL;
+	gs_unref_variant GVariant *ret = NULL;
+	gs_unref_variant GVariant *objects = NULL;
+	gs_free_error GError *error = NULL;
+	guint64 cursor;
+	guint n_calls;
+	guint i;
+
+	if (_bus_skip ())
+		return;
+
+	for (i = 0; i < G_N_ELEMENTS (objs4); i++)
+		objs4[i] = nm_dhcp4_config_new ();
+	for (i = 0; i < G_N_ELEMENTS (objs6); i++)
+		objs6[i] = nm_dhcp6_config_new ();
+
+	paths = _objmgr_get_managed_objects (NM_DBUS_INTERFACE_DHCP6_CONFIG, NULL, 0, &n_calls);
+	g_assert_cmpuint (n_calls, ==, 1);
+	g_assert_cmpuint (g_hash_table_size (paths), ==, G_N_ELEMENTS (objs6));
+	for (i = 0; i < G_N_ELEMENTS (objs6); i++)
+		g_assert (g_hash_table_contains (paths, nm_dbus_object_get_path (NM_DBUS_OBJECT (objs6[i]))));
+	nm_clear_pointer (&paths, g_hash_table_unref);
+
+	paths = _objmgr_get_managed_objects (NULL, NM_DBUS_PATH"/DHCP4Config", 0, NULL);
+	g_assert_cmpuint (g_hash_table_size (paths), ==, G_N_ELEMENTS (objs4));
+	for (i = 0; i < G_N_ELEMENTS (objs4); i++)
+		g_assert (g_hash_table_contains (paths, nm_dbus_object_get_path (NM_DBUS_OBJECT (objs4[i]))));
+	nm_clear_pointer (&paths, g_hash_table_unref);
+
+	/* the filter on the interface does not match the path. */
+	paths = _objmgr_get_managed_objects (NM_DBUS_INTERFACE_DHCP6_CONFIG, NM_DBUS_PATH"/DHCP4Config", 0, NULL);
+	g_assert_cmpuint (g_hash_table_size (paths), ==, 0);
+	nm_clear_pointer (&paths, g_hash_table_unref);
+
+	/* fetch in chunks. */
+	paths = _objmgr_get_managed_objects (NM_DBUS_INTERFACE_DHCP4_CONFIG, NULL, 2, &n_calls);
+	g_assert_cmpuint (n_calls, ==, 3);
+	g_assert_cmpuint (g_hash_table_size (paths), ==, G_N_ELEMENTS (objs4));
+	for (i = 0; i < G_N_ELEMENTS (objs4); i++)
+		g_assert (g_hash_table_contains (paths, nm_dbus_object_get_path (NM_DBUS_OBJECT (objs4[i]))));
+	nm_clear_pointer (&paths, g_hash_table_unref);
+
+	/* the DHCP6Config objects after the last DHCP4Config match the path, but no
+	 * interface. They don't cause another, empty page. */
+	paths = _objmgr_get_managed_objects (NM_DBUS_INTERFACE_DHCP4_CONFIG, NULL, G_N_ELEMENTS (objs4), &n_calls);
+	g_assert_cmpuint (n_calls, ==, 1);
+	g_assert_cmpuint (g_hash_table_size (paths), ==, G_N_ELEMENTS (objs4));
+	nm_clear_pointer (&paths, g_hash_table_unref);
+
+	/* the listing continues after the cursor, even if that object is gone. */
+	ret = _objmgr_call ("GetManagedObjectsFiltered",
+	                    _objmgr_options (NM_DBUS_INTERFACE_DHCP4_CONFIG, NULL, 0, 2),
+	                    G_VARIANT_TYPE ("(a{oa{sa{sv}}}t)"),
+	                    &error);
+	g_assert_no_error (error);
+	g_variant_get (ret, "(@a{oa{sa{sv}}}t)", NULL, &cursor);
+	g_assert_cmpuint (cursor, ==, nm_dbus_object_get_export_version_id (NM_DBUS_OBJECT (objs4[1])));
+	nm_clear_pointer (&ret, g_variant_unref);
+
+	g_clear_object (&objs4[1]);
+
+	ret = _objmgr_call ("GetManagedObjectsFiltered",
+	                    _objmgr_options (NM_DBUS_INTERFACE_DHCP4_CONFIG, NULL, cursor, 2),
+	                    G_VARIANT_TYPE ("(a{oa{sa{sv}}}t)"),
+	                    &error);
+	g_assert_no_error (error);
+	g_variant_get (ret, "(@a{oa{sa{sv}}}t)", &objects, &cursor);
+	g_assert_cmpuint (g_variant_n_children (objects), ==, 2);
+	g_assert (g_variant_lookup (objects, nm_dbus_object_get_path (NM_DBUS_OBJECT (objs4[2])), "@a{sa{sv}}", NULL));
+	g_assert (g_variant_lookup (objects, nm_dbus_object_get_path (NM_DBUS_OBJECT (objs4[3])), "@a{sa{sv}}", NULL));
+	g_assert_cmpuint (cursor, ==, nm_dbus_object_get_export_version_id (NM_DBUS_OBJECT (objs4[3])));
+	nm_clear_pointer (&objects, g_variant_unref);
+	nm_clear_pointer (&ret, g_variant_unref);
+
+	ret = _objmgr_call ("GetManagedObjectsFiltered",
+	                    g_variant_new_parsed ("(@a{sv} {'no-such-option': <1>},)"),
+	                    G_VARIANT_TYPE ("(a{oa{sa{sv}}}t)"),
+	                    &error);
+	g_assert_error (error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS);
+	g_assert (!ret);
+
+	for (i = 0; i < G_N_ELEMENTS (objs4); i++)
+		g_clear_object (&objs4[i]);
+	for (i = 0; i < G_N_ELEMENTS (objs6); i++)
+		g_object_unref (objs6[i]);
+	_bus_sync ();
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GPtrArray *added;
+	GPtrArray *removed;
+} ObjmgrSignals;
+
+static void
+_objmgr_signal_cb (GDBusConnection *connection,
+                   const char *sender_name,
+                   const char *object_path,
+                   const char *interface_name,
+                   const char *signal_name,
+                   GVariant *parameters,
+                   gpointer user_data)
+{
+	ObjmgrSignals *signals = user_data;
+	const char *path;
+	gs_unref_variant GVariant *interfaces = NULL;
+
+	g_assert_cmpstr (object_path, ==, OBJECT_MANAGER_PATH);
+
+	if (nm_streq (signal_name, "InterfacesAdded")) {
+		g_assert (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(oa{sa{sv}})")));
+		g_variant_get (parameters, "(&o@a{sa{sv}})", &path, &interfaces);
+		g_assert_cmpuint (g_variant_n_children (interfaces), ==, 1);
+		g_assert (g_variant_lookup (interfaces, NM_DBUS_INTERFACE_DHCP6_CONFIG, "@a{sv}", NULL));
+		g_ptr_array_add (signals->added, g_strdup (path));
+	} else if (nm_streq (signal_name, "InterfacesRemoved")) {
+		gs_free const char **strv = NULL;
+
+		g_assert (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(oas)")));
+		g_variant_get (parameters, "(&o@as)", &path, &interfaces);
+		strv = g_variant_get_strv (interfaces, NULL);
+		g_assert_cmpint (NM_PTRARRAY_LEN (strv), ==, 1);
+		g_assert_cmpstr (strv[0], ==, NM_DBUS_INTERFACE_DHCP6_CONFIG);
+		g_ptr_array_add (signals->removed, g_strdup (path));
+	} else
+		g_assert_not_reached ();
+}
+
+static void
+test_objmgr_subscribe (void)
+{
+	gs_unref_ptrarray GPtrArray *added = g_ptr_array_new_with_free_func (g_free);
+	gs_unref_ptrarray GPtrArray *removed = g_ptr_array_new_with_free_func (g_free);
+	ObjmgrSignals signals = {
+		.added   = added,
+		.removed = removed,
+	};
+	gs_unref_variant GVariant *ret = NULL;
+	gs_free_error GError *error = NULL;
+	gs_free char *path6 = NULL;
+	NMDhcp4Config *obj4;
+	NMDhcp6Config *obj6;
+	guint subscription_id;
+
+	if (_bus_skip ())
+		return;
+
+	subscription_id = g_dbus_connection_signal_subscribe (gl.client,
+	                                                      gl.nm_name,
+	                                                      OBJECT_MANAGER_FILTERED_INTERFACE,
+	                                                      NULL,
+	                                                      OBJECT_MANAGER_PATH,
+	                                                      NULL,
+	                                                      G_DBUS_SIGNAL_FLAGS_NONE,
+	                                                      _objmgr_signal_cb,
+	                                                      &signals,
+	                                                      NULL);
+
+	ret = _objmgr_call ("Subscribe",
+	                    _objmgr_options (NM_DBUS_INTERFACE_DHCP6_CONFIG, NULL, 0, 0),
+	                    G_VARIANT_TYPE ("()"),
+	                    &error);
+	g_assert_no_error (error);
+	nm_clear_pointer (&ret, g_variant_unref);
+
+	/* only the object with a DHCP6Config interface is announced. */
+	obj4 = nm_dhcp4_config_new ();
+	obj6 = nm_dhcp6_config_new ();
+	path6 = g_strdup (nm_dbus_object_get_path (NM_DBUS_OBJECT (obj6)));
+	_bus_sync ();
+	g_assert_cmpuint (added->len, ==, 1);
+	g_assert_cmpstr (added->pdata[0], ==, path6);
+	g_assert_cmpuint (removed->len, ==, 0);
+
+	g_object_unref (obj4);
+	g_object_unref (obj6);
+	_bus_sync ();
+	g_assert_cmpuint (added->len, ==, 1);
+	g_assert_cmpuint (removed->len, ==, 1);
+	g_assert_cmpstr (removed->pdata[0], ==, path6);
+
+	ret = _objmgr_call ("Unsubscribe",
+	                    NULL,
+	                    G_VARIANT_TYPE ("()"),
+	                    &error);
+	g_assert_no_error (error);
+
+	/* no more signals after Unsubscribe(). */
+	obj6 = nm_dhcp6_config_new ();
+	_bus_sync ();
+	g_object_unref (obj6);
+	_bus_sync ();
+	g_assert_cmpuint (added->len, ==, 1);
+	g_assert_cmpuint (removed->len, ==, 1);
+
+	g_dbus_connection_signal_unsubscribe (gl.client, subscription_id);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	int r;
+
+	nmtst_init_with_logging (&argc, &argv, NULL, "ALL");
+
+	_bus_setup ();
+
+	g_test_add_func ("/dbus-manager/legacy-properties-changed", test_legacy_properties_changed);
+	g_test_add_func ("/dbus-manager/properties-changed-coalesce", test_properties_changed_coalesce);
+	g_test_add_func ("/dbus-manager/objmgr/get-managed-objects-filtered", test_objmgr_get_managed_objects_filtered);
+	g_test_add_func ("/dbus-manager/objmgr/subscribe", test_objmgr_subscribe);
+
+	r = g_test_run ();
+
+	_bus_teardown ();
+	return r;
+}
@@ -0,0 +1,226 @@
+/* This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2019 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-simple-connection.h"
+#include "nm-setting-connection.h"
+#include "nm-setting-wireless.h"
+#include "nm-setting-wireless-security.h"
+#include "settings/nm-settings-connection.h"
+
+#include "nm-test-utils-core.h"
+
+#define BSSID "00:11:22:33:44:55"
+
+/*****************************************************************************/
+
+static NMConnection *
+_create_connection (void)
+{
+	NMConnection *con;
+	NMSetting *s_wsec;
+	gs_unref_bytes GBytes *ssid = NULL;
+
+	con = nmtst_create_minimal_connection ("test", NULL, NM_SETTING_WIRELESS_SETTING_NAME, NULL);
+
+	ssid = g_bytes_new_static ("test", 4);
+	g_object_set (nm_connection_get_setting_wireless (con),
+	              NM_SETTING_WIRELESS_SSID, ssid,
+	              NULL);
+
+	s_wsec = nm_setting_wireless_security_new ();
+	g_object_set (s_wsec,
+	              NM_SETTING_WIRELESS_SECURITY_KEY_MGMT, "wpa-psk",
+	              NM_SETTING_WIRELESS_SECURITY_PSK, "password1",
+	              NULL);
+	nm_connection_add_setting (con, s_wsec);
+
+	nmtst_connection_normalize (con);
+	return con;
+}
+
+static void
+_update (NMSettingsConnection *sett_conn, NMConnection *con)
+{
+	gs_free_error GError *error = NULL;
+	gboolean success;
+
+	success = nm_settings_connection_update (sett_conn,
+	                                         con,
+	                                         NM_SETTINGS_CONNECTION_PERSIST_MODE_KEEP_SAVED,
+	                                         NM_SETTINGS_CONNECTION_COMMIT_REASON_NONE,
+	                                         NULL,
+	                                         &error);
+	g_assert_no_error (error);
+	g_assert (success);
+}
+
+static GVariant *
+_get (NMSettingsConnection *sett_conn, NMConnectionSerializationFlags flags)
+{
+	/* the returned variant is owned by the cache. Keep a reference, so that
+	 * an invalidated entry is not confused with a new one at the same address. */
+	return g_variant_ref (nm_settings_connection_get_dbus_settings (sett_conn, flags));
+}
+
+static GVariant *
+_lookup (GVariant *settings, const char *setting_name, const char *key)
+{
+	gs_unref_variant GVariant *setting = NULL;
+
+	if (!g_variant_lookup (settings, setting_name, "@a{sv}", &setting))
+		return NULL;
+	return g_variant_lookup_value (setting, key, NULL);
+}
+
+static void
+_assert_str (GVariant *settings, const char *setting_name, const char *key, const char *expected)
+{
+	gs_unref_variant GVariant *value = NULL;
+
+	value = _lookup (settings, setting_name, key);
+	if (!expected) {
+		g_assert (!value);
+		return;
+	}
+	g_assert (value);
+	g_assert_cmpstr (g_variant_get_string (value, NULL), ==, expected);
+}
+
+/*****************************************************************************/
+
+static void
+test_dbus_settings_cache (void)
+{
+	gs_unref_object NMSettingsConnection *sett_conn = NULL;
+	gs_unref_object NMConnection *con = NULL;
+	gs_unref_object NMConnection *con2 = NULL;
+	gs_unref_variant GVariant *settings = NULL;
+	gs_unref_variant GVariant *settings2 = NULL;
+	gs_unref_variant GVariant *settings_all = NULL;
+	gs_unref_variant GVariant *secrets = NULL;
+	gs_unref_variant GVariant *value = NULL;
+	gs_free_error GError *error = NULL;
+
+	con = _create_connection ();
+	sett_conn = g_object_new (NM_TYPE_SETTINGS_CONNECTION, NULL);
+	_update (sett_conn, con);
+
+	/* a second call is served from the cache. */
+	settings = _get (sett_conn, NM_CONNECTION_SERIALIZE_NO_SECRETS);
+	settings2 = _get (sett_conn, NM_CONNECTION_SERIALIZE_NO_SECRETS);
+	g_assert (settings == settings2);
+	_assert_str (settings, NM_SETTING_CONNECTION_SETTING_NAME, NM_SETTING_CONNECTION_ID, "test");
+	g_clear_pointer (&settings2, g_variant_unref);
+
+	/* other flags don't share the entry. Only they get the secrets. */
+	settings_all = _get (sett_conn, NM_CONNECTION_SERIALIZE_ALL);
+	g_assert (settings_all != settings);
+	_assert_str (settings_all, NM_SETTING_WIRELESS_SECURITY_SETTING_NAME, NM_SETTING_WIRELESS_SECURITY_PSK, "password1");
+	_assert_str (settings, NM_SETTING_WIRELESS_SECURITY_SETTING_NAME, NM_SETTING_WIRELESS_SECURITY_PSK, NULL);
+	settings2 = _get (sett_conn, NM_CONNECTION_SERIALIZE_NO_SECRETS);
+	g_assert (settings2 == settings);
+	g_clear_pointer (&settings2, g_variant_unref);
+	g_clear_pointer (&settings_all, g_variant_unref);
+
+	/* an update drops the cache. */
+	con2 = nm_simple_connection_new_clone (con);
+	g_object_set (nm_connection_get_setting_connection (con2),
+	              NM_SETTING_CONNECTION_ID, "test-2",
+	              NULL);
+	_update (sett_conn, con2);
+	settings2 = _get (sett_conn, NM_CONNECTION_SERIALIZE_NO_SECRETS);
+	g_assert (settings2 != settings);
+	_assert_str (settings2, NM_SETTING_CONNECTION_SETTING_NAME, NM_SETTING_CONNECTION_ID, "test-2");
+	g_clear_pointer (&settings, g_variant_unref);
+	settings = g_steal_pointer (&settings2);
+
+	/* and so does a change of the secrets. */
+	settings_all = _get (sett_conn, NM_CONNECTION_SERIALIZE_ALL);
+	g_object_set (nm_connection_get_setting_wireless_security (con2),
+	              NM_SETTING_WIRELESS_SECURITY_PSK, "password2",
+	              NULL);
+	secrets = nm_connection_to_dbus (con2, NM_CONNECTION_SERIALIZE_ONLY_SECRETS);
+	g_assert (secrets);
+	nm_connection_update_secrets (nm_settings_connection_get_connection (sett_conn), NULL, secrets, &error);
+	g_assert_no_error (error);
+	settings2 = _get (sett_conn, NM_CONNECTION_SERIALIZE_ALL);
+	g_assert (settings2 != settings_all);
+	_assert_str (settings2, NM_SETTING_WIRELESS_SECURITY_SETTING_NAME, NM_SETTING_WIRELESS_SECURITY_PSK, "password2");
+	g_clear_pointer (&settings_all, g_variant_unref);
+	settings_all = g_steal_pointer (&settings2);
+
+	nm_connection_clear_secrets (nm_settings_connection_get_connection (sett_conn));
+	settings2 = _get (sett_conn, NM_CONNECTION_SERIALIZE_ALL);
+	g_assert (settings2 != settings_all);
+	_assert_str (settings2, NM_SETTING_WIRELESS_SECURITY_SETTING_NAME, NM_SETTING_WIRELESS_SECURITY_PSK, NULL);
+	g_clear_pointer (&settings2, g_variant_unref);
+
+	/* the permissions of the profile, which decide whether a caller may
+	 * see it, are part of the cached settings too. */
+	g_clear_pointer (&settings, g_variant_unref);
+	settings = _get (sett_conn, NM_CONNECTION_SERIALIZE_NO_SECRETS);
+	g_assert (!_lookup (settings, NM_SETTING_CONNECTION_SETTING_NAME, NM_SETTING_CONNECTION_PERMISSIONS));
+	nm_setting_connection_add_permission (nm_connection_get_setting_connection (con2), "user", "root", NULL);
+	_update (sett_conn, con2);
+	settings2 = _get (sett_conn, NM_CONNECTION_SERIALIZE_NO_SECRETS);
+	g_assert (settings2 != settings);
+	value = _lookup (settings2, NM_SETTING_CONNECTION_SETTING_NAME, NM_SETTING_CONNECTION_PERMISSIONS);
+	g_assert (value);
+	g_assert_cmpint (g_variant_n_children (value), ==, 1);
+	g_clear_pointer (&value, g_variant_unref);
+	g_clear_pointer (&settings, g_variant_unref);
+	settings = g_steal_pointer (&settings2);
+
+	/* the timestamp and the seen-bssids are merged into the result. */
+	nm_settings_connection_update_timestamp (sett_conn, 42);
+	settings2 = _get (sett_conn, NM_CONNECTION_SERIALIZE_NO_SECRETS);
+	g_assert (settings2 != settings);
+	value = _lookup (settings2, NM_SETTING_CONNECTION_SETTING_NAME, NM_SETTING_CONNECTION_TIMESTAMP);
+	g_assert (value);
+	g_assert_cmpint (g_variant_get_uint64 (value), ==, 42);
+	g_clear_pointer (&value, g_variant_unref);
+	g_clear_pointer (&settings, g_variant_unref);
+	settings = g_steal_pointer (&settings2);
+
+	nm_settings_connection_update_timestamp (sett_conn, 42);
+	settings2 = _get (sett_conn, NM_CONNECTION_SERIALIZE_NO_SECRETS);
+	g_assert (settings2 == settings);
+	g_clear_pointer (&settings2, g_variant_unref);
+
+	nm_settings_connection_add_seen_bssid (sett_conn, BSSID);
+	settings2 = _get (sett_conn, NM_CONNECTION_SERIALIZE_NO_SECRETS);
+	g_assert (settings2 != settings);
+	value = _lookup (settings2, NM_SETTING_WIRELESS_SETTING_NAME, NM_SETTING_WIRELESS_SEEN_BSSIDS);
+	g_assert (value);
+	g_assert_cmpint (g_variant_n_children (value), ==, 1);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "ALL");
+
+	g_test_add_func ("/settings/connection/dbus-settings-cache", test_dbus_settings_cache);
+
+	return g_test_run ();
+}
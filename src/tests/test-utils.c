@@ -21,6 +21,9 @@
 
 #include <arpa/inet.h>
 
+#include "nm-dbus-object.h"
+#include "devices/nm-device-ethernet.h"
+
 #include "nm-test-utils-core.h"
 
 static void
@@ -123,6 +126,127 @@ test_hw_addr_gen_stable_eth (void)
 
 /*****************************************************************************/
 
+static guint
+_property_index_lookup_naive (const NMDBusInterfaceInfoExtended *const*interface_infos,
+                              guint n_interface_infos,
+                              const char *property_name)
+{
+	guint i, j;
+	guint n = 0;
+
+	/* this is how _nm_dbus_manager_obj_notify() used to search for properties. */
+	for (i = 0; i < n_interface_infos; i++) {
+		const GDBusInterfaceInfo *info = &interface_infos[i]->parent;
+
+		if (!info->properties)
+			continue;
+		for (j = 0; info->properties[j]; j++) {
+			if (nm_streq (((const NMDBusPropertyInfoExtended *) info->properties[j])->property_name, property_name))
+				n++;
+		}
+	}
+	return n;
+}
+
+typedef struct {
+	GHashTable *property_index;
+	GPtrArray *interface_infos;
+	GPtrArray *names;
+} PropertyIndexData;
+
+static void
+_benchmark_property_index_naive (gpointer user_data)
+{
+	const PropertyIndexData *data = user_data;
+	guint j;
+
+	for (j = 0; j < data->names->len; j++) {
+		_property_index_lookup_naive ((const NMDBusInterfaceInfoExtended *const*) data->interface_infos->pdata,
+		                              data->interface_infos->len,
+		                              data->names->pdata[j]);
+	}
+}
+
+static void
+_benchmark_property_index (gpointer user_data)
+{
+	const PropertyIndexData *data = user_data;
+	guint j, n;
+
+	for (j = 0; j < data->names->len; j++)
+		nm_dbus_utils_property_index_lookup (data->property_index, data->names->pdata[j], &n);
+}
+
+static void
+test_dbus_property_index (void)
+{
+	gs_unref_hashtable GHashTable *property_index = NULL;
+	gs_unref_ptrarray GPtrArray *interface_infos = NULL;
+	const NMDBusInterfaceInfoExtended *const*prev_interface_infos = NULL;
+	gs_unref_ptrarray GPtrArray *names = NULL;
+	PropertyIndexData data;
+	NMDBusObjectClass *klass;
+	GType gtype;
+	guint i, j, k, n;
+
+	/* collect the D-Bus interfaces of a device, the same way as NMDBusManager does. */
+	interface_infos = g_ptr_array_new ();
+	klass = g_type_class_ref (NM_TYPE_DEVICE_ETHERNET);
+	for (gtype = NM_TYPE_DEVICE_ETHERNET; gtype != NM_TYPE_DBUS_OBJECT; gtype = g_type_parent (gtype)) {
+		NMDBusObjectClass *k_class = g_type_class_peek (gtype);
+
+		if (   !k_class->interface_infos
+		    || k_class->interface_infos == prev_interface_infos)
+			continue;
+		prev_interface_infos = k_class->interface_infos;
+		for (i = 0; k_class->interface_infos[i]; i++)
+			g_ptr_array_add (interface_infos, (gpointer) k_class->interface_infos[i]);
+	}
+	g_assert_cmpint (interface_infos->len, >=, 2);
+
+	property_index = nm_dbus_utils_property_index_new ((const NMDBusInterfaceInfoExtended *const*) interface_infos->pdata,
+	                                                   interface_infos->len);
+
+	names = g_ptr_array_new ();
+	for (i = 0; i < interface_infos->len; i++) {
+		const GDBusInterfaceInfo *info = &((const NMDBusInterfaceInfoExtended *) interface_infos->pdata[i])->parent;
+
+		if (!info->properties)
+			continue;
+		for (j = 0; info->properties[j]; j++) {
+			const NMDBusPropertyInfoExtended *property_info = (const NMDBusPropertyInfoExtended *) info->properties[j];
+			const NMDBusPropertyIndexEntry *entries;
+
+			entries = nm_dbus_utils_property_index_lookup (property_index, property_info->property_name, &n);
+			g_assert_cmpint (n, ==, _property_index_lookup_naive ((const NMDBusInterfaceInfoExtended *const*) interface_infos->pdata,
+			                                                      interface_infos->len,
+			                                                      property_info->property_name));
+			for (k = 0; k < n; k++) {
+				g_assert (entries[k].interface_info == interface_infos->pdata[entries[k].interface_idx]);
+				if (   entries[k].interface_idx == i
+				    && entries[k].property_idx == j)
+					break;
+			}
+			g_assert_cmpint (k, <, n);
+			g_ptr_array_add (names, (gpointer) property_info->property_name);
+		}
+	}
+	g_assert (!nm_dbus_utils_property_index_lookup (property_index, "no-such-property", &n));
+	g_assert_cmpint (n, ==, 0);
+
+	data = (PropertyIndexData) {
+		.property_index  = property_index,
+		.interface_infos = interface_infos,
+		.names           = names,
+	};
+	nmtst_benchmark ("property lookup (naive)", 100000, _benchmark_property_index_naive, &data);
+	nmtst_benchmark ("property lookup (index)", 100000, _benchmark_property_index, &data);
+
+	g_type_class_unref (klass);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -132,6 +256,7 @@ main (int argc, char **argv)
 
 	g_test_add_func ("/utils/stable_privacy", test_stable_privacy);
 	g_test_add_func ("/utils/hw_addr_gen_stable_eth", test_hw_addr_gen_stable_eth);
+	g_test_add_func ("/utils/dbus_property_index", test_dbus_property_index);
 
 	return g_test_run ();
 }
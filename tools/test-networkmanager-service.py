@@ -1058,6 +1058,17 @@ class WifiDevice(Device):
         self.AccessPointAdded(ExportedObj.to_path(ap))
         return ap
 
+    def add_aps(self, aps):
+        # like add_ap(), but the access points appear at once, like
+        # after a scan.
+        for ap in aps:
+            ap.export()
+            self.aps.append(ap)
+        self._dbus_property_set(IFACE_WIFI, PRP_WIFI_ACCESS_POINTS, ExportedObj.to_path_array(self.aps))
+        for ap in aps:
+            self.AccessPointAdded(ExportedObj.to_path(ap))
+        return aps
+
     def remove_ap(self, ap):
         self.aps.remove(ap)
         self._dbus_property_set(IFACE_WIFI, PRP_WIFI_ACCESS_POINTS, ExportedObj.to_path_array(self.aps))
@@ -1619,6 +1630,12 @@ class NetworkManager(ExportedObj):
         ap = WifiAp(ssid, bssid)
         return ExportedObj.to_path(d.add_ap(ap))
 
+    @dbus.service.method(IFACE_TEST, in_signature='su', out_signature='ao')
+    def AddWifiAps(self, ident, num):
+        d = self.find_device_first(ident = ident, require = TestError)
+        aps = [WifiAp('%s-scan-%d' % (d.ident, i)) for i in range(num)]
+        return ExportedObj.to_path_array(d.add_aps(aps))
+
     @dbus.service.method(IFACE_TEST, in_signature='so', out_signature='')
     def RemoveWifiAp(self, ident, ap_path):
         d = self.find_device_first(ident = ident, require = TestError)